@@ -1,97 +1,143 @@
 #include "FRAMECOUNTER.h"
 #include "EEPROM.h"
+#include "crc8.h"
+#include "framelog.h"
 #include <string.h>
 
-// Number of counter positions for wear leveling
-#define COUNTER_POSITIONS   128  // 512 bytes / 4 bytes per counter = 128 positions
-#define BYTES_PER_COUNTER   4
-
-// Invalid counter value marker
-#define COUNTER_INVALID     0xFFFFFFFF
+// The counter area is a ring of slots, each holding one save of the counter:
+//
+//   [Count_MSB][Count][Count][Count_LSB][Save_MSB][Save][Save_LSB][CRC8]
+//
+// Saves are numbered, and save N goes in slot N % COUNTER_SLOTS, so every save goes to
+// the next slot round and the slots hold an unbroken run of save numbers - laid out just
+// like the SD frame log and session index. The latest save is found at boot the same way,
+// by binary search (FrameLog_FindRun()), in log2(COUNTER_SLOTS) + 3 slot reads.
+//
+// A save never touches the slot holding the one before it. If it's cut short, its CRC8
+// doesn't check out, the run ends a slot earlier, and the counter comes back as it was
+// last saved. The SD frame log then puts it right (STORE_Init()).
+
+#define COUNTER_SLOT_BYTES      8
+#define COUNTER_SLOTS           (EEPROM_FRAME_COUNTER_SIZE / COUNTER_SLOT_BYTES)  // 64
+#define COUNTER_SLOT_CRC_BYTES  7   // All but the CRC8
+
+// The old layout, from before saves were numbered: 128 positions of 4 bytes, MSB first,
+// the counter in one and 0xFFFFFFFF in the rest
+#define LEGACY_POSITIONS        (EEPROM_FRAME_COUNTER_SIZE / LEGACY_BYTES)  // 128
+#define LEGACY_BYTES            4
+#define LEGACY_INVALID          0xFFFFFFFFUL
+
+// 24 bit save numbers - 16M saves. The area wears out long before they wrap (64 slots x
+// 100,000 writes).
+#define COUNTER_SAVE_MASK       0x00FFFFFFUL
+
+// Increments between saves. A reset loses at most this many - 1, the same as the old
+// layout, and the frame log on the card has them anyway. Each slot gets written once
+// every COUNTER_SLOTS saves, so once every 1024 frames.
+#define COUNTER_SAVE_FRAMES     16
 
 // Current state
 static uint32_t sg_u32CurrentCounter = 0;
-static uint8_t sg_u8CurrentPosition = 0;
-static uint8_t sg_u8UpdateCounter = 0;  // Update EEPROM every 256 increments
+static uint32_t sg_u32CurrentSave = COUNTER_SAVE_MASK;  // The next save is 0
+static uint8_t sg_u8Unsaved = 0;                        // Increments since the last save
 
-// Read a 32-bit counter from EEPROM at given position
-static uint32_t ReadCounterAtPosition(uint8_t position) {
-    uint16_t addr = EEPROM_FRAME_COUNTER_BASE + (position * BYTES_PER_COUNTER);
-    uint32_t value = 0;
+// Reads a slot, whole - fits PFFrameLogRead
+static bool ReadSlot(uint32_t slot, uint8_t* record, bool whole) {
+    uint16_t addr = EEPROM_FRAME_COUNTER_BASE + (uint16_t)(slot * COUNTER_SLOT_BYTES);
 
-    // Read 4 bytes (MSB first for easier debugging)
-    value  = ((uint32_t)EEPROMRead(addr) << 24);
-    value |= ((uint32_t)EEPROMRead(addr + 1) << 16);
-    value |= ((uint32_t)EEPROMRead(addr + 2) << 8);
-    value |= ((uint32_t)EEPROMRead(addr + 3));
+    (void)whole;
+    for (uint8_t i = 0; i < COUNTER_SLOT_BYTES; i++) {
+        record[i] = EEPROMRead(addr + i);
+    }
 
-    return value;
+    return true;
 }
 
-// Write a 32-bit counter to EEPROM at given position
-static void WriteCounterAtPosition(uint8_t position, uint32_t value) {
-    uint16_t addr = EEPROM_FRAME_COUNTER_BASE + (position * BYTES_PER_COUNTER);
+// True if the slot holds a save that checks out. *save gets its number. Fits
+// PFFrameLogHeader.
+static bool SlotSave(const uint8_t* record, uint32_t* save) {
+    if (CRC8_Calculate(record, COUNTER_SLOT_CRC_BYTES) != record[COUNTER_SLOT_CRC_BYTES]) {
+        return false;
+    }
 
-    // Only write bytes that have changed (wear optimization)
-    uint32_t current = ReadCounterAtPosition(position);
+    *save = ((uint32_t)record[4] << 16) | ((uint32_t)record[5] << 8) | record[6];
+    return true;
+}
 
-    // Write MSB first
-    if ((uint8_t)(value >> 24) != (uint8_t)(current >> 24)) {
-        EEPROMWrite(addr, (uint8_t)(value >> 24));
-    }
-    if ((uint8_t)(value >> 16) != (uint8_t)(current >> 16)) {
-        EEPROMWrite(addr + 1, (uint8_t)(value >> 16));
-    }
-    if ((uint8_t)(value >> 8) != (uint8_t)(current >> 8)) {
-        EEPROMWrite(addr + 2, (uint8_t)(value >> 8));
-    }
-    if ((uint8_t)(value) != (uint8_t)(current)) {
-        EEPROMWrite(addr + 3, (uint8_t)(value));
+// Saves the counter to the next slot round. Only the bytes that have changed get
+// written, and the CRC8 last, so the save doesn't count until it's all there.
+static void SaveCounter(void) {
+    uint8_t record[COUNTER_SLOT_BYTES];
+    uint16_t addr;
+
+    sg_u32CurrentSave = (sg_u32CurrentSave + 1) & COUNTER_SAVE_MASK;
+    sg_u8Unsaved = 0;
+
+    record[0] = (uint8_t)(sg_u32CurrentCounter >> 24);
+    record[1] = (uint8_t)(sg_u32CurrentCounter >> 16);
+    record[2] = (uint8_t)(sg_u32CurrentCounter >> 8);
+    record[3] = (uint8_t)(sg_u32CurrentCounter);
+    record[4] = (uint8_t)(sg_u32CurrentSave >> 16);
+    record[5] = (uint8_t)(sg_u32CurrentSave >> 8);
+    record[6] = (uint8_t)(sg_u32CurrentSave);
+    record[7] = CRC8_Calculate(record, COUNTER_SLOT_CRC_BYTES);
+
+    addr = EEPROM_FRAME_COUNTER_BASE + (uint16_t)((sg_u32CurrentSave % COUNTER_SLOTS) * COUNTER_SLOT_BYTES);
+    for (uint8_t i = 0; i < COUNTER_SLOT_BYTES; i++) {
+        if (EEPROMRead(addr + i) != record[i]) {
+            EEPROMWrite(addr + i, record[i]);
+        }
     }
 }
 
-// Find the position with the highest valid counter value
-static void FindCurrentPosition(void) {
+// The highest counter in the old layout, or 0 if there isn't one (a blank EEPROM). Only
+// ever run once, the first boot after an upgrade - the save that follows replaces it.
+static uint32_t LegacyCounter(void) {
     uint32_t maxCounter = 0;
-    uint8_t maxPosition = 0;
-    bool foundValid = false;
 
-    // Scan all positions to find highest counter
-    for (uint8_t pos = 0; pos < COUNTER_POSITIONS; pos++) {
-        uint32_t value = ReadCounterAtPosition(pos);
+    for (uint8_t pos = 0; pos < LEGACY_POSITIONS; pos++) {
+        uint16_t addr = EEPROM_FRAME_COUNTER_BASE + (uint16_t)(pos * LEGACY_BYTES);
+        uint32_t value = ((uint32_t)EEPROMRead(addr) << 24) |
+                         ((uint32_t)EEPROMRead(addr + 1) << 16) |
+                         ((uint32_t)EEPROMRead(addr + 2) << 8) |
+                         EEPROMRead(addr + 3);
 
-        // Skip invalid entries
-        if (value == COUNTER_INVALID) {
-            continue;
-        }
-
-        // Check if this is the highest value so far
-        // Handle wrap-around: if difference is huge, assume wrap
-        if (!foundValid || value > maxCounter) {
+        if ((value != LEGACY_INVALID) && (value > maxCounter)) {
             maxCounter = value;
-            maxPosition = pos;
-            foundValid = true;
         }
     }
 
-    if (foundValid) {
-        sg_u32CurrentCounter = maxCounter;
-        sg_u8CurrentPosition = maxPosition;
-    } else {
-        // No valid counter found, initialize first position
-        sg_u32CurrentCounter = 0;
-        sg_u8CurrentPosition = 0;
-        WriteCounterAtPosition(0, 0);
-    }
+    return maxCounter;
 }
 
 // Initialize frame counter system
 void FrameCounter_Init(void) {
-    // Find the current counter value and position
-    FindCurrentPosition();
+    uint8_t record[COUNTER_SLOT_BYTES];
+    uint32_t save;
+
+    sg_u8Unsaved = 0;
+
+    // Start from the last slot. Once the ring has been round, that's always part of the
+    // latest run, even if the save to slot 0 was the one cut short. Until then it's
+    // empty, and the search starts from slot 0.
+    if (FrameLog_FindRun(COUNTER_SLOTS, COUNTER_SLOTS - 1, ReadSlot, SlotSave, record, &save)) {
+        // The search may have finished on a slot past the latest save
+        ReadSlot(save % COUNTER_SLOTS, record, true);
+
+        sg_u32CurrentSave = save;
+        sg_u32CurrentCounter = ((uint32_t)record[0] << 24) |
+                               ((uint32_t)record[1] << 16) |
+                               ((uint32_t)record[2] << 8) |
+                               record[3];
+        return;
+    }
 
-    // Reset update counter
-    sg_u8UpdateCounter = 0;
+    // Nothing saved yet - a blank EEPROM, or the old layout, which had no save numbers.
+    // Carry on from the old layout's counter, or 0, as save 0. STORE_Init() moves it on
+    // to the head of the log on the card.
+    sg_u32CurrentSave = COUNTER_SAVE_MASK;
+    sg_u32CurrentCounter = LegacyCounter();
+    SaveCounter();
 }
 
 // Get current counter value
@@ -99,32 +145,22 @@ uint32_t FrameCounter_Get(void) {
     return sg_u32CurrentCounter;
 }
 
-// Increment and persist counter
+// Increment the counter, saving it every COUNTER_SAVE_FRAMES
 void FrameCounter_Increment(void) {
-    // Increment the counter
     sg_u32CurrentCounter++;
-    sg_u8UpdateCounter++;
-
-    // Only update EEPROM every 256 increments to reduce wear
-    if (sg_u8UpdateCounter == 0) {  // Wrapped around from 255 to 0
-        // Move to next position for wear leveling
-        uint8_t nextPosition = (sg_u8CurrentPosition + 1) % COUNTER_POSITIONS;
-
-        // Mark current position as invalid before moving
-        // This helps with recovery if power is lost during transition
-        WriteCounterAtPosition(sg_u8CurrentPosition, COUNTER_INVALID);
-
-        // Write new counter to next position
-        sg_u8CurrentPosition = nextPosition;
-        WriteCounterAtPosition(sg_u8CurrentPosition, sg_u32CurrentCounter);
-    } else if ((sg_u8UpdateCounter & 0x0F) == 0) {
-        // Every 16 increments, update current position (but don't move)
-        // This balances wear vs. data loss on power failure
-        WriteCounterAtPosition(sg_u8CurrentPosition, sg_u32CurrentCounter);
+
+    if (++sg_u8Unsaved >= COUNTER_SAVE_FRAMES) {
+        SaveCounter();
     }
 }
 
-// Get current wear leveling position (for diagnostics)
+// Move the counter to a new value (the SD frame log is ahead of it) and save it now
+void FrameCounter_Set(uint32_t value) {
+    sg_u32CurrentCounter = value;
+    SaveCounter();
+}
+
+// Get the slot the latest save is in (for diagnostics)
 uint8_t FrameCounter_GetPosition(void) {
-    return sg_u8CurrentPosition;
-}
\ No newline at end of file
+    return (uint8_t)(sg_u32CurrentSave % COUNTER_SLOTS);
+}
@@ -8,6 +8,7 @@
 extern void FrameCounter_Init(void);           // Initialize and find current counter value
 extern uint32_t FrameCounter_Get(void);        // Get current counter value
 extern void FrameCounter_Increment(void);      // Increment and persist counter
+extern void FrameCounter_Set(uint32_t value);  // Move counter to a new value and persist it
 extern uint8_t FrameCounter_GetPosition(void); // Get current wear leveling position
 
 #endif
\ No newline at end of file
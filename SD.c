@@ -515,7 +515,28 @@ static bool SDReceiveDataBlock(uint8_t *pu8Buffer,
 	return(true);			   
 }
 
-// Transmits a datablock during the data phase which may take some time
+// Waits for the card to finish programming - it holds MISO low while it's busy
+static bool SDWaitNotBusy(void)
+{
+	uint8_t u8Response;
+	uint16_t u16Attempts = 0;
+
+	while (u16Attempts < SD_MAX_WRITE_ATTEMPTS)
+	{
+		SPIRead(&u8Response,
+				sizeof(u8Response));
+		if (u8Response)
+		{
+			return(true);
+		}
+
+		++u16Attempts;
+	}
+
+	return(false);
+}
+
+// Transmits a single sector during the data phase which may take some time
 static bool SDTransmitDataBlock(uint8_t *pu8Buffer,
 							    uint16_t u16TXCount,
 								uint8_t u8DataPhaseToken)
@@ -524,81 +545,413 @@ static bool SDTransmitDataBlock(uint8_t *pu8Buffer,
 	uint16_t u16Attempts;
 	bool bResult = true;
 
-	// Send the data phase token (whatever it is)
+	// Send the data phase token
 	SPIWrite(&u8DataPhaseToken,
 			 sizeof(u8DataPhaseToken));
 	
-	if (u8DataPhaseToken != SD_STOP_TRANSACTION)
+	SPIWrite(pu8Buffer,
+			 u16TXCount);
+			 
+	// Wait for acceptance of the sector
+	u16Attempts = 0;
+	while (u16Attempts < SD_MAX_WRITE_ATTEMPTS)
 	{
-		// As long as we're not stopping a transaction, we're writing data
-		SPIWrite(pu8Buffer,
-				 u16TXCount);
-				 
-		// Wait for acceptance of the sector
-		u16Attempts = 0;
-		while (u16Attempts < SD_MAX_WRITE_ATTEMPTS)
+		// Get some data
+		SPIRead(&u8Response,
+				sizeof(u8Response));
+		if (u8Response != 0xff)
 		{
-			// Get some data
-			SPIRead(&u8Response,
-					sizeof(u8Response));
-			if (u8Response != 0xff)
+			break;
+		}
+			
+		++u16Attempts;
+	}
+		
+	// We've timed out or else the card is dead
+	if (SD_MAX_WRITE_ATTEMPTS == u16Attempts)
+	{
+		bResult = false;
+		goto errorExit;
+	}
+		
+	// See if the data was accepted
+	u8Response &= 0x1f;
+	if (0x05 == u8Response)
+	{
+		// Wait for the write to finish
+		bResult = SDWaitNotBusy();
+	}
+	else
+	{
+		// Sector not accepted
+		bResult = false;
+	}
+	
+errorExit:
+	return(bResult);
+}
+
+#define CMD17                   17
+#define CMD17_CRC               0x00
+
+#define CMD18					18
+#define CMD12					12
+
+#define CMD24               24
+#define CMD25				25
+#define ACMD23				(0x80 | 23)		// SET_WR_BLK_ERASE_COUNT - pre-erase for the next CMD25
+
+// Multisector writes are run by a state machine, a slice at a time, so a card that's slow
+// to take the data in doesn't hold up the caller. SDWriteStep() does at most
+// SD_WRITE_STEP_BYTES of data, or SD_WRITE_STEP_POLLS bytes of waiting on the card, then
+// returns. Chip select stays asserted from one step to the next until the write is done.
+#define SD_WRITE_STEP_BYTES			64
+#define SD_WRITE_STEP_POLLS			8
+
+typedef enum
+{
+	ESDWRITE_IDLE,				// Nothing to do - a burst may still be left open
+	ESDWRITE_START,				// ACMD23/CMD25, unless there's an open write to end or carry on
+	ESDWRITE_DATA,				// Data token, then the sector a slice at a time
+	ESDWRITE_RESPONSE,			// Waiting for the sector's data response
+	ESDWRITE_BUSY,				// Card taking the sector in
+	ESDWRITE_STOP,				// Stop token
+	ESDWRITE_STOP_BUSY,			// Card programming everything it's been sent
+} ESDWriteState;
+
+static ESDWriteState sg_eSDWriteState = ESDWRITE_IDLE;
+
+// Multisector write left open (a burst, or one in progress), and the sector it'll write next
+static bool sg_bSDWriteOpen = false;
+static uint32_t sg_u32SDWriteSector;
+
+// The write being run
+static uint32_t sg_u32SDWriteStart;		// First sector
+static uint8_t *sg_pu8SDWriteBuffer;	// Next sector's data
+static uint32_t sg_u32SDWriteCount;		// Sectors still to send
+static uint32_t sg_u32SDWriteGroup;		// Burst size in sectors, or 0 to end the write after it
+static uint16_t sg_u16SDWriteByte;		// Next byte of the sector
+static uint16_t sg_u16SDWriteAttempts;	// Bytes spent waiting on the card
+static bool sg_bSDWriteResult = true;
+static void (*sg_pfSDWriteComplete)(bool bResult);
+
+// Gives up on the write - the card isn't taking it. Whatever's open still gets a stop token.
+static void SDWriteFail(void)
+{
+	sg_bSDWriteResult = false;
+	sg_u32SDWriteCount = 0;
+	sg_eSDWriteState = ESDWRITE_STOP;
+}
+
+// Polls up to SD_WRITE_STEP_POLLS bytes while the card holds MISO low. Returns true once
+// it lets go, or once it's been too long (sg_bSDWriteResult goes false).
+static bool SDWriteBusyPoll(void)
+{
+	uint8_t u8Response;
+	uint8_t u8Count = SD_WRITE_STEP_POLLS;
+
+	do
+	{
+		SPIRead(&u8Response,
+				sizeof(u8Response));
+		if (u8Response)
+		{
+			return(true);
+		}
+	}
+	while ((++sg_u16SDWriteAttempts < SD_MAX_WRITE_ATTEMPTS) &&
+		   (--u8Count));
+
+	if (SD_MAX_WRITE_ATTEMPTS == sg_u16SDWriteAttempts)
+	{
+		sg_bSDWriteResult = false;
+		return(true);
+	}
+
+	return(false);
+}
+
+// Write finished - let the card go and tell whoever asked for it
+static void SDWriteEnd(void)
+{
+	void (*pfComplete)(bool bResult) = sg_pfSDWriteComplete;
+
+	sg_eSDWriteState = ESDWRITE_IDLE;
+	sg_pfSDWriteComplete = NULL;
+	SDSetCS(false);
+
+	if (pfComplete)
+	{
+		pfComplete(sg_bSDWriteResult);
+	}
+}
+
+// Moves the write in progress along by one slice. Returns true if there's more to do.
+bool SDWriteStep(void)
+{
+	uint8_t u8Response;
+	uint16_t u16Bytes;
+
+	if (ESDWRITE_IDLE == sg_eSDWriteState)
+	{
+		return(false);
+	}
+
+	// Assert chip select
+	SDSetCS(true);
+
+	switch (sg_eSDWriteState)
+	{
+		case ESDWRITE_START:
+		{
+			if (sg_bSDWriteOpen)
 			{
+				if ((0 == sg_u32SDWriteGroup) ||
+					(sg_u32SDWriteSector != sg_u32SDWriteStart))
+				{
+					// Doesn't carry on from the open write - that has to end first
+					sg_eSDWriteState = ESDWRITE_STOP;
+				}
+				else
+				{
+					sg_u16SDWriteByte = 0;
+					sg_eSDWriteState = ESDWRITE_DATA;
+				}
 				break;
 			}
-				
-			++u16Attempts;
+
+			// Pre-erase to the end of the burst, or just what's being written. It's only
+			// a hint - a card that doesn't take it still does the write.
+			(void) SDCommand(ACMD23,
+							 sg_u32SDWriteGroup ? (sg_u32SDWriteGroup - (sg_u32SDWriteStart % sg_u32SDWriteGroup)) : sg_u32SDWriteCount);
+
+			if (0 == SDCommand(CMD25,
+							   sg_u32SDWriteStart))
+			{
+				// At least a byte between the response and the first data token
+				SPIWritePattern(0xff,
+								1);
+
+				sg_bSDWriteOpen = true;
+				sg_u32SDWriteSector = sg_u32SDWriteStart;
+				sg_u16SDWriteByte = 0;
+				sg_eSDWriteState = ESDWRITE_DATA;
+			}
+			else
+			{
+				// Failed
+				sg_bSDWriteResult = false;
+				SDWriteEnd();
+			}
+			break;
 		}
-			
-		// We've timed out or else the card is dead
-		if (SD_MAX_WRITE_ATTEMPTS == u16Attempts)
+
+		case ESDWRITE_DATA:
 		{
-			bResult = false;
-			goto errorExit;
+			if (0 == sg_u16SDWriteByte)
+			{
+				u8Response = SD_START_MULTI_TOKEN;
+				SPIWrite(&u8Response,
+						 sizeof(u8Response));
+			}
+
+			u16Bytes = sg_u16BlockSize - sg_u16SDWriteByte;
+			if (u16Bytes > SD_WRITE_STEP_BYTES)
+			{
+				u16Bytes = SD_WRITE_STEP_BYTES;
+			}
+
+			SPIWrite(sg_pu8SDWriteBuffer + sg_u16SDWriteByte,
+					 u16Bytes);
+			sg_u16SDWriteByte += u16Bytes;
+
+			if (sg_u16SDWriteByte >= sg_u16BlockSize)
+			{
+				// The CRC goes out while we wait for the data response
+				sg_u16SDWriteAttempts = 0;
+				sg_eSDWriteState = ESDWRITE_RESPONSE;
+			}
+			break;
 		}
-			
-		// See if the data was accepted
-		u8Response &= 0x1f;
-		if (0x05 == u8Response)
+
+		case ESDWRITE_RESPONSE:
 		{
-			// Wait for the write to finish
-			u16Attempts = 0;
-			while (u16Attempts < SD_MAX_WRITE_ATTEMPTS)
+			uint8_t u8Count = SD_WRITE_STEP_POLLS;
+
+			do
 			{
-				// Wait for the card to accept writing the sector
 				SPIRead(&u8Response,
 						sizeof(u8Response));
-				if (u8Response)
+			}
+			while ((0xff == u8Response) &&
+				   (++sg_u16SDWriteAttempts < SD_MAX_WRITE_ATTEMPTS) &&
+				   (--u8Count));
+
+			if (0xff == u8Response)
+			{
+				// Still waiting, unless we've timed out or else the card is dead
+				if (SD_MAX_WRITE_ATTEMPTS == sg_u16SDWriteAttempts)
 				{
-					break;
+					SDWriteFail();
 				}
-					
-				++u16Attempts;
 			}
-				
-			if (SD_MAX_WRITE_ATTEMPTS == u16Attempts)
+			else
+			if (0x05 == (u8Response & 0x1f))
 			{
-				bResult = false;
-				goto errorExit;
+				// Accepted - now it takes it in
+				sg_u16SDWriteAttempts = 0;
+				sg_eSDWriteState = ESDWRITE_BUSY;
 			}
-			
-			// Success!
+			else
+			{
+				// Sector not accepted
+				SDWriteFail();
+			}
+			break;
 		}
-		else
+
+		case ESDWRITE_BUSY:
 		{
-			// Sector not accepted
-			bResult = false;
+			if (false == SDWriteBusyPoll())
+			{
+				break;
+			}
+
+			if (false == sg_bSDWriteResult)
+			{
+				SDWriteFail();
+				break;
+			}
+
+			// Pet the watchdog
+			WatchdogReset();
+
+			sg_pu8SDWriteBuffer += sg_u16BlockSize;
+			sg_u32SDWriteSector++;
+			sg_u32SDWriteCount--;
+
+			if (sg_u32SDWriteCount)
+			{
+				sg_u16SDWriteByte = 0;
+				sg_eSDWriteState = ESDWRITE_DATA;
+			}
+			else
+			if ((0 == sg_u32SDWriteGroup) ||
+				(0 == (sg_u32SDWriteSector % sg_u32SDWriteGroup)))
+			{
+				// End of the write, or the end of the burst
+				sg_eSDWriteState = ESDWRITE_STOP;
+			}
+			else
+			{
+				// Burst stays open for the next one
+				SDWriteEnd();
+			}
+			break;
+		}
+
+		case ESDWRITE_STOP:
+		{
+			// The stop token, not CMD12 - that's for reads. There's a byte before the card
+			// goes busy, then it's busy until everything it's been sent is programmed.
+			u8Response = SD_STOP_TRANSACTION;
+			SPIWrite(&u8Response,
+					 sizeof(u8Response));
+			SPIRead(&u8Response,
+					sizeof(u8Response));
+
+			sg_bSDWriteOpen = false;
+			sg_u16SDWriteAttempts = 0;
+			sg_eSDWriteState = ESDWRITE_STOP_BUSY;
+			break;
+		}
+
+		case ESDWRITE_STOP_BUSY:
+		{
+			if (SDWriteBusyPoll())
+			{
+				if ((sg_bSDWriteResult) &&
+					(sg_u32SDWriteCount))
+				{
+					// That was an open write ending before this one starts
+					sg_eSDWriteState = ESDWRITE_START;
+				}
+				else
+				{
+					SDWriteEnd();
+				}
+			}
+			break;
+		}
+
+		default:
+		{
+			SDWriteEnd();
+			break;
 		}
 	}
-	
-errorExit:
-	return(bResult);
+
+	return(sg_eSDWriteState != ESDWRITE_IDLE);
 }
 
-#define CMD17                   17
-#define CMD17_CRC               0x00
+// Runs the write in progress (if any) to the end. Returns how it went.
+bool SDWriteWait(void)
+{
+	while (SDWriteStep())
+	{
+		// Pet the watchdog
+		WatchdogReset();
+	}
 
-#define CMD18					18
-#define CMD12					12
+	return(sg_bSDWriteResult);
+}
+
+// Starts writing u32SectorCount sectors from pu8Buffer, which has to stay put until it's
+// done. SDWriteStep() does the work and pfComplete (if not NULL) is called at the end.
+// With u32GroupSectors at 0 it's one pre-erased multisector write. Otherwise the write
+// is kept open from one call to the next: sectors are grouped in aligned groups of
+// u32GroupSectors, and each write is pre-erased to the end of its group. It's ended at the
+// end of a group, or when the next call doesn't carry on from where the last one finished.
+// It's also ended by SDRead(), SDWrite() or SDWriteFlush(). Until then the card may not
+// have programmed all of it. A write still in progress is finished first.
+void SDWriteAsync(uint32_t u32Sector,
+				  uint8_t *pu8Buffer,
+				  uint32_t u32SectorCount,
+				  uint32_t u32GroupSectors,
+				  void (*pfComplete)(bool bResult))
+{
+	(void) SDWriteWait();
+
+	// Pet the watchdog
+	WatchdogReset();
+
+	sg_u32SDWriteStart = u32Sector;
+	sg_pu8SDWriteBuffer = pu8Buffer;
+	sg_u32SDWriteCount = u32SectorCount;
+	sg_u32SDWriteGroup = u32GroupSectors;
+	sg_pfSDWriteComplete = pfComplete;
+	sg_bSDWriteResult = true;
+	sg_eSDWriteState = ESDWRITE_START;
+}
+
+// Finishes the write in progress, then ends the open write if there is one. Returns once
+// the card has programmed everything it was sent.
+static bool SDWriteStop(void)
+{
+	(void) SDWriteWait();
+
+	if (false == sg_bSDWriteOpen)
+	{
+		return(true);
+	}
+
+	sg_u32SDWriteCount = 0;
+	sg_pfSDWriteComplete = NULL;
+	sg_bSDWriteResult = true;
+	sg_eSDWriteState = ESDWRITE_STOP;
+
+	return(SDWriteWait());
+}
 
 // Read one or more sectors from SD
 bool SDRead(uint32_t u32Sector,
@@ -607,6 +960,9 @@ bool SDRead(uint32_t u32Sector,
 {
 	bool bResult = false;
 	
+	// The card can't do anything else until an open write is finished
+	(void) SDWriteStop();
+
 	// Pet the watchdog
 	WatchdogReset();
 		
@@ -642,7 +998,7 @@ bool SDRead(uint32_t u32Sector,
 				pu8Buffer += sg_u16BlockSize;
 			} 
 			while ((bResult) &&
-				   (u32SectorCount--));
+				   (--u32SectorCount));
 				   
 			// Regardless, send a stop command
 			(void) SDCommand(CMD12,
@@ -659,9 +1015,6 @@ bool SDRead(uint32_t u32Sector,
 	return(bResult);
 }
 
-#define CMD24               24
-#define CMD25				25
-
 // Write one or more sectors to SD
 bool SDWrite(uint32_t u32Sector,
 			 uint8_t *pu8Buffer,
@@ -669,14 +1022,17 @@ bool SDWrite(uint32_t u32Sector,
 {
 	bool bResult = false;
 	
-	// Pet the watchdog
-	WatchdogReset();
-	
-	// Assert chip select
-	SDSetCS(true);
+	// Finish off any open write first
+	(void) SDWriteStop();
 
  	if (1 == u32SectorCount)
 	{
+		// Pet the watchdog
+		WatchdogReset();
+	
+		// Assert chip select
+		SDSetCS(true);
+
 		// Single sector
 		if (0 == SDCommand(CMD24,
 						   u32Sector))
@@ -689,38 +1045,26 @@ bool SDWrite(uint32_t u32Sector,
 		{
 			// Failed
 		}
+
+		SDSetCS(false);
 	}
 	else
 	{
-		// Multisector
-		if (0 == SDCommand(CMD25,
-						   u32Sector))
-		{
-			do
-			{
-				bResult = SDTransmitDataBlock(pu8Buffer,
-											  sg_u16BlockSize,
-											  SD_START_MULTI_TOKEN);
-											  
-				// Pet the watchdog
-				WatchdogReset();
-				
-				pu8Buffer += sg_u16BlockSize;
-			}
-			while ((bResult) &&
-				   (u32SectorCount--));
-			
-			// Regardless, send a stop command
-			(void) SDCommand(CMD12,
-							 0);
-		}
-		else
-		{
-			// Failed
-		}
+		// Multisector, pre-erased, as one transaction
+		SDWriteAsync(u32Sector,
+					 pu8Buffer,
+					 u32SectorCount,
+					 0,
+					 NULL);
+		bResult = SDWriteWait();
 	}
-	
-	SDSetCS(false);
 
 	return(bResult);
 }
+
+// Finishes any write in progress and ends a burst left open, returning once it's all
+// programmed
+bool SDWriteFlush(void)
+{
+	return(SDWriteStop());
+}
@@ -8,6 +8,14 @@ extern bool SDRead(uint32_t u32Sector,
 extern bool SDWrite(uint32_t u32Sector,
 					uint8_t *pu8Buffer,
 					uint32_t u32SectorCount);
+extern void SDWriteAsync(uint32_t u32Sector,
+						 uint8_t *pu8Buffer,
+						 uint32_t u32SectorCount,
+						 uint32_t u32GroupSectors,
+						 void (*pfComplete)(bool bResult));
+extern bool SDWriteStep(void);
+extern bool SDWriteWait(void);
+extern bool SDWriteFlush(void);
 extern bool SDGetSectorCount(uint32_t *pu32SectorCount);
 extern bool SDGetBlockSize(uint32_t *pu32BlockSize);
 
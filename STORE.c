@@ -1,215 +1,641 @@
 #include "STORE.h"
 #include "SD.h"
+#include "main.h"
+#include "FRAMECOUNTER.h"
+#include "framelog.h"
+#include "sessionlog.h"
 #include <string.h>
 
-static GlobalState gState;
-static uint32_t currentSector;
+// Uncomment to keep the SD write open from one frame to the next, in aligned bursts of
+// this many frames (power of 2), pre-erased to the end of the burst. Frames in a burst
+// that hasn't ended may not be on the card yet (see SD_FRAME_WRITES.md).
+//#define STORE_WRITE_BURST_FRAMES 8
+
+// Bytes of a frame's CRC worked out per STORE_Process() call, before its SD write starts.
+// Checking a frame read back, or scrubbing one, goes at the same rate.
+#define STORE_CRC_STEP_BYTES 64
+
+// Session records kept in RAM (power of 2) - the latest sessions, and whatever was last
+// asked for
+#define STORE_SESSION_CACHE 4
+
+// Frames carry their own header for the SD frame log (framelog.h)
+STATIC_ASSERT(offsetof(FrameMetadata, validSig) == FRAMELOG_OFFSET_SIG, framelog_sig_offset);
+STATIC_ASSERT(offsetof(FrameMetadata, frameBytes) == FRAMELOG_OFFSET_FRAMEBYTES, framelog_framebytes_offset);
+STATIC_ASSERT(offsetof(FrameMetadata, frameCounter) == FRAMELOG_OFFSET_COUNTER, framelog_counter_offset);
+STATIC_ASSERT(offsetof(FrameMetadata, frameCrc) == FRAMELOG_OFFSET_CRC, framelog_crc_offset);
+STATIC_ASSERT(FRAME_VALID_SIG == FRAMELOG_SIG, framelog_sig);
+STATIC_ASSERT((FRAME_BUFFER_SIZE == FRAMELOG_FRAME_BYTES) && (SECTOR_SIZE == FRAMELOG_HEADER_BYTES), framelog_sizes);
+STATIC_ASSERT(offsetof(SSessionRecord, u32Crc) == SESSIONLOG_RECORD_CRC_BYTES, sessionlog_crc_offset);
+STATIC_ASSERT(SECTOR_SIZE == SESSIONLOG_SECTOR_BYTES, sessionlog_sector);
+
 static uint8_t __attribute__((aligned(4))) frameBuffer[FRAME_BUFFER_SIZE];  // Frame data for CAN transfer - DO NOT REUSE
-static uint8_t __attribute__((aligned(4))) sectorBuffer[SECTOR_SIZE];  // Temporary buffer for global state/session map operations
+static uint8_t __attribute__((aligned(4))) sectorBuffer[SECTOR_SIZE];  // Temporary buffer for global state/session map operations, frame prefetch
+static uint32_t prefetchCounter;  // Frame whose first sector is in sectorBuffer
+static bool prefetchValid = false;
+static bool writePending = false;  // Frame in frameBuffer is on its way to the SD card
+static bool writeFailed = false;  // A frame or session record didn't make it to the card - the next STORE_WriteFrame() says so
+static uint32_t writeSector;  // Where it's going
+static uint16_t writeCrcByte;  // How far its CRC has got - FRAME_BUFFER_SIZE once the SD write's started
+static uint32_t writeCrc;
+static uint16_t checkCrcByte;  // How far the CRC of the frame read into frameBuffer has got
+static uint32_t checkCrc;
+static SFrameLogScrub scrub;  // Frame being scrubbed - sectorBuffer holds its sector if scrub.bSectorRead
+static uint32_t scrubRemaining;  // Frames left to scrub, that one included
+static uint32_t frameSlots;  // Frames the card holds - it's a ring of them, 0 if there's no card
+static uint32_t indexSector;  // Session index (sessionlog.h), after the frames
+static uint32_t sessionSlots;  // Sessions it holds, 0 if there's no index
+static uint32_t sessionNext;  // Number the next session gets
+static bool sessionOpen;  // Session sessionNext - 1 is under way
+static SSessionRecord sessionCache[STORE_SESSION_CACHE];  // Session N in [N % STORE_SESSION_CACHE]
+static bool sessionStartPending;  // A session opens once the frame write in progress is done
+static uint64_t sessionStartTime;
+static bool sessionEndPending;  // The open session closes once the frame write in progress is done
+static SSessionRecord sessionEndSummary;  // Its summary, from the frame STORE_EndSession() had
+static bool sessionEndFirst;  // STORE_EndSession() was called before STORE_StartNewSession()
+
+// Where frame counter N lives on the card
+static uint32_t frameSector(uint32_t frameCounter) {
+	return (frameCounter % frameSlots) * SECTORS_PER_FRAME;
+}
 
-static bool readGlobalState(void) {
-	// Global state now tracked in EEPROM (frame counter, etc.)
-	// SD card no longer used for global state
-	// Nothing to read here - EEPROM reads happen in specific modules
-	return true;
+// sectorBuffer is about to be used for something else - a prefetched frame sector or
+// the sector being scrubbed has to be read again
+static void sectorBufferTake(void) {
+	prefetchValid = false;
+	scrub.bSectorRead = false;
 }
 
-static bool writeGlobalState(void) {
-	// Global state now tracked in EEPROM (frame counter, etc.)
-	// SD card no longer used for global state
-	// TODO: Save key metrics to EEPROM here if needed
-	return true;
+// One slice of the CRC of the frame in frameBuffer, from byte crcByte. Returns how far it's got.
+static uint16_t frameCrcStep(uint32_t* crc, uint16_t crcByte) {
+	uint16_t end = crcByte + STORE_CRC_STEP_BYTES;
+
+	if (end > FRAME_BUFFER_SIZE) {
+		end = FRAME_BUFFER_SIZE;
+	}
+	*crc = FrameLog_CrcUpdate(*crc, frameBuffer, crcByte, end);
+	return end;
 }
 
-static bool updateSessionMap(void) {
+// FrameLog_FindHead() reads slots into frameBuffer through this
+static bool storeReadSlot(uint32_t slot, uint8_t* frame, bool whole) {
+	return SDRead(slot * SECTORS_PER_FRAME, frame, whole ? SECTORS_PER_FRAME : 1);
+}
 
-	// Global state now tracked in EEPROM (frame counter, etc.)
-	// SD card no longer used for global state
-	// TODO: Save key metrics to EEPROM here if needed
-	return true;
+// FrameLog_ScrubStep() reads frame sectors into sectorBuffer through this
+static bool storeReadFrameSector(uint32_t slot, uint8_t sector, uint8_t* buffer) {
+	bool result;
+
+	SetSDBusy(true);
+	result = SDRead((slot * SECTORS_PER_FRAME) + sector, buffer, 1);
+	SetSDBusy(false);
 
-/*	
-	uint32_t mapSector = gState.activeSessionMapSector;
-	uint32_t mapOffset = gState.activeSessionMapOffset;
+	return result;
+}
 
-	if (!SDRead(mapSector, sectorBuffer, 1)) {
-		return false;
-	}
+// SessionLog_FindHead() reads index slots into sectorBuffer through this
+static bool storeReadSession(uint32_t slot, uint8_t* sector, bool whole) {
+	(void) whole;
+	return SDRead(indexSector + slot, sector, 1);
+}
 
-	// Update session map
-	*(uint64_t*)(sectorBuffer + mapOffset) = gState.newSessionSector;
+// The record for a session, if it's in RAM
+static SSessionRecord* sessionCacheGet(uint32_t session) {
+	SSessionRecord* cached = &sessionCache[session % STORE_SESSION_CACHE];
 
-	if (!SDWrite(mapSector, sectorBuffer, 1)) {
-		return false;
+	if ((SESSIONLOG_SIG != cached->u16Sig) || (cached->u32Session != session)) {
+		return NULL;
 	}
+	return cached;
+}
+
+// Keeps a record in RAM. The open session's record always stays.
+static void sessionCachePut(const SSessionRecord* record) {
+	SSessionRecord* cached = &sessionCache[record->u32Session % STORE_SESSION_CACHE];
 
-	// Update map pointers
-	gState.activeSessionMapOffset += sizeof(uint64_t);
-	if (gState.activeSessionMapOffset >= SECTOR_SIZE) {
-		gState.activeSessionMapSector++;
-		gState.activeSessionMapOffset = 0;
+	if ((cached == record) || (sessionOpen && (cached == sessionCacheGet(sessionNext - 1)))) {
+		return;
 	}
+	memcpy(cached, record, sizeof(*cached));
+}
+
+// Seals a session's record and writes it to its index slot - one sector, nothing read first
+static bool sessionWrite(SSessionRecord* record) {
+	bool result;
 
-	return writeGlobalState();
-	*/
+	SessionLog_Seal(record);
+	sessionCachePut(record);
+
+	// Out of the way of any prefetched or scrubbed frame sector
+	sectorBufferTake();
+	memset(sectorBuffer, 0, sizeof(sectorBuffer));
+	memcpy(sectorBuffer, record, sizeof(*record));
+
+	SetSDBusy(true);
+	result = SDWrite(indexSector + (record->u32Session % sessionSlots), sectorBuffer, 1);
+	SetSDBusy(false);
+
+	return result;
 }
 
-bool STORE_Init(void) {
+bool STORE_Init(bool sessionResume) {
+	uint32_t sectors;
+	uint32_t next;
+	uint32_t head;
+
+	// Frame counter as EEPROM has it - it's only saved every so many frames, so the log
+	// on the card can be ahead of it
+	FrameCounter_Init();
+
+	frameSlots = 0;
+	sessionSlots = 0;
+	sessionNext = 0;
+	sessionOpen = false;
+	writePending = false;
+	writeFailed = false;
+	sessionStartPending = false;
+	sessionEndPending = false;
+	sectorBufferTake();
+	scrubRemaining = 0;
+	memset(sessionCache, 0, sizeof(sessionCache));
+
 	if (!SDInit()) {
 		return false;
 	}
-	// Global state now tracked in EEPROM (frame counter, etc.)
-	// SD card no longer used for global state
-	// TODO: Save key metrics to EEPROM here if needed
+	if (!SDGetSectorCount(&sectors)) {
+		return false;
+	}
+
+	// Frames from sector 0, the session index in the last sectors
+	SessionLog_Layout(sectors, &frameSlots, &indexSector, &sessionSlots);
+	if (!frameSlots) {
+		return false;
+	}
+
+	// Carry on from the head of the log, so nothing on the card is written over. The
+	// counter never goes back on what EEPROM has, even for a card with older frames on it.
+	if (FrameLog_FindHead(frameSlots, FrameCounter_Get(), storeReadSlot, frameBuffer, &next) &&
+		(next > FrameCounter_Get())) {
+		FrameCounter_Set(next);
+	}
+	// Nothing's been written yet this time round
+	memset(frameBuffer, 0, sizeof(frameBuffer));
+
+	// Sessions carry on from the last one in the index
+	if (sessionSlots && SessionLog_FindHead(sessionSlots, storeReadSession, sectorBuffer, &head)) {
+		SSessionRecord* record = &sessionCache[head % STORE_SESSION_CACHE];
+
+		memcpy(record, sectorBuffer, sizeof(*record));
+		sessionNext = head + 1;
+
+		if (record->u8Flags & SESSIONLOG_FLAG_OPEN) {
+			if (sessionResume) {
+				// A watchdog reset part way through - the session carries on
+				sessionOpen = true;
+			} else {
+				// It was never closed, so it ends where its frames do
+				record->u8Flags = (record->u8Flags & (uint8_t) ~SESSIONLOG_FLAG_OPEN) | SESSIONLOG_FLAG_CUT_SHORT;
+				record->u32EndFrame = FrameCounter_Get();
+				if (!sessionWrite(record)) {
+					return false;
+				}
+			}
+		}
+	}
+
 	return true;
-/*
-	if (!readGlobalState()) {
-		// Initialize global state if it doesn't exist
-		memset(&gState, 0, sizeof(GlobalState));
-		gState.firstSessionSector = 1;
-		gState.newSessionSector = 1;
-		gState.activeSessionMapSector = 4;
-		gState.activeSessionMapOffset = 0;
-		// TODO: Initialize other fields as needed
-		if (!writeGlobalState()) {
-			return false;
+}
+
+// A frame write in progress has finished - it's on the card (or in the open burst) if written
+static void storeWriteComplete(bool written) {
+	writePending = false;
+	if (!written) {
+		writeFailed = true;
+	}
+	FrameWriteCallback(written);
+}
+
+// One slice of the frame write in progress. The CRC goes in the frame's header, so
+// that's worked out first, a slice at a time too. Then the SD write gets a step.
+static void storeWriteStep(void) {
+	if (writeCrcByte < FRAME_BUFFER_SIZE) {
+		writeCrcByte = frameCrcStep(&writeCrc, writeCrcByte);
+
+		if (writeCrcByte < FRAME_BUFFER_SIZE) {
+			return;
 		}
+
+		// All sectors in one multisector write, so the card only goes busy programming once
+		((FrameData*)frameBuffer)->m.frameCrc = writeCrc;
+#ifdef STORE_WRITE_BURST_FRAMES
+		SDWriteAsync(writeSector, frameBuffer, SECTORS_PER_FRAME, STORE_WRITE_BURST_FRAMES * SECTORS_PER_FRAME, storeWriteComplete);
+#else
+		SDWriteAsync(writeSector, frameBuffer, SECTORS_PER_FRAME, 0, storeWriteComplete);
+#endif
+		return;
+	}
+
+	SetSDBusy(true);
+	(void) SDWriteStep();
+	SetSDBusy(false);
+}
+
+// Gets the frame write in progress (if any) as far as having its CRC in frameBuffer
+static void storeCrcFinish(void) {
+	while (writePending && (writeCrcByte < FRAME_BUFFER_SIZE)) {
+		storeWriteStep();
+	}
+}
+
+// Opens the next session now - its record goes in the index straight away, marked open,
+// so a reset can't lose it
+static bool sessionStart(uint64_t startTime) {
+	SSessionRecord record;
+
+	if (sessionOpen || !sessionSlots) {
+		return true;
+	}
+
+	memset(&record, 0, sizeof(record));
+	record.u8Flags = SESSIONLOG_FLAG_OPEN;
+	record.u32Session = sessionNext;
+	record.u32StartFrame = FrameCounter_Get();
+	record.u32EndFrame = record.u32StartFrame;
+	record.u64StartTime = startTime;
+
+	if (!sessionWrite(&record)) {
+		return false;
 	}
 
-	currentSector = gState.newSessionSector;
+	sessionNext++;
+	sessionOpen = true;
 	return true;
-*/
 }
 
-bool STORE_WriteFrame(volatile FrameData* frame, bool bSDCardReady, bool bSDWriteEnabled) {
-	uint32_t currentOffset = 0;
-	uint32_t sectorsToWrite;
+// Closes the open session now, with sessionEndSummary as its summary. The session's
+// record is written over, closed, in the same index slot.
+static bool sessionEnd(void) {
+	SSessionRecord* record;
 
+	// Make sure the last frames are on the card
+	if (!STORE_Flush()) {
+		return false;
+	}
+
+	if (!sessionOpen) {
+		return true;
+	}
+
+	// The open session's record is always in RAM (sessionCachePut())
+	record = sessionCacheGet(sessionNext - 1);
+	sessionOpen = false;
+	if (NULL == record) {
+		return false;
+	}
+
+	record->u8Flags &= (uint8_t) ~SESSIONLOG_FLAG_OPEN;
+	record->u32EndFrame = FrameCounter_Get();
+	record->u16MaxCurrent = sessionEndSummary.u16MaxCurrent;
+	record->u16MinCurrent = sessionEndSummary.u16MinCurrent;
+	record->u8WDTCount = sessionEndSummary.u8WDTCount;
+	record->u8CellCount = sessionEndSummary.u8CellCount;
+
+	return sessionWrite(record);
+}
+
+bool STORE_WriteBusy(void) {
+	return writePending || sessionStartPending || sessionEndPending;
+}
+
+// Copies the frame to frameBuffer and starts writing it to the SD card. The write is
+// done a slice at a time by STORE_Process(), and FrameWriteCallback() says how it went.
+// Only call it once STORE_WriteBusy() is false - frameBuffer can't change until then.
+// Returns false if the last write before it didn't make it to the card, in which case
+// this one isn't written either.
+bool STORE_WriteFrame(volatile FrameData* frame, bool bSDCardReady, bool bSDWriteEnabled) {
 	// Verify frame size
 	if(frame->m.frameBytes > FRAME_BUFFER_SIZE) {
 		return false;
 	}
 
+	// The last frame is still on its way out of frameBuffer
+	if (STORE_WriteBusy()) {
+		return true;
+	}
+
+	bool lastWritten = !writeFailed;
+	writeFailed = false;
+
 	// ALWAYS copy frame data to frameBuffer (needed for CAN frame transfer)
 	// This ensures frameBuffer contains complete frame regardless of SD write status
 	memcpy(frameBuffer, (const void*)frame, FRAME_BUFFER_SIZE);
 
+	// SD contents are about to change under any prefetched sector
+	prefetchValid = false;
+
+	// The frame being scrubbed may be the one about to be written over. Starting it again
+	// finds it gone.
+	if (scrubRemaining && frameSlots &&
+		(frameSector(scrub.u32Counter) == frameSector(frame->m.frameCounter))) {
+		FrameLog_ScrubStart(&scrub, scrub.u32Counter);
+	}
+
+	if (!lastWritten) {
+		return false;  // SD write failed
+	}
+
 	// Only write to SD card if flags permit
 	if (!bSDCardReady || !bSDWriteEnabled) {
 		return true;  // Frame copied to buffer, SD write skipped
 	}
 
-	// Set SD busy flag to prevent state transitions during SD write
-	SetSDBusy(true);
+	if (!frameSlots) {
+		return false;  // STORE_Init() never found a card
+	}
+
+	// Frame counter maps to its slot in the log, as STORE_ReadFrameByCounter() reads it.
+	// Finishing the last frame has already moved the counter on.
+	writeSector = frameSector(frame->m.frameCounter);
+	writeCrcByte = 0;
+	writeCrc = 0;
+	writePending = true;
+
+	return true;  // Frame copied, SD write under way
+}
 
-	// Calculate how many complete sectors we need to write
-	sectorsToWrite = SECTORS_PER_FRAME;
+// Moves a frame write along by one slice - call from the main loop. The SD busy flag is
+// only up while SPI traffic is going, so state transitions can happen between slices.
+// Once it's done, a session that was waiting on it opens or closes.
+void STORE_Process(void) {
+	if (writePending) {
+		storeWriteStep();
+		return;
+	}
 
-	// Write all sectors to SD card
-	while(sectorsToWrite > 0) {
-		if(!SDWrite(currentSector, frameBuffer + currentOffset, 1)) {
-			SetSDBusy(false);  // Clear busy flag before returning on error
-			return false;  // SD write failed
+	// In the order they were asked for
+	if (sessionEndPending && sessionEndFirst) {
+		sessionEndPending = false;
+		if (!sessionEnd()) {
+			writeFailed = true;
+		}
+	}
+	if (sessionStartPending) {
+		sessionStartPending = false;
+		if (!sessionStart(sessionStartTime)) {
+			writeFailed = true;
+		}
+	}
+	if (sessionEndPending) {
+		sessionEndPending = false;
+		if (!sessionEnd()) {
+			writeFailed = true;
 		}
-		currentSector++;
-		currentOffset += SECTOR_SIZE;
-		sectorsToWrite--;
 	}
+}
 
-	// Clear SD busy flag - operation complete
-	SetSDBusy(false);
+// Reads a frame into frameBuffer. EFRAMELOG_CHECK_BUSY if it's there - its CRC is then
+// checked a slice at a time by STORE_CheckFrameStep(). EFRAMELOG_CHECK_WAIT if the frame
+// in frameBuffer is still on its way to the card - try again on a later pass.
+EFrameLogCheck STORE_ReadFrameByCounter(uint32_t frameCounter) {
+	// Frame counter maps to its slot in the log
+	// Each frame is 2 sectors (SECTORS_PER_FRAME)
+	// Frame N is at sector ((N % frameSlots) * SECTORS_PER_FRAME)
+	uint32_t startSector;
+	uint32_t sectorsRead = 0;
+	uint32_t found;
 
-	// Frame successfully written to SD - this is now a permanent frame
-	// Note: Frame counter is incremented by caller BEFORE calling this function
-	// and is already updated in the frame metadata
+	if (!frameSlots) {
+		return EFRAMELOG_CHECK_READ_FAILED;
+	}
+	startSector = frameSector(frameCounter);
 
-	return true;  // Frame copied and written to SD
-}
+	// frameBuffer is about to be overwritten - the frame in it has to be written first
+	if (writePending) {
+		return EFRAMELOG_CHECK_WAIT;
+	}
 
-bool STORE_ReadFrameByCounter(uint32_t frameCounter) {
-	// Frame counter directly maps to SD sector address
-	// Each frame is 2 sectors (SECTORS_PER_FRAME)
-	// Frame N is at sector (N * SECTORS_PER_FRAME)
-	uint32_t startSector = frameCounter * SECTORS_PER_FRAME;
+	// First sector already read by STORE_PrefetchFrame()?
+	if (prefetchValid && (prefetchCounter == frameCounter)) {
+		memcpy(frameBuffer, sectorBuffer, SECTOR_SIZE);
+		sectorsRead = 1;
+	}
+	prefetchValid = false;
 
 	// Set SD busy flag to prevent state transitions during SD read
 	SetSDBusy(true);
 
-	// Read the complete frame (2 sectors) into frameBuffer
-	if (!SDRead(startSector, frameBuffer, SECTORS_PER_FRAME)) {
+	// Read the rest of the frame (2 sectors) into frameBuffer
+	if (!SDRead(startSector + sectorsRead, frameBuffer + (sectorsRead * SECTOR_SIZE), SECTORS_PER_FRAME - sectorsRead)) {
 		SetSDBusy(false);  // Clear busy flag before returning on error
-		return false;  // SD read failed
+		return EFRAMELOG_CHECK_READ_FAILED;
 	}
 
 	// Clear SD busy flag - operation complete
 	SetSDBusy(false);
 
-	return true;  // Frame loaded into frameBuffer
+	// The slot may hold an older frame from the last time round the card, or nothing
+	if (!FrameLog_Header(frameBuffer, &found) || (found != frameCounter)) {
+		return EFRAMELOG_CHECK_MISSING;
+	}
+
+	checkCrcByte = 0;
+	checkCrc = 0;
+	return EFRAMELOG_CHECK_BUSY;  // Frame loaded into frameBuffer, CRC still to check
+}
+
+// One slice of checking the CRC of the frame STORE_ReadFrameByCounter() read. Returns
+// EFRAMELOG_CHECK_BUSY until it's done, then EFRAMELOG_CHECK_OK or _CORRUPT.
+EFrameLogCheck STORE_CheckFrameStep(void) {
+	if (checkCrcByte < FRAME_BUFFER_SIZE) {
+		checkCrcByte = frameCrcStep(&checkCrc, checkCrcByte);
+		if (checkCrcByte < FRAME_BUFFER_SIZE) {
+			return EFRAMELOG_CHECK_BUSY;
+		}
+	}
+
+	return (checkCrc == ((FrameData*)frameBuffer)->m.frameCrc) ? EFRAMELOG_CHECK_OK : EFRAMELOG_CHECK_CORRUPT;
+}
+
+// Read the first sector of a frame into sectorBuffer so the next
+// STORE_ReadFrameByCounter() for it only has to read the remainder.
+// frameBuffer is left alone - it may still be on the wire.
+bool STORE_PrefetchFrame(uint32_t frameCounter) {
+	sectorBufferTake();
+
+	// A read would have to wait for the frame write in progress - it's only a read ahead
+	if (!frameSlots || writePending) {
+		return false;
+	}
+
+	SetSDBusy(true);
+
+	if (!SDRead(frameSector(frameCounter), sectorBuffer, 1)) {
+		SetSDBusy(false);
+		return false;
+	}
+
+	SetSDBusy(false);
+
+	prefetchCounter = frameCounter;
+	prefetchValid = true;
+	return true;
 }
 
-bool STORE_StartNewSession(void) {
-	// Update session info
-	gState.sessionCount++;
-	gState.newSessionSector = currentSector;
-	
-	// Ensure sector alignment for new sessions
-	if(currentSector % SECTORS_PER_FRAME != 0) {
-		currentSector += SECTORS_PER_FRAME - (currentSector % SECTORS_PER_FRAME);
+// Opens the next session. Does nothing if a session's already open. The frame on its
+// way to the card belongs before the session, and moves the frame counter on when it's
+// written - if there is one, STORE_Process() opens the session once it's done.
+bool STORE_StartNewSession(uint64_t startTime) {
+	if (STORE_WriteBusy()) {
+		sessionEndFirst = sessionEndPending;
+		sessionStartPending = true;
+		sessionStartTime = startTime;
+		return true;
 	}
-	
-	return updateSessionMap();
+
+	return sessionStart(startTime);
+}
+
+// Finish off a frame write, and an SD write burst (STORE_WRITE_BURST_FRAMES), in progress
+bool STORE_Flush(void) {
+	bool result;
+
+	SetSDBusy(true);
+	result = SDWriteFlush();
+	SetSDBusy(false);
+
+	return result;
 }
 
 uint8_t* STORE_GetFrameBuffer(void) {
+	// It may be about to go out - a frame on its way to the card needs its CRC in first
+	storeCrcFinish();
 	return frameBuffer;
 }
 
-bool STORE_EndSession(void) {
-	// Ensure we end on a frame boundary
-	if(currentSector % SECTORS_PER_FRAME != 0) {
-		currentSector += SECTORS_PER_FRAME - (currentSector % SECTORS_PER_FRAME);
+// Closes the open session, if there is one. The frame's session variables are its
+// summary. If a frame's on its way to the card, STORE_Process() closes the session
+// once it's done.
+bool STORE_EndSession(volatile FrameData* frame) {
+	sessionEndSummary.u16MaxCurrent = frame->m.u16maxCurrent;
+	sessionEndSummary.u16MinCurrent = frame->m.u16minCurrent;
+	sessionEndSummary.u8WDTCount = frame->m.sg_u8WDTCount;
+	sessionEndSummary.u8CellCount = frame->m.sg_u8CellCountExpected;
+
+	if (STORE_WriteBusy()) {
+		sessionEndFirst = !sessionStartPending;
+		sessionEndPending = true;
+		return true;
 	}
-	
-	gState.lastSessionSector = currentSector - 1;
-	return writeGlobalState();
+
+	return sessionEnd();
 }
 
-// Modified to account for multi-sector frames
-bool STORE_GetSessionInfo(uint32_t sessionIndex, uint32_t* startSector, uint32_t* sectorCount) {
-	if (sessionIndex >= gState.sessionCount) {
+bool STORE_GetSessionCount(uint32_t* count) {
+	if (!sessionSlots) {
 		return false;
 	}
 
-	uint32_t mapSector = gState.activeSessionMapSector;
-	uint32_t mapOffset = sessionIndex * sizeof(uint64_t);
+	*count = sessionNext;
+	return true;
+}
 
-	while (mapOffset >= SECTOR_SIZE) {
-		mapSector++;
-		mapOffset -= SECTOR_SIZE;
+// A session's record, from RAM if it's there, or else one sector read of its index slot.
+// EFRAMELOG_CHECK_MISSING for a session the index has gone round and written over, and
+// EFRAMELOG_CHECK_WAIT if it has to be read while a frame's on its way to the card - try
+// again on a later pass. An open session ends at the frames written so far.
+EFrameLogCheck STORE_GetSessionInfo(uint32_t session, SSessionRecord* record) {
+	SSessionRecord* cached;
+	uint32_t found;
+	bool result;
+
+	if (!sessionSlots || (session >= sessionNext) || ((sessionNext - session) > sessionSlots)) {
+		return EFRAMELOG_CHECK_MISSING;
 	}
 
-	if (!SDRead(mapSector, frameBuffer, 1)) {
-		return false;
-	}
+	cached = sessionCacheGet(session);
+	if (cached) {
+		memcpy(record, cached, sizeof(*record));
+	} else {
+		// A read would have to wait for the frame write to finish
+		if (writePending) {
+			return EFRAMELOG_CHECK_WAIT;
+		}
 
-	*startSector = *(uint64_t*)(frameBuffer + mapOffset);
+		// frameBuffer may be on the wire, so it's read into sectorBuffer
+		sectorBufferTake();
 
-	if (sessionIndex == gState.sessionCount - 1) {
-		// Current session - calculate based on current position
-		*sectorCount = currentSector - *startSector;
-		} else {
-		// Get next session's start sector
-		uint32_t nextStartSector;
-		if (!STORE_GetSessionInfo(sessionIndex + 1, &nextStartSector, NULL)) {
-			return false;
+		SetSDBusy(true);
+		result = SDRead(indexSector + (session % sessionSlots), sectorBuffer, 1);
+		SetSDBusy(false);
+
+		if (!result) {
+			return EFRAMELOG_CHECK_READ_FAILED;
+		}
+		if (!SessionLog_Header(sectorBuffer, &found) || (found != session)) {
+			return EFRAMELOG_CHECK_MISSING;
 		}
-		*sectorCount = nextStartSector - *startSector;
+
+		memcpy(record, sectorBuffer, sizeof(*record));
+		sessionCachePut(record);
 	}
 
-	// Validate sector count is a multiple of SECTORS_PER_FRAME
-	if (*sectorCount % SECTORS_PER_FRAME != 0) {
-		return false;  // Corrupted session data
+	if (record->u8Flags & SESSIONLOG_FLAG_OPEN) {
+		record->u32EndFrame = FrameCounter_Get();
 	}
 
-	return true;
-}
\ No newline at end of file
+	return EFRAMELOG_CHECK_OK;
+}
+
+// Sets a scrub going over count frames from first, cut down to the frames the log still
+// holds. A count of 0 stops one in progress. Returns the frames it'll check.
+uint32_t STORE_ScrubStart(uint32_t first, uint32_t count) {
+	uint32_t next = FrameCounter_Get();
+	uint32_t oldest = (next > frameSlots) ? (next - frameSlots) : 0;
+
+	scrubRemaining = 0;
+	if (!frameSlots || (first >= next)) {
+		return 0;
+	}
+
+	if (first < oldest) {
+		count = ((oldest - first) < count) ? (count - (oldest - first)) : 0;
+		first = oldest;
+	}
+	if (count > (next - first)) {
+		count = next - first;
+	}
+
+	scrubRemaining = count;
+	FrameLog_ScrubStart(&scrub, first);
+	return count;
+}
+
+// One step of the scrub - a sector read, or a slice of a frame's CRC. Only goes while no
+// frame write is under way. Returns EFRAMELOG_CHECK_BUSY until a frame's been checked,
+// then what it found, with *frameCounter the frame.
+EFrameLogCheck STORE_ScrubStep(uint32_t* frameCounter) {
+	EFrameLogCheck result;
+
+	if (!scrubRemaining || writePending) {
+		return EFRAMELOG_CHECK_BUSY;
+	}
+
+	// It's sectorBuffer's turn - anything prefetched in it is gone
+	if (!scrub.bSectorRead) {
+		prefetchValid = false;
+	}
+
+	result = FrameLog_ScrubStep(&scrub, frameSlots, storeReadFrameSector, sectorBuffer, STORE_CRC_STEP_BYTES);
+	if (EFRAMELOG_CHECK_BUSY != result) {
+		*frameCounter = scrub.u32Counter;
+		scrubRemaining--;
+		FrameLog_ScrubStart(&scrub, scrub.u32Counter + 1);
+	}
+
+	return result;
+}
+
+// Frames the scrub has still to check
+uint32_t STORE_ScrubRemaining(void) {
+	return scrubRemaining;
+}
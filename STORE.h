@@ -6,6 +6,7 @@
 #include <stddef.h>  // For offsetof macro
 #include <adc.h>
 #include <vUART.h>
+#include "sessionlog.h"
 
 // Define constants
 #define SECTOR_SIZE 512
@@ -14,23 +15,6 @@
 
 
 
-// Global state structure (Sector 0) - MUST BE 4-BYTE ALIGNED FOR 32-BIT XFERS
-typedef struct __attribute__((aligned(4))) {
-	uint64_t lastUpdateTimestamp;
-	uint32_t checksum;
-	uint32_t firstSessionSector;
-	uint32_t lastSessionSector;
-	uint32_t sessionCount;
-	uint32_t newSessionSector;
-	uint32_t activeSessionMapSector;
-	uint32_t activeSessionMapOffset;
-	uint8_t cellDataDescriptor[16];  // Placeholder size, adjust as needed
-	uint8_t frameDataDescriptor[32]; // Placeholder size, adjust as needed
-	uint8_t cellCount;
-	uint8_t cellStructuresPerFrame;
-	uint8_t lifetimeStats[384];      // Placeholder size, adjust as needed
-} GlobalState;
-
 // Cell data structure - MUST BE 4-BYTE ALIGNED FOR 32-BIT XFERS
 // Contains RAW data from CellCPU in native format (not converted)
 typedef struct __attribute__((aligned(4))) {
@@ -58,6 +42,7 @@ typedef struct
 
 #define FRAME_VALID_SIG 0xBA77
 #define FRAME_VERSION 1  // Frame format version number
+#define FRAME_VERSION_DELTA 2  // String readings delta packed - see FRAME_DELTA_STRINGS.md
 
 // Frame metadata structure - contains all the control and status fields
 typedef struct __attribute__((aligned(4))) {
@@ -113,6 +98,9 @@ typedef struct __attribute__((aligned(4))) {
 	uint16_t nstrings;              // Number of string readings that can fit in buffer
 	uint16_t currentIndex;          // Current position in circular buffer (0 to nstrings-1)
 	uint16_t readingCount;          // Number of valid readings in buffer
+
+// SD frame log (framelog.h)
+	uint32_t frameCrc;              // CRC32 of the rest of the frame, filled in as it's written to SD
 } FrameMetadata;
 
 // Frame data structure - MUST BE 4-BYTE ALIGNED FOR 32-BIT XFERS
@@ -176,14 +164,22 @@ STATIC_ASSERT(sizeof(FrameData) == FRAME_BUFFER_SIZE, frame_size_mismatch);
 
 
 // Function prototypes
-bool STORE_Init(void);
-bool STORE_WriteFrame(volatile FrameData* frame, bool bSDCardReady, bool bSDWriteEnabled);
-bool STORE_ReadFrameByCounter(uint32_t frameCounter);  // Read frame from SD by counter into frameBuffer
-bool STORE_StartNewSession(void);
-bool STORE_EndSession(void);
-bool STORE_GetSessionCount(uint32_t* count);
-bool STORE_GetSessionInfo(uint32_t sessionIndex, uint32_t* startSector, uint32_t* sectorCount);
+bool STORE_Init(bool sessionResume);  // sessionResume - carry on a session left open (watchdog reset)
+bool STORE_WriteFrame(volatile FrameData* frame, bool bSDCardReady, bool bSDWriteEnabled);  // Starts the SD write - see STORE_Process()
+void STORE_Process(void);  // Moves a frame write along, a slice at a time - call from the main loop
+bool STORE_WriteBusy(void);  // A frame write, or a session waiting on one, is in progress - STORE_WriteFrame() has to wait
+EFrameLogCheck STORE_ReadFrameByCounter(uint32_t frameCounter);  // Read frame from SD by counter into frameBuffer - EFRAMELOG_CHECK_BUSY if it's there, EFRAMELOG_CHECK_WAIT to try again later
+EFrameLogCheck STORE_CheckFrameStep(void);  // Checks its CRC, a slice a call - EFRAMELOG_CHECK_BUSY until it's done
+bool STORE_PrefetchFrame(uint32_t frameCounter);  // Read first sector of a frame ahead of STORE_ReadFrameByCounter()
+bool STORE_StartNewSession(uint64_t startTime);  // Opens a session in the SD session index (sessionlog.h)
+bool STORE_EndSession(volatile FrameData* frame);  // Closes it, with the frame's session variables as its summary
+bool STORE_Flush(void);  // Finish any SD write burst in progress
+bool STORE_GetSessionCount(uint32_t* count);  // Sessions so far, the open one included - the card holds the last SESSIONLOG_SLOTS
+EFrameLogCheck STORE_GetSessionInfo(uint32_t session, SSessionRecord* record);  // RAM or one sector read - EFRAMELOG_CHECK_WAIT to try again later
 uint8_t* STORE_GetFrameBuffer(void);  // Get pointer to internal frame buffer for CAN frame transfer
+uint32_t STORE_ScrubStart(uint32_t first, uint32_t count);  // Checks frames on the card in the background - returns how many it'll check
+EFrameLogCheck STORE_ScrubStep(uint32_t* frameCounter);  // A sector read or a CRC slice - EFRAMELOG_CHECK_BUSY until a frame's done
+uint32_t STORE_ScrubRemaining(void);  // Frames the scrub has still to check
 
 
 #endif
\ No newline at end of file
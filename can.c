@@ -23,23 +23,39 @@
 
 #define CANMOB_RX_IDX			(0)
 #define CANMOB_TX_IDX			(1)
+#define CANMOB_COUNT			(6)
+
+// Spare MOBs used to stream bulk data (frame transfer) without tying up CANMOB_TX_IDX
+#define CANMOB_BURST_FIRST_IDX	(3)
+#define CANMOB_BURST_LAST_IDX	(5)
+#define CANMOB_BURST_MASK		((1 << 3) | (1 << 4) | (1 << 5))
+
+// MOBs the TX queue drains into.  The burst MOBs are only used while no burst is running.
+#define CANMOB_TX_QUEUE_MASK	((1 << CANMOB_TX_IDX) | CANMOB_BURST_MASK)
+
+// Burst flow control - segments sent per window before yielding to control traffic
+#define CAN_BURST_WINDOW_SEGMENTS	(32)
+
+// Retries per message (collision, ACK error, etc.) before it's dropped
+#define CAN_TX_MAX_ATTEMPTS		(20)
 
 // Timeout for CAN TX in main loop ticks (100ms each)
 #define CAN_TX_TIMEOUT_TICKS	(2)	// 200ms timeout
 
-static volatile uint8_t sg_u8Busy;	// 0 = not busy, >0 = busy with timeout countdown
+// TX queue priorities - lower value leaves the queue first
+#define CAN_TX_PRIORITY_HIGH	(0)	// Module state/safety - status, announcement
+#define CAN_TX_PRIORITY_NORMAL	(1)	// Detail, comm stats, hardware, time request
+#define CAN_TX_PRIORITY_BULK	(2)	// Frame transfer control
+#define CAN_TX_PRIORITY_COUNT	(3)
+
+// Messages queued per priority
+#define CAN_TX_QUEUE_DEPTH		(4)
+
 static void (*sg_pfRXCallback)(ECANMessageType eType, uint8_t* pu8Data, uint8_t u8DataLen);
 
 // Maximum size of CAN message
 #define CAN_MAX_MSG_SIZE		8
 
-// Last transmit info
-static uint8_t sg_u8TransmitAttempts;
-static ECANMessageType sg_eLastTXType;
-static uint8_t sg_u8LastTXData[CAN_MAX_MSG_SIZE];
-static uint8_t sg_u8LastTXDataLen;
-static volatile bool sg_bInRetransmit = false;
-
 // Diagnostic counters for CAN issues
 static uint16_t sg_u16TxTimeouts = 0;		// Count of TX timeouts
 static uint16_t sg_u16TxErrors = 0;		// Count of TX errors recovered
@@ -63,12 +79,35 @@ static volatile uint8_t sg_rxQueueHead = 0;
 static volatile uint8_t sg_rxQueueTail = 0;
 static uint16_t sg_u16RxQueueOverflows = 0;	// Diagnostic: queue overflow count
 
+// TX Message Queue - producers enqueue and return, the CAN ISR drains it into free MOBs.
+// One ring per priority; only touched from the ISR or with ENIT cleared.
+typedef struct {
+	uint8_t u8Type;			// ECANMessageType
+	uint8_t u8DataLen;
+	uint16_t u16SeqNum;
+	uint8_t u8Data[CAN_MAX_MSG_SIZE];
+} CANTxMessage;
+
+static CANTxMessage sg_txQueue[CAN_TX_PRIORITY_COUNT][CAN_TX_QUEUE_DEPTH];
+static volatile uint8_t sg_txQueueHead[CAN_TX_PRIORITY_COUNT];
+static volatile uint8_t sg_txQueueCount[CAN_TX_PRIORITY_COUNT];
+static uint16_t sg_u16TxQueueOverflows = 0;	// Diagnostic: messages refused with the queue full
+
+static volatile uint8_t sg_u8TxInFlight = 0;		// Bitmap of MOBs loaded from the TX queue
+static uint8_t sg_u8TxTimeout[CANMOB_COUNT];		// Ticks left before a queued MOB is given up on
+static uint8_t sg_u8TxAttempts[CANMOB_COUNT];		// Retries used by the message in each TX MOB
+
 // MOB Reconfiguration Flags - defers MOB setup to main loop
 static volatile bool sg_bMOB0NeedsReconfigure = false;
 static volatile bool sg_bMOB2NeedsReconfigure = false;
 
-// TX Retry Flag - defers retry logic to main loop
-static volatile bool sg_bRetryPending = false;
+// Burst transfer state - burst MOBs are refilled from the TX complete interrupt
+static bool (*sg_pfBurstFill)(uint16_t* pu16SeqNum, uint8_t* pu8Data, uint8_t* pu8DataLen);
+static volatile bool sg_bBurstActive = false;		// Burst in progress (segments pending or in flight)
+static volatile bool sg_bBurstDrained = false;		// Fill callback has no more segments
+static volatile bool sg_bBurstFailed = false;		// Burst aborted on exhausted retries or bus-off
+static volatile uint8_t sg_u8BurstInFlight = 0;		// Bitmap of loaded burst MOBs
+static volatile uint8_t sg_u8BurstWindow = 0;		// Segments left in current flow control window
 
 typedef struct 
 {
@@ -78,8 +117,11 @@ typedef struct
 	uint16_t u16IDMask;
 	bool bRTRTag;
 	bool bRTRMask;
+	uint8_t u8TxPriority;	// CAN_TX_PRIORITY_* - transmit MOBs only
 } SMOBDef;
 
+static const SMOBDef* sg_psBurstDef;				// MOB definition for the burst message type
+
 static const SMOBDef sg_sMOBDisabled =
 {
 	CAN_DISABLED,
@@ -88,6 +130,7 @@ static const SMOBDef sg_sMOBDisabled =
 	0x7ff,
 	false,
 	false,
+	CAN_TX_PRIORITY_NORMAL,
 };
 
 // Recevie any message with ID 0x5xx (RTR or not)
@@ -99,6 +142,7 @@ static const SMOBDef sg_sMOBGenericReceive =
 	0x700,  // Mask: 0x700 = bits 10:8 must match, allowing only 0x500-0x5FF
 	false,
 	false,
+	CAN_TX_PRIORITY_NORMAL,
 };
 
 static const SMOBDef sg_sMOBModuleAnnouncement =
@@ -109,6 +153,7 @@ static const SMOBDef sg_sMOBModuleAnnouncement =
 	0x7ff,
 	false,
 	false,
+	CAN_TX_PRIORITY_HIGH,
 };
 
 static const SMOBDef sg_sMOBModuleStatus1 =
@@ -119,6 +164,7 @@ static const SMOBDef sg_sMOBModuleStatus1 =
 	0x7ff,
 	false,
 	false,
+	CAN_TX_PRIORITY_HIGH,
 };
 
 static const SMOBDef sg_sMOBModuleStatus2 =
@@ -129,6 +175,7 @@ static const SMOBDef sg_sMOBModuleStatus2 =
 	0x7ff,
 	false,
 	false,
+	CAN_TX_PRIORITY_HIGH,
 };
 
 static const SMOBDef sg_sMOBModuleStatus3 =
@@ -139,6 +186,7 @@ static const SMOBDef sg_sMOBModuleStatus3 =
 	0x7ff,
 	false,
 	false,
+	CAN_TX_PRIORITY_HIGH,
 };
 
 static const SMOBDef sg_sMOBModuleCellCommStat1 =
@@ -149,6 +197,7 @@ static const SMOBDef sg_sMOBModuleCellCommStat1 =
 	0x7ff,
 	false,
 	false,
+	CAN_TX_PRIORITY_NORMAL,
 };
 
 static const SMOBDef sg_sMOBModuleCellCommStat2 =
@@ -159,6 +208,7 @@ static const SMOBDef sg_sMOBModuleCellCommStat2 =
 	0x7ff,
 	false,
 	false,
+	CAN_TX_PRIORITY_NORMAL,
 };
 
 static const SMOBDef sg_sMOBModuleCellDetail = 
@@ -169,6 +219,62 @@ static const SMOBDef sg_sMOBModuleCellDetail =
 	0x7ff,
 	false,
 	false,
+	CAN_TX_PRIORITY_NORMAL,
+};
+
+static const SMOBDef sg_sMOBModuleCellDetailBulk =
+{
+	CAN_TXONLY,
+	false,
+	PKT_MODULE_CELL_DETAIL_BULK,
+	0x7ff,
+	false,
+	false,
+	CAN_TX_PRIORITY_NORMAL,
+};
+
+static const SMOBDef sg_sMOBModuleVUARTTiming =
+{
+	CAN_TXONLY,
+	false,
+	PKT_MODULE_VUART_TIMING,
+	0x7ff,
+	false,
+	false,
+	CAN_TX_PRIORITY_NORMAL,
+};
+
+static const SMOBDef sg_sMOBModuleCellErrors =
+{
+	CAN_TXONLY,
+	false,
+	PKT_MODULE_CELL_ERRORS,
+	0x7ff,
+	false,
+	false,
+	CAN_TX_PRIORITY_NORMAL,
+};
+
+static const SMOBDef sg_sMOBModuleSession =
+{
+	CAN_TXONLY,
+	false,
+	PKT_MODULE_SESSION,
+	0x7ff,
+	false,
+	false,
+	CAN_TX_PRIORITY_NORMAL,
+};
+
+static const SMOBDef sg_sMOBModuleSessionSummary =
+{
+	CAN_TXONLY,
+	false,
+	PKT_MODULE_SESSION_SUMMARY,
+	0x7ff,
+	false,
+	false,
+	CAN_TX_PRIORITY_NORMAL,
 };
 
 static const SMOBDef sg_sMOBModuleHardwareDetail = 
@@ -179,6 +285,7 @@ static const SMOBDef sg_sMOBModuleHardwareDetail =
 	0x7ff,
 	false,
 	false,
+	CAN_TX_PRIORITY_NORMAL,
 };
 
 static const SMOBDef sg_sMOBModuleRequestTime =
@@ -189,6 +296,7 @@ static const SMOBDef sg_sMOBModuleRequestTime =
 	0x7ff,
 	false,
 	false,
+	CAN_TX_PRIORITY_NORMAL,
 };
 
 // Frame transfer MOBs
@@ -200,6 +308,7 @@ static const SMOBDef sg_sMOBFrameTransferStart =
 	0x7ff,
 	false,
 	false,
+	CAN_TX_PRIORITY_BULK,
 };
 
 static const SMOBDef sg_sMOBFrameTransferData =
@@ -210,6 +319,7 @@ static const SMOBDef sg_sMOBFrameTransferData =
 	0x7ff,
 	false,
 	false,
+	CAN_TX_PRIORITY_BULK,
 };
 
 static const SMOBDef sg_sMOBFrameTransferEnd =
@@ -220,6 +330,18 @@ static const SMOBDef sg_sMOBFrameTransferEnd =
 	0x7ff,
 	false,
 	false,
+	CAN_TX_PRIORITY_BULK,
+};
+
+static const SMOBDef sg_sMOBFrameCheck =
+{
+	CAN_TXONLY,
+	false,
+	PKT_FRAME_CHECK,
+	0x7ff,
+	false,
+	false,
+	CAN_TX_PRIORITY_BULK,
 };
 
 
@@ -242,7 +364,13 @@ static const SCANCmdReg sg_sRXCommandList[] =
 	{PKT_MODULE_ALL_ISOLATE,	ECANMessageType_AllIsolate},
 	{PKT_MODULE_SET_TIME,		ECANMessageType_SetTime},
 	{PKT_MODULE_MAX_STATE,		ECANMessageType_MaxState},
-	{PKT_FRAME_TRANSFER_REQUEST, ECANMessageType_FrameTransferRequest}
+	{PKT_MODULE_FRAME_RATE,		ECANMessageType_FrameRate},
+	{PKT_MODULE_CELL_WINDOW,	ECANMessageType_CellWindow},
+	{PKT_MODULE_SESSION_REQUEST, ECANMessageType_SessionRequest},
+	{PKT_FRAME_TRANSFER_REQUEST, ECANMessageType_FrameTransferRequest},
+	{PKT_FRAME_TRANSFER_ACK,	ECANMessageType_FrameTransferAck},
+	{PKT_FRAME_TRANSFER_NACK,	ECANMessageType_FrameTransferNack},
+	{PKT_FRAME_SCRUB_REQUEST,	ECANMessageType_FrameScrubRequest}
 };
 
 static ECANMessageType CANLookupCommand( uint16_t u16ID )
@@ -262,6 +390,87 @@ static ECANMessageType CANLookupCommand( uint16_t u16ID )
 	return( ECANMessageType_MAX );
 }
 
+// Map a transmit message type to its MOB definition
+static const SMOBDef* CANMessageDef( ECANMessageType eType )
+{
+	if( ECANMessageType_ModuleAnnouncement == eType )
+	{
+		return( &sg_sMOBModuleAnnouncement );
+	}
+	else if( ECANMessageType_ModuleStatus1 == eType )
+	{
+		return( &sg_sMOBModuleStatus1 );
+	}
+	else if( ECANMessageType_ModuleStatus2 == eType )
+	{
+		return( &sg_sMOBModuleStatus2 );
+	}
+	else if( ECANMessageType_ModuleStatus3 == eType )
+	{
+		return( &sg_sMOBModuleStatus3 );
+	}
+	else if( ECANMessageType_ModuleCellCommStat1 == eType )
+	{
+		return( &sg_sMOBModuleCellCommStat1 );
+	}
+	else if( ECANMessageType_ModuleCellCommStat2 == eType )
+	{
+		return( &sg_sMOBModuleCellCommStat2 );
+	}
+	else if( ECANMessageType_ModuleHardwareDetail == eType )
+	{
+		return( &sg_sMOBModuleHardwareDetail );
+	}
+	else if( ECANMessageType_ModuleCellDetail == eType )
+	{
+		return( &sg_sMOBModuleCellDetail );
+	}
+	else if( ECANMessageType_ModuleCellDetailBulk == eType )
+	{
+		return( &sg_sMOBModuleCellDetailBulk );
+	}
+	else if( ECANMessageType_ModuleVUARTTiming == eType )
+	{
+		return( &sg_sMOBModuleVUARTTiming );
+	}
+	else if( ECANMessageType_ModuleCellErrors == eType )
+	{
+		return( &sg_sMOBModuleCellErrors );
+	}
+	else if( ECANMessageType_ModuleSession == eType )
+	{
+		return( &sg_sMOBModuleSession );
+	}
+	else if( ECANMessageType_ModuleSessionSummary == eType )
+	{
+		return( &sg_sMOBModuleSessionSummary );
+	}
+	else if( ECANMessageType_ModuleRequestTime == eType )
+	{
+		return( &sg_sMOBModuleRequestTime );
+	}
+	else if( ECANMessageType_FrameTransferStart == eType )
+	{
+		return( &sg_sMOBFrameTransferStart );
+	}
+	else if( ECANMessageType_FrameTransferData == eType )
+	{
+		return( &sg_sMOBFrameTransferData );
+	}
+	else if( ECANMessageType_FrameTransferEnd == eType )
+	{
+		return( &sg_sMOBFrameTransferEnd );
+	}
+	else if( ECANMessageType_FrameCheck == eType )
+	{
+		return( &sg_sMOBFrameCheck );
+	}
+
+	// Invalid message type
+	MBASSERT(0);
+	return( NULL );
+}
+
 static void CANMOBSetWithSeq( uint8_t u8MOBIndex,
 					   const SMOBDef* psDef,
 					   uint8_t* pu8Data,
@@ -352,190 +561,131 @@ static void CANMOBSet( uint8_t u8MOBIndex,
 	CANMOBSetWithSeq(u8MOBIndex, psDef, pu8Data, u8DataLen, 0);
 }
 
-static void CANSendMessageInternal( ECANMessageType eType,
-									uint8_t* pu8Data,
-									uint8_t u8DataLen,	
-									bool bRetransmit )
+// Add a message to the TX queue for its priority.  Returns false if that priority is full.
+// Caller must have CAN interrupts disabled.
+static bool CANTxQueuePut( ECANMessageType eType,
+						   uint8_t* pu8Data,
+						   uint8_t u8DataLen,
+						   uint16_t u16SeqNum )
 {
-	const SMOBDef* psDef = NULL;
-	
-	if( ECANMessageType_ModuleAnnouncement == eType )
-	{
-		psDef = &sg_sMOBModuleAnnouncement;
-	}
-	else if( ECANMessageType_ModuleStatus1 == eType )
-	{
-		psDef = &sg_sMOBModuleStatus1;
-	}
-	else if( ECANMessageType_ModuleStatus2 == eType )
-	{
-		psDef = &sg_sMOBModuleStatus2;
-	}
-	else if( ECANMessageType_ModuleStatus3 == eType )
-	{
-		psDef = &sg_sMOBModuleStatus3;
-	}
-	else if( ECANMessageType_ModuleCellCommStat1 == eType )
-	{
-		psDef = &sg_sMOBModuleCellCommStat1;
-	}
-	else if( ECANMessageType_ModuleCellCommStat2 == eType )
-	{
-		psDef = &sg_sMOBModuleCellCommStat2;
-	}
-	else if( ECANMessageType_ModuleHardwareDetail == eType )
-	{
-		psDef = &sg_sMOBModuleHardwareDetail;
-	}
-	else if( ECANMessageType_ModuleCellDetail == eType )
-	{
-		psDef = &sg_sMOBModuleCellDetail;
-	}
-	else if( ECANMessageType_ModuleRequestTime == eType )
-	{
-		psDef = &sg_sMOBModuleRequestTime;
-	}
-	else if( ECANMessageType_FrameTransferStart == eType )
+	const SMOBDef* psDef = CANMessageDef( eType );
+	CANTxMessage* psMsg;
+	uint8_t u8Priority;
+
+	MBASSERT(u8DataLen <= CAN_MAX_MSG_SIZE);
+
+	if( NULL == psDef )
 	{
-		psDef = &sg_sMOBFrameTransferStart;
+		return( false );
 	}
-	else if( ECANMessageType_FrameTransferData == eType )
+
+	u8Priority = psDef->u8TxPriority;
+	if( sg_txQueueCount[u8Priority] >= CAN_TX_QUEUE_DEPTH )
 	{
-		psDef = &sg_sMOBFrameTransferData;
+		sg_u16TxQueueOverflows++;
+		return( false );
 	}
-	else if( ECANMessageType_FrameTransferEnd == eType )
+
+	psMsg = &sg_txQueue[u8Priority][(sg_txQueueHead[u8Priority] + sg_txQueueCount[u8Priority]) % CAN_TX_QUEUE_DEPTH];
+	psMsg->u8Type = (uint8_t) eType;
+	psMsg->u8DataLen = u8DataLen;
+	psMsg->u16SeqNum = u16SeqNum;
+	memcpy(psMsg->u8Data, pu8Data, u8DataLen);
+	sg_txQueueCount[u8Priority]++;
+
+	return( true );
+}
+
+static bool CANTxQueueEmpty( void )
+{
+	uint8_t u8Priority;
+
+	for( u8Priority = 0; u8Priority < CAN_TX_PRIORITY_COUNT; u8Priority++ )
 	{
-		psDef = &sg_sMOBFrameTransferEnd;
+		if( sg_txQueueCount[u8Priority] )
+		{
+			return( false );
+		}
 	}
-	else
+
+	return( true );
+}
+
+// Move queued messages, highest priority first, into every free TX MOB.
+// Caller must have CAN interrupts disabled (ISR or ENIT cleared).
+static void CANTxQueueLoad( void )
+{
+	uint8_t u8MOBIndex;
+	uint8_t u8Priority = 0;
+
+	// Nothing goes on the wire while recovering from bus-off or backing off
+	if( (sg_u8BusOffRecoveryDelay > 0) ||
+		(sg_u8TxBackoffDelay > 0) )
 	{
-		// Invalid message type
-		MBASSERT(0);
-	}
-	
-	if(bRetransmit && sg_bInRetransmit) {
-		// Already in a retransmit, don't allow nested retries
 		return;
 	}
-	if( bRetransmit || (0 == sg_u8Busy) )
+
+	for( u8MOBIndex = CANMOB_TX_IDX; u8MOBIndex < CANMOB_COUNT; u8MOBIndex++ )
 	{
-		// Only reset timeout if not already busy, or if explicitly retransmitting
-		// Don't extend timeout on retransmits - use existing countdown
-		if (0 == sg_u8Busy)
+		CANTxMessage* psMsg;
+
+		if( (0 == (CANMOB_TX_QUEUE_MASK & (1 << u8MOBIndex))) ||
+			(sg_u8TxInFlight & (1 << u8MOBIndex)) )
 		{
-			sg_u8Busy = CAN_TX_TIMEOUT_TICKS;
+			continue;
 		}
-		
-		// Save this message info for retransmit later if needed
-		if( false == bRetransmit )
+
+		// The burst owns its MOBs until it finishes
+		if( sg_bBurstActive && (CANMOB_BURST_MASK & (1 << u8MOBIndex)) )
 		{
-			sg_u8TransmitAttempts = 0;
-			sg_eLastTXType = eType;
-			MBASSERT(u8DataLen <= CAN_MAX_MSG_SIZE);
-			memcpy(sg_u8LastTXData, pu8Data, u8DataLen);
-			sg_u8LastTXDataLen = u8DataLen;
+			continue;
 		}
-		else
+
+		while( (u8Priority < CAN_TX_PRIORITY_COUNT) && (0 == sg_txQueueCount[u8Priority]) )
 		{
-			sg_u8TransmitAttempts++;
+			u8Priority++;
 		}
-		
-		// Send it now
-		CANMOBSet( CANMOB_TX_IDX, psDef, pu8Data, u8DataLen );
+
+		if( u8Priority >= CAN_TX_PRIORITY_COUNT )
+		{
+			// Queue is empty
+			return;
+		}
+
+		psMsg = &sg_txQueue[u8Priority][sg_txQueueHead[u8Priority]];
+		sg_u8TxAttempts[u8MOBIndex] = 0;
+		sg_u8TxTimeout[u8MOBIndex] = CAN_TX_TIMEOUT_TICKS;
+		sg_u8TxInFlight |= (1 << u8MOBIndex);
+		CANMOBSetWithSeq( u8MOBIndex,
+						  CANMessageDef( (ECANMessageType) psMsg->u8Type ),
+						  psMsg->u8Data,
+						  psMsg->u8DataLen,
+						  psMsg->u16SeqNum );
+
+		sg_txQueueHead[u8Priority] = (sg_txQueueHead[u8Priority] + 1) % CAN_TX_QUEUE_DEPTH;
+		sg_txQueueCount[u8Priority]--;
 	}
 }
 
-static void CANSendMessageInternalWithSeq( ECANMessageType eType,
-									uint8_t* pu8Data,
-									uint8_t u8DataLen,
-									uint16_t u16SeqNum,
-									bool bRetransmit )
+// Drop everything queued and disable the queue's MOBs.  Caller must have CAN interrupts disabled.
+static void CANTxQueueFlush( void )
 {
-	const SMOBDef* psDef = NULL;
-
-	if( ECANMessageType_ModuleAnnouncement == eType )
-	{
-		psDef = &sg_sMOBModuleAnnouncement;
-	}
-	else if( ECANMessageType_ModuleStatus1 == eType )
-	{
-		psDef = &sg_sMOBModuleStatus1;
-	}
-	else if( ECANMessageType_ModuleStatus2 == eType )
-	{
-		psDef = &sg_sMOBModuleStatus2;
-	}
-	else if( ECANMessageType_ModuleStatus3 == eType )
-	{
-		psDef = &sg_sMOBModuleStatus3;
-	}
-	else if( ECANMessageType_ModuleCellCommStat1 == eType )
-	{
-		psDef = &sg_sMOBModuleCellCommStat1;
-	}
-	else if( ECANMessageType_ModuleCellCommStat2 == eType )
-	{
-		psDef = &sg_sMOBModuleCellCommStat2;
-	}
-	else if( ECANMessageType_ModuleHardwareDetail == eType )
-	{
-		psDef = &sg_sMOBModuleHardwareDetail;
-	}
-	else if( ECANMessageType_ModuleCellDetail == eType )
-	{
-		psDef = &sg_sMOBModuleCellDetail;
-	}
-	else if( ECANMessageType_ModuleRequestTime == eType )
-	{
-		psDef = &sg_sMOBModuleRequestTime;
-	}
-	else if( ECANMessageType_FrameTransferStart == eType )
-	{
-		psDef = &sg_sMOBFrameTransferStart;
-	}
-	else if( ECANMessageType_FrameTransferData == eType )
-	{
-		psDef = &sg_sMOBFrameTransferData;
-	}
-	else if( ECANMessageType_FrameTransferEnd == eType )
-	{
-		psDef = &sg_sMOBFrameTransferEnd;
-	}
-	else
-	{
-		// Invalid message type
-		MBASSERT(0);
-	}
+	uint8_t u8MOBIndex;
+	uint8_t u8Priority;
 
-	if(bRetransmit && sg_bInRetransmit) {
-		// Already in a retransmit, don't allow nested retries
-		return;
-	}
-	if( bRetransmit || (0 == sg_u8Busy) )
+	for( u8MOBIndex = CANMOB_TX_IDX; u8MOBIndex < CANMOB_COUNT; u8MOBIndex++ )
 	{
-		// Only reset timeout if not already busy, or if explicitly retransmitting
-		// Don't extend timeout on retransmits - use existing countdown
-		if (0 == sg_u8Busy)
-		{
-			sg_u8Busy = CAN_TX_TIMEOUT_TICKS;
-		}
-
-		// Save this message info for retransmit later if needed
-		if( false == bRetransmit )
-		{
-			sg_u8TransmitAttempts = 0;
-			sg_eLastTXType = eType;
-			MBASSERT(u8DataLen <= CAN_MAX_MSG_SIZE);
-			memcpy(sg_u8LastTXData, pu8Data, u8DataLen);
-			sg_u8LastTXDataLen = u8DataLen;
-		}
-		else
+		if( sg_u8TxInFlight & (1 << u8MOBIndex) )
 		{
-			sg_u8TransmitAttempts++;
+			CANMOBSet( u8MOBIndex, &sg_sMOBDisabled, NULL, 0 );
 		}
+	}
+	sg_u8TxInFlight = 0;
 
-		// Send it now with sequence number
-		CANMOBSetWithSeq( CANMOB_TX_IDX, psDef, pu8Data, u8DataLen, u16SeqNum );
+	for( u8Priority = 0; u8Priority < CAN_TX_PRIORITY_COUNT; u8Priority++ )
+	{
+		sg_txQueueHead[u8Priority] = 0;
+		sg_txQueueCount[u8Priority] = 0;
 	}
 }
 
@@ -545,18 +695,19 @@ static void CANSendMessageInternalWithSeq( ECANMessageType eType,
  * 
  * NORMAL TX FLOW:
  * 1. CANSendMessage() called by application
- * 2. CANSendMessageInternal() prepares message
- * 3. CANMOBSet() configures TX MOB and enables CANIE2 interrupt (line 266)
- * 4. TX completes, interrupt fires, this handler called
- * 5. TX MOB handler disables MOB (line 359-360) but does NOT re-enable
- * 6. Next TX: CANMOBSet() called again, re-enables CANIE2
+ * 2. CANTxQueuePut() copies the message into the ring for its priority
+ * 3. CANTxQueueLoad() moves the highest priority message into a free TX MOB
+ *    (CANMOB_TX_IDX, or MOBs 3-5 when no burst is running) and enables its interrupt
+ * 4. TX completes, interrupt fires, CANTxInterrupt() frees the MOB
+ * 5. CANTxQueueLoad() refills it from the queue before the ISR returns
  * 
  * TX ERROR/RETRY FLOW:
  * 1. TX error occurs (collision, ACK error, etc.)
- * 2. This handler detects error in TX MOB section
- * 3. If retries available, calls CANSendMessageInternal() directly
- * 4. CANSendMessageInternal() calls CANMOBSet() which re-enables MOB
- * 5. If retries exhausted, clears sg_bBusy but MOB stays disabled
+ * 2. CANTxInterrupt() sees the error bits on the MOB
+ * 3. If retries available, the MOB is re-armed in place (ID and data are still loaded)
+ * 4. If retries exhausted, the message is dropped and the MOB refilled from the queue
+ * 5. CANCheckTxStatus() gives up on any MOB that hasn't completed within CAN_TX_TIMEOUT_TICKS.
+ *    A burst MOB that times out fails the whole burst (CANBurstFailed()).
  * 
  * NORMAL RX FLOW:
  * 1. At init, CANMOBSet() configures RX MOB with receive filter
@@ -568,10 +719,10 @@ static void CANSendMessageInternalWithSeq( ECANMessageType eType,
  * 7. Ready to receive next message
  * 
  * IMPORTANT NOTES:
- * - TX MOB is one-shot, gets re-enabled only when next TX is set up
+ * - TX MOBs are one-shot, they get re-enabled only when the next message is loaded
  * - RX MOB is continuous, gets re-enabled immediately after processing
- * - System works because CANMOBSet() always re-enables on next TX
- * - Potential issue: TX MOB stays disabled after last transmission
+ * - Priority decides the order messages leave the queue.  Once several MOBs are loaded
+ *   the controller sends the lowest numbered MOB first.
  */
 void CANMOBInterrupt( uint8_t u8MOBIndex )
 {
@@ -666,44 +817,150 @@ void CANMOBInterrupt( uint8_t u8MOBIndex )
 		CANIE2 |= (1 << u8MOBIndex);
 		CANCDMOB |= (1 << CONMOB1);
 	}
-	else if( CANMOB_TX_IDX == u8MOBIndex )
+}
+
+// TX queue MOB interrupt - free the MOB on TX complete, re-arm it on error.
+// The caller refills free MOBs from the queue once all MOB interrupts are handled.
+static void CANTxInterrupt( uint8_t u8MOBIndex )
+{
+	CANPAGE = u8MOBIndex << 4;
+
+	// Disable the MOB while we look at it
+	CANCDMOB &= (uint8_t)~((1 << CONMOB0) | (1 << CONMOB1));
+
+	if( CANSTMOB & (1 << TXOK) )
 	{
-		if( CANSTMOB & (1 << TXOK) )
-		{
-			// Clear it
-			CANSTMOB &= ~(1 << TXOK);
+		CANSTMOB &= ~(1 << TXOK);
+		sg_u8TxInFlight &= (uint8_t)~(1 << u8MOBIndex);
+	}
+	else if( CANSTMOB & ((1 << BERR) | (1 << AERR) | (1 << SERR) | (1 << CERR) | (1 << FERR)) )
+	{
+		// TX Error on transmit (collision with another device)
+		// -or- ACK error (nobody listening)
+		CANSTMOB &= ~((1 << BERR) | (1 << AERR) | (1 << SERR) | (1 << CERR) | (1 << FERR));
 
-			sg_u8Busy = 0;
+		if( (sg_u8TxInFlight & (1 << u8MOBIndex)) &&
+			(++sg_u8TxAttempts[u8MOBIndex] < CAN_TX_MAX_ATTEMPTS) )
+		{
+			// ID and data are still in the MOB - just re-arm it
+			CANCDMOB |= (1 << CONMOB0);
 		}
-		
-		// RX success, just clear it since this is the TX context
-//		if( CANSTMOB & (1 << RXOK) )
-//		{
-			// Clear it
-//			CANSTMOB &= ~(1 << RXOK);
-//		}
-
-		// If TX Error on transmit (collision with another device)
-		// -or- ACK error (nobody listening),
-		// defer retry to main loop
-		if( CANSTMOB & ((1 << BERR) | (1 << AERR) | (1 << SERR)) )
+		else
 		{
-			// Clear it
-			CANSTMOB &= ~((1 << BERR) | (1 << AERR) | (1 << SERR));
+			// Retries exhausted.  Give up on this message
+			sg_u16TxErrors++;
+			sg_u8TxInFlight &= (uint8_t)~(1 << u8MOBIndex);
+		}
+	}
+}
 
-			if( sg_u8TransmitAttempts < 20 )
-			{
-				// Set flag to retry in main loop (reduces ISR duration)
-				sg_bRetryPending = true;
-			}
-			else
+// Load the next segment from the burst fill callback into a burst MOB.  Returns
+// false if the flow control window is closed or the callback has run dry.
+// Caller must have CAN interrupts disabled (ISR or ENIT cleared).
+static bool CANBurstLoad( uint8_t u8MOBIndex )
+{
+	uint8_t u8Data[CAN_MAX_MSG_SIZE];
+	uint8_t u8DataLen = CAN_MAX_MSG_SIZE;
+	uint16_t u16SeqNum;
+
+	if( (0 == sg_u8BurstWindow) || sg_bBurstDrained )
+	{
+		return( false );
+	}
+
+	if( false == sg_pfBurstFill( &u16SeqNum, u8Data, &u8DataLen ) )
+	{
+		sg_bBurstDrained = true;
+		return( false );
+	}
+
+	sg_u8BurstWindow--;
+	sg_u8TxAttempts[u8MOBIndex] = 0;
+	sg_u8TxTimeout[u8MOBIndex] = CAN_TX_TIMEOUT_TICKS;
+	sg_u8BurstInFlight |= (1 << u8MOBIndex);
+	MBASSERT( u8DataLen <= CAN_MAX_MSG_SIZE );
+	CANMOBSetWithSeq( u8MOBIndex, sg_psBurstDef, u8Data, u8DataLen, u16SeqNum );
+
+	return( true );
+}
+
+// Burst is finished once the callback is dry and nothing is left on the wire
+static void CANBurstCheckDone( void )
+{
+	if( sg_bBurstDrained && (0 == sg_u8BurstInFlight) )
+	{
+		sg_bBurstActive = false;
+	}
+}
+
+// Fill every idle burst MOB.  Caller must have CAN interrupts disabled.
+static void CANBurstLoadAll( void )
+{
+	uint8_t u8MOBIndex;
+
+	for( u8MOBIndex = CANMOB_BURST_FIRST_IDX; u8MOBIndex <= CANMOB_BURST_LAST_IDX; u8MOBIndex++ )
+	{
+		if( 0 == (sg_u8BurstInFlight & (1 << u8MOBIndex)) )
+		{
+			if( false == CANBurstLoad( u8MOBIndex ) )
 			{
-				// Retries exhausted.  Give up
-				sg_u8Busy = 0;
-				sg_bInRetransmit = false;
+				break;
 			}
 		}
 	}
+
+	CANBurstCheckDone();
+}
+
+// Disable all burst MOBs and drop the burst.  Caller must have CAN interrupts disabled.
+static void CANBurstStop( void )
+{
+	uint8_t u8MOBIndex;
+
+	for( u8MOBIndex = CANMOB_BURST_FIRST_IDX; u8MOBIndex <= CANMOB_BURST_LAST_IDX; u8MOBIndex++ )
+	{
+		CANMOBSet( u8MOBIndex, &sg_sMOBDisabled, NULL, 0 );
+	}
+
+	sg_u8BurstInFlight = 0;
+	sg_u8BurstWindow = 0;
+	sg_bBurstActive = false;
+}
+
+// Burst MOB interrupt - refill from the fill callback on TX complete, re-arm on error.
+// Keeping the refill here (rather than on the 100ms tick) keeps the MOBs back-to-back on the wire.
+static void CANBurstInterrupt( uint8_t u8MOBIndex )
+{
+	CANPAGE = u8MOBIndex << 4;
+
+	// Disable the MOB while we look at it
+	CANCDMOB &= (uint8_t)~((1 << CONMOB0) | (1 << CONMOB1));
+
+	if( CANSTMOB & (1 << TXOK) )
+	{
+		CANSTMOB &= ~(1 << TXOK);
+		sg_u8BurstInFlight &= (uint8_t)~(1 << u8MOBIndex);
+
+		(void) CANBurstLoad( u8MOBIndex );
+		CANBurstCheckDone();
+	}
+	else if( CANSTMOB & ((1 << BERR) | (1 << AERR) | (1 << SERR) | (1 << CERR) | (1 << FERR)) )
+	{
+		CANSTMOB &= ~((1 << BERR) | (1 << AERR) | (1 << SERR) | (1 << CERR) | (1 << FERR));
+
+		if( ++sg_u8TxAttempts[u8MOBIndex] < CAN_TX_MAX_ATTEMPTS )
+		{
+			// ID and data are still in the MOB - just re-arm it
+			CANCDMOB |= (1 << CONMOB0);
+		}
+		else
+		{
+			// Retries exhausted.  Give up on the whole burst
+			sg_u16TxErrors++;
+			sg_bBurstFailed = true;
+			CANBurstStop();
+		}
+	}
 }
 
 // Generic CAN interrupt handler
@@ -712,7 +969,9 @@ ISR(CAN_INT_vect, ISR_BLOCK)
 {
 	// Save state we'll need to restore
 	uint8_t saved_cangie = CANGIE;
-	uint8_t saved_canie2 = CANIE2;	// Temporarily disable CAN interrupts to prevent reentry
+	uint8_t saved_canie2 = CANIE2;	// MOB interrupt enables, for the MOBs CANMOBInterrupt() masks
+	uint8_t u8Masked = 0;			// MOBs whose enable CANMOBInterrupt() cleared
+	uint8_t saved_canpage = CANPAGE;	// Main loop may be mid-access on another MOB page
 	CANGIE &= (uint8_t)~(1 << ENIT);
 
 	// Do NOT re-enable global interrupts - this causes race conditions!
@@ -723,19 +982,41 @@ ISR(CAN_INT_vect, ISR_BLOCK)
 	 // Check MOB 0 (module-specific RX)
 	 if(sit & (1 << CANMOB_RX_IDX)) {
 		 CANMOBInterrupt(CANMOB_RX_IDX);
+		 u8Masked |= (1 << CANMOB_RX_IDX);
 		 sg_bMOB0NeedsReconfigure = true;  // Defer MOB reconfiguration to main loop
 	 }
 
 	 // Check MOB 2 (broadcast RX)
 	 if(sit & (1 << 2)) {
 		 CANMOBInterrupt(2);
+		 u8Masked |= (1 << 2);
 		 sg_bMOB2NeedsReconfigure = true;  // Defer MOB reconfiguration to main loop
 	 }
 
-	// Check TX MOB
-	if( sit & (1 << CANMOB_TX_IDX) )
+	// Check TX MOBs - queue and burst
+	if( sit & CANMOB_TX_QUEUE_MASK )
 	{
-		CANMOBInterrupt( CANMOB_TX_IDX );
+		uint8_t u8MOBIndex;
+
+		for( u8MOBIndex = CANMOB_TX_IDX; u8MOBIndex < CANMOB_COUNT; u8MOBIndex++ )
+		{
+			if( 0 == (sit & CANMOB_TX_QUEUE_MASK & (1 << u8MOBIndex)) )
+			{
+				continue;
+			}
+
+			if( sg_u8BurstInFlight & (1 << u8MOBIndex) )
+			{
+				CANBurstInterrupt( u8MOBIndex );
+			}
+			else
+			{
+				CANTxInterrupt( u8MOBIndex );
+			}
+		}
+
+		// Refill whatever was freed (including burst MOBs if the burst just finished)
+		CANTxQueueLoad();
 	}
 	
 	// Now the generic, non-MOB interrupts (some of which may have already been handled by the MOB handler)
@@ -754,9 +1035,15 @@ ISR(CAN_INT_vect, ISR_BLOCK)
 		// and must be manually re-enabled
 		CANGCON = (1 << ENASTB);
 
-		// Clear busy flag since any pending transmission is lost
-		sg_u8Busy = 0;
-		sg_bInRetransmit = false;
+		// Any pending transmission is lost - drop the queue with it
+		CANTxQueueFlush();
+
+		// Same goes for any burst in progress
+		if( sg_bBurstActive )
+		{
+			sg_bBurstFailed = true;
+			CANBurstStop();
+		}
 
 		// Set recovery delay - don't transmit for a while after bus-off
 		// This gives the bus time to stabilize and prevents immediate re-entry to bus-off
@@ -804,21 +1091,17 @@ ISR(CAN_INT_vect, ISR_BLOCK)
 		// Clear the interrupt
 		CANGIT = (1 << AERG);
 
-		if( sg_u8TransmitAttempts < 20 )
-		{
-			// Set flag to retry in main loop (reduces ISR duration)
-			sg_bRetryPending = true;
-		}
-		else
-		{
-			// Retries exhausted.  Give up
-			sg_u8Busy = 0;
-		}
+		// The TX MOB that missed its ACK also flags AERR in CANSTMOB and
+		// is retried from CANTxInterrupt() / CANBurstInterrupt()
 	}
 
 	// Reenable CAN general interrupt	
 //	CANGIE |= (1 << ENIT);
-    CANIE2 = saved_canie2;
+	CANPAGE = saved_canpage;
+	// Only give back the enables CANMOBInterrupt() took away.  TX MOBs armed in here
+	// (CANTxQueueLoad(), CANBurstLoad()) set their own, and writing the saved value
+	// back over the whole register would clear them again.
+    CANIE2 |= (uint8_t)(saved_canie2 & u8Masked);
     CANGIE = saved_cangie;
 }
 
@@ -826,6 +1109,19 @@ bool CANSendMessage( ECANMessageType eType,
 					 uint8_t* pu8Data,
 					 uint8_t u8DataLen )
 {
+	return( CANSendMessageWithSeq( eType, pu8Data, u8DataLen, 0 ) );
+}
+
+// Queue a message for transmit.  Returns false only if the bus is recovering
+// (bus-off/backoff) or the queue for the message's priority is full.
+bool CANSendMessageWithSeq( ECANMessageType eType,
+						uint8_t* pu8Data,
+						uint8_t u8DataLen,
+						uint16_t u16SeqNum )
+{
+	uint8_t savedCANGIE;
+	bool bQueued;
+
 	// VUART timing interference prevention - COMMENTED OUT
 	// While this successfully eliminated scope-visible disruptions to VUART timing,
 	// it severely disrupted CAN communications. Next-gen solution is faster processor.
@@ -847,52 +1143,115 @@ bool CANSendMessage( ECANMessageType eType,
 		return(false);
 	}
 
-	// If we're busy, kick it back so we're cooperatively multitasking
-	// rather than spin locking
-	if (sg_u8Busy)
+	savedCANGIE = CANGIE;
+	CANGIE &= ~(1 << ENIT);
+
+	bQueued = CANTxQueuePut( eType, pu8Data, u8DataLen, u16SeqNum );
+
+	// Start it now if a TX MOB is free, otherwise the ISR picks it up
+	CANTxQueueLoad();
+
+	CANGIE = savedCANGIE;
+
+	return( bQueued );
+}
+
+// Start streaming segments through the burst MOBs.  pfFill is called from the CAN
+// ISR for each segment and returns false when there are no more.  The data length
+// defaults to 8 bytes; pfFill may shorten it.  Returns false if a burst is already
+// running or the bus isn't fit to transmit.
+bool CANBurstStart( ECANMessageType eType,
+					bool (*pfFill)(uint16_t* pu16SeqNum, uint8_t* pu8Data, uint8_t* pu8DataLen) )
+{
+	uint8_t savedCANGIE;
+
+	if( sg_bBurstActive ||
+		(sg_u8BusOffRecoveryDelay > 0) ||
+		(sg_u8TxBackoffDelay > 0) )
 	{
-		return(false);
+		return( false );
+	}
+
+	// Let the TX queue drain first so anything sent ahead of the
+	// burst (eg. FrameTransferStart) goes out ahead of it on the wire
+	if( sg_u8TxInFlight || (false == CANTxQueueEmpty()) )
+	{
+		return( false );
 	}
 
-	CANSendMessageInternal( eType, pu8Data, u8DataLen, false );
+	savedCANGIE = CANGIE;
+	CANGIE &= ~(1 << ENIT);
+
+	sg_psBurstDef = CANMessageDef( eType );
+	sg_pfBurstFill = pfFill;
+	sg_bBurstDrained = false;
+	sg_bBurstFailed = false;
+	sg_u8BurstInFlight = 0;
+	sg_u8BurstWindow = CAN_BURST_WINDOW_SEGMENTS;
+	sg_bBurstActive = true;
+
+	CANBurstLoadAll();
+
+	CANGIE = savedCANGIE;
+
 	return( true );
 }
 
-bool CANSendMessageWithSeq( ECANMessageType eType,
-						uint8_t* pu8Data,
-						uint8_t u8DataLen,
-						uint16_t u16SeqNum )
+// Abandon any burst in progress
+void CANBurstAbort( void )
 {
-	// VUART timing interference prevention - COMMENTED OUT
-	// While this successfully eliminated scope-visible disruptions to VUART timing,
-	// it severely disrupted CAN communications. Next-gen solution is faster processor.
-	// For now, need to find alternate approach (priority adjustment, shorter ISRs, etc.)
-	// if (vUARTIsBusy())
-	// {
-	//     return(false);
-	// }
+	uint8_t savedCANGIE = CANGIE;
+	CANGIE &= ~(1 << ENIT);
 
-	// Don't transmit during bus-off recovery period
-	if (sg_u8BusOffRecoveryDelay > 0)
+	if( sg_bBurstActive )
 	{
-		return(false);
+		CANBurstStop();
 	}
 
-	// Don't transmit during TX backoff period (adaptive backoff for persistent errors)
-	if (sg_u8TxBackoffDelay > 0)
+	CANGIE = savedCANGIE;
+}
+
+// Burst flow control - call every main loop pass.  Once a window of
+// CAN_BURST_WINDOW_SEGMENTS has drained, the next window is only opened when
+// the TX queue is idle and there's no received traffic waiting, so
+// status responses and MaxState handling get their turn between windows.
+void CANBurstService( void )
+{
+	uint8_t savedCANGIE;
+
+	if( (false == sg_bBurstActive) ||
+		(sg_u8BurstWindow > 0) ||
+		(sg_u8BurstInFlight != 0) )
 	{
-		return(false);
+		return;
 	}
 
-	// If we're busy, kick it back so we're cooperatively multitasking
-	// rather than spin locking
-	if (sg_u8Busy)
+	if( sg_u8TxInFlight ||
+		(false == CANTxQueueEmpty()) ||
+		(sg_rxQueueHead != sg_rxQueueTail) ||
+		(sg_u8BusOffRecoveryDelay > 0) ||
+		(sg_u8TxBackoffDelay > 0) )
 	{
-		return(false);
+		return;
 	}
 
-	CANSendMessageInternalWithSeq( eType, pu8Data, u8DataLen, u16SeqNum, false );
-	return( true );
+	savedCANGIE = CANGIE;
+	CANGIE &= ~(1 << ENIT);
+
+	sg_u8BurstWindow = CAN_BURST_WINDOW_SEGMENTS;
+	CANBurstLoadAll();
+
+	CANGIE = savedCANGIE;
+}
+
+bool CANBurstActive( void )
+{
+	return( sg_bBurstActive );
+}
+
+bool CANBurstFailed( void )
+{
+	return( sg_bBurstFailed );
 }
 
 void CANSetRXCallback( void (*pfCallback)(ECANMessageType eType, uint8_t* pu8Data, uint8_t u8DataLen) )
@@ -975,62 +1334,94 @@ void CANInit( void )
 
 	// Enable the bus
 	CANGCON = (1 << ENASTB);
-	sg_u8Busy = 0;
+	CANTxQueueFlush();
 }
 
+// Poll the TX queue MOBs every tick (100ms) - catches completions whose interrupt
+// was missed, gives up on stuck transmissions and restarts the queue once any
+// bus-off/backoff delay has expired.
 void CANCheckTxStatus(void)
 {
-	// Only check if we think we're busy
-	if (sg_u8Busy > 0)
+	uint8_t savedCANGIE = CANGIE;
+	uint8_t savedMOB;
+	uint8_t u8MOBIndex;
+
+	CANGIE &= ~(1 << ENIT);
+	savedMOB = CANPAGE;
+
+	for( u8MOBIndex = CANMOB_TX_IDX; u8MOBIndex < CANMOB_COUNT; u8MOBIndex++ )
 	{
-		// Save current MOB and switch to TX MOB
-		uint8_t savedMOB = CANPAGE;
-		CANPAGE = CANMOB_TX_IDX << MOBNB0;
+		// Burst MOBs age the same way.  One that never completes (a missed
+		// interrupt, say) fails the burst rather than leaving it running for good.
+		if( sg_u8BurstInFlight & (1 << u8MOBIndex) )
+		{
+			CANPAGE = u8MOBIndex << MOBNB0;
+
+			if( CANSTMOB & ((1 << TXOK) | (1 << BERR) | (1 << SERR) | (1 << CERR) | (1 << FERR) | (1 << AERR)) )
+			{
+				// Completed or errored without us hearing about it
+				sg_u16TxOkPolled++;
+				CANBurstInterrupt( u8MOBIndex );
+			}
+			else if( 0 == --sg_u8TxTimeout[u8MOBIndex] )
+			{
+				sg_u16TxTimeouts++;
+				sg_bBurstFailed = true;
+				CANBurstAbort();
+			}
+
+			continue;
+		}
+
+		// Only check MOBs we think are busy
+		if( 0 == (sg_u8TxInFlight & (1 << u8MOBIndex)) )
+		{
+			continue;
+		}
+
+		CANPAGE = u8MOBIndex << MOBNB0;
 
 		// Check if transmission completed successfully
 		if (CANSTMOB & (1 << TXOK))
 		{
 			// Clear the flag
 			CANSTMOB &= ~(1 << TXOK);
-			sg_u8Busy = 0;
+			sg_u8TxInFlight &= (uint8_t)~(1 << u8MOBIndex);
 			sg_u16TxOkPolled++;	// Diagnostic: we caught TXOK by polling
 		}
 		// Check for transmission errors
 		else if (CANSTMOB & ((1 << BERR) | (1 << SERR) | (1 << CERR) | (1 << FERR) | (1 << AERR)))
 		{
-			// Clear all error flags and reset busy flag
+			// Clear all error flags and give up on the message
 			CANSTMOB = 0x00;
-			sg_u8Busy = 0;
+			CANCDMOB = 0x00;
+			sg_u8TxInFlight &= (uint8_t)~(1 << u8MOBIndex);
 			sg_u16TxErrors++;	// Diagnostic: error recovered
-
-			// Clear in-retransmit flag since we're giving up
-			sg_bInRetransmit = false;
 		}
 		else
 		{
 			// No completion or error yet, decrement timeout counter
-			sg_u8Busy--;
+			sg_u8TxTimeout[u8MOBIndex]--;
 
 			// If timeout expired, force clear
-			if (sg_u8Busy == 0)
+			if (sg_u8TxTimeout[u8MOBIndex] == 0)
 			{
 				// Clear any pending status and disable the MOB
 				CANSTMOB = 0x00;
 				CANCDMOB = 0x00;	// Disable the MOB
-
-				// Clear in-retransmit flag since we're giving up
-				sg_bInRetransmit = false;
-
-				// Disable the MOB interrupt to prevent spurious interrupts
-				CANIE2 &= ~(1 << CANMOB_TX_IDX);
+				sg_u8TxInFlight &= (uint8_t)~(1 << u8MOBIndex);
 
 				sg_u16TxTimeouts++;	// Diagnostic: timeout occurred
 			}
 		}
-
-		// Restore MOB
-		CANPAGE = savedMOB;
 	}
+
+	// Refill anything freed above
+	CANTxQueueLoad();
+
+	// Restore MOB
+	CANPAGE = savedMOB;
+	CANGIE = savedCANGIE;
 }
 
 uint16_t CANGetTxTimeouts(void)
@@ -1154,6 +1545,13 @@ void CANCheckHealth(void)
 		// CAN controller is disabled - re-enable it!
 		CANGCON = (1 << ENASTB);
 
+		// Any burst in flight was lost with it
+		if( sg_bBurstActive )
+		{
+			sg_bBurstFailed = true;
+			CANBurstAbort();
+		}
+
 		// Re-initialize RX MOB since controller was disabled
 		CANMOBSet(CANMOB_RX_IDX, &sg_sMOBGenericReceive, NULL, 0);
 
@@ -1221,21 +1619,15 @@ void CANCheckMOBs(void)
 	}
 }
 
-// Check and process TX retries if needed - call from main loop
-// This defers TX retry logic out of ISR for reduced interrupt latency
-void CANCheckRetry(void)
-{
-	if (sg_bRetryPending)
-	{
-		sg_bInRetransmit = true;
-		CANSendMessageInternal(sg_eLastTXType, sg_u8LastTXData, sg_u8LastTXDataLen, true);
-		sg_bRetryPending = false;
-	}
-}
-
 // Get RX queue overflow count - diagnostic function
 uint16_t CANGetRxQueueOverflows(void)
 {
 	return sg_u16RxQueueOverflows;
 }
 
+// Get TX queue overflow count - diagnostic function
+uint16_t CANGetTxQueueOverflows(void)
+{
+	return sg_u16TxQueueOverflows;
+}
+
@@ -17,6 +17,11 @@ typedef enum
 	ECANMessageType_ModuleCellCommStat1,
 	ECANMessageType_ModuleCellCommStat2,
 	ECANMessageType_ModuleRequestTime,
+	ECANMessageType_ModuleCellDetailBulk,
+	ECANMessageType_ModuleVUARTTiming,
+	ECANMessageType_ModuleCellErrors,
+	ECANMessageType_ModuleSession,
+	ECANMessageType_ModuleSessionSummary,
 	
 	// Pack controller messages
 	ECANMessageType_ModuleRegistration,
@@ -29,12 +34,19 @@ typedef enum
 	ECANMessageType_AllIsolate,
 	ECANMessageType_SetTime,
 	ECANMessageType_MaxState,
+	ECANMessageType_FrameRate,
+	ECANMessageType_CellWindow,
+	ECANMessageType_SessionRequest,
 
 	// Frame transfer messages
 	ECANMessageType_FrameTransferRequest,  // Pack → Module: Request frame transfer
 	ECANMessageType_FrameTransferStart,    // Module → Pack: Start frame transfer
 	ECANMessageType_FrameTransferData,     // Module → Pack: Frame data segment
 	ECANMessageType_FrameTransferEnd,      // Module → Pack: End frame transfer
+	ECANMessageType_FrameTransferAck,      // Pack → Module: Frame received intact
+	ECANMessageType_FrameTransferNack,     // Pack → Module: Resend missing segments
+	ECANMessageType_FrameCheck,            // Module → Pack: Frame that didn't read back, or scrub finished
+	ECANMessageType_FrameScrubRequest,     // Pack → Module: Check a range of frames on the card
 
 	ECANMessageType_MAX
 } ECANMessageType;
@@ -55,7 +67,14 @@ extern void CANCheckTxStatus( void );
 // Main loop processing functions - MUST be called regularly from main loop
 extern void CANProcessQueue( void );    // Process queued RX messages
 extern void CANCheckMOBs( void );       // Reconfigure MOBs if needed
-extern void CANCheckRetry( void );      // Process TX retries
+
+// Burst transfer - streams bulk data through the spare MOBs, refilled from the CAN ISR
+extern bool CANBurstStart( ECANMessageType eType,
+						   bool (*pfFill)(uint16_t* pu16SeqNum, uint8_t* pu8Data, uint8_t* pu8DataLen) );
+extern void CANBurstAbort( void );
+extern void CANBurstService( void );    // Burst flow control - call every main loop pass
+extern bool CANBurstActive( void );
+extern bool CANBurstFailed( void );
 
 // Diagnostic functions
 extern uint16_t CANGetTxTimeouts( void );
@@ -63,6 +82,7 @@ extern uint16_t CANGetTxErrors( void );
 extern uint16_t CANGetTxOkPolled( void );
 extern uint16_t CANGetBusOffEvents( void );
 extern uint16_t CANGetRxQueueOverflows( void );
+extern uint16_t CANGetTxQueueOverflows( void );
 extern uint8_t CANGetTEC( void );
 extern uint8_t CANGetREC( void );
 extern uint8_t CANGetTxOnlyErrorCount( void );
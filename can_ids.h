@@ -24,6 +24,11 @@
 #define PKT_MODULE_STATUS2          ID_MODULE_STATUS_2
 #define PKT_MODULE_STATUS3          ID_MODULE_STATUS_3
 #define PKT_MODULE_CELL_DETAIL      ID_MODULE_DETAIL
+#define PKT_MODULE_CELL_DETAIL_BULK ID_MODULE_DETAIL_BULK
+#define PKT_MODULE_VUART_TIMING     ID_MODULE_VUART_TIMING
+#define PKT_MODULE_CELL_ERRORS      ID_MODULE_CELL_ERRORS
+#define PKT_MODULE_SESSION          ID_MODULE_SESSION
+#define PKT_MODULE_SESSION_SUMMARY  ID_MODULE_SESSION_SUMMARY
 #define PKT_MODULE_REQUEST_TIME     ID_MODULE_TIME_REQUEST
 #define PKT_MODULE_CELL_COMM_STAT1  ID_MODULE_CELL_COMM_STATUS1
 #define PKT_MODULE_CELL_COMM_STAT2  ID_MODULE_CELL_COMM_STATUS2
@@ -37,6 +42,9 @@
 #define PKT_MODULE_SET_TIME         ID_MODULE_SET_TIME
 #define PKT_MODULE_MAX_STATE        ID_MODULE_MAX_STATE
 #define PKT_MODULE_DEREGISTER       ID_MODULE_DEREGISTER
+#define PKT_MODULE_FRAME_RATE       ID_MODULE_FRAME_RATE
+#define PKT_MODULE_CELL_WINDOW      ID_MODULE_CELL_WINDOW
+#define PKT_MODULE_SESSION_REQUEST  ID_MODULE_SESSION_REQUEST
 #define PKT_MODULE_ANNOUNCE_REQUEST ID_MODULE_ANNOUNCE_REQUEST
 #define PKT_MODULE_ALL_DEREGISTER   ID_MODULE_ALL_DEREGISTER
 #define PKT_MODULE_ALL_ISOLATE      ID_MODULE_ALL_ISOLATE
@@ -46,5 +54,9 @@
 #define PKT_FRAME_TRANSFER_START    ID_FRAME_TRANSFER_START
 #define PKT_FRAME_TRANSFER_DATA     ID_FRAME_TRANSFER_DATA
 #define PKT_FRAME_TRANSFER_END      ID_FRAME_TRANSFER_END
+#define PKT_FRAME_TRANSFER_ACK      ID_FRAME_TRANSFER_ACK
+#define PKT_FRAME_TRANSFER_NACK     ID_FRAME_TRANSFER_NACK
+#define PKT_FRAME_CHECK             ID_FRAME_CHECK
+#define PKT_FRAME_SCRUB_REQUEST     ID_FRAME_SCRUB_REQUEST
 
 #endif /* INC_CAN_IDS_H_ */
@@ -0,0 +1,65 @@
+#ifndef _CELLCAL_H_
+#define _CELLCAL_H_
+
+#include <stdint.h>
+#include "adc.h"
+
+// Cell voltage/temperature calibration - the one place it's expressed. Shared by the
+// firmware and gencelltables, which turns it into the flash lookup tables in
+// celltables.h. Change anything here and regenerate (see gencelltables/).
+
+// # Of valid data bits for cell voltage
+#define CELL_VOLTAGE_BITS		10			// # Of valid bits in the cell voltage
+#define CELL_DIV_TOP			90900		// Resistance of cell plus->voltage resistor on cell CPU
+#define CELL_DIV_BOTTOM			30100		// Resistance of ground->voltage resistor on cell CPU
+#define CELL_VOLTAGE_SCALE		(((float) CELL_DIV_BOTTOM) / ((float) CELL_DIV_TOP + (float) CELL_DIV_BOTTOM))
+
+#define CELL_VOLTAGE_CAL 1.032 //measured calibration factor
+
+// Cell VREF
+#define CELL_VREF				1.1
+
+#define FIXED_POINT_SCALE 512  // 2^9, gives us 9 bits of fractional precision  (10 bits overflows)
+
+// Pre-calculate these constants:
+#define VOLTAGE_CONVERSION_FACTOR ((uint32_t)((CELL_VREF * 1000.0 / CELL_VOLTAGE_SCALE * CELL_VOLTAGE_CAL * FIXED_POINT_SCALE) + 0.5))
+#define ADC_MAX_VALUE (1 << CELL_VOLTAGE_BITS)
+
+// Temperature table covers whole degrees -256 to +255 (bits 4-12 of the sign
+// extended MCP9843 reading), indexed by (whole degrees & CELL_TEMP_TABLE_MASK)
+#define CELL_TEMP_TABLE_ENTRIES		512
+#define CELL_TEMP_TABLE_MASK		(CELL_TEMP_TABLE_ENTRIES - 1)
+#define CELL_TEMP_FRACTION_ENTRIES	16
+
+// Reference arithmetic. The tables are generated from these, and the firmware falls
+// back to them for anything outside the tables.
+
+// RAW 10 bit cell ADC reading to millivolts (0 = invalid)
+static inline uint16_t CellCalVoltage(uint16_t u16Raw)
+{
+	// Convert from # of scale of the ADC to the nondivided voltage range, in millivolts
+	uint32_t temp = (uint32_t)u16Raw * VOLTAGE_CONVERSION_FACTOR;
+	uint16_t u16Voltage = (uint16_t)((temp / ADC_MAX_VALUE + FIXED_POINT_SCALE/2) / FIXED_POINT_SCALE);
+
+	// Still check for completely invalid values (0 or 0xFFFF)
+	if (u16Voltage == 0xFFFF)
+	{
+		u16Voltage = 0;
+	}
+
+	return(u16Voltage);
+}
+
+// 16ths of a degree C to 100ths (0-15 -> 0-93)
+static inline uint8_t CellCalTemperatureFraction(uint8_t u8Fractional)
+{
+	return((uint8_t) (((uint16_t) u8Fractional * 100) >> 4));
+}
+
+// Whole degrees C plus 16ths to 100ths of degrees C with TEMPERATURE_BASE offset
+static inline int16_t CellCalTemperature(int16_t s16Whole, uint8_t u8Fractional)
+{
+	return((int16_t) ((s16Whole * 100) + (int16_t) CellCalTemperatureFraction(u8Fractional) + TEMPERATURE_BASE));
+}
+
+#endif // _CELLCAL_H_
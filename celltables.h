@@ -0,0 +1,227 @@
+#ifndef _CELLTABLES_H_
+#define _CELLTABLES_H_
+
+// GENERATED by gencelltables from cellcal.h - do not edit. Regenerate whenever the
+// calibration in cellcal.h changes.
+
+#include <stdint.h>
+
+#ifdef __AVR__
+#include <avr/pgmspace.h>
+#elif !defined(PROGMEM)
+#define PROGMEM
+#endif
+
+// VOLTAGE_CONVERSION_FACTOR these tables were generated with
+#define CELL_TABLE_VOLTAGE_CONVERSION_FACTOR	2336475UL
+
+// RAW 10 bit cell voltage to millivolts, 0 = invalid
+static const uint16_t sg_u16CellVoltageTable[1 << CELL_VOLTAGE_BITS] PROGMEM =
+{
+	    0,     4,     9,    13,    18,    22,    27,    31,
+	   36,    40,    45,    49,    53,    58,    62,    67,
+	   71,    76,    80,    85,    89,    94,    98,   102,
+	  107,   111,   116,   120,   125,   129,   134,   138,
+	  143,   147,   152,   156,   160,   165,   169,   174,
+	  178,   183,   187,   192,   196,   201,   205,   209,
+	  214,   218,   223,   227,   232,   236,   241,   245,
+	  250,   254,   258,   263,   267,   272,   276,   281,
+	  285,   290,   294,   299,   303,   307,   312,   316,
+	  321,   325,   330,   334,   339,   343,   348,   352,
+	  357,   361,   365,   370,   374,   379,   383,   388,
+	  392,   397,   401,   406,   410,   414,   419,   423,
+	  428,   432,   437,   441,   446,   450,   455,   459,
+	  463,   468,   472,   477,   481,   486,   490,   495,
+	  499,   504,   508,   512,   517,   521,   526,   530,
+	  535,   539,   544,   548,   553,   557,   562,   566,
+	  570,   575,   579,   584,   588,   593,   597,   602,
+	  606,   611,   615,   619,   624,   628,   633,   637,
+	  642,   646,   651,   655,   660,   664,   668,   673,
+	  677,   682,   686,   691,   695,   700,   704,   709,
+	  713,   717,   722,   726,   731,   735,   740,   744,
+	  749,   753,   758,   762,   767,   771,   775,   780,
+	  784,   789,   793,   798,   802,   807,   811,   816,
+	  820,   824,   829,   833,   838,   842,   847,   851,
+	  856,   860,   865,   869,   873,   878,   882,   887,
+	  891,   896,   900,   905,   909,   914,   918,   922,
+	  927,   931,   936,   940,   945,   949,   954,   958,
+	  963,   967,   972,   976,   980,   985,   989,   994,
+	  998,  1003,  1007,  1012,  1016,  1021,  1025,  1029,
+	 1034,  1038,  1043,  1047,  1052,  1056,  1061,  1065,
+	 1070,  1074,  1078,  1083,  1087,  1092,  1096,  1101,
+	 1105,  1110,  1114,  1119,  1123,  1127,  1132,  1136,
+	 1141,  1145,  1150,  1154,  1159,  1163,  1168,  1172,
+	 1177,  1181,  1185,  1190,  1194,  1199,  1203,  1208,
+	 1212,  1217,  1221,  1226,  1230,  1234,  1239,  1243,
+	 1248,  1252,  1257,  1261,  1266,  1270,  1275,  1279,
+	 1283,  1288,  1292,  1297,  1301,  1306,  1310,  1315,
+	 1319,  1324,  1328,  1332,  1337,  1341,  1346,  1350,
+	 1355,  1359,  1364,  1368,  1373,  1377,  1382,  1386,
+	 1390,  1395,  1399,  1404,  1408,  1413,  1417,  1422,
+	 1426,  1431,  1435,  1439,  1444,  1448,  1453,  1457,
+	 1462,  1466,  1471,  1475,  1480,  1484,  1488,  1493,
+	 1497,  1502,  1506,  1511,  1515,  1520,  1524,  1529,
+	 1533,  1537,  1542,  1546,  1551,  1555,  1560,  1564,
+	 1569,  1573,  1578,  1582,  1587,  1591,  1595,  1600,
+	 1604,  1609,  1613,  1618,  1622,  1627,  1631,  1636,
+	 1640,  1644,  1649,  1653,  1658,  1662,  1667,  1671,
+	 1676,  1680,  1685,  1689,  1693,  1698,  1702,  1707,
+	 1711,  1716,  1720,  1725,  1729,  1734,  1738,  1742,
+	 1747,  1751,  1756,  1760,  1765,  1769,  1774,  1778,
+	 1783,  1787,  1792,  1796,  1800,  1805,  1809,  1814,
+	 1818,  1823,  1827,  1832,  1836,  1841,  1845,  1849,
+	 1854,  1858,  1863,  1867,  1872,  1876,  1881,  1885,
+	 1890,  1894,  1898,  1903,  1907,  1912,  1916,  1921,
+	 1925,  1930,  1934,  1939,  1943,  1947,  1952,  1956,
+	 1961,  1965,  1970,  1974,  1979,  1983,  1988,  1992,
+	 1996,  2001,  2005,  2010,  2014,  2019,  2023,  2028,
+	 2032,  2037,  2041,  2046,  2050,  2054,  2059,  2063,
+	 2068,  2072,  2077,  2081,  2086,  2090,  2095,  2099,
+	 2103,  2108,  2112,  2117,  2121,  2126,  2130,  2135,
+	 2139,  2144,  2148,  2152,  2157,  2161,  2166,  2170,
+	 2175,  2179,  2184,  2188,  2193,  2197,  2201,  2206,
+	 2210,  2215,  2219,  2224,  2228,  2233,  2237,  2242,
+	 2246,  2251,  2255,  2259,  2264,  2268,  2273,  2277,
+	 2282,  2286,  2291,  2295,  2300,  2304,  2308,  2313,
+	 2317,  2322,  2326,  2331,  2335,  2340,  2344,  2349,
+	 2353,  2357,  2362,  2366,  2371,  2375,  2380,  2384,
+	 2389,  2393,  2398,  2402,  2406,  2411,  2415,  2420,
+	 2424,  2429,  2433,  2438,  2442,  2447,  2451,  2456,
+	 2460,  2464,  2469,  2473,  2478,  2482,  2487,  2491,
+	 2496,  2500,  2505,  2509,  2513,  2518,  2522,  2527,
+	 2531,  2536,  2540,  2545,  2549,  2554,  2558,  2562,
+	 2567,  2571,  2576,  2580,  2585,  2589,  2594,  2598,
+	 2603,  2607,  2611,  2616,  2620,  2625,  2629,  2634,
+	 2638,  2643,  2647,  2652,  2656,  2661,  2665,  2669,
+	 2674,  2678,  2683,  2687,  2692,  2696,  2701,  2705,
+	 2710,  2714,  2718,  2723,  2727,  2732,  2736,  2741,
+	 2745,  2750,  2754,  2759,  2763,  2767,  2772,  2776,
+	 2781,  2785,  2790,  2794,  2799,  2803,  2808,  2812,
+	 2816,  2821,  2825,  2830,  2834,  2839,  2843,  2848,
+	 2852,  2857,  2861,  2866,  2870,  2874,  2879,  2883,
+	 2888,  2892,  2897,  2901,  2906,  2910,  2915,  2919,
+	 2923,  2928,  2932,  2937,  2941,  2946,  2950,  2955,
+	 2959,  2964,  2968,  2972,  2977,  2981,  2986,  2990,
+	 2995,  2999,  3004,  3008,  3013,  3017,  3021,  3026,
+	 3030,  3035,  3039,  3044,  3048,  3053,  3057,  3062,
+	 3066,  3071,  3075,  3079,  3084,  3088,  3093,  3097,
+	 3102,  3106,  3111,  3115,  3120,  3124,  3128,  3133,
+	 3137,  3142,  3146,  3151,  3155,  3160,  3164,  3169,
+	 3173,  3177,  3182,  3186,  3191,  3195,  3200,  3204,
+	 3209,  3213,  3218,  3222,  3226,  3231,  3235,  3240,
+	 3244,  3249,  3253,  3258,  3262,  3267,  3271,  3276,
+	 3280,  3284,  3289,  3293,  3298,  3302,  3307,  3311,
+	 3316,  3320,  3325,  3329,  3333,  3338,  3342,  3347,
+	 3351,  3356,  3360,  3365,  3369,  3374,  3378,  3382,
+	 3387,  3391,  3396,  3400,  3405,  3409,  3414,  3418,
+	 3423,  3427,  3431,  3436,  3440,  3445,  3449,  3454,
+	 3458,  3463,  3467,  3472,  3476,  3481,  3485,  3489,
+	 3494,  3498,  3503,  3507,  3512,  3516,  3521,  3525,
+	 3530,  3534,  3538,  3543,  3547,  3552,  3556,  3561,
+	 3565,  3570,  3574,  3579,  3583,  3587,  3592,  3596,
+	 3601,  3605,  3610,  3614,  3619,  3623,  3628,  3632,
+	 3636,  3641,  3645,  3650,  3654,  3659,  3663,  3668,
+	 3672,  3677,  3681,  3686,  3690,  3694,  3699,  3703,
+	 3708,  3712,  3717,  3721,  3726,  3730,  3735,  3739,
+	 3743,  3748,  3752,  3757,  3761,  3766,  3770,  3775,
+	 3779,  3784,  3788,  3792,  3797,  3801,  3806,  3810,
+	 3815,  3819,  3824,  3828,  3833,  3837,  3841,  3846,
+	 3850,  3855,  3859,  3864,  3868,  3873,  3877,  3882,
+	 3886,  3891,  3895,  3899,  3904,  3908,  3913,  3917,
+	 3922,  3926,  3931,  3935,  3940,  3944,  3948,  3953,
+	 3957,  3962,  3966,  3971,  3975,  3980,  3984,  3989,
+	 3993,  3997,  4002,  4006,  4011,  4015,  4020,  4024,
+	 4029,  4033,  4038,  4042,  4046,  4051,  4055,  4060,
+	 4064,  4069,  4073,  4078,  4082,  4087,  4091,  4095,
+	 4100,  4104,  4109,  4113,  4118,  4122,  4127,  4131,
+	 4136,  4140,  4145,  4149,  4153,  4158,  4162,  4167,
+	 4171,  4176,  4180,  4185,  4189,  4194,  4198,  4202,
+	 4207,  4211,  4216,  4220,  4225,  4229,  4234,  4238,
+	 4243,  4247,  4251,  4256,  4260,  4265,  4269,  4274,
+	 4278,  4283,  4287,  4292,  4296,  4300,  4305,  4309,
+	 4314,  4318,  4323,  4327,  4332,  4336,  4341,  4345,
+	 4350,  4354,  4358,  4363,  4367,  4372,  4376,  4381,
+	 4385,  4390,  4394,  4399,  4403,  4407,  4412,  4416,
+	 4421,  4425,  4430,  4434,  4439,  4443,  4448,  4452,
+	 4456,  4461,  4465,  4470,  4474,  4479,  4483,  4488,
+	 4492,  4497,  4501,  4505,  4510,  4514,  4519,  4523,
+	 4528,  4532,  4537,  4541,  4546,  4550,  4555,  4559
+};
+
+// Whole degrees C (& CELL_TEMP_TABLE_MASK) to 100ths of degrees C with TEMPERATURE_BASE offset
+static const int16_t sg_s16CellTemperatureTable[CELL_TEMP_TABLE_ENTRIES] PROGMEM =
+{
+	  5535,   5635,   5735,   5835,   5935,   6035,   6135,   6235,
+	  6335,   6435,   6535,   6635,   6735,   6835,   6935,   7035,
+	  7135,   7235,   7335,   7435,   7535,   7635,   7735,   7835,
+	  7935,   8035,   8135,   8235,   8335,   8435,   8535,   8635,
+	  8735,   8835,   8935,   9035,   9135,   9235,   9335,   9435,
+	  9535,   9635,   9735,   9835,   9935,  10035,  10135,  10235,
+	 10335,  10435,  10535,  10635,  10735,  10835,  10935,  11035,
+	 11135,  11235,  11335,  11435,  11535,  11635,  11735,  11835,
+	 11935,  12035,  12135,  12235,  12335,  12435,  12535,  12635,
+	 12735,  12835,  12935,  13035,  13135,  13235,  13335,  13435,
+	 13535,  13635,  13735,  13835,  13935,  14035,  14135,  14235,
+	 14335,  14435,  14535,  14635,  14735,  14835,  14935,  15035,
+	 15135,  15235,  15335,  15435,  15535,  15635,  15735,  15835,
+	 15935,  16035,  16135,  16235,  16335,  16435,  16535,  16635,
+	 16735,  16835,  16935,  17035,  17135,  17235,  17335,  17435,
+	 17535,  17635,  17735,  17835,  17935,  18035,  18135,  18235,
+	 18335,  18435,  18535,  18635,  18735,  18835,  18935,  19035,
+	 19135,  19235,  19335,  19435,  19535,  19635,  19735,  19835,
+	 19935,  20035,  20135,  20235,  20335,  20435,  20535,  20635,
+	 20735,  20835,  20935,  21035,  21135,  21235,  21335,  21435,
+	 21535,  21635,  21735,  21835,  21935,  22035,  22135,  22235,
+	 22335,  22435,  22535,  22635,  22735,  22835,  22935,  23035,
+	 23135,  23235,  23335,  23435,  23535,  23635,  23735,  23835,
+	 23935,  24035,  24135,  24235,  24335,  24435,  24535,  24635,
+	 24735,  24835,  24935,  25035,  25135,  25235,  25335,  25435,
+	 25535,  25635,  25735,  25835,  25935,  26035,  26135,  26235,
+	 26335,  26435,  26535,  26635,  26735,  26835,  26935,  27035,
+	 27135,  27235,  27335,  27435,  27535,  27635,  27735,  27835,
+	 27935,  28035,  28135,  28235,  28335,  28435,  28535,  28635,
+	 28735,  28835,  28935,  29035,  29135,  29235,  29335,  29435,
+	 29535,  29635,  29735,  29835,  29935,  30035,  30135,  30235,
+	 30335,  30435,  30535,  30635,  30735,  30835,  30935,  31035,
+	-20065, -19965, -19865, -19765, -19665, -19565, -19465, -19365,
+	-19265, -19165, -19065, -18965, -18865, -18765, -18665, -18565,
+	-18465, -18365, -18265, -18165, -18065, -17965, -17865, -17765,
+	-17665, -17565, -17465, -17365, -17265, -17165, -17065, -16965,
+	-16865, -16765, -16665, -16565, -16465, -16365, -16265, -16165,
+	-16065, -15965, -15865, -15765, -15665, -15565, -15465, -15365,
+	-15265, -15165, -15065, -14965, -14865, -14765, -14665, -14565,
+	-14465, -14365, -14265, -14165, -14065, -13965, -13865, -13765,
+	-13665, -13565, -13465, -13365, -13265, -13165, -13065, -12965,
+	-12865, -12765, -12665, -12565, -12465, -12365, -12265, -12165,
+	-12065, -11965, -11865, -11765, -11665, -11565, -11465, -11365,
+	-11265, -11165, -11065, -10965, -10865, -10765, -10665, -10565,
+	-10465, -10365, -10265, -10165, -10065,  -9965,  -9865,  -9765,
+	 -9665,  -9565,  -9465,  -9365,  -9265,  -9165,  -9065,  -8965,
+	 -8865,  -8765,  -8665,  -8565,  -8465,  -8365,  -8265,  -8165,
+	 -8065,  -7965,  -7865,  -7765,  -7665,  -7565,  -7465,  -7365,
+	 -7265,  -7165,  -7065,  -6965,  -6865,  -6765,  -6665,  -6565,
+	 -6465,  -6365,  -6265,  -6165,  -6065,  -5965,  -5865,  -5765,
+	 -5665,  -5565,  -5465,  -5365,  -5265,  -5165,  -5065,  -4965,
+	 -4865,  -4765,  -4665,  -4565,  -4465,  -4365,  -4265,  -4165,
+	 -4065,  -3965,  -3865,  -3765,  -3665,  -3565,  -3465,  -3365,
+	 -3265,  -3165,  -3065,  -2965,  -2865,  -2765,  -2665,  -2565,
+	 -2465,  -2365,  -2265,  -2165,  -2065,  -1965,  -1865,  -1765,
+	 -1665,  -1565,  -1465,  -1365,  -1265,  -1165,  -1065,   -965,
+	  -865,   -765,   -665,   -565,   -465,   -365,   -265,   -165,
+	   -65,     35,    135,    235,    335,    435,    535,    635,
+	   735,    835,    935,   1035,   1135,   1235,   1335,   1435,
+	  1535,   1635,   1735,   1835,   1935,   2035,   2135,   2235,
+	  2335,   2435,   2535,   2635,   2735,   2835,   2935,   3035,
+	  3135,   3235,   3335,   3435,   3535,   3635,   3735,   3835,
+	  3935,   4035,   4135,   4235,   4335,   4435,   4535,   4635,
+	  4735,   4835,   4935,   5035,   5135,   5235,   5335,   5435
+};
+
+// 16ths of a degree C to 100ths
+static const uint8_t sg_u8CellTemperatureFractionTable[CELL_TEMP_FRACTION_ENTRIES] PROGMEM =
+{
+	 0,  6, 12, 18, 25, 31, 37, 43,
+	50, 56, 62, 68, 75, 81, 87, 93
+};
+
+#endif // _CELLTABLES_H_
@@ -6,4 +6,8 @@
 // Calculate CRC32 checksum of data buffer
 extern uint32_t CRC32_Calculate(const uint8_t* data, uint16_t length);
 
+// Carry a CRC32 on over more data - start with 0, and the result of one call is the CRC32
+// of everything so far
+extern uint32_t CRC32_Update(uint32_t crc, const uint8_t* data, uint16_t length);
+
 #endif // _CRC32_H_
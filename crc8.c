@@ -0,0 +1,21 @@
+#include "crc8.h"
+
+// CRC-8 calculation using bit-by-bit algorithm
+// Polynomial: 0x07 (x^8 + x^2 + x + 1), the same one the cell CPUs use on their records
+// Only ever run over a few bytes at a time, so no table
+uint8_t CRC8_Calculate(const uint8_t* data, uint8_t length)
+{
+	uint8_t crc = 0;
+
+	for (uint8_t i = 0; i < length; i++)
+	{
+		crc ^= data[i];
+
+		for (uint8_t j = 0; j < 8; j++)
+		{
+			crc = (uint8_t) ((crc << 1) ^ (0x07 & -(crc >> 7)));
+		}
+	}
+
+	return crc;
+}
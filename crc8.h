@@ -0,0 +1,9 @@
+#ifndef _CRC8_H_
+#define _CRC8_H_
+
+#include <stdint.h>
+
+// Calculate CRC-8 (polynomial 0x07, initial value 0, MSB first) of data buffer
+extern uint8_t CRC8_Calculate(const uint8_t* data, uint8_t length);
+
+#endif // _CRC8_H_
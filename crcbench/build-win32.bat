@@ -0,0 +1 @@
+cl crcbench.c ..\geneeprom\cmdline.c shell32.lib
\ No newline at end of file
@@ -0,0 +1,270 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "../geneeprom/CmdLine.h"
+
+// Times the firmware's own crc32.c built each way CRC32_TABLE_BITS allows (see
+// CRC32_TABLES.md). crc32.c is pulled in once per table size, with its functions and
+// table renamed, so all three are the same source the firmware builds.
+//
+// Times are cycles of the host's time stamp counter where there is one, otherwise ns.
+// They say how the three compare, not what they take on the AVR.
+
+#define CRC32_Update		CRC32_UpdateBits0
+#define CRC32_Calculate		CRC32_CalculateBits0
+#define CRC32_TABLE_BITS	0
+#include "../crc32.c"
+#undef CRC32_Update
+#undef CRC32_Calculate
+#undef CRC32_TABLE_BITS
+
+#define CRC32_Update		CRC32_UpdateBits4
+#define CRC32_Calculate		CRC32_CalculateBits4
+#define sg_u32CRC32Table	sg_u32CRC32Table4
+#define CRC32_TABLE_BITS	4
+#include "../crc32.c"
+#undef CRC32_Update
+#undef CRC32_Calculate
+#undef sg_u32CRC32Table
+#undef CRC32_TABLE_BITS
+
+#define CRC32_Update		CRC32_UpdateBits8
+#define CRC32_Calculate		CRC32_CalculateBits8
+#define sg_u32CRC32Table	sg_u32CRC32Table8
+#define CRC32_TABLE_BITS	8
+#include "../crc32.c"
+#undef CRC32_Update
+#undef CRC32_Calculate
+#undef sg_u32CRC32Table
+#undef CRC32_TABLE_BITS
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define CRCBENCH_CYCLES
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CRCBENCH_CYCLES
+#endif
+
+#define BYTES_DEFAULT		1024	// A frame
+#define PASSES_DEFAULT		2000
+#define VERIFY_BUFFERS		64
+#define VERIFY_BYTES		1024
+
+// The standard check value - CRC32 of "123456789"
+#define CRC32_CHECK			0xcbf43926
+
+typedef uint32_t (*PFCRC32Update)(uint32_t crc, const uint8_t* data, uint16_t length);
+
+typedef struct
+{
+	const char* peName;
+	uint16_t u16FlashBytes;		// Table size
+	PFCRC32Update pfUpdate;
+} SCRC32Variant;
+
+static const SCRC32Variant sg_sVariants[] =
+{
+	{"Bit by bit (0)",		0,		CRC32_UpdateBits0},
+	{"Nibble table (4)",	64,		CRC32_UpdateBits4},
+	{"Byte table (8)",		1024,	CRC32_UpdateBits8},
+};
+
+#define VARIANT_COUNT		(sizeof(sg_sVariants) / sizeof(sg_sVariants[0]))
+
+static SCmdLineOption sg_sCmdLineOptions[] =
+{
+	{"-bytes",			"Bytes per CRC (1024)",									false,	true},
+	{"-passes",			"CRCs timed per variant (2000)",						false,	true},
+	{"-verify",			"Check every variant, one shot and in slices, against each other and the check value",	false,	false},
+	{NULL}
+};
+
+static uint64_t TimeNow(void)
+{
+#ifdef CRCBENCH_CYCLES
+	return(__rdtsc());
+#else
+	return((uint64_t) clock() * (1000000000 / CLOCKS_PER_SEC));
+#endif
+}
+
+// Every variant has to give the check value, and agree with the others on random
+// buffers - in one go and carried on over random slices
+static bool Verify(void)
+{
+	uint8_t u8Buffer[VERIFY_BYTES];
+	uint32_t u32Expected;
+	uint32_t u32Crc;
+	uint16_t u16Pos;
+	uint16_t u16Slice;
+	uint32_t u32Errors = 0;
+	uint8_t u8Variant;
+	uint8_t u8Buf;
+
+	for (u8Variant = 0; u8Variant < VARIANT_COUNT; u8Variant++)
+	{
+		u32Crc = sg_sVariants[u8Variant].pfUpdate(0, (const uint8_t*) "123456789", 9);
+		if (CRC32_CHECK != u32Crc)
+		{
+			printf("%s: check value 0x%08x, should be 0x%08x\n", sg_sVariants[u8Variant].peName, u32Crc, CRC32_CHECK);
+			u32Errors++;
+		}
+	}
+
+	srand(1);
+	for (u8Buf = 0; u8Buf < VERIFY_BUFFERS; u8Buf++)
+	{
+		for (u16Pos = 0; u16Pos < sizeof(u8Buffer); u16Pos++)
+		{
+			u8Buffer[u16Pos] = (uint8_t) rand();
+		}
+
+		u32Expected = CRC32_CalculateBits0(u8Buffer, sizeof(u8Buffer));
+
+		for (u8Variant = 0; u8Variant < VARIANT_COUNT; u8Variant++)
+		{
+			u32Crc = sg_sVariants[u8Variant].pfUpdate(0, u8Buffer, sizeof(u8Buffer));
+			if (u32Crc != u32Expected)
+			{
+				printf("%s: buffer %u in one go 0x%08x, should be 0x%08x\n", sg_sVariants[u8Variant].peName, u8Buf, u32Crc, u32Expected);
+				u32Errors++;
+			}
+
+			// Slices of 0 to 64 bytes, the way the frame transfer and STORE carry it on
+			u32Crc = 0;
+			u16Pos = 0;
+			while (u16Pos < sizeof(u8Buffer))
+			{
+				u16Slice = (uint16_t) (rand() % 65);
+				if (u16Slice > (sizeof(u8Buffer) - u16Pos))
+				{
+					u16Slice = sizeof(u8Buffer) - u16Pos;
+				}
+
+				u32Crc = sg_sVariants[u8Variant].pfUpdate(u32Crc, &u8Buffer[u16Pos], u16Slice);
+				u16Pos += u16Slice;
+			}
+
+			if (u32Crc != u32Expected)
+			{
+				printf("%s: buffer %u in slices 0x%08x, should be 0x%08x\n", sg_sVariants[u8Variant].peName, u8Buf, u32Crc, u32Expected);
+				u32Errors++;
+			}
+		}
+	}
+
+	if (u32Errors)
+	{
+		printf("%u errors\n", u32Errors);
+		return(false);
+	}
+
+	printf("All variants agree\n");
+	return(true);
+}
+
+static void Bench(uint16_t u16Bytes, uint32_t u32Passes)
+{
+	uint8_t* pu8Buffer;
+	uint32_t u32Crc = 0;
+	uint32_t u32Pass;
+	uint64_t u64Start;
+	uint64_t u64Elapsed;
+	double dBase = 0.0;
+	double dPerByte;
+	uint8_t u8Variant;
+	uint16_t u16Pos;
+
+	pu8Buffer = malloc(u16Bytes);
+	if (NULL == pu8Buffer)
+	{
+		printf("Out of memory\n");
+		return;
+	}
+
+	srand(1);
+	for (u16Pos = 0; u16Pos < u16Bytes; u16Pos++)
+	{
+		pu8Buffer[u16Pos] = (uint8_t) rand();
+	}
+
+#ifdef CRCBENCH_CYCLES
+	printf("%u bytes, %u passes, time stamp counter cycles\n\n", u16Bytes, u32Passes);
+	printf("%-18s %-10s %-12s %s\n", "Variant", "Table", "Cycles/byte", "Speed up");
+#else
+	printf("%u bytes, %u passes, ns\n\n", u16Bytes, u32Passes);
+	printf("%-18s %-10s %-12s %s\n", "Variant", "Table", "ns/byte", "Speed up");
+#endif
+
+	for (u8Variant = 0; u8Variant < VARIANT_COUNT; u8Variant++)
+	{
+		// Warm up the caches first
+		u32Crc ^= sg_sVariants[u8Variant].pfUpdate(u32Crc, pu8Buffer, u16Bytes);
+
+		u64Start = TimeNow();
+		for (u32Pass = 0; u32Pass < u32Passes; u32Pass++)
+		{
+			u32Crc ^= sg_sVariants[u8Variant].pfUpdate(u32Crc, pu8Buffer, u16Bytes);
+		}
+		u64Elapsed = TimeNow() - u64Start;
+
+		dPerByte = (double) u64Elapsed / ((double) u32Passes * u16Bytes);
+		if (0 == u8Variant)
+		{
+			dBase = dPerByte;
+		}
+
+		printf("%-18s %-10u %-12.2f %.1fx\n", sg_sVariants[u8Variant].peName,
+			   sg_sVariants[u8Variant].u16FlashBytes,
+			   dPerByte,
+			   (dPerByte > 0.0) ? (dBase / dPerByte) : 0.0);
+	}
+
+	// Keeps the loops from being optimised away
+	printf("\n(0x%08x)\n", u32Crc);
+	free(pu8Buffer);
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t u32Bytes = BYTES_DEFAULT;
+	uint32_t u32Passes = PASSES_DEFAULT;
+
+	if (false == CmdLineInitArgcArgv(argc,
+									 argv,
+									 sg_sCmdLineOptions,
+									 argv[0]))
+	{
+		printf("Failed\n");
+		CmdLineDumpOptions(sg_sCmdLineOptions);
+		return(1);
+	}
+
+	if (CmdLineOptionValue("-bytes"))
+	{
+		u32Bytes = (uint32_t) strtoul(CmdLineOptionValue("-bytes"), NULL, 0);
+	}
+	if (CmdLineOptionValue("-passes"))
+	{
+		u32Passes = (uint32_t) strtoul(CmdLineOptionValue("-passes"), NULL, 0);
+	}
+
+	if ((0 == u32Bytes) || (u32Bytes > 0xffff) || (0 == u32Passes))
+	{
+		printf("-bytes must be 1-65535 and -passes at least 1\n");
+		return(1);
+	}
+
+	if (CmdLineOption("-verify"))
+	{
+		return(Verify() ? 0 : 1);
+	}
+
+	Bench((uint16_t) u32Bytes, u32Passes);
+	return(0);
+}
@@ -0,0 +1,202 @@
+#include "framecodec.h"
+
+void FrameCodec_Init(SFrameCodec* psCodec, const uint8_t* pu8Frame)
+{
+	uint16_t u16Start = pu8Frame[FRAMECODEC_OFFSET_CELLBUFFERSTART];
+	uint16_t u16Stride = (uint16_t) pu8Frame[FRAMECODEC_OFFSET_CELLCOUNT] * FRAMECODEC_CELL_BYTES;
+
+	psCodec->u16DeltaStart = FRAMECODEC_FRAME_BYTES;
+	psCodec->u16Stride = 0;
+
+	// Only delta a sane, quad aligned cell buffer that holds at least two readings.
+	// The metadata parameters themselves must stay raw so the decoder can read them.
+	if ((FRAMECODEC_VERSION_RAW == pu8Frame[FRAMECODEC_OFFSET_VERSION]) &&
+		(u16Start > FRAMECODEC_OFFSET_CELLCOUNT) &&
+		(0 == (u16Start & 3)) &&
+		(u16Stride > 0) &&
+		((u16Start + u16Stride) < FRAMECODEC_FRAME_BYTES))
+	{
+		psCodec->u16DeltaStart = u16Start + u16Stride;
+		psCodec->u16Stride = u16Stride;
+	}
+}
+
+// Transformed (delta) bytes of one quad, returns the nonzero byte mask
+static uint8_t FrameCodecQuad(const SFrameCodec* psCodec,
+							  const uint8_t* pu8Frame,
+							  uint16_t u16Quad,
+							  uint8_t* pu8Bytes)
+{
+	uint16_t u16Offset = u16Quad << 2;
+	uint8_t u8Mask = 0;
+	uint8_t u8Index;
+
+	for (u8Index = 0; u8Index < 4; u8Index++)
+	{
+		uint8_t u8Byte = pu8Frame[u16Offset + u8Index];
+
+		if (u16Offset >= psCodec->u16DeltaStart)
+		{
+			u8Byte -= pu8Frame[u16Offset + u8Index - psCodec->u16Stride];
+		}
+
+		pu8Bytes[u8Index] = u8Byte;
+		if (u8Byte)
+		{
+			u8Mask |= (uint8_t) (1 << u8Index);
+		}
+	}
+
+	return(u8Mask);
+}
+
+// Quick check for an all-zero transformed quad - a single compare per quad,
+// since the encoder runs from the CAN ISR
+static bool FrameCodecQuadZero(const SFrameCodec* psCodec,
+							   const uint8_t* pu8Frame,
+							   uint16_t u16Quad)
+{
+	const uint8_t* pu8Quad = &pu8Frame[u16Quad << 2];
+
+	if ((u16Quad << 2) >= psCodec->u16DeltaStart)
+	{
+		const uint8_t* pu8Previous = pu8Quad - psCodec->u16Stride;
+
+		return((pu8Quad[0] == pu8Previous[0]) &&
+			   (pu8Quad[1] == pu8Previous[1]) &&
+			   (pu8Quad[2] == pu8Previous[2]) &&
+			   (pu8Quad[3] == pu8Previous[3]));
+	}
+
+	return(0 == (pu8Quad[0] | pu8Quad[1] | pu8Quad[2] | pu8Quad[3]));
+}
+
+uint8_t FrameCodec_EncodeSegment(const SFrameCodec* psCodec,
+								 const uint8_t* pu8Frame,
+								 uint16_t* pu16Quad,
+								 uint8_t* pu8Segment)
+{
+	uint16_t u16Quad = *pu16Quad;
+	uint8_t u8Length = 1;
+
+	if (u16Quad >= FRAMECODEC_QUADS)
+	{
+		return(0);
+	}
+
+	pu8Segment[0] = (uint8_t) u16Quad;
+
+	while (u16Quad < FRAMECODEC_QUADS)
+	{
+		uint8_t u8Bytes[4];
+		uint8_t u8Mask = FrameCodecQuad(psCodec, pu8Frame, u16Quad, u8Bytes);
+		uint8_t u8Token = u8Length;
+		uint8_t u8Run = 0;
+		uint8_t u8Index;
+
+		// Token byte plus the nonzero bytes must fit
+		if ((u8Length + 1 + ((u8Mask & 1) + ((u8Mask >> 1) & 1) + ((u8Mask >> 2) & 1) + ((u8Mask >> 3) & 1))) > FRAMECODEC_SEGMENT_BYTES)
+		{
+			break;
+		}
+
+		u8Length++;
+		for (u8Index = 0; u8Index < 4; u8Index++)
+		{
+			if (u8Mask & (1 << u8Index))
+			{
+				pu8Segment[u8Length++] = u8Bytes[u8Index];
+			}
+		}
+		u16Quad++;
+
+		// Zero run after it
+		while ((u8Run < 15) &&
+			   (u16Quad < FRAMECODEC_QUADS) &&
+			   FrameCodecQuadZero(psCodec, pu8Frame, u16Quad))
+		{
+			u8Run++;
+			u16Quad++;
+		}
+
+		pu8Segment[u8Token] = (uint8_t) (u8Mask | (u8Run << 4));
+	}
+
+	*pu16Quad = u16Quad;
+	return(u8Length);
+}
+
+#ifndef __AVR__
+bool FrameCodec_DecodeSegment(uint8_t* pu8Frame,
+							  uint8_t* pu8QuadsSeen,
+							  const uint8_t* pu8Segment,
+							  uint8_t u8Length)
+{
+	uint16_t u16Quad;
+	uint8_t u8Pos = 1;
+
+	if ((u8Length < 2) || (u8Length > FRAMECODEC_SEGMENT_BYTES))
+	{
+		return(false);
+	}
+
+	u16Quad = pu8Segment[0];
+
+	while (u8Pos < u8Length)
+	{
+		uint8_t u8Token = pu8Segment[u8Pos++];
+		uint8_t u8Run = u8Token >> 4;
+		uint8_t u8Index;
+
+		if ((u16Quad + 1 + u8Run) > FRAMECODEC_QUADS)
+		{
+			return(false);
+		}
+
+		for (u8Index = 0; u8Index < 4; u8Index++)
+		{
+			uint8_t u8Byte = 0;
+
+			if (u8Token & (1 << u8Index))
+			{
+				if (u8Pos >= u8Length)
+				{
+					return(false);
+				}
+				u8Byte = pu8Segment[u8Pos++];
+			}
+
+			pu8Frame[(u16Quad << 2) + u8Index] = u8Byte;
+		}
+		pu8QuadsSeen[u16Quad >> 3] |= (uint8_t) (1 << (u16Quad & 7));
+		u16Quad++;
+
+		while (u8Run--)
+		{
+			pu8Frame[(u16Quad << 2) + 0] = 0;
+			pu8Frame[(u16Quad << 2) + 1] = 0;
+			pu8Frame[(u16Quad << 2) + 2] = 0;
+			pu8Frame[(u16Quad << 2) + 3] = 0;
+			pu8QuadsSeen[u16Quad >> 3] |= (uint8_t) (1 << (u16Quad & 7));
+			u16Quad++;
+		}
+	}
+
+	return(true);
+}
+
+void FrameCodec_Finish(uint8_t* pu8Frame)
+{
+	SFrameCodec sCodec;
+	uint16_t u16Offset;
+
+	// Delta parameters sit in the metadata, which is never delta coded
+	FrameCodec_Init(&sCodec, pu8Frame);
+
+	// Ascending, so the reading each byte was coded against is already restored
+	for (u16Offset = sCodec.u16DeltaStart; u16Offset < FRAMECODEC_FRAME_BYTES; u16Offset++)
+	{
+		pu8Frame[u16Offset] += pu8Frame[u16Offset - sCodec.u16Stride];
+	}
+}
+#endif
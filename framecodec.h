@@ -0,0 +1,65 @@
+#ifndef _FRAMECODEC_H_
+#define _FRAMECODEC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Compressed frame transfer encoding - shared by the firmware (encoder) and
+// host tools (decoder), so no AVR dependencies in here.
+//
+// The frame is treated as 256 quads of 4 bytes.  Cell data past the first string
+// reading is first replaced by its byte-wise difference from the same byte one
+// string reading earlier (mod 256), so unchanged cells become zeros.  Each CAN
+// segment then carries:
+//
+//	Byte 0		- Index of the first quad it covers (0-255)
+//	Bytes 1-7	- Tokens, as many as fit (segment DLC says where they end):
+//					bits 0-3 - Which bytes of the current quad are nonzero
+//					bits 4-7 - Number of all-zero quads following it (0-15)
+//				  followed by the nonzero bytes of the current quad
+//
+// Segments decode independently, so any quad can be resent on its own.
+
+#define FRAMECODEC_FRAME_BYTES			1024
+#define FRAMECODEC_QUADS				(FRAMECODEC_FRAME_BYTES / 4)
+#define FRAMECODEC_SEGMENT_BYTES		8
+
+// Where the delta parameters live in the (uncompressed) frame metadata.  These
+// are the AVR offsets of FrameMetadata.version/cellBufferStart/sg_u8CellCountExpected.
+// Only raw string reading frames (version 1) are delta coded - delta packed ones
+// (FRAME_DELTA_STRINGS.md) don't line up reading by reading.
+#define FRAMECODEC_OFFSET_VERSION			2
+#define FRAMECODEC_VERSION_RAW				1
+#define FRAMECODEC_OFFSET_CELLBUFFERSTART	3
+#define FRAMECODEC_OFFSET_CELLCOUNT			21
+#define FRAMECODEC_CELL_BYTES				4
+
+typedef struct
+{
+	uint16_t u16DeltaStart;		// First byte that's a delta (FRAMECODEC_FRAME_BYTES = none)
+	uint16_t u16Stride;			// Bytes per string reading
+} SFrameCodec;
+
+// Work out the delta region from the frame's own metadata
+extern void FrameCodec_Init(SFrameCodec* psCodec, const uint8_t* pu8Frame);
+
+// Encode the segment starting at *pu16Quad, advancing it past the quads covered.
+// Returns the segment length, or 0 once *pu16Quad is past the end of the frame.
+extern uint8_t FrameCodec_EncodeSegment(const SFrameCodec* psCodec,
+										const uint8_t* pu8Frame,
+										uint16_t* pu16Quad,
+										uint8_t* pu8Segment);
+
+#ifndef __AVR__
+// Decode one segment into pu8Frame, setting a bit in pu8QuadsSeen (32 bytes) for
+// every quad covered.  Returns false if the segment is malformed.
+extern bool FrameCodec_DecodeSegment(uint8_t* pu8Frame,
+									 uint8_t* pu8QuadsSeen,
+									 const uint8_t* pu8Segment,
+									 uint8_t u8Length);
+
+// Once every quad has been seen, undo the delta to get the original frame back
+extern void FrameCodec_Finish(uint8_t* pu8Frame);
+#endif
+
+#endif // _FRAMECODEC_H_
@@ -0,0 +1 @@
+cl framedecode.c ..\framecodec.c ..\stringdelta.c ..\crc32.c ..\crc8.c ..\framelog.c ..\sessionlog.c ..\FRAMECOUNTER.c ..\geneeprom\cmdline.c shell32.lib
\ No newline at end of file
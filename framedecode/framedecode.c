@@ -0,0 +1,1651 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+#include <ctype.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "../geneeprom/CmdLine.h"
+#include "../framecodec.h"
+#include "../stringdelta.h"
+#include "../crc32.h"
+#include "../framelog.h"
+#include "../sessionlog.h"
+#include "../EEPROM.h"
+#include "../FRAMECOUNTER.h"
+
+// Rebuilds frames from a CAN capture of a frame transfer (raw or compressed, see
+// FRAME_TRANSFER_PROTOCOL.md), or round trips a recorded frame through the encoder.
+// Also lists the string readings in recorded frames, raw or delta packed
+// (FRAME_DELTA_STRINGS.md), and round trips made up strings through the packing.
+// Finds the head of the SD frame log (framelog.h) in a card image and scrubs it, and
+// runs made up logs through the head search and the scrub. Lists the SD session index
+// (sessionlog.h) in a card image, and runs made up sessions through it. Runs the EEPROM
+// frame counter (FRAMECOUNTER.c) through resets and power cuts.
+//
+// Capture files are one CAN message per line - extended ID then the data bytes,
+// all in hex:
+//
+//	14801a05 07 00 00 00 21 00 00 00
+
+#define ID_FRAME_TRANSFER_START		0x521
+#define ID_FRAME_TRANSFER_DATA		0x522
+#define ID_FRAME_TRANSFER_END		0x523
+
+#define FRAME_SEGMENTS_RAW			(FRAMECODEC_FRAME_BYTES / FRAMECODEC_SEGMENT_BYTES)
+
+// Frame metadata - see STORE.h
+#define FRAME_VERSION_RAW			1
+#define FRAME_CELLBUFFER_START		100		// sizeof(FrameMetadata) on the AVR, quad aligned
+#define FRAME_READINGS_MAX			FRAMECODEC_FRAME_BYTES
+
+// -stringverify
+#define STRING_VERIFY_READINGS		5000
+#define STRING_VERIFY_SEEDS			8
+
+// -logverify
+#define LOG_VERIFY_EVENTS			20000
+#define LOG_VERIFY_SEEDS			8
+#define LOG_VERIFY_SLOTS_MAX		65536
+#define LOG_VERIFY_CORRUPT			8		// Frames corrupted before the scrub
+#define LOG_SCRUB_STEP_BYTES		64		// STORE_CRC_STEP_BYTES
+
+// -sessionverify
+#define SESSION_VERIFY_EVENTS		20000
+#define SESSION_VERIFY_SEEDS		8
+#define SESSION_VERIFY_SAMPLES		8		// Sessions read back after each boot
+
+// -counterverify
+#define COUNTER_VERIFY_EVENTS		200000
+#define COUNTER_VERIFY_SEEDS		8
+#define COUNTER_VERIFY_SLOT_BYTES	8		// FRAMECOUNTER.c
+#define COUNTER_VERIFY_SLOTS		(EEPROM_FRAME_COUNTER_SIZE / COUNTER_VERIFY_SLOT_BYTES)
+
+static SCmdLineOption sg_sCmdLineOptions[] =
+{
+	{"-capture",		"CAN capture to decode",							false,	true},
+	{"-file",			"Output filename for decoded frames (appended)",	false,	true},
+	{"-verify",			"Recorded frame to round trip through the encoder",	false,	true},
+	{"-strings",		"Recorded frames to list the string readings of",	false,	true},
+	{"-stringverify",	"Round trip made up strings of this many cells",	false,	true},
+	{"-loghead",		"SD card image to find the frame log head in",		false,	true},
+	{"-logverify",		"Find the head of made up logs this many slots long",	false,	true},
+	{"-logscrub",		"SD card image to check the frame log of",			false,	true},
+	{"-sessions",		"SD card image to list the session index of",		false,	true},
+	{"-sessionverify",	"Run made up sessions through an index this many slots long",	false,	true},
+	{"-counterverify",	"Run the EEPROM frame counter through resets and power cuts",	false,	false},
+
+	{NULL}
+};
+
+typedef struct
+{
+	bool bActive;
+	bool bCompressed;
+	uint32_t u32FrameCounter;
+	uint16_t u16Messages;
+	uint16_t u16Segments;
+	uint8_t u8Seen[FRAMECODEC_QUADS / 8];	// Quads (compressed) or segments (raw) received
+	uint8_t u8Frame[FRAMECODEC_FRAME_BYTES];
+} SFrameDecode;
+
+static bool AllSeen(SFrameDecode *psDecode)
+{
+	uint16_t u16Count = FRAMECODEC_QUADS;
+	uint16_t u16Index;
+
+	if (false == psDecode->bCompressed)
+	{
+		u16Count = FRAME_SEGMENTS_RAW;
+	}
+
+	for (u16Index = 0; u16Index < u16Count; u16Index++)
+	{
+		if (0 == (psDecode->u8Seen[u16Index >> 3] & (1 << (u16Index & 7))))
+		{
+			printf("  Missing %s %u\n", psDecode->bCompressed ? "quad" : "segment", u16Index);
+			return(false);
+		}
+	}
+
+	return(true);
+}
+
+static bool FrameEnd(SFrameDecode *psDecode,
+					 uint8_t *pu8Data,
+					 uint8_t u8Length,
+					 FILE *psOutput)
+{
+	uint8_t u8Frame[FRAMECODEC_FRAME_BYTES];
+	uint32_t u32CRC;
+	uint32_t u32CRCExpected;
+
+	if (u8Length < 4)
+	{
+		printf("  Short END\n");
+		return(false);
+	}
+
+	u32CRCExpected = pu8Data[0] | (pu8Data[1] << 8) | (pu8Data[2] << 16) | ((uint32_t) pu8Data[3] << 24);
+
+	if (false == AllSeen(psDecode))
+	{
+		printf("Frame %u incomplete - pack would NACK\n", psDecode->u32FrameCounter);
+		return(false);
+	}
+
+	// Undo the delta on a copy - resent segments after a NACK land in the coded frame
+	memcpy((void *) u8Frame, (void *) psDecode->u8Frame, sizeof(u8Frame));
+	if (psDecode->bCompressed)
+	{
+		FrameCodec_Finish(u8Frame);
+	}
+
+	u32CRC = CRC32_Calculate(u8Frame, FRAMECODEC_FRAME_BYTES);
+	printf("Frame %u: %u data segments (%s), CRC %.8x %s\n",
+		   psDecode->u32FrameCounter,
+		   psDecode->u16Segments,
+		   psDecode->bCompressed ? "compressed" : "raw",
+		   u32CRC,
+		   (u32CRC == u32CRCExpected) ? "OK" : "MISMATCH");
+
+	if (u32CRC != u32CRCExpected)
+	{
+		return(false);
+	}
+
+	if (psOutput)
+	{
+		fwrite(u8Frame, 1, FRAMECODEC_FRAME_BYTES, psOutput);
+	}
+
+	return(true);
+}
+
+static bool DecodeCapture(char *peCapture,
+						  FILE *psOutput)
+{
+	FILE *psFile;
+	char eLine[200];
+	SFrameDecode sDecode;
+	bool bResult = true;
+	uint32_t u32Line = 0;
+
+	psFile = fopen(peCapture, "r");
+	if (NULL == psFile)
+	{
+		printf("Can't open capture '%s'\n", peCapture);
+		return(false);
+	}
+
+	memset((void *) &sDecode, 0, sizeof(sDecode));
+
+	while (fgets(eLine, sizeof(eLine), psFile))
+	{
+		char *peLine = eLine;
+		char *peEnd;
+		uint32_t u32ID;
+		uint16_t u16Base;
+		uint16_t u16Seq;
+		uint8_t u8Data[FRAMECODEC_SEGMENT_BYTES];
+		uint8_t u8Length = 0;
+
+		++u32Line;
+
+		u32ID = strtoul(peLine, &peEnd, 16);
+		if (peEnd == peLine)
+		{
+			// Blank or comment line
+			continue;
+		}
+
+		peLine = peEnd;
+		while (u8Length < sizeof(u8Data))
+		{
+			uint32_t u32Byte = strtoul(peLine, &peEnd, 16);
+
+			if (peEnd == peLine)
+			{
+				break;
+			}
+
+			u8Data[u8Length++] = (uint8_t) u32Byte;
+			peLine = peEnd;
+		}
+
+		// Extended ID is (base << 18) | (sequence << 8) | module ID
+		u16Base = (uint16_t) (u32ID >> 18);
+		u16Seq = (uint16_t) ((u32ID >> 8) & 0x3ff);
+
+		if (ID_FRAME_TRANSFER_START == u16Base)
+		{
+			if (u8Length < 6)
+			{
+				printf("Line %u: short START\n", u32Line);
+				bResult = false;
+				continue;
+			}
+
+			memset((void *) &sDecode, 0, sizeof(sDecode));
+			sDecode.bActive = true;
+			sDecode.bCompressed = (u16Seq != 0);
+			sDecode.u32FrameCounter = u8Data[0] | (u8Data[1] << 8) | (u8Data[2] << 16) | ((uint32_t) u8Data[3] << 24);
+			sDecode.u16Messages = u8Data[4] | (u8Data[5] << 8);
+		}
+		else
+		if ((ID_FRAME_TRANSFER_DATA == u16Base) && sDecode.bActive)
+		{
+			++sDecode.u16Segments;
+
+			if (sDecode.bCompressed)
+			{
+				if (false == FrameCodec_DecodeSegment(sDecode.u8Frame, sDecode.u8Seen, u8Data, u8Length))
+				{
+					printf("Line %u: malformed compressed segment %u\n", u32Line, u16Seq);
+					bResult = false;
+				}
+			}
+			else
+			if ((u16Seq < FRAME_SEGMENTS_RAW) && (FRAMECODEC_SEGMENT_BYTES == u8Length))
+			{
+				memcpy((void *) &sDecode.u8Frame[u16Seq * FRAMECODEC_SEGMENT_BYTES], (void *) u8Data, FRAMECODEC_SEGMENT_BYTES);
+				sDecode.u8Seen[u16Seq >> 3] |= (1 << (u16Seq & 7));
+			}
+			else
+			{
+				printf("Line %u: bad raw segment %u\n", u32Line, u16Seq);
+				bResult = false;
+			}
+		}
+		else
+		if ((ID_FRAME_TRANSFER_END == u16Base) && sDecode.bActive)
+		{
+			// The frame stays active - resent segments after a NACK are followed by another END
+			if (false == FrameEnd(&sDecode, u8Data, u8Length, psOutput))
+			{
+				bResult = false;
+			}
+		}
+	}
+
+	fclose(psFile);
+	return(bResult);
+}
+
+static bool VerifyFrame(char *peFrame)
+{
+	FILE *psFile;
+	uint8_t u8Frame[FRAMECODEC_FRAME_BYTES];
+	uint8_t u8Decoded[FRAMECODEC_FRAME_BYTES];
+	uint8_t u8Seen[FRAMECODEC_QUADS / 8];
+	uint8_t u8Segment[FRAMECODEC_SEGMENT_BYTES];
+	SFrameCodec sCodec;
+	uint16_t u16Quad = 0;
+	uint16_t u16Segments = 0;
+	uint32_t u32Frames = 0;
+	bool bResult = true;
+
+	psFile = fopen(peFrame, "rb");
+	if (NULL == psFile)
+	{
+		printf("Can't open frame file '%s'\n", peFrame);
+		return(false);
+	}
+
+	// The file can hold any number of back to back frames
+	while (FRAMECODEC_FRAME_BYTES == fread(u8Frame, 1, sizeof(u8Frame), psFile))
+	{
+		uint8_t u8Length;
+		uint16_t u16Index;
+
+		memset((void *) u8Decoded, 0xa5, sizeof(u8Decoded));
+		memset((void *) u8Seen, 0, sizeof(u8Seen));
+		u16Quad = 0;
+		u16Segments = 0;
+
+		FrameCodec_Init(&sCodec, u8Frame);
+		while ((u8Length = FrameCodec_EncodeSegment(&sCodec, u8Frame, &u16Quad, u8Segment)) != 0)
+		{
+			if (false == FrameCodec_DecodeSegment(u8Decoded, u8Seen, u8Segment, u8Length))
+			{
+				printf("Frame %u: encoder produced a segment the decoder rejects\n", u32Frames);
+				bResult = false;
+			}
+			++u16Segments;
+		}
+
+		for (u16Index = 0; u16Index < sizeof(u8Seen); u16Index++)
+		{
+			if (u8Seen[u16Index] != 0xff)
+			{
+				printf("Frame %u: quads not covered\n", u32Frames);
+				bResult = false;
+				break;
+			}
+		}
+
+		FrameCodec_Finish(u8Decoded);
+
+		printf("Frame %u: %u segments vs %u raw - %s\n",
+			   u32Frames,
+			   u16Segments,
+			   FRAME_SEGMENTS_RAW,
+			   memcmp(u8Frame, u8Decoded, sizeof(u8Frame)) ? "MISMATCH" : "OK");
+
+		if (memcmp(u8Frame, u8Decoded, sizeof(u8Frame)))
+		{
+			bResult = false;
+		}
+
+		++u32Frames;
+	}
+
+	fclose(psFile);
+	return(bResult);
+}
+
+// Unpacks a frame's string readings into pu8Readings, oldest first. Returns the number
+// of readings, or -1 if the frame doesn't hold a sane set.
+static int32_t FrameStrings(const uint8_t *pu8Frame, uint8_t *pu8Readings)
+{
+	uint16_t u16Start = pu8Frame[FRAMECODEC_OFFSET_CELLBUFFERSTART];
+	uint8_t u8Cells = pu8Frame[FRAMECODEC_OFFSET_CELLCOUNT];
+	uint16_t u16ReadingBytes = (uint16_t) u8Cells * STRINGDELTA_CELL_BYTES;
+	uint16_t u16Readings = pu8Frame[STRINGDELTA_OFFSET_READINGCOUNT] | (pu8Frame[STRINGDELTA_OFFSET_READINGCOUNT + 1] << 8);
+
+	if ((0 == u8Cells) ||
+		((u16Start + u16ReadingBytes) > FRAMECODEC_FRAME_BYTES))
+	{
+		return(-1);
+	}
+
+	if (STRINGDELTA_FRAME_VERSION == pu8Frame[STRINGDELTA_OFFSET_VERSION])
+	{
+		if ((u16Readings > FRAME_READINGS_MAX) ||
+			(false == StringDelta_Decode(&pu8Frame[u16Start],
+										 &pu8Frame[u16Start + u16ReadingBytes],
+										 FRAMECODEC_FRAME_BYTES - (u16Start + u16ReadingBytes),
+										 u8Cells,
+										 u16Readings,
+										 pu8Readings)))
+		{
+			return(-1);
+		}
+
+		return(u16Readings);
+	}
+
+	// Raw - the frame goes out as its last slot is filled, so the slots are in order
+	if ((u16Start + ((uint32_t) u16Readings * u16ReadingBytes)) > FRAMECODEC_FRAME_BYTES)
+	{
+		return(-1);
+	}
+
+	memcpy((void *) pu8Readings, (void *) &pu8Frame[u16Start], u16Readings * u16ReadingBytes);
+	return(u16Readings);
+}
+
+static bool ListStrings(char *peFrames)
+{
+	FILE *psFile;
+	uint8_t u8Frame[FRAMECODEC_FRAME_BYTES];
+	static uint8_t u8Readings[FRAME_READINGS_MAX * FRAMECODEC_FRAME_BYTES];
+	uint32_t u32Frames = 0;
+	bool bResult = true;
+
+	psFile = fopen(peFrames, "rb");
+	if (NULL == psFile)
+	{
+		printf("Can't open frame file '%s'\n", peFrames);
+		return(false);
+	}
+
+	printf("frame,reading,cell,voltage,temperature\n");
+	while (FRAMECODEC_FRAME_BYTES == fread(u8Frame, 1, sizeof(u8Frame), psFile))
+	{
+		int32_t s32Readings = FrameStrings(u8Frame, u8Readings);
+		uint8_t u8Cells = u8Frame[FRAMECODEC_OFFSET_CELLCOUNT];
+		int32_t s32Reading;
+		uint8_t u8Cell;
+
+		if (s32Readings < 0)
+		{
+			printf("Frame %u: bad string readings\n", u32Frames);
+			bResult = false;
+		}
+
+		for (s32Reading = 0; s32Reading < s32Readings; s32Reading++)
+		{
+			for (u8Cell = 0; u8Cell < u8Cells; u8Cell++)
+			{
+				const uint8_t *pu8Cell = &u8Readings[((s32Reading * u8Cells) + u8Cell) * STRINGDELTA_CELL_BYTES];
+
+				printf("%u,%d,%u,0x%.4x,0x%.4x\n",
+					   u32Frames,
+					   s32Reading,
+					   u8Cell,
+					   pu8Cell[0] | (pu8Cell[1] << 8),
+					   pu8Cell[2] | (pu8Cell[3] << 8));
+			}
+		}
+
+		++u32Frames;
+	}
+
+	fclose(psFile);
+	return(bResult);
+}
+
+static void StringVerifyCell(uint8_t *pu8Cell, uint16_t u16Voltage, uint16_t u16Temperature)
+{
+	pu8Cell[0] = (uint8_t) u16Voltage;
+	pu8Cell[1] = (uint8_t) (u16Voltage >> 8);
+	pu8Cell[2] = (uint8_t) u16Temperature;
+	pu8Cell[3] = (uint8_t) (u16Temperature >> 8);
+}
+
+// Made up string readings through the packing, the way main.c drives it: cells as they
+// come in, short and missing strings, single bad cells, jumps, and frames that can't be
+// written straight away (frame transfer in progress). Every frame written has to unpack
+// to the readings that went into it.
+static bool StringVerify(uint8_t u8Cells, uint32_t u32Seed)
+{
+	static uint8_t u8History[FRAME_READINGS_MAX][FRAMECODEC_FRAME_BYTES];
+	static uint8_t u8Readings[FRAME_READINGS_MAX * FRAMECODEC_FRAME_BYTES];
+	uint8_t u8Frame[FRAMECODEC_FRAME_BYTES];
+	uint16_t u16Voltage[256];
+	uint16_t u16Temperature[256];
+	uint16_t u16ReadingBytes = (uint16_t) u8Cells * STRINGDELTA_CELL_BYTES;
+	SStringDelta sDelta;
+	uint16_t u16ReadingCount = 0;
+	uint32_t u32Reading;
+	uint32_t u32Frames = 0;
+	uint32_t u32FrameReadings = 0;
+	uint32_t u32Dropped = 0;
+	uint32_t u32Errors = 0;
+	uint8_t u8Cell;
+
+	srand(u32Seed);
+	memset((void *) u8Frame, 0, sizeof(u8Frame));
+	u8Frame[STRINGDELTA_OFFSET_VERSION] = STRINGDELTA_FRAME_VERSION;
+	u8Frame[FRAMECODEC_OFFSET_CELLBUFFERSTART] = FRAME_CELLBUFFER_START;
+	u8Frame[FRAMECODEC_OFFSET_CELLCOUNT] = u8Cells;
+
+	// Starts out invalid, like CellCountExpectedSet() leaves it
+	for (u8Cell = 0; u8Cell < u8Cells; u8Cell++)
+	{
+		StringVerifyCell(&u8Frame[FRAME_CELLBUFFER_START + (u8Cell * STRINGDELTA_CELL_BYTES)],
+						 STRINGDELTA_INVALID_VOLTAGE, STRINGDELTA_INVALID_TEMP);
+		u16Voltage[u8Cell] = (uint16_t) (700 + (rand() % 100));
+		u16Temperature[u8Cell] = (uint16_t) (0x8000 | (25 << 4) | (rand() & 0x0f));
+	}
+
+	StringDelta_Init(&sDelta,
+					 &u8Frame[FRAME_CELLBUFFER_START],
+					 &u8Frame[FRAME_CELLBUFFER_START + u16ReadingBytes],
+					 FRAMECODEC_FRAME_BYTES - (FRAME_CELLBUFFER_START + u16ReadingBytes),
+					 u8Cells);
+
+	for (u32Reading = 0; u32Reading < STRING_VERIFY_READINGS; u32Reading++)
+	{
+		uint8_t *pu8Expected;
+		uint8_t u8Reported = u8Cells;
+		uint8_t u8Bad = 0xff;
+		uint8_t u8Dropped = 0;
+
+		// Room for this reading at the end of the history
+		if (u16ReadingCount >= FRAME_READINGS_MAX)
+		{
+			printf("  %u cells seed %u: more readings in a frame than the history holds\n", u8Cells, u32Seed);
+			return(false);
+		}
+		pu8Expected = u8History[u16ReadingCount];
+
+		switch (rand() % 200)
+		{
+			case 0:
+				u8Reported = 0;						// String didn't answer
+				break;
+			case 1:
+			case 2:
+				u8Reported = (uint8_t) (rand() % u8Cells);	// Came up short
+				break;
+			case 3:
+			case 4:
+				u8Bad = (uint8_t) (rand() % u8Cells);		// One bad record
+				break;
+			default:
+				break;
+		}
+
+		StringDelta_Start(&sDelta);
+		for (u8Cell = 0; u8Cell < u8Cells; u8Cell++)
+		{
+			uint8_t *pu8Cell = &pu8Expected[u8Cell * STRINGDELTA_CELL_BYTES];
+
+			// Noise on the voltage, the odd temperature step, and now and then a jump
+			u16Voltage[u8Cell] = (uint16_t) (u16Voltage[u8Cell] + (rand() % 5) - 2);
+			if (0 == (rand() % 8))
+			{
+				u16Temperature[u8Cell] = (uint16_t) (u16Temperature[u8Cell] + (rand() % 3) - 1);
+			}
+			if (0 == (rand() % 500))
+			{
+				u16Voltage[u8Cell] = (uint16_t) (rand() & 0x3ff);
+			}
+			if (0 == (rand() % 500))
+			{
+				u16Temperature[u8Cell] = (uint16_t) (u16Temperature[u8Cell] + (rand() % 64) - 32);
+			}
+
+			if ((u8Cell >= u8Reported) || (u8Cell == u8Bad))
+			{
+				StringVerifyCell(pu8Cell, STRINGDELTA_INVALID_VOLTAGE, STRINGDELTA_INVALID_TEMP);
+				continue;
+			}
+
+			StringVerifyCell(pu8Cell, u16Voltage[u8Cell], u16Temperature[u8Cell]);
+			u8Dropped += StringDelta_Cell(&sDelta, u8Cell, pu8Cell);
+		}
+
+		u8Dropped += StringDelta_End(&sDelta, (u16ReadingCount > 0));
+		if (0 == u16ReadingCount)
+		{
+			// The reading before belonged to the last frame
+			++u16ReadingCount;
+			memcpy((void *) u8History[0], (void *) pu8Expected, u16ReadingBytes);
+		}
+		else
+		{
+			u16ReadingCount = (uint16_t) (u16ReadingCount + 1 - u8Dropped);
+			memmove((void *) u8History[0], (void *) u8History[u8Dropped], u16ReadingCount * sizeof(u8History[0]));
+		}
+		u32Dropped += u8Dropped;
+
+		if (memcmp((void *) &u8Frame[FRAME_CELLBUFFER_START], (void *) u8History[u16ReadingCount - 1], u16ReadingBytes))
+		{
+			printf("  %u cells seed %u reading %u: latest reading is wrong\n", u8Cells, u32Seed, u32Reading);
+			++u32Errors;
+		}
+
+		// Write the frame out - unless a frame transfer is holding it up
+		if (StringDelta_Full(&sDelta) && (rand() % 16))
+		{
+			int32_t s32Readings;
+			uint16_t u16Reading;
+
+			u8Frame[STRINGDELTA_OFFSET_READINGCOUNT] = (uint8_t) u16ReadingCount;
+			u8Frame[STRINGDELTA_OFFSET_READINGCOUNT + 1] = (uint8_t) (u16ReadingCount >> 8);
+
+			s32Readings = FrameStrings(u8Frame, u8Readings);
+			if (s32Readings != u16ReadingCount)
+			{
+				printf("  %u cells seed %u frame %u: won't unpack\n", u8Cells, u32Seed, u32Frames);
+				++u32Errors;
+			}
+			else
+			{
+				for (u16Reading = 0; u16Reading < u16ReadingCount; u16Reading++)
+				{
+					if (memcmp((void *) &u8Readings[u16Reading * u16ReadingBytes], (void *) u8History[u16Reading], u16ReadingBytes))
+					{
+						printf("  %u cells seed %u frame %u: reading %u doesn't match\n", u8Cells, u32Seed, u32Frames, u16Reading);
+						++u32Errors;
+						break;
+					}
+				}
+			}
+
+			++u32Frames;
+			u32FrameReadings += u16ReadingCount;
+			u16ReadingCount = 0;
+			StringDelta_Clear(&sDelta);
+		}
+	}
+
+	printf("%u cells seed %u: %u frames, %.1f readings per frame (raw %u), %u dropped, %u errors\n",
+		   u8Cells,
+		   u32Seed,
+		   u32Frames,
+		   u32Frames ? ((double) u32FrameReadings / u32Frames) : 0.0,
+		   (FRAMECODEC_FRAME_BYTES - FRAME_CELLBUFFER_START) / u16ReadingBytes,
+		   u32Dropped,
+		   u32Errors);
+
+	return(0 == u32Errors);
+}
+
+// -logverify/-loghead - the SD frame log (framelog.h). The card is an array of slots.
+static uint8_t (*sg_pu8LogCard)[FRAMELOG_FRAME_BYTES];
+static uint32_t sg_u32LogSlots;
+static uint32_t sg_u32LogReads;
+static FILE *sg_psLogImage;
+
+static bool LogReadSim(uint32_t u32Slot, uint8_t *pu8Frame, bool bWhole)
+{
+	sg_u32LogReads++;
+	memcpy((void *) pu8Frame, (void *) sg_pu8LogCard[u32Slot], bWhole ? FRAMELOG_FRAME_BYTES : FRAMELOG_HEADER_BYTES);
+	return(true);
+}
+
+static bool LogReadImage(uint32_t u32Slot, uint8_t *pu8Frame, bool bWhole)
+{
+	uint16_t u16Bytes = bWhole ? FRAMELOG_FRAME_BYTES : FRAMELOG_HEADER_BYTES;
+
+	sg_u32LogReads++;
+	return((0 == fseek(sg_psLogImage, (long) u32Slot * FRAMELOG_FRAME_BYTES, SEEK_SET)) &&
+		   (u16Bytes == fread(pu8Frame, 1, u16Bytes, sg_psLogImage)));
+}
+
+static bool LogReadSectorSim(uint32_t u32Slot, uint8_t u8Sector, uint8_t *pu8Sector)
+{
+	sg_u32LogReads++;
+	memcpy((void *) pu8Sector, (void *) &sg_pu8LogCard[u32Slot][u8Sector * FRAMELOG_HEADER_BYTES], FRAMELOG_HEADER_BYTES);
+	return(true);
+}
+
+static bool LogReadSectorImage(uint32_t u32Slot, uint8_t u8Sector, uint8_t *pu8Sector)
+{
+	sg_u32LogReads++;
+	return((0 == fseek(sg_psLogImage, ((long) u32Slot * FRAMELOG_FRAME_BYTES) + ((long) u8Sector * FRAMELOG_HEADER_BYTES), SEEK_SET)) &&
+		   (FRAMELOG_HEADER_BYTES == fread(pu8Sector, 1, FRAMELOG_HEADER_BYTES, sg_psLogImage)));
+}
+
+static void LogFrameFill(uint8_t *pu8Frame, uint32_t u32Counter)
+{
+	uint16_t u16Byte;
+
+	for (u16Byte = 0; u16Byte < FRAMELOG_FRAME_BYTES; u16Byte++)
+	{
+		pu8Frame[u16Byte] = (uint8_t) (rand() >> 4);
+	}
+	pu8Frame[FRAMELOG_OFFSET_SIG] = (uint8_t) FRAMELOG_SIG;
+	pu8Frame[FRAMELOG_OFFSET_SIG + 1] = (uint8_t) (FRAMELOG_SIG >> 8);
+	pu8Frame[FRAMELOG_OFFSET_FRAMEBYTES] = (uint8_t) FRAMELOG_FRAME_BYTES;
+	pu8Frame[FRAMELOG_OFFSET_FRAMEBYTES + 1] = (uint8_t) (FRAMELOG_FRAME_BYTES >> 8);
+	pu8Frame[FRAMELOG_OFFSET_COUNTER] = (uint8_t) u32Counter;
+	pu8Frame[FRAMELOG_OFFSET_COUNTER + 1] = (uint8_t) (u32Counter >> 8);
+	pu8Frame[FRAMELOG_OFFSET_COUNTER + 2] = (uint8_t) (u32Counter >> 16);
+	pu8Frame[FRAMELOG_OFFSET_COUNTER + 3] = (uint8_t) (u32Counter >> 24);
+	FrameLog_Seal(pu8Frame);
+}
+
+// Scrubs frames u32First up to u32Next the way STORE.c does, after corrupting a few
+// past their headers. Now and then the sector is taken for something else part way
+// through a frame, and has to be read again. Each corrupted frame has to come back
+// corrupt and the rest OK, and the frame at u32Next (not written yet) missing. Returns
+// the # of errors.
+static uint32_t LogScrubVerify(uint32_t u32Slots, uint32_t u32Seed, uint32_t u32First, uint32_t u32Next)
+{
+	uint8_t u8Sector[FRAMELOG_HEADER_BYTES];
+	uint8_t *pu8Corrupt;
+	SFrameLogScrub sScrub;
+	EFrameLogCheck eResult;
+	EFrameLogCheck eExpected;
+	uint32_t u32Counter;
+	uint32_t u32Errors = 0;
+	uint32_t u32Corrupted = 0;
+	uint32_t u32Found = 0;
+	uint32_t u32Steps = 0;
+	uint32_t u32Index;
+
+	pu8Corrupt = calloc(u32Slots, 1);
+	if (NULL == pu8Corrupt)
+	{
+		printf("Out of memory\n");
+		return(1);
+	}
+
+	for (u32Index = 0; (u32Index < LOG_VERIFY_CORRUPT) && (u32Next > u32First); u32Index++)
+	{
+		u32Counter = u32First + ((uint32_t) rand() % (u32Next - u32First));
+		if (0 == pu8Corrupt[u32Counter % u32Slots])
+		{
+			uint16_t u16Byte = (uint16_t) (FRAME_CELLBUFFER_START + ((uint32_t) rand() % (FRAMELOG_FRAME_BYTES - FRAME_CELLBUFFER_START)));
+
+			sg_pu8LogCard[u32Counter % u32Slots][u16Byte] ^= (uint8_t) (1 + (rand() % 255));
+			pu8Corrupt[u32Counter % u32Slots] = 1;
+			u32Corrupted++;
+		}
+	}
+
+	// One past the head, too
+	for (u32Counter = u32First; u32Counter <= u32Next; u32Counter++)
+	{
+		eExpected = EFRAMELOG_CHECK_OK;
+		if (u32Counter == u32Next)
+		{
+			eExpected = EFRAMELOG_CHECK_MISSING;
+		}
+		else
+		if (pu8Corrupt[u32Counter % u32Slots])
+		{
+			eExpected = EFRAMELOG_CHECK_CORRUPT;
+		}
+
+		FrameLog_ScrubStart(&sScrub, u32Counter);
+		do
+		{
+			if (0 == (rand() % 8))
+			{
+				memset((void *) u8Sector, 0xa5, sizeof(u8Sector));
+				sScrub.bSectorRead = false;
+			}
+
+			eResult = FrameLog_ScrubStep(&sScrub, u32Slots, LogReadSectorSim, u8Sector, LOG_SCRUB_STEP_BYTES);
+			u32Steps++;
+		}
+		while (EFRAMELOG_CHECK_BUSY == eResult);
+
+		if (EFRAMELOG_CHECK_CORRUPT == eResult)
+		{
+			u32Found++;
+		}
+
+		if (eResult != eExpected)
+		{
+			printf("  %u slots seed %u: scrub of frame %u gave %u, should be %u\n", u32Slots, u32Seed, u32Counter, eResult, eExpected);
+			++u32Errors;
+		}
+	}
+
+	printf("%u slots seed %u: scrubbed %u frames in %u steps, %u of %u corrupted frames found\n",
+		   u32Slots,
+		   u32Seed,
+		   u32Next - u32First,
+		   u32Steps,
+		   u32Found,
+		   u32Corrupted);
+
+	free(pu8Corrupt);
+	return(u32Errors);
+}
+
+// A module writing frames the way STORE.c does, with the frame counter in EEPROM only
+// saved every 16 frames (FRAMECOUNTER.c). It's reset now and then, sometimes part way
+// through a frame's write, and now and then gets a blank card. Every boot has to carry
+// on from the head of the log, and no frame can be written over until the log has
+// been all the way round the card.
+static bool LogVerify(uint32_t u32Slots, uint32_t u32Seed)
+{
+	uint8_t u8Frame[FRAMELOG_FRAME_BYTES];
+	uint8_t u8Scratch[FRAMELOG_FRAME_BYTES];
+	uint32_t u32EEPROM;
+	uint32_t u32Counter;
+	uint32_t u32SinceBoot = 0;
+	uint32_t u32Written = 0;
+	uint32_t u32Expected;
+	uint32_t u32Boots = 0;
+	uint32_t u32ReadsWorst = 0;
+	uint32_t u32ReadsMax = 3;
+	uint32_t u32Errors = 0;
+	uint32_t u32Event;
+	uint32_t u32RunStart;
+
+	// Anchor (and maybe slot 0), the search, then the head in full
+	while ((1UL << (u32ReadsMax - 3)) < u32Slots)
+	{
+		u32ReadsMax++;
+	}
+
+	srand(u32Seed);
+	sg_u32LogSlots = u32Slots;
+	memset((void *) sg_pu8LogCard, 0, (size_t) u32Slots * FRAMELOG_FRAME_BYTES);
+
+	// Some modules have been going a while before they get a card
+	u32EEPROM = (u32Seed & 1) ? (((uint32_t) rand() & 0xfffff) * 16) : 0;
+	u32Counter = u32EEPROM;
+	u32Expected = u32Counter;
+	u32RunStart = u32Counter;
+
+	for (u32Event = 0; u32Event < LOG_VERIFY_EVENTS; u32Event++)
+	{
+		uint32_t u32Roll = (uint32_t) rand() % 100;
+		bool bTorn = (u32Roll < 2);
+
+		if ((u32Roll < 5) ||
+			(u32Event == (LOG_VERIFY_EVENTS - 1)))
+		{
+			uint32_t u32Next = u32EEPROM;
+
+			// Reset, maybe part way through writing the next frame - just its first sector
+			if (bTorn)
+			{
+				LogFrameFill(u8Frame, u32Counter);
+				memcpy((void *) sg_pu8LogCard[u32Counter % u32Slots], (void *) u8Frame, FRAMELOG_HEADER_BYTES);
+			}
+
+			// Blank card now and then
+			if (4 == u32Roll)
+			{
+				memset((void *) sg_pu8LogCard, 0, (size_t) u32Slots * FRAMELOG_FRAME_BYTES);
+				u32Expected = u32EEPROM;
+				u32RunStart = u32EEPROM;
+			}
+
+			sg_u32LogReads = 0;
+			if (FrameLog_FindHead(u32Slots, u32EEPROM, LogReadSim, u8Scratch, &u32Next) &&
+				(u32Next > u32EEPROM))
+			{
+				u32EEPROM = u32Next;
+			}
+			else
+			{
+				u32Next = u32EEPROM;
+			}
+
+			if (u32Next != u32Expected)
+			{
+				printf("  %u slots seed %u boot %u: head %u, should be %u\n", u32Slots, u32Seed, u32Boots, u32Next, u32Expected);
+				++u32Errors;
+			}
+			if (sg_u32LogReads > u32ReadsWorst)
+			{
+				u32ReadsWorst = sg_u32LogReads;
+			}
+
+			u32Counter = u32Next;
+			u32Expected = u32Next;
+			u32SinceBoot = 0;
+			++u32Boots;
+		}
+		else
+		{
+			uint8_t *pu8Slot = sg_pu8LogCard[u32Counter % u32Slots];
+			uint32_t u32Old;
+
+			// Only a frame from at least once round the card ago, or a torn one, goes
+			if (FrameLog_Header(pu8Slot, &u32Old) &&
+				(u32Old != u32Counter) &&
+				((u32Old > u32Counter) || ((u32Counter - u32Old) < u32Slots)))
+			{
+				printf("  %u slots seed %u: frame %u written over frame %u\n", u32Slots, u32Seed, u32Counter, u32Old);
+				++u32Errors;
+			}
+
+			LogFrameFill(pu8Slot, u32Counter);
+			u32Counter++;
+			u32Written++;
+			u32Expected = u32Counter;
+
+			if (0 == (++u32SinceBoot & 0x0f))
+			{
+				u32EEPROM = u32Counter;
+			}
+		}
+	}
+
+	// The last event's a boot, so the log's whole up to u32Counter
+	if ((u32Counter - u32RunStart) > u32Slots)
+	{
+		u32RunStart = u32Counter - u32Slots;
+	}
+	u32Errors += LogScrubVerify(u32Slots, u32Seed, u32RunStart, u32Counter);
+
+	printf("%u slots seed %u: %u frames, %u boots, at most %u reads a boot (%u allowed), %u errors\n",
+		   u32Slots,
+		   u32Seed,
+		   u32Written,
+		   u32Boots,
+		   u32ReadsWorst,
+		   u32ReadsMax,
+		   u32Errors);
+
+	return((0 == u32Errors) && (u32ReadsWorst <= u32ReadsMax));
+}
+
+// Finds the head of the log in an image of a card
+static bool LogHead(char *peImage)
+{
+	uint8_t u8Frame[FRAMELOG_FRAME_BYTES];
+	uint32_t u32Next;
+	uint32_t u32IndexSector;
+	uint32_t u32SessionSlots;
+	long s32Bytes;
+
+	sg_psLogImage = fopen(peImage, "rb");
+	if (NULL == sg_psLogImage)
+	{
+		printf("Can't open card image '%s'\n", peImage);
+		return(false);
+	}
+
+	fseek(sg_psLogImage, 0, SEEK_END);
+	s32Bytes = ftell(sg_psLogImage);
+	sg_u32LogReads = 0;
+
+	// The session index is at the end of the card
+	SessionLog_Layout((uint32_t) (s32Bytes / FRAMELOG_HEADER_BYTES), &sg_u32LogSlots, &u32IndexSector, &u32SessionSlots);
+
+	if (0 == sg_u32LogSlots)
+	{
+		printf("Card image '%s' is smaller than a frame\n", peImage);
+	}
+	else
+	if (FrameLog_FindHead(sg_u32LogSlots, 0, LogReadImage, u8Frame, &u32Next))
+	{
+		printf("%u slots: next frame %u, in slot %u (%u reads)\n", sg_u32LogSlots, u32Next, u32Next % sg_u32LogSlots, sg_u32LogReads);
+	}
+	else
+	{
+		printf("%u slots: no frames\n", sg_u32LogSlots);
+	}
+
+	fclose(sg_psLogImage);
+	return(0 != sg_u32LogSlots);
+}
+
+// Checks every frame in the log in an image of a card, the way the module's scrub does,
+// and lists the ones that don't check out
+static bool LogScrub(char *peImage)
+{
+	uint8_t u8Frame[FRAMELOG_FRAME_BYTES];
+	SFrameLogScrub sScrub;
+	EFrameLogCheck eResult;
+	uint32_t u32Next;
+	uint32_t u32Counter;
+	uint32_t u32IndexSector;
+	uint32_t u32SessionSlots;
+	uint32_t u32Missing = 0;
+	uint32_t u32Bad = 0;
+	long s32Bytes;
+
+	sg_psLogImage = fopen(peImage, "rb");
+	if (NULL == sg_psLogImage)
+	{
+		printf("Can't open card image '%s'\n", peImage);
+		return(false);
+	}
+
+	fseek(sg_psLogImage, 0, SEEK_END);
+	s32Bytes = ftell(sg_psLogImage);
+	SessionLog_Layout((uint32_t) (s32Bytes / FRAMELOG_HEADER_BYTES), &sg_u32LogSlots, &u32IndexSector, &u32SessionSlots);
+
+	if ((0 == sg_u32LogSlots) ||
+		(false == FrameLog_FindHead(sg_u32LogSlots, 0, LogReadImage, u8Frame, &u32Next)))
+	{
+		printf("Card image '%s' has no frames\n", peImage);
+		fclose(sg_psLogImage);
+		return(false);
+	}
+
+	// As far back as the card goes. Slots that were never written come up missing.
+	u32Counter = (u32Next > sg_u32LogSlots) ? (u32Next - sg_u32LogSlots) : 0;
+	for ( ; u32Counter < u32Next; u32Counter++)
+	{
+		FrameLog_ScrubStart(&sScrub, u32Counter);
+		do
+		{
+			eResult = FrameLog_ScrubStep(&sScrub, sg_u32LogSlots, LogReadSectorImage, u8Frame, FRAMELOG_HEADER_BYTES);
+		}
+		while (EFRAMELOG_CHECK_BUSY == eResult);
+
+		if (EFRAMELOG_CHECK_MISSING == eResult)
+		{
+			u32Missing++;
+		}
+		else
+		if (EFRAMELOG_CHECK_OK != eResult)
+		{
+			printf("Frame %u (slot %u): %s\n", u32Counter, u32Counter % sg_u32LogSlots,
+				   (EFRAMELOG_CHECK_CORRUPT == eResult) ? "CRC doesn't match" : "can't be read");
+			u32Bad++;
+		}
+	}
+
+	printf("%u slots, frames up to %u: %u bad, %u not on the card\n", sg_u32LogSlots, u32Next, u32Bad, u32Missing);
+
+	fclose(sg_psLogImage);
+	return(0 == u32Bad);
+}
+
+// -sessionverify/-sessions - the SD session index (sessionlog.h). One sector a slot.
+static uint8_t (*sg_pu8SessionIndex)[SESSIONLOG_SECTOR_BYTES];
+static SSessionRecord *sg_psSessionTruth;		// What each slot should read back as, u16Sig 0 if nothing
+static uint32_t sg_u32SessionIndexSector;
+
+static bool SessionReadSim(uint32_t u32Slot, uint8_t *pu8Sector, bool bWhole)
+{
+	(void) bWhole;
+	sg_u32LogReads++;
+	memcpy((void *) pu8Sector, (void *) sg_pu8SessionIndex[u32Slot], SESSIONLOG_SECTOR_BYTES);
+	return(true);
+}
+
+static bool SessionReadImage(uint32_t u32Slot, uint8_t *pu8Sector, bool bWhole)
+{
+	(void) bWhole;
+	sg_u32LogReads++;
+	return((0 == fseek(sg_psLogImage, (long) (sg_u32SessionIndexSector + u32Slot) * SESSIONLOG_SECTOR_BYTES, SEEK_SET)) &&
+		   (SESSIONLOG_SECTOR_BYTES == fread(pu8Sector, 1, SESSIONLOG_SECTOR_BYTES, sg_psLogImage)));
+}
+
+// Writes a record to its slot, the way STORE.c does. A torn write leaves the slot
+// holding part of it.
+static void SessionWriteSim(uint32_t u32Slots, SSessionRecord *psRecord, bool bTorn)
+{
+	uint32_t u32Slot = psRecord->u32Session % u32Slots;
+
+	SessionLog_Seal(psRecord);
+	memset((void *) sg_pu8SessionIndex[u32Slot], 0, SESSIONLOG_SECTOR_BYTES);
+	memcpy((void *) sg_pu8SessionIndex[u32Slot], (void *) psRecord, bTorn ? (size_t) (rand() % SESSIONLOG_RECORD_CRC_BYTES) : sizeof(*psRecord));
+
+	memset((void *) &sg_psSessionTruth[u32Slot], 0, sizeof(sg_psSessionTruth[u32Slot]));
+	if (false == bTorn)
+	{
+		sg_psSessionTruth[u32Slot] = *psRecord;
+	}
+}
+
+// A module opening and closing sessions the way STORE.c does, with frames going by in
+// between. It's reset now and then - a watchdog reset carries an open session on,
+// anything else closes it as cut short. Some resets come part way through writing a
+// record. Every boot has to find the last session, and every session still in the
+// index has to read back as it was written.
+static bool SessionVerify(uint32_t u32Slots, uint32_t u32Seed)
+{
+	uint8_t u8Sector[SESSIONLOG_SECTOR_BYTES];
+	SSessionRecord sOpen;
+	uint32_t u32Frame = 0;
+	uint32_t u32Next = 0;			// As the module has it
+	uint32_t u32Expected = 0;		// As it should be
+	bool bOpen = false;
+	bool bOpenExpected = false;
+	uint32_t u32Sessions = 0;
+	uint32_t u32Boots = 0;
+	uint32_t u32ReadsWorst = 0;
+	uint32_t u32ReadsMax = 3;
+	uint32_t u32Errors = 0;
+	uint32_t u32Event;
+
+	// Anchor (and maybe slot 0), the search, then the head again
+	while ((1UL << (u32ReadsMax - 3)) < u32Slots)
+	{
+		u32ReadsMax++;
+	}
+
+	srand(u32Seed);
+	memset((void *) sg_pu8SessionIndex, 0, (size_t) u32Slots * SESSIONLOG_SECTOR_BYTES);
+	memset((void *) sg_psSessionTruth, 0, (size_t) u32Slots * sizeof(*sg_psSessionTruth));
+	memset((void *) &sOpen, 0, sizeof(sOpen));
+
+	for (u32Event = 0; u32Event < SESSION_VERIFY_EVENTS; u32Event++)
+	{
+		uint32_t u32Roll = (uint32_t) rand() % 100;
+		bool bTorn = ((rand() % 100) < 3);
+		bool bBoot = false;
+		bool bResume = false;
+
+		if (u32Roll < 40)
+		{
+			u32Frame += (uint32_t) rand() % 50;
+		}
+		else
+		if ((u32Roll < 70) && (false == bOpen))
+		{
+			memset((void *) &sOpen, 0, sizeof(sOpen));
+			sOpen.u8Flags = SESSIONLOG_FLAG_OPEN;
+			sOpen.u32Session = u32Next;
+			sOpen.u32StartFrame = u32Frame;
+			sOpen.u32EndFrame = u32Frame;
+			sOpen.u64StartTime = 1700000000ULL + u32Event;
+			SessionWriteSim(u32Slots, &sOpen, bTorn);
+
+			// A torn record is as good as not there - the session gets the number again
+			bBoot = bTorn;
+			if (false == bTorn)
+			{
+				u32Next++;
+				u32Expected = u32Next;
+				bOpen = true;
+				bOpenExpected = true;
+				u32Sessions++;
+			}
+		}
+		else
+		if ((u32Roll < 95) && bOpen)
+		{
+			sOpen.u8Flags &= (uint8_t) ~SESSIONLOG_FLAG_OPEN;
+			sOpen.u32EndFrame = u32Frame;
+			sOpen.u8WDTCount = (uint8_t) (rand() & 3);
+			SessionWriteSim(u32Slots, &sOpen, bTorn);
+			bOpen = false;
+			bOpenExpected = false;
+
+			// Torn on the way out - the session's record is lost, and its number goes again
+			bBoot = bTorn;
+			if (bTorn)
+			{
+				u32Expected = sOpen.u32Session;
+			}
+		}
+		else
+		if (u32Roll >= 95)
+		{
+			bBoot = true;
+			bResume = (u32Roll < 98);
+		}
+
+		if (bBoot)
+		{
+			uint32_t u32Head;
+			uint32_t u32Sample;
+
+			// STORE_Init()
+			sg_u32LogReads = 0;
+			u32Next = 0;
+			bOpen = false;
+			if (SessionLog_FindHead(u32Slots, SessionReadSim, u8Sector, &u32Head))
+			{
+				memcpy((void *) &sOpen, (void *) u8Sector, sizeof(sOpen));
+				u32Next = u32Head + 1;
+
+				if (sOpen.u8Flags & SESSIONLOG_FLAG_OPEN)
+				{
+					if (bResume)
+					{
+						bOpen = true;
+					}
+					else
+					{
+						sOpen.u8Flags = (sOpen.u8Flags & (uint8_t) ~SESSIONLOG_FLAG_OPEN) | SESSIONLOG_FLAG_CUT_SHORT;
+						sOpen.u32EndFrame = u32Frame;
+						SessionWriteSim(u32Slots, &sOpen, false);
+					}
+				}
+			}
+
+			if ((u32Next != u32Expected) || (bOpen != (bOpenExpected && bResume)))
+			{
+				printf("  %u slots seed %u boot %u: next session %u%s, should be %u%s\n",
+					   u32Slots, u32Seed, u32Boots,
+					   u32Next, bOpen ? " (open)" : "",
+					   u32Expected, (bOpenExpected && bResume) ? " (open)" : "");
+				++u32Errors;
+			}
+			if (sg_u32LogReads > u32ReadsWorst)
+			{
+				u32ReadsWorst = sg_u32LogReads;
+			}
+
+			// Sessions the index still holds read back from their slots as written
+			for (u32Sample = 0; (u32Sample < SESSION_VERIFY_SAMPLES) && u32Next; u32Sample++)
+			{
+				uint32_t u32Held = (u32Next < u32Slots) ? u32Next : u32Slots;
+				uint32_t u32Session = u32Next - 1 - ((uint32_t) rand() % u32Held);
+				uint32_t u32Slot = u32Session % u32Slots;
+				uint32_t u32Found;
+
+				// The oldest session goes if the write that was taking its slot was torn
+				if ((0 == sg_psSessionTruth[u32Slot].u16Sig) &&
+					((u32Session + u32Slots) == u32Next))
+				{
+					continue;
+				}
+
+				(void) SessionReadSim(u32Slot, u8Sector, false);
+				if ((false == SessionLog_Header(u8Sector, &u32Found)) ||
+					(u32Found != u32Session) ||
+					(0 != memcmp((void *) u8Sector, (void *) &sg_psSessionTruth[u32Slot], sizeof(SSessionRecord))))
+				{
+					printf("  %u slots seed %u boot %u: session %u doesn't read back\n", u32Slots, u32Seed, u32Boots, u32Session);
+					++u32Errors;
+				}
+			}
+
+			u32Expected = u32Next;
+			bOpenExpected = bOpen;
+			++u32Boots;
+		}
+	}
+
+	printf("%u slots seed %u: %u sessions, %u boots, at most %u reads a boot (%u allowed), %u errors\n",
+		   u32Slots,
+		   u32Seed,
+		   u32Sessions,
+		   u32Boots,
+		   u32ReadsWorst,
+		   u32ReadsMax,
+		   u32Errors);
+
+	return((0 == u32Errors) && (u32ReadsWorst <= u32ReadsMax));
+}
+
+// Lists the sessions in the index of an image of a card, oldest first
+static bool SessionList(char *peImage)
+{
+	uint8_t u8Sector[SESSIONLOG_SECTOR_BYTES];
+	uint32_t u32FrameSlots;
+	uint32_t u32Slots;
+	uint32_t u32Head;
+	uint32_t u32Session;
+	long s32Bytes;
+
+	sg_psLogImage = fopen(peImage, "rb");
+	if (NULL == sg_psLogImage)
+	{
+		printf("Can't open card image '%s'\n", peImage);
+		return(false);
+	}
+
+	fseek(sg_psLogImage, 0, SEEK_END);
+	s32Bytes = ftell(sg_psLogImage);
+	SessionLog_Layout((uint32_t) (s32Bytes / SESSIONLOG_SECTOR_BYTES), &u32FrameSlots, &sg_u32SessionIndexSector, &u32Slots);
+	sg_u32LogReads = 0;
+
+	if (0 == u32Slots)
+	{
+		printf("Card image '%s' is too small for a session index\n", peImage);
+		fclose(sg_psLogImage);
+		return(false);
+	}
+
+	if (false == SessionLog_FindHead(u32Slots, SessionReadImage, u8Sector, &u32Head))
+	{
+		printf("%u slots: no sessions\n", u32Slots);
+		fclose(sg_psLogImage);
+		return(true);
+	}
+
+	printf("%u slots: %u sessions, found in %u reads\n", u32Slots, u32Head + 1, sg_u32LogReads);
+
+	for (u32Session = (u32Head >= u32Slots) ? (u32Head + 1 - u32Slots) : 0; u32Session <= u32Head; u32Session++)
+	{
+		SSessionRecord sRecord;
+		uint32_t u32Found;
+
+		if ((false == SessionReadImage(u32Session % u32Slots, u8Sector, false)) ||
+			(false == SessionLog_Header(u8Sector, &u32Found)) ||
+			(u32Found != u32Session))
+		{
+			printf("  Session %u: no record\n", u32Session);
+			continue;
+		}
+
+		memcpy((void *) &sRecord, (void *) u8Sector, sizeof(sRecord));
+		printf("  Session %u: frames %u-%u (%u), started %llu, %u cells, %u WDT resets, current 0x%04x-0x%04x%s%s\n",
+			   u32Session,
+			   sRecord.u32StartFrame,
+			   sRecord.u32EndFrame,
+			   sRecord.u32EndFrame - sRecord.u32StartFrame,
+			   (unsigned long long) sRecord.u64StartTime,
+			   sRecord.u8CellCount,
+			   sRecord.u8WDTCount,
+			   sRecord.u16MinCurrent,
+			   sRecord.u16MaxCurrent,
+			   (sRecord.u8Flags & SESSIONLOG_FLAG_OPEN) ? ", open" : "",
+			   (sRecord.u8Flags & SESSIONLOG_FLAG_CUT_SHORT) ? ", cut short" : "");
+	}
+
+	fclose(sg_psLogImage);
+	return(true);
+}
+
+// -counterverify - the frame counter in EEPROM (FRAMECOUNTER.c), built as it is for the
+// AVR against a made up EEPROM that can lose power part way through a write
+static uint8_t sg_u8CounterEEPROM[EEPROM_SIZE];
+static uint32_t sg_u32CounterReads;
+static uint32_t sg_u32CounterWritesLeft;		// Until the power goes, 0 = it doesn't
+static bool sg_bCounterPowerOff;
+
+uint8_t EEPROMRead(uint16_t u16Address)
+{
+	assert(u16Address < EEPROM_SIZE);
+	sg_u32CounterReads++;
+	return(sg_u8CounterEEPROM[u16Address]);
+}
+
+void EEPROMWrite(uint16_t u16Address,
+				 uint8_t u8Data)
+{
+	assert(u16Address < EEPROM_SIZE);
+	if (sg_bCounterPowerOff)
+	{
+		return;
+	}
+
+	// The byte the power goes on is left as it was, erased, or written
+	if (sg_u32CounterWritesLeft && (0 == --sg_u32CounterWritesLeft))
+	{
+		uint32_t u32Roll = (uint32_t) rand() % 3;
+
+		sg_bCounterPowerOff = true;
+		if (0 == u32Roll)
+		{
+			return;
+		}
+		if (1 == u32Roll)
+		{
+			u8Data = 0xff;
+		}
+	}
+
+	sg_u8CounterEEPROM[u16Address] = u8Data;
+}
+
+// A module counting frames. Now and then it's reset, sometimes by the power going part
+// way through a save. Every boot has to come back with the last save that got to EEPROM
+// (or, if the power went part way through one, that one), in no more than
+// log2(slots) + 3 slot reads. Then half the time there's a card, and the counter has to
+// carry on from the head of its log (STORE_Init()), exactly. Half the seeds start from
+// the old layout, and the first boot has to carry on from its counter.
+static bool CounterVerify(uint32_t u32Seed)
+{
+	uint32_t u32Frames = 0;			// Frames written - the head of the log on the card
+	uint32_t u32Saved = 0;			// The last whole save
+	uint32_t u32Torn = 0;			// The one the power went on
+	bool bTorn = false;
+	uint32_t u32Boots = 0;
+	uint32_t u32ReadsWorst = 0;
+	uint32_t u32ReadsMax = 3;
+	uint32_t u32Errors = 0;
+	uint32_t u32Event;
+
+	// Anchor (and maybe slot 0), the search, then the latest save again
+	while ((1UL << (u32ReadsMax - 3)) < COUNTER_VERIFY_SLOTS)
+	{
+		u32ReadsMax++;
+	}
+	u32ReadsMax *= COUNTER_VERIFY_SLOT_BYTES;
+
+	srand(u32Seed);
+	sg_u32CounterWritesLeft = 0;
+	sg_bCounterPowerOff = false;
+
+	// A blank EEPROM, or the old layout - a counter in one position, and 0xFFFFFFFF in
+	// the rest. Neither has a save in it. A blank one starts from 0, the old layout from
+	// its counter.
+	memset((void *) sg_u8CounterEEPROM, 0xff, sizeof(sg_u8CounterEEPROM));
+	if (u32Seed & 1)
+	{
+		uint16_t u16Address = EEPROM_FRAME_COUNTER_BASE + ((uint16_t) (rand() % (EEPROM_FRAME_COUNTER_SIZE / 4)) * 4);
+
+		sg_u8CounterEEPROM[u16Address + 1] = (uint8_t) rand();
+		sg_u8CounterEEPROM[u16Address + 2] = (uint8_t) rand();
+		sg_u8CounterEEPROM[u16Address + 3] = (uint8_t) rand();
+		sg_u8CounterEEPROM[u16Address] = 0;
+		u32Saved = ((uint32_t) sg_u8CounterEEPROM[u16Address + 1] << 16) |
+				   ((uint32_t) sg_u8CounterEEPROM[u16Address + 2] << 8) |
+				   sg_u8CounterEEPROM[u16Address + 3];
+	}
+	FrameCounter_Init();
+	if (FrameCounter_Get() != u32Saved)
+	{
+		printf("  Seed %u first boot: counter %u, should be %u\n", u32Seed, FrameCounter_Get(), u32Saved);
+		++u32Errors;
+	}
+	u32Frames = u32Saved;
+
+	for (u32Event = 0; u32Event < COUNTER_VERIFY_EVENTS; u32Event++)
+	{
+		uint32_t u32Roll = (uint32_t) rand() % 1000;
+		uint8_t u8Position = FrameCounter_GetPosition();
+
+		// Now and then the power's going to go in the next few writes
+		if (((rand() % 1000) < 5) && (0 == sg_u32CounterWritesLeft))
+		{
+			sg_u32CounterWritesLeft = 1 + ((uint32_t) rand() % 12);
+		}
+
+		// The frame's on the card before the counter moves on, even if the power goes
+		// while it's being saved
+		if (u32Roll >= 10)
+		{
+			FrameCounter_Increment();
+			u32Frames = FrameCounter_Get();
+		}
+
+		// A save moves the position on
+		if (u8Position != FrameCounter_GetPosition())
+		{
+			if (sg_bCounterPowerOff && (false == bTorn))
+			{
+				u32Torn = FrameCounter_Get();
+				bTorn = true;
+			}
+			else
+			if (false == sg_bCounterPowerOff)
+			{
+				u32Saved = FrameCounter_Get();
+			}
+		}
+
+		if ((u32Roll < 10) || sg_bCounterPowerOff || (u32Event == (COUNTER_VERIFY_EVENTS - 1)))
+		{
+			uint32_t u32Boot;
+
+			sg_bCounterPowerOff = false;
+			sg_u32CounterWritesLeft = 0;
+			sg_u32CounterReads = 0;
+			FrameCounter_Init();
+			u32Boot = FrameCounter_Get();
+
+			if ((u32Boot != u32Saved) &&
+				((false == bTorn) || (u32Boot != u32Torn)))
+			{
+				printf("  Seed %u boot %u: counter %u, should be %u\n", u32Seed, u32Boots, u32Boot, u32Saved);
+				++u32Errors;
+			}
+			if (sg_u32CounterReads > u32ReadsWorst)
+			{
+				u32ReadsWorst = sg_u32CounterReads;
+			}
+
+			// The card puts it right (STORE_Init()). Without one it carries on from EEPROM,
+			// which is as far as any card's log got.
+			if ((rand() & 1) && (u32Frames > u32Boot))
+			{
+				FrameCounter_Set(u32Frames);
+			}
+			if ((FrameCounter_Get() != u32Frames) && (FrameCounter_Get() != u32Boot))
+			{
+				printf("  Seed %u boot %u: counter %u after the card, should be %u\n", u32Seed, u32Boots, FrameCounter_Get(), u32Frames);
+				++u32Errors;
+			}
+
+			u32Frames = FrameCounter_Get();
+			u32Saved = u32Boot;
+			if (u32Frames != u32Boot)
+			{
+				u32Saved = u32Frames;
+			}
+			bTorn = false;
+			++u32Boots;
+		}
+	}
+
+	printf("Seed %u: %u frames, %u boots, at most %u EEPROM reads a boot (%u allowed), %u errors\n",
+		   u32Seed,
+		   FrameCounter_Get(),
+		   u32Boots,
+		   u32ReadsWorst,
+		   u32ReadsMax,
+		   u32Errors);
+
+	return((0 == u32Errors) && (u32ReadsWorst <= u32ReadsMax));
+}
+
+int main(int argc, char **argv)
+{
+	FILE *psOutput = NULL;
+	bool bResult = true;
+
+	if ((false == CmdLineInitArgcArgv(argc,
+									  argv,
+									  sg_sCmdLineOptions,
+									  argv[0])) ||
+		((NULL == CmdLineOptionValue("-capture")) &&
+		 (NULL == CmdLineOptionValue("-verify")) &&
+		 (NULL == CmdLineOptionValue("-strings")) &&
+		 (NULL == CmdLineOptionValue("-stringverify")) &&
+		 (NULL == CmdLineOptionValue("-loghead")) &&
+		 (NULL == CmdLineOptionValue("-logverify")) &&
+		 (NULL == CmdLineOptionValue("-logscrub")) &&
+		 (NULL == CmdLineOptionValue("-sessions")) &&
+		 (NULL == CmdLineOptionValue("-sessionverify")) &&
+		 (false == CmdLineOption("-counterverify"))))
+	{
+		printf("Failed\n");
+		CmdLineDumpOptions(sg_sCmdLineOptions);
+		return(1);
+	}
+
+	if (CmdLineOptionValue("-verify"))
+	{
+		bResult = VerifyFrame(CmdLineOptionValue("-verify"));
+	}
+
+	if (CmdLineOptionValue("-strings"))
+	{
+		if (false == ListStrings(CmdLineOptionValue("-strings")))
+		{
+			bResult = false;
+		}
+	}
+
+	if (CmdLineOptionValue("-stringverify"))
+	{
+		uint32_t u32Cells = (uint32_t) strtoul(CmdLineOptionValue("-stringverify"), NULL, 0);
+		uint32_t u32Seed;
+
+		// The records have to hold a reading of escapes (StringDelta_Init())
+		if ((0 == u32Cells) ||
+			((u32Cells * STRINGDELTA_CELL_BITS_MAX) > ((FRAMECODEC_FRAME_BYTES - FRAME_CELLBUFFER_START - (u32Cells * STRINGDELTA_CELL_BYTES)) << 3)))
+		{
+			printf("Too many cells for a frame\n");
+			return(1);
+		}
+
+		for (u32Seed = 1; u32Seed <= STRING_VERIFY_SEEDS; u32Seed++)
+		{
+			if (false == StringVerify((uint8_t) u32Cells, u32Seed))
+			{
+				bResult = false;
+			}
+		}
+	}
+
+	if (CmdLineOptionValue("-loghead"))
+	{
+		if (false == LogHead(CmdLineOptionValue("-loghead")))
+		{
+			bResult = false;
+		}
+	}
+
+	if (CmdLineOptionValue("-logscrub"))
+	{
+		if (false == LogScrub(CmdLineOptionValue("-logscrub")))
+		{
+			bResult = false;
+		}
+	}
+
+	if (CmdLineOptionValue("-logverify"))
+	{
+		uint32_t u32Slots = (uint32_t) strtoul(CmdLineOptionValue("-logverify"), NULL, 0);
+		uint32_t u32Seed;
+
+		if ((0 == u32Slots) || (u32Slots > LOG_VERIFY_SLOTS_MAX))
+		{
+			printf("Slots has to be 1-%u\n", LOG_VERIFY_SLOTS_MAX);
+			return(1);
+		}
+
+		sg_pu8LogCard = malloc((size_t) u32Slots * FRAMELOG_FRAME_BYTES);
+		if (NULL == sg_pu8LogCard)
+		{
+			printf("Out of memory\n");
+			return(1);
+		}
+
+		for (u32Seed = 1; u32Seed <= LOG_VERIFY_SEEDS; u32Seed++)
+		{
+			if (false == LogVerify(u32Slots, u32Seed))
+			{
+				bResult = false;
+			}
+		}
+
+		free(sg_pu8LogCard);
+	}
+
+	if (CmdLineOptionValue("-sessions"))
+	{
+		if (false == SessionList(CmdLineOptionValue("-sessions")))
+		{
+			bResult = false;
+		}
+	}
+
+	if (CmdLineOptionValue("-sessionverify"))
+	{
+		uint32_t u32Slots = (uint32_t) strtoul(CmdLineOptionValue("-sessionverify"), NULL, 0);
+		uint32_t u32Seed;
+
+		// A torn write to the only slot would take the whole index with it
+		if ((u32Slots < 2) || (u32Slots > LOG_VERIFY_SLOTS_MAX))
+		{
+			printf("Slots has to be 2-%u\n", LOG_VERIFY_SLOTS_MAX);
+			return(1);
+		}
+
+		sg_pu8SessionIndex = malloc((size_t) u32Slots * SESSIONLOG_SECTOR_BYTES);
+		sg_psSessionTruth = malloc((size_t) u32Slots * sizeof(*sg_psSessionTruth));
+		if ((NULL == sg_pu8SessionIndex) || (NULL == sg_psSessionTruth))
+		{
+			printf("Out of memory\n");
+			return(1);
+		}
+
+		for (u32Seed = 1; u32Seed <= SESSION_VERIFY_SEEDS; u32Seed++)
+		{
+			if (false == SessionVerify(u32Slots, u32Seed))
+			{
+				bResult = false;
+			}
+		}
+
+		free(sg_pu8SessionIndex);
+		free(sg_psSessionTruth);
+	}
+
+	if (CmdLineOption("-counterverify"))
+	{
+		uint32_t u32Seed;
+
+		for (u32Seed = 1; u32Seed <= COUNTER_VERIFY_SEEDS; u32Seed++)
+		{
+			if (false == CounterVerify(u32Seed))
+			{
+				bResult = false;
+			}
+		}
+	}
+
+	if (CmdLineOptionValue("-capture"))
+	{
+		if (CmdLineOptionValue("-file"))
+		{
+			psOutput = fopen(CmdLineOptionValue("-file"), "ab");
+			if (NULL == psOutput)
+			{
+				printf("Can't open file '%s' for writing\n", CmdLineOptionValue("-file"));
+				return(1);
+			}
+		}
+
+		if (false == DecodeCapture(CmdLineOptionValue("-capture"), psOutput))
+		{
+			bResult = false;
+		}
+
+		if (psOutput)
+		{
+			fclose(psOutput);
+		}
+	}
+
+	return(bResult ? 0 : 1);
+}
@@ -0,0 +1,234 @@
+#include "framelog.h"
+#include "crc32.h"
+
+static uint32_t FrameLogGet32(const uint8_t* pu8Data)
+{
+	return((uint32_t) pu8Data[0] |
+		   ((uint32_t) pu8Data[1] << 8) |
+		   ((uint32_t) pu8Data[2] << 16) |
+		   ((uint32_t) pu8Data[3] << 24));
+}
+
+uint32_t FrameLog_CrcUpdate(uint32_t u32Crc,
+							const uint8_t* pu8Frame,
+							uint16_t u16From,
+							uint16_t u16To)
+{
+	// The bit before the CRC field
+	if (u16From < FRAMELOG_OFFSET_CRC)
+	{
+		uint16_t u16End = (u16To < FRAMELOG_OFFSET_CRC) ? u16To : FRAMELOG_OFFSET_CRC;
+
+		u32Crc = CRC32_Update(u32Crc, &pu8Frame[u16From], u16End - u16From);
+		u16From = u16End;
+	}
+
+	// Skip the field itself
+	if (u16From < (FRAMELOG_OFFSET_CRC + sizeof(uint32_t)))
+	{
+		u16From = FRAMELOG_OFFSET_CRC + sizeof(uint32_t);
+	}
+
+	if (u16From < u16To)
+	{
+		u32Crc = CRC32_Update(u32Crc, &pu8Frame[u16From], u16To - u16From);
+	}
+
+	return(u32Crc);
+}
+
+void FrameLog_Seal(uint8_t* pu8Frame)
+{
+	uint32_t u32Crc = FrameLog_CrcUpdate(0, pu8Frame, 0, FRAMELOG_FRAME_BYTES);
+
+	pu8Frame[FRAMELOG_OFFSET_CRC] = (uint8_t) u32Crc;
+	pu8Frame[FRAMELOG_OFFSET_CRC + 1] = (uint8_t) (u32Crc >> 8);
+	pu8Frame[FRAMELOG_OFFSET_CRC + 2] = (uint8_t) (u32Crc >> 16);
+	pu8Frame[FRAMELOG_OFFSET_CRC + 3] = (uint8_t) (u32Crc >> 24);
+}
+
+bool FrameLog_Header(const uint8_t* pu8Frame, uint32_t* pu32Counter)
+{
+	if ((pu8Frame[FRAMELOG_OFFSET_SIG] != (uint8_t) FRAMELOG_SIG) ||
+		(pu8Frame[FRAMELOG_OFFSET_SIG + 1] != (uint8_t) (FRAMELOG_SIG >> 8)) ||
+		(pu8Frame[FRAMELOG_OFFSET_FRAMEBYTES] != (uint8_t) FRAMELOG_FRAME_BYTES) ||
+		(pu8Frame[FRAMELOG_OFFSET_FRAMEBYTES + 1] != (uint8_t) (FRAMELOG_FRAME_BYTES >> 8)))
+	{
+		return(false);
+	}
+
+	*pu32Counter = FrameLogGet32(&pu8Frame[FRAMELOG_OFFSET_COUNTER]);
+	return(true);
+}
+
+bool FrameLog_Check(const uint8_t* pu8Frame)
+{
+	return(FrameLog_CrcUpdate(0, pu8Frame, 0, FRAMELOG_FRAME_BYTES) == FrameLogGet32(&pu8Frame[FRAMELOG_OFFSET_CRC]));
+}
+
+void FrameLog_ScrubStart(SFrameLogScrub* psScrub, uint32_t u32Counter)
+{
+	psScrub->u32Counter = u32Counter;
+	psScrub->u32Crc = 0;
+	psScrub->u32Expected = 0;
+	psScrub->u16Byte = 0;
+	psScrub->bSectorRead = false;
+}
+
+EFrameLogCheck FrameLog_ScrubStep(SFrameLogScrub* psScrub,
+								  uint32_t u32Slots,
+								  PFFrameLogReadSector pfRead,
+								  uint8_t* pu8Sector,
+								  uint16_t u16StepBytes)
+{
+	uint8_t u8Sector = (uint8_t) (psScrub->u16Byte / FRAMELOG_HEADER_BYTES);
+	uint16_t u16From = psScrub->u16Byte % FRAMELOG_HEADER_BYTES;
+	uint16_t u16To;
+
+	if (false == psScrub->bSectorRead)
+	{
+		uint32_t u32Found;
+
+		if (false == pfRead(psScrub->u32Counter % u32Slots, u8Sector, pu8Sector))
+		{
+			return(EFRAMELOG_CHECK_READ_FAILED);
+		}
+		psScrub->bSectorRead = true;
+
+		// The header's only looked at once. A sector read again after its buffer was
+		// used for something else just carries the CRC on.
+		if (0 == psScrub->u16Byte)
+		{
+			if ((false == FrameLog_Header(pu8Sector, &u32Found)) ||
+				(u32Found != psScrub->u32Counter))
+			{
+				return(EFRAMELOG_CHECK_MISSING);
+			}
+			psScrub->u32Expected = FrameLogGet32(&pu8Sector[FRAMELOG_OFFSET_CRC]);
+		}
+		return(EFRAMELOG_CHECK_BUSY);
+	}
+
+	u16To = u16From + u16StepBytes;
+	if (u16To > FRAMELOG_HEADER_BYTES)
+	{
+		u16To = FRAMELOG_HEADER_BYTES;
+	}
+
+	// The CRC field is in the first sector
+	if (0 == u8Sector)
+	{
+		psScrub->u32Crc = FrameLog_CrcUpdate(psScrub->u32Crc, pu8Sector, u16From, u16To);
+	}
+	else
+	{
+		psScrub->u32Crc = CRC32_Update(psScrub->u32Crc, &pu8Sector[u16From], u16To - u16From);
+	}
+	psScrub->u16Byte += u16To - u16From;
+
+	if (FRAMELOG_HEADER_BYTES == u16To)
+	{
+		psScrub->bSectorRead = false;
+	}
+
+	if (psScrub->u16Byte < FRAMELOG_FRAME_BYTES)
+	{
+		return(EFRAMELOG_CHECK_BUSY);
+	}
+
+	return((psScrub->u32Crc == psScrub->u32Expected) ? EFRAMELOG_CHECK_OK : EFRAMELOG_CHECK_CORRUPT);
+}
+
+// True if slot u32Slot holds counter u32Counter
+static bool FrameLogHolds(uint32_t u32Slot,
+						  uint32_t u32Counter,
+						  PFFrameLogRead pfRead,
+						  PFFrameLogHeader pfHeader,
+						  uint8_t* pu8Slot)
+{
+	uint32_t u32Found;
+
+	return(pfRead(u32Slot, pu8Slot, false) &&
+		   pfHeader(pu8Slot, &u32Found) &&
+		   (u32Found == u32Counter));
+}
+
+// True if slot u32Anchor holds an entry that belongs there
+static bool FrameLogAnchor(uint32_t u32Slots,
+						   uint32_t u32Anchor,
+						   PFFrameLogRead pfRead,
+						   PFFrameLogHeader pfHeader,
+						   uint8_t* pu8Slot,
+						   uint32_t* pu32Counter)
+{
+	return(pfRead(u32Anchor, pu8Slot, false) &&
+		   pfHeader(pu8Slot, pu32Counter) &&
+		   ((*pu32Counter % u32Slots) == u32Anchor));
+}
+
+bool FrameLog_FindRun(uint32_t u32Slots,
+					  uint32_t u32Hint,
+					  PFFrameLogRead pfRead,
+					  PFFrameLogHeader pfHeader,
+					  uint8_t* pu8Slot,
+					  uint32_t* pu32Head)
+{
+	uint32_t u32Anchor = u32Hint % u32Slots;
+	uint32_t u32Counter;
+	uint32_t u32Low = 0;
+	uint32_t u32High = u32Slots;
+
+	// Somewhere to start from - an entry in the hint's slot, or failing that in slot 0.
+	// An entry's counter has to belong in the slot it's in.
+	if (false == FrameLogAnchor(u32Slots, u32Anchor, pfRead, pfHeader, pu8Slot, &u32Counter))
+	{
+		u32Anchor = 0;
+		if (false == FrameLogAnchor(u32Slots, u32Anchor, pfRead, pfHeader, pu8Slot, &u32Counter))
+		{
+			return(false);
+		}
+	}
+
+	// The run from the anchor is at least u32Low + 1 entries long and shorter than u32High + 1
+	while ((u32High - u32Low) > 1)
+	{
+		uint32_t u32Mid = u32Low + ((u32High - u32Low) >> 1);
+
+		if (FrameLogHolds((u32Anchor + u32Mid) % u32Slots,
+						  u32Counter + u32Mid,
+						  pfRead,
+						  pfHeader,
+						  pu8Slot))
+		{
+			u32Low = u32Mid;
+		}
+		else
+		{
+			u32High = u32Mid;
+		}
+	}
+
+	*pu32Head = u32Counter + u32Low;
+	return(true);
+}
+
+bool FrameLog_FindHead(uint32_t u32Slots,
+					   uint32_t u32Hint,
+					   PFFrameLogRead pfRead,
+					   uint8_t* pu8Frame,
+					   uint32_t* pu32Next)
+{
+	if (false == FrameLog_FindRun(u32Slots, u32Hint, pfRead, FrameLog_Header, pu8Frame, pu32Next))
+	{
+		return(false);
+	}
+
+	// The head - if it doesn't check out its write was cut short, so it's written again
+	if (pfRead(*pu32Next % u32Slots, pu8Frame, true) &&
+		FrameLog_Check(pu8Frame))
+	{
+		(*pu32Next)++;
+	}
+
+	return(true);
+}
@@ -0,0 +1,116 @@
+#ifndef _FRAMELOG_H_
+#define _FRAMELOG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// The SD frame log - shared by the firmware and host tools, so no AVR dependencies in
+// here.
+//
+// The card is a ring of frame slots, SECTORS_PER_FRAME sectors each. Frame counter N
+// goes in slot N % slots, and the counter only moves on once a frame is written, so the
+// slots hold an unbroken run of counters that wraps round. Each frame describes itself
+// in its first sector: the valid signature, the frame counter and a CRC32 of the whole
+// frame (all but the CRC field itself).
+//
+// At boot the write head is found by binary search. From a slot known to hold a frame,
+// the run carries on for as long as slot + d holds counter + d, then stops (older
+// frames from the last time round, or slots never written). That's a yes/no that only
+// changes once, so it takes log2(slots) header reads. Only the frame the search ends on
+// has its CRC checked - a write cut short by a reset only ever hits the last frame.
+
+#define FRAMELOG_FRAME_BYTES		1024
+#define FRAMELOG_HEADER_BYTES		512		// The header fields are all in the first sector
+
+// AVR offsets of FrameMetadata.validSig/.frameBytes/.frameCounter/.frameCrc
+#define FRAMELOG_OFFSET_SIG			0
+#define FRAMELOG_OFFSET_FRAMEBYTES	4
+#define FRAMELOG_OFFSET_COUNTER		85
+#define FRAMELOG_OFFSET_CRC			95
+#define FRAMELOG_SIG				0xba77	// FRAME_VALID_SIG
+
+// Reads slot u32Slot into pu8Frame - just the first FRAMELOG_HEADER_BYTES unless bWhole.
+// Returns false if it can't be read.
+typedef bool (*PFFrameLogRead)(uint32_t u32Slot, uint8_t* pu8Frame, bool bWhole);
+
+// True if pu8Slot holds a log entry (a frame's header, say). *pu32Counter gets its counter.
+typedef bool (*PFFrameLogHeader)(const uint8_t* pu8Slot, uint32_t* pu32Counter);
+
+// Carries a CRC on over bytes u16From to u16To of a frame, leaving out the CRC field. Start
+// with 0 at byte 0 - the frame's CRC is the result at FRAMELOG_FRAME_BYTES.
+extern uint32_t FrameLog_CrcUpdate(uint32_t u32Crc,
+								   const uint8_t* pu8Frame,
+								   uint16_t u16From,
+								   uint16_t u16To);
+
+// Works out the frame's CRC and puts it in the header
+extern void FrameLog_Seal(uint8_t* pu8Frame);
+
+// True if the header looks like a frame's. *pu32Counter gets its frame counter.
+extern bool FrameLog_Header(const uint8_t* pu8Frame, uint32_t* pu32Counter);
+
+// True if the whole frame checks out against its CRC
+extern bool FrameLog_Check(const uint8_t* pu8Frame);
+
+// What reading a frame back found. The values go out over CAN (FRAME_CHECK).
+typedef enum
+{
+	EFRAMELOG_CHECK_OK = 0,				// It's there and its CRC checks out
+	EFRAMELOG_CHECK_MISSING = 1,		// Its slot holds another frame or nothing - gone round, or never written
+	EFRAMELOG_CHECK_CORRUPT = 2,		// It's in its slot, but its CRC doesn't match
+	EFRAMELOG_CHECK_READ_FAILED = 3,	// The card didn't read
+	EFRAMELOG_CHECK_BUSY = 4,			// Not finished yet
+	EFRAMELOG_CHECK_WAIT = 5,			// Not started - a frame write has the card (STORE only, never sent)
+} EFrameLogCheck;
+
+// Reads sector u8Sector (0 to frame sectors - 1) of slot u32Slot into pu8Sector. Returns
+// false if it can't be read.
+typedef bool (*PFFrameLogReadSector)(uint32_t u32Slot, uint8_t u8Sector, uint8_t* pu8Sector);
+
+// A frame being checked against its CRC a step at a time, with only a sector of RAM:
+// each step either reads the next sector or works out a slice of the CRC
+typedef struct
+{
+	uint32_t u32Counter;		// Frame being checked
+	uint32_t u32Crc;			// Its CRC so far
+	uint32_t u32Expected;		// What its header says it should be
+	uint16_t u16Byte;			// How far the CRC has got
+	bool bSectorRead;			// The sector u16Byte is in has been read - cleared if its buffer is used for anything else
+} SFrameLogScrub;
+
+// Starts checking frame counter u32Counter
+extern void FrameLog_ScrubStart(SFrameLogScrub* psScrub, uint32_t u32Counter);
+
+// One step of checking the frame in a log of u32Slots slots. pu8Sector is a sector that
+// has to be left alone between steps, unless bSectorRead is cleared. Returns
+// EFRAMELOG_CHECK_BUSY until the frame's been checked.
+extern EFrameLogCheck FrameLog_ScrubStep(SFrameLogScrub* psScrub,
+										 uint32_t u32Slots,
+										 PFFrameLogReadSector pfRead,
+										 uint8_t* pu8Sector,
+										 uint16_t u16StepBytes);
+
+// Finds the last entry of the run of counters in a log of u32Slots slots, any log laid
+// out like the frames are (sessionlog.h too). The search starts from the slot for
+// counter u32Hint, or slot 0 if there's no entry there, and only reads headers.
+// pu8Slot is scratch for pfRead. Returns false if there's no log to find. Otherwise
+// *pu32Head is the last counter in the run - nothing's checked beyond its header.
+extern bool FrameLog_FindRun(uint32_t u32Slots,
+							 uint32_t u32Hint,
+							 PFFrameLogRead pfRead,
+							 PFFrameLogHeader pfHeader,
+							 uint8_t* pu8Slot,
+							 uint32_t* pu32Head);
+
+// Finds the write head of a log of u32Slots slots, starting from the slot for frame
+// counter u32Hint (slot 0 if there's no frame there). pu8Frame is FRAMELOG_FRAME_BYTES
+// of scratch. Returns false if there's no log to find. Otherwise *pu32Next is the
+// counter of the next frame to write - one past the head, or the head itself if its
+// write didn't finish.
+extern bool FrameLog_FindHead(uint32_t u32Slots,
+							  uint32_t u32Hint,
+							  PFFrameLogRead pfRead,
+							  uint8_t* pu8Frame,
+							  uint32_t* pu32Next);
+
+#endif // _FRAMELOG_H_
@@ -0,0 +1 @@
+cl /DVERIFY_TABLES gencelltables.c ..\geneeprom\cmdline.c shell32.lib
\ No newline at end of file
@@ -0,0 +1,364 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+#include <ctype.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "../geneeprom/CmdLine.h"
+#include "../cellcal.h"
+
+// Generates celltables.h - the flash resident cell voltage/temperature conversion
+// tables - from the calibration in cellcal.h. -verify checks the celltables.h this
+// tool was built with, bit for bit, against the arithmetic the firmware used before
+// the tables, over every possible input.
+
+#ifndef MSG_CELL_TEMP_I2C_OK
+#define MSG_CELL_TEMP_I2C_OK		0x8000
+#endif
+
+#define TEMPERATURE_INVALID			0xffff
+
+#define VOLTAGE_TABLE_ENTRIES		(1 << CELL_VOLTAGE_BITS)
+
+static SCmdLineOption sg_sCmdLineOptions[] =
+{
+	{"-file",			"Output header filename (celltables.h)",			false,	true},
+	{"-verify",			"Check the built in celltables.h against the arithmetic",	false,	false},
+
+	{NULL}
+};
+
+// Whole degrees for a temperature table index
+static int16_t TemperatureTableWhole(uint16_t u16Index)
+{
+	if (u16Index >= (CELL_TEMP_TABLE_ENTRIES / 2))
+	{
+		return((int16_t) u16Index - CELL_TEMP_TABLE_ENTRIES);
+	}
+
+	return((int16_t) u16Index);
+}
+
+static void DumpTable(FILE *psFile,
+					  const char *peDeclaration,
+					  int32_t *ps32Values,
+					  uint16_t u16Count,
+					  const char *peFormat)
+{
+	uint16_t u16Index;
+
+	fprintf(psFile, "%s PROGMEM =\n{\n", peDeclaration);
+
+	for (u16Index = 0; u16Index < u16Count; u16Index++)
+	{
+		if (0 == (u16Index & 7))
+		{
+			fprintf(psFile, "\t");
+		}
+
+		fprintf(psFile, peFormat, ps32Values[u16Index]);
+
+		if (u16Index != (u16Count - 1))
+		{
+			fprintf(psFile, ",");
+		}
+
+		fprintf(psFile, ((u16Index & 7) == 7) ? "\n" : " ");
+	}
+
+	fprintf(psFile, "};\n\n");
+}
+
+static bool Generate(char *peFilename)
+{
+	FILE *psFile;
+	int32_t s32Values[VOLTAGE_TABLE_ENTRIES];
+	uint16_t u16Index;
+
+	psFile = fopen(peFilename, "w");
+	if (NULL == psFile)
+	{
+		printf("Can't open file '%s' for writing\n", peFilename);
+		return(false);
+	}
+
+	fprintf(psFile, "#ifndef _CELLTABLES_H_\n#define _CELLTABLES_H_\n\n");
+	fprintf(psFile, "// GENERATED by gencelltables from cellcal.h - do not edit. Regenerate whenever the\n");
+	fprintf(psFile, "// calibration in cellcal.h changes.\n\n");
+	fprintf(psFile, "#include <stdint.h>\n\n");
+	fprintf(psFile, "#ifdef __AVR__\n#include <avr/pgmspace.h>\n#elif !defined(PROGMEM)\n#define PROGMEM\n#endif\n\n");
+	fprintf(psFile, "// VOLTAGE_CONVERSION_FACTOR these tables were generated with\n");
+	fprintf(psFile, "#define CELL_TABLE_VOLTAGE_CONVERSION_FACTOR\t%luUL\n\n", (unsigned long) VOLTAGE_CONVERSION_FACTOR);
+
+	// RAW 10 bit cell voltage -> millivolts, 0 = invalid
+	for (u16Index = 0; u16Index < VOLTAGE_TABLE_ENTRIES; u16Index++)
+	{
+		s32Values[u16Index] = CellCalVoltage(u16Index);
+	}
+	fprintf(psFile, "// RAW 10 bit cell voltage to millivolts, 0 = invalid\n");
+	DumpTable(psFile, "static const uint16_t sg_u16CellVoltageTable[1 << CELL_VOLTAGE_BITS]", s32Values, VOLTAGE_TABLE_ENTRIES, "%5d");
+
+	// Whole degrees -> 100ths of degrees with TEMPERATURE_BASE offset
+	for (u16Index = 0; u16Index < CELL_TEMP_TABLE_ENTRIES; u16Index++)
+	{
+		s32Values[u16Index] = CellCalTemperature(TemperatureTableWhole(u16Index), 0);
+	}
+	fprintf(psFile, "// Whole degrees C (& CELL_TEMP_TABLE_MASK) to 100ths of degrees C with TEMPERATURE_BASE offset\n");
+	DumpTable(psFile, "static const int16_t sg_s16CellTemperatureTable[CELL_TEMP_TABLE_ENTRIES]", s32Values, CELL_TEMP_TABLE_ENTRIES, "%6d");
+
+	// 16ths of a degree -> 100ths
+	for (u16Index = 0; u16Index < CELL_TEMP_FRACTION_ENTRIES; u16Index++)
+	{
+		s32Values[u16Index] = CellCalTemperatureFraction((uint8_t) u16Index);
+	}
+	fprintf(psFile, "// 16ths of a degree C to 100ths\n");
+	DumpTable(psFile, "static const uint8_t sg_u8CellTemperatureFractionTable[CELL_TEMP_FRACTION_ENTRIES]", s32Values, CELL_TEMP_FRACTION_ENTRIES, "%2d");
+
+	fprintf(psFile, "#endif // _CELLTABLES_H_\n");
+	fclose(psFile);
+
+	printf("Wrote '%s' - VOLTAGE_CONVERSION_FACTOR %lu\n", peFilename, (unsigned long) VOLTAGE_CONVERSION_FACTOR);
+	return(true);
+}
+
+#ifdef VERIFY_TABLES
+#include "../celltables.h"
+
+// CellDataConvertVoltage()/CellDataConvertTemperature() arithmetic as it was before
+// the tables, verbatim
+
+static const uint8_t sg_u8FractionalLookup[] =
+{
+	0,
+	6,
+	12,
+	18,
+	25,
+	31,
+	37,
+	43,
+	50,
+	56,
+	62,
+	68,
+	75,
+	81,
+	87,
+	93
+};
+
+static bool LegacyVoltage(uint16_t u16CellData,
+						  uint16_t *pu16Voltage)
+{
+	uint16_t u16Voltage = u16CellData;
+	bool bCellDataValid = true;
+
+	u16Voltage &= ((1 << (CELL_VOLTAGE_BITS)) - 1);
+	{
+		uint32_t temp = (uint32_t)u16Voltage * VOLTAGE_CONVERSION_FACTOR;
+		u16Voltage = (uint16_t)((temp / ADC_MAX_VALUE + FIXED_POINT_SCALE/2) / FIXED_POINT_SCALE);
+
+		if (u16Voltage == 0 || u16Voltage == 0xFFFF)
+		{
+			bCellDataValid = false;
+			u16Voltage = 0;
+		}
+	}
+
+	*pu16Voltage = u16Voltage;
+	return(bCellDataValid);
+}
+
+static bool LegacyTemperature(int16_t s16CellData,
+							  int16_t *ps16Temperature)
+{
+	bool bCellDataValid = true;
+	int16_t s16Temperature = s16CellData;
+	uint8_t u8Fractional;
+
+	// Never false for an int16_t - kept exactly as the firmware has it
+	if (TEMPERATURE_INVALID != s16Temperature)
+	{
+		u8Fractional = (uint8_t) (s16Temperature & 0x0f);
+
+		if (s16Temperature & (1 << 12))
+		{
+			s16Temperature |= 0xf000;
+		}
+		else
+		{
+			s16Temperature &= ~MSG_CELL_TEMP_I2C_OK;
+		}
+
+		s16Temperature >>= 4;
+		s16Temperature = (s16Temperature * 100) + (int16_t) sg_u8FractionalLookup[u8Fractional];
+		s16Temperature += TEMPERATURE_BASE;
+	}
+	else
+	{
+		bCellDataValid = false;
+	}
+
+	*ps16Temperature = s16Temperature;
+	return(bCellDataValid);
+}
+
+// Table paths, as CellDataConvertVoltage()/CellDataConvertTemperature() now do it
+
+static bool TableVoltage(uint16_t u16CellData,
+						 uint16_t *pu16Voltage)
+{
+	*pu16Voltage = sg_u16CellVoltageTable[u16CellData & ((1 << CELL_VOLTAGE_BITS) - 1)];
+	return(*pu16Voltage != 0);
+}
+
+static bool TableTemperature(int16_t s16CellData,
+							 int16_t *ps16Temperature)
+{
+	bool bCellDataValid = true;
+	int16_t s16Temperature = s16CellData;
+	uint8_t u8Fractional;
+
+	// Never false for an int16_t - kept exactly as the firmware has it
+	if (TEMPERATURE_INVALID != s16Temperature)
+	{
+		u8Fractional = (uint8_t) (s16Temperature & 0x0f);
+
+		if (s16Temperature & (1 << 12))
+		{
+			s16Temperature |= 0xf000;
+		}
+		else
+		{
+			s16Temperature &= ~MSG_CELL_TEMP_I2C_OK;
+		}
+
+		s16Temperature >>= 4;
+		if ((uint16_t) (s16Temperature + (CELL_TEMP_TABLE_ENTRIES / 2)) < CELL_TEMP_TABLE_ENTRIES)
+		{
+			s16Temperature = sg_s16CellTemperatureTable[s16Temperature & CELL_TEMP_TABLE_MASK] + (int16_t) sg_u8CellTemperatureFractionTable[u8Fractional];
+		}
+		else
+		{
+			s16Temperature = CellCalTemperature(s16Temperature, u8Fractional);
+		}
+	}
+	else
+	{
+		bCellDataValid = false;
+	}
+
+	*ps16Temperature = s16Temperature;
+	return(bCellDataValid);
+}
+
+static bool Verify(void)
+{
+	uint32_t u32Input;
+	uint32_t u32Mismatches = 0;
+	uint32_t u32TableHits = 0;
+
+	if (CELL_TABLE_VOLTAGE_CONVERSION_FACTOR != VOLTAGE_CONVERSION_FACTOR)
+	{
+		printf("celltables.h was generated for VOLTAGE_CONVERSION_FACTOR %lu, cellcal.h says %lu - regenerate\n",
+			   (unsigned long) CELL_TABLE_VOLTAGE_CONVERSION_FACTOR,
+			   (unsigned long) VOLTAGE_CONVERSION_FACTOR);
+		return(false);
+	}
+
+	// Every 16 bit voltage word
+	for (u32Input = 0; u32Input < 0x10000; u32Input++)
+	{
+		uint16_t u16Legacy;
+		uint16_t u16Table;
+		bool bLegacy = LegacyVoltage((uint16_t) u32Input, &u16Legacy);
+		bool bTable = TableVoltage((uint16_t) u32Input, &u16Table);
+
+		if ((bLegacy != bTable) || (u16Legacy != u16Table))
+		{
+			if (u32Mismatches < 10)
+			{
+				printf("Voltage 0x%.4x: arithmetic %u/%u, table %u/%u\n", u32Input, bLegacy, u16Legacy, bTable, u16Table);
+			}
+			++u32Mismatches;
+		}
+	}
+
+	// Every 16 bit temperature word
+	for (u32Input = 0; u32Input < 0x10000; u32Input++)
+	{
+		int16_t s16Legacy;
+		int16_t s16Table;
+		int16_t s16Whole = (int16_t) u32Input;
+		bool bLegacy = LegacyTemperature((int16_t) u32Input, &s16Legacy);
+		bool bTable = TableTemperature((int16_t) u32Input, &s16Table);
+
+		if ((bLegacy != bTable) || (s16Legacy != s16Table))
+		{
+			if (u32Mismatches < 10)
+			{
+				printf("Temperature 0x%.4x: arithmetic %u/%d, table %u/%d\n", u32Input, bLegacy, s16Legacy, bTable, s16Table);
+			}
+			++u32Mismatches;
+		}
+
+		if (s16Whole & (1 << 12))
+		{
+			s16Whole |= 0xf000;
+		}
+		else
+		{
+			s16Whole &= ~MSG_CELL_TEMP_I2C_OK;
+		}
+		s16Whole >>= 4;
+		if ((uint16_t) (s16Whole + (CELL_TEMP_TABLE_ENTRIES / 2)) < CELL_TEMP_TABLE_ENTRIES)
+		{
+			++u32TableHits;
+		}
+	}
+
+	printf("Voltage: 65536 inputs, temperature: 65536 inputs (%u from the tables) - %u mismatches\n",
+		   u32TableHits,
+		   u32Mismatches);
+
+	return(0 == u32Mismatches);
+}
+#endif
+
+int main(int argc, char **argv)
+{
+	bool bResult = true;
+
+	if ((false == CmdLineInitArgcArgv(argc,
+									  argv,
+									  sg_sCmdLineOptions,
+									  argv[0])) ||
+		((NULL == CmdLineOptionValue("-file")) && (false == CmdLineOption("-verify"))))
+	{
+		printf("Failed\n");
+		CmdLineDumpOptions(sg_sCmdLineOptions);
+		return(1);
+	}
+
+	if (CmdLineOptionValue("-file"))
+	{
+		bResult = Generate(CmdLineOptionValue("-file"));
+	}
+
+	if (CmdLineOption("-verify"))
+	{
+#ifdef VERIFY_TABLES
+		if (false == Verify())
+		{
+			bResult = false;
+		}
+#else
+		printf("Built without VERIFY_TABLES - rebuild with celltables.h present (build-win32.bat does)\n");
+		bResult = false;
+#endif
+	}
+
+	return(bResult ? 0 : 1);
+}
@@ -18,6 +18,7 @@
 #include <avr/interrupt.h>
 #include <avr/sleep.h>
 #include <avr/wdt.h>
+#include <avr/pgmspace.h>
 #include "main.h"
 #include "../Shared/Shared.h"
 //#include "FatFS/source/ff.h"
@@ -32,6 +33,11 @@
 #include "FRAMECOUNTER.h"
 #include "SD.h"
 #include "crc32.h"
+#include "crc8.h"
+#include "framecodec.h"
+#include "stringdelta.h"
+#include "cellcal.h"
+#include "celltables.h"
 
 // watchdog stuff
 // Uncomment to enable watchdog timer
@@ -58,9 +64,67 @@ static volatile eWDTstatus __attribute__((section(".noinit"))) sg_eWDTCurrentSta
 //#define	STATE_CYCLE								// if REQUEST_CELL_BALANCE_ENABLE is defined, will test discharge in OFF and STDBY
 #define	STATE_CYCLE_INTERVAL		1			// How often do we switch state? (in seconds)
 
+// Uncomment to pipeline string reads - every frame processes the string that just came in
+// and requests the next one into the following circular buffer slot, instead of alternating
+// READ and WRITE frames. A reading lands every frame rather than every other frame.
+//#define	PIPELINED_FRAMES
+
+// Uncomment to step the vUART up to a faster bit rate once the string is running clean,
+// checking each new rate with the cells' test pattern (see VUART_RATE_NEGOTIATION.md).
+// Needs cell firmware that knows MSG_CELL_SET_BIT_RATE.
+//#define	VUART_RATE_NEGOTIATION
+
+// Uncomment for cell records with a CRC-8 byte after the 4 data bytes, checked as each
+// record comes in (see CELL_RECORD_CRC.md). The cell firmware has to be built to match.
+//#define	CELL_RECORD_CRC
+
+// Uncomment to let the pack have a window of a few cells read between full string readings
+// (see CELL_WINDOW_POLLING.md). The cell firmware has to know MSG_CELL_REPORT_WINDOW.
+//#define	CELL_WINDOW_POLLING
+
+// Uncomment to keep the frame's older string readings delta packed behind the latest one,
+// so a frame holds several times as many (see FRAME_DELTA_STRINGS.md). Frames are
+// written as FRAME_VERSION_DELTA, which the pack/host tools have to know.
+//#define	FRAME_DELTA_STRINGS
+
+// Uncomment to time CellStringProcess()'s string statistics to 1us and report the longest
+// in CELL_COMM_STAT1 bytes 6-7 (see CELL_STRING_STATISTICS.md). The pack has to be built
+// with it too, to read them. Off, they're 0 as before.
+//#define	STRING_PROCESS_PROFILING
+
+// CELL_COMM_STAT2 byte 4 frame mode flags
+#define CELL_COMM_STAT2_PIPELINED			0x01
+#define CELL_COMM_STAT2_RATE_NEGOTIATION	0x02
+#define CELL_COMM_STAT2_RATE_SHIFT			2		// Bits 2-3 - current vUART rate
+#define CELL_COMM_STAT2_RATE_FASTEST_SHIFT	4		// Bits 4-5 - fastest vUART rate that's worked
+
 // Request ALL cell detail
 #define CELL_DETAIL_ALL						0xff
 
+// MODULE_DETAIL_REQUEST byte 2 - reply with packed MODULE_DETAIL_BULK messages instead
+#define CELL_DETAIL_REQUEST_BULK			0x01
+
+// Cells packed into each MODULE_DETAIL_BULK message
+#define CELL_DETAIL_BULK_CELLS				3
+
+// MODULE_DETAIL_REQUEST byte 2 - reply with the string timing profile (MODULE_VUART_TIMING)
+#define CELL_DETAIL_REQUEST_TIMING			0x02
+
+// Cells in each MODULE_VUART_TIMING message
+#define CELL_TIMING_CELLS					7
+
+// MODULE_DETAIL_REQUEST byte 2 - reply with the cell record CRC error counts (MODULE_CELL_ERRORS)
+#define CELL_DETAIL_REQUEST_ERRORS			0x04
+
+// Cells in each MODULE_CELL_ERRORS message
+#define CELL_ERRORS_CELLS					7
+
+// Window polling - most cells in a window, cells either side of the hottest one in an
+// automatic window, and how often a full string is read by default
+#define CELL_WINDOW_CELLS_MAX				16
+#define CELL_WINDOW_AUTO					0xff
+#define CELL_WINDOW_FULL_EVERY_DEFAULT		4
+
 // Uncomment to cause cell CPUs to return fixed patterns (communication test)
 // #define REQUEST_DEBUG_CELL_RESPONSE		5
 
@@ -86,31 +150,21 @@ static volatile eWDTstatus __attribute__((section(".noinit"))) sg_eWDTCurrentSta
 // Value returned when cell temperature is invalid
 #define CELL_TEMPERATURE_INVALID			0x7fff
 
-// # Of valid data bits for cell voltage
-#define CELL_VOLTAGE_BITS		10			// # Of valid bits in the cell voltage
-#define CELL_DIV_TOP			90900		// Resistance of cell plus->voltage resistor on cell CPU
-#define CELL_DIV_BOTTOM			30100		// Resistance of ground->voltage resistor on cell CPU
-#define CELL_VOLTAGE_SCALE		(((float) CELL_DIV_BOTTOM) / ((float) CELL_DIV_TOP + (float) CELL_DIV_BOTTOM))
-
-#define CELL_VOLTAGE_CAL 1.032 //measured calibration factor
-
-#define FIXED_POINT_SCALE 512  // 2^9, gives us 9 bits of fractional precision  (10 bits overflows)
+// Cell voltage calibration (CELL_VOLTAGE_CAL etc.) lives in cellcal.h
 
 // Default unique ID for unprogrammed EEPROM
 #define EEPROM_UNPROGRAMMED_DEFAULT_UID		0xBA77BABE
 
-// Pre-calculate these constants:
-#define VOLTAGE_CONVERSION_FACTOR ((uint32_t)((CELL_VREF * 1000.0 / CELL_VOLTAGE_SCALE * CELL_VOLTAGE_CAL * FIXED_POINT_SCALE) + 0.5))
-#define ADC_MAX_VALUE (1 << CELL_VOLTAGE_BITS)
+// celltables.h must be regenerated (gencelltables) whenever the calibration changes.
+// _Static_assert rather than STATIC_ASSERT - the factor is folded from float math,
+// which an array size won't take without a warning.
+_Static_assert(CELL_TABLE_VOLTAGE_CONVERSION_FACTOR == VOLTAGE_CONVERSION_FACTOR, "celltables.h is stale - regenerate it with gencelltables");
 
 #define ADC_CURRENT_BUFFER_SIZE 8
 
 static int16_t sg_sCurrenBuffer [ADC_CURRENT_BUFFER_SIZE];
 static uint8_t sg_u8CurrentBufferIndex;
 
-// Cell VREF
-#define CELL_VREF				1.1
-
 // Cell string "off to on" time in milliseconds
 #define	CELL_POWER_OFF_TO_ON_MS			100
 
@@ -164,6 +218,11 @@ static uint8_t sg_u8CurrentBufferIndex;
 
 // Clear current interrupt flag, set the next compare, and enable the interrupt
 #define TIMER1_CHA_INT(x)					TIFR1 = (1 << OCF1A); OCR1A = (uint16_t) (TCNT1 + (x)); TIMSK1 |= (1 << OCIE1A)
+#define TIMER1_CHB_INT(x)					TIFR1 = (1 << OCF1B); OCR1B = (uint16_t) (TCNT1 + (x)); TIMSK1 |= (1 << OCIE1B)
+
+// Soonest the frame timer can be pulled in to (timer 1 ticks) - a compare write blocks
+// the match on the next timer clock
+#define FRAME_TIMER1_SOONEST				2
 
 #define PIN_RELAY_EN						(PORTE1)  //moved from c0!
 #define PIN_OCF_N							(PORTC1)  // when FET is on configure as input to monitor OCF, value is inverted starting 
@@ -218,6 +277,12 @@ volatile static uint8_t __attribute__((section(".noinit"))) sg_u8SOC;
 volatile static uint8_t __attribute__((section(".noinit"))) sg_u8SOH;
 volatile static uint8_t __attribute__((section(".noinit"))) sg_u8CellStatusTarget;
 volatile static uint8_t __attribute__((section(".noinit"))) sg_u8CellStatus;
+volatile static uint8_t __attribute__((section(".noinit"))) sg_u8CellBulkTarget;
+volatile static uint8_t __attribute__((section(".noinit"))) sg_u8CellBulkNext;
+volatile static uint8_t __attribute__((section(".noinit"))) sg_u8CellTimingTarget;
+volatile static uint8_t __attribute__((section(".noinit"))) sg_u8CellTimingNext;
+volatile static uint8_t __attribute__((section(".noinit"))) sg_u8CellErrorsTarget;
+volatile static uint8_t __attribute__((section(".noinit"))) sg_u8CellErrorsNext;
 
 
 volatile static bool __attribute__((section(".noinit"))) sg_bSendAnnouncement;			// true If we're sending a module announcement to the pack controller
@@ -234,6 +299,9 @@ volatile static bool __attribute__((section(".noinit"))) sg_bPackControllerTimeo
 
 volatile static bool __attribute__((section(".noinit"))) sg_bSendModuleControllerStatus;
 volatile static bool __attribute__((section(".noinit"))) sg_bSendCellStatus;
+volatile static bool __attribute__((section(".noinit"))) sg_bSendCellDetailBulk;		// true If we're streaming MODULE_DETAIL_BULK messages
+volatile static bool __attribute__((section(".noinit"))) sg_bSendCellTiming;			// true If we're streaming MODULE_VUART_TIMING messages
+volatile static bool __attribute__((section(".noinit"))) sg_bSendCellErrors;			// true If we're streaming MODULE_CELL_ERRORS messages
 volatile static bool __attribute__((section(".noinit"))) sg_bSendHardwareDetail;
 volatile static bool __attribute__((section(".noinit"))) sg_bSendCellCommStatus;
 static bool sg_bIgnoreStatusRequests = false;  // Ignore new requests while sending
@@ -271,14 +339,87 @@ static volatile bool __attribute__((section(".noinit"))) sg_bSDBusy;  // Flag in
 typedef enum
 {
 	FRAME_TRANSFER_IDLE,
+	FRAME_TRANSFER_READING,
+	FRAME_TRANSFER_CHECKING,
+	FRAME_TRANSFER_SENDING_CHECK,
 	FRAME_TRANSFER_SENDING_START,
 	FRAME_TRANSFER_SENDING_DATA,
+	FRAME_TRANSFER_BURSTING,
 	FRAME_TRANSFER_SENDING_END,
+	FRAME_TRANSFER_WAIT_ACK,
+	FRAME_TRANSFER_NEXT_FRAME,
 } FrameTransferState;
 
+// 8 byte segments per 1024 byte frame
+#define FRAME_TRANSFER_SEGMENTS		(sizeof(FrameData) / 8)
+#define FRAME_TRANSFER_BITMAP_BYTES	(FRAME_TRANSFER_SEGMENTS / 8)
+
+// FrameTransferNack byte 0 - bits 0-6 first segment covered by bytes 1-7, bit 7 more NACKs follow
+#define FRAME_TRANSFER_NACK_BASE_MASK	0x7f
+#define FRAME_TRANSFER_NACK_MORE		0x80
+#define FRAME_TRANSFER_NACK_BITS		56
+
+// FrameTransferRequest byte 7 flags
+#define FRAME_TRANSFER_FLAG_COMPRESSED	0x01	// Pack can decode framecodec segments
+
+// FrameTransferStart sequence number (extended ID bits 8-17) - encoding of the data segments
+#define FRAME_TRANSFER_ENCODING_RAW			0
+#define FRAME_TRANSFER_ENCODING_COMPRESSED	1
+
+// FrameCheck byte 4 is an EFrameLogCheck, or this when a scrub has finished. Byte 5 says
+// where it came from.
+#define FRAME_CHECK_SCRUB_FINISHED		EFRAMELOG_CHECK_OK
+#define FRAME_CHECK_SOURCE_TRANSFER		0
+#define FRAME_CHECK_SOURCE_SCRUB		1
+
+// framecodec reads the delta parameters from fixed metadata offsets
+STATIC_ASSERT(offsetof(FrameMetadata, cellBufferStart) == FRAMECODEC_OFFSET_CELLBUFFERSTART, framecodec_cellbufferstart_offset);
+STATIC_ASSERT(offsetof(FrameMetadata, sg_u8CellCountExpected) == FRAMECODEC_OFFSET_CELLCOUNT, framecodec_cellcount_offset);
+STATIC_ASSERT(sizeof(FrameData) == FRAMECODEC_FRAME_BYTES, framecodec_frame_size);
+STATIC_ASSERT(offsetof(FrameMetadata, version) == FRAMECODEC_OFFSET_VERSION, framecodec_version_offset);
+STATIC_ASSERT(FRAME_VERSION == FRAMECODEC_VERSION_RAW, framecodec_version_raw);
+
+#define FRAME_TRANSFER_ACK_TIMEOUT_TICKS	5	// 500ms for the pack to ACK/NACK after END
+#define FRAME_TRANSFER_BURST_TIMEOUT_TICKS	30	// 3s without a data segment going out, past the worst TX backoff
+#define FRAME_TRANSFER_MAX_RESENDS			3	// Resend rounds per transfer before NACKs are ignored
+#define FRAME_TRANSFER_CRC_STEP_BYTES		64	// Bytes of the END CRC worked out per main loop pass while the burst runs
+
 static FrameTransferState sg_eFrameTransferState = FRAME_TRANSFER_IDLE;
-static uint8_t sg_u8FrameTransferSegment = 0;  // Current segment being sent (0-127)
+static volatile uint8_t sg_u8FrameTransferSegment = 0;  // Next segment to be sent (0-127), advanced from CAN ISR during burst
 static volatile FrameData* sg_pFrameToTransfer = NULL;  // Pointer to frame being transferred
+static uint8_t sg_u8FrameTransferResend[FRAME_TRANSFER_BITMAP_BYTES];	// Segments NACKed by the pack, one bit each
+static bool sg_bFrameTransferResending = false;		// Burst sends only the NACKed segments
+static uint8_t sg_u8FrameTransferResendRounds = 0;	// Resend rounds done for this transfer
+static volatile uint8_t sg_u8FrameTransferTimeoutTicks = 0;	// Ticks left to wait for ACK/NACK, or for the burst to move
+static uint8_t sg_u8FrameTransferBurstSegment = 0;	// Where the burst had got to when the timeout was last loaded
+static uint32_t sg_u32FrameTransferCrc = 0;			// END CRC so far
+static uint16_t sg_u16FrameTransferCrcByte = 0;		// How far it's got - sizeof(FrameData) once it's done
+static uint32_t sg_u32FrameTransferCheckFrame = 0;	// Frame read off the card for the transfer
+static EFrameLogCheck sg_eFrameTransferCheck = EFRAMELOG_CHECK_OK;	// What was wrong with it, for FrameCheck
+
+// Range transfer - frames still to send after the current one
+static uint32_t sg_u32FrameRangeNext = 0;		// Counter of the next frame in the range
+static uint16_t sg_u16FrameRangeRemaining = 0;	// Frames left to send after the current one
+static uint8_t sg_u8FrameRangeStep = 1;			// Decimation - counter increment between frames
+static bool sg_bFrameRangePrefetched = false;	// Next frame's first sector is already in STORE's sector buffer
+
+// Compressed transfer
+static uint8_t sg_u8FrameTransferFlags = 0;				// FRAME_TRANSFER_FLAG_* from the request
+static bool sg_bFrameTransferCompressed = false;		// Current frame is going out framecodec encoded
+static SFrameCodec sg_sFrameCodec;						// Delta parameters for the current frame
+static volatile uint16_t sg_u16FrameTransferQuad = 0;	// Next frame quad to encode, advanced from CAN ISR
+
+// SD session index listing (MODULE_SESSION_REQUEST)
+static uint32_t sg_u32SessionSendNext = 0;		// Next session to send
+static uint16_t sg_u16SessionSendRemaining = 0;	// Sessions left to send, that one included
+static bool sg_bSessionSendSummary = false;		// Its MODULE_SESSION has gone - MODULE_SESSION_SUMMARY next
+
+// SD frame scrub (FRAME_SCRUB_REQUEST)
+static bool sg_bFrameScrubActive = false;		// Scrubbing, or its finish is still to be reported
+static uint32_t sg_u32FrameScrubChecked = 0;	// Frames checked so far
+static uint16_t sg_u16FrameScrubBad = 0;		// Of those, the ones that didn't check out
+static uint32_t sg_u32FrameScrubBadFrame = 0;	// Last bad frame found
+static EFrameLogCheck sg_eFrameScrubBad = EFRAMELOG_CHECK_OK;	// What was wrong with it - EFRAMELOG_CHECK_OK once it's reported
 
 typedef enum
 {
@@ -302,9 +443,14 @@ volatile static EModuleControllerState __attribute__((section(".noinit")))sg_eMo
 volatile static EModuleControllerState __attribute__((section(".noinit")))sg_eModuleControllerStateTarget;
 volatile static EModuleControllerState __attribute__((section(".noinit")))sg_eModuleControllerStateMax;
 
-// Counter incremented every time the periodic timer fires (once every PERIODIC_INTERUPT_RATE_MS ms)
-static volatile uint8_t sg_u8CellFrameTimer;
+// Frame timer - timer 1 compare B fires at each frame boundary, sg_u16FramePeriodTimer1
+// ticks after the last one (sg_u16FrameStartTimer1)
+static volatile uint16_t sg_u16FramePeriodTimer1;
+static volatile uint16_t sg_u16FrameStartTimer1;
+static uint16_t sg_u16FramePeriodMinMs = FRAME_PERIOD_MIN_MS_DEFAULT;
+static uint16_t sg_u16FramePeriodMaxMs = FRAME_PERIOD_MAX_MS_DEFAULT;
 static volatile bool sg_bFrameStart;
+static volatile bool sg_bStringComplete;	// Set by vUARTRXComplete(), the READ frame can end early
 static volatile uint8_t sg_u8CellStringPowerTimer;
 static volatile uint8_t sg_u8TicksSinceLastPackControllerMessage;
 
@@ -544,19 +690,142 @@ static uint8_t sg_u8CellIndex;
 // How far into sg_u8CellBufferTemp[] are we?
 static uint8_t sg_u8CellBufferRX;
 
+// Bytes in each cell record off the string
+#ifdef CELL_RECORD_CRC
+#define CELL_RECORD_BYTES		((1 << BYTES_PER_CELL_SHIFT) + 1)	// Cell data, then its CRC-8
+#else
+#define CELL_RECORD_BYTES		(1 << BYTES_PER_CELL_SHIFT)
+#endif
+
+// Nonzero if u16Bytes isn't a whole number of cell records
+#define CELL_RECORD_PARTIAL(u16Bytes)	((u16Bytes) % CELL_RECORD_BYTES)
+
 // Cell data reception - MUST BE 4 BYTE ALIGNED FOR 32 BIT TRANSFERS
-static volatile uint8_t __attribute__((aligned(4))) sg_u8CellBufferTemp[4];
+static uint8_t __attribute__((aligned(4))) sg_u8CellBufferTemp[CELL_RECORD_BYTES];
+
+// Received bytes on their way from the vUART RX interrupt to the main loop, which puts
+// the cell records together. Single producer (vUARTRXData()), single consumer
+// (CellRecordsAssemble()) - each side only writes its own index. Power of 2, and
+// 16 cells' worth covers about 35ms of main loop latency.
+#define VUART_RX_RING_SIZE		64
+#define VUART_RX_RING_MASK		(VUART_RX_RING_SIZE - 1)
 
+static volatile uint8_t sg_u8RXRing[VUART_RX_RING_SIZE];
+static volatile int8_t sg_s8RXTimingRing[VUART_RX_RING_SIZE];	// Each byte's vUARTRXData() timing
+static volatile uint8_t sg_u8RXRingHead;		// Written by vUARTRXData()
+static volatile uint8_t sg_u8RXRingTail;		// Written by CellRecordsAssemble()
+static volatile bool sg_bRXRingOverrun;			// Rest of the string is dropped
 
 // MC RX Statistic
-static uint16_t sg_u16BytesReceived;
+static volatile uint16_t sg_u16BytesReceived;
 static uint8_t sg_u8CellReports;
 
+// Where vUARTRXData() is in the string - record and byte within it. Kept alongside the
+// byte count so the RX interrupt doesn't have to divide.
+static volatile uint8_t sg_u8RXRecordPosition;
+static volatile uint8_t sg_u8RXRecordByte;
+
+#ifdef CELL_RECORD_CRC
+// Records that failed their CRC - in the string being received, and by position in the
+// string over the session (saturating)
+static uint8_t sg_u8RXRecordErrors;
+static uint8_t sg_u8CellRecordErrors[MAX_CELLS];
+#endif
+
+#ifdef CELL_WINDOW_POLLING
+// Window the pack asked for (cell IDs, MODULE_DETAIL numbering), 0 cells = off, and one
+// full string reading every sg_u8CellWindowFullEvery readings
+static uint8_t sg_u8CellWindowFirst;			// CELL_WINDOW_AUTO = around the hottest cell
+static uint8_t sg_u8CellWindowCount;
+static uint8_t sg_u8CellWindowFullEvery = CELL_WINDOW_FULL_EVERY_DEFAULT;
+static uint8_t sg_u8CellWindowAutoFirst;		// From the last full string reading
+static uint8_t sg_u8CellWindowReadings;		// Window readings since the last full one
+
+// Window reading in progress - its cells, and the string position its first record
+// would have in a full string
+static bool sg_bRXWindow;
+static uint8_t sg_u8RXWindowFirst;
+static uint8_t sg_u8RXWindowCount;
+static uint8_t sg_u8RXWindowPosition;
+
+// Last window reading, in the order it came in, on its way to the pack
+static CellData sg_sCellWindow[CELL_WINDOW_CELLS_MAX];
+static uint8_t sg_u8CellWindowReceived;
+static uint8_t sg_u8CellWindowSentFirst;
+static uint8_t sg_u8CellWindowSentCount;
+static uint8_t sg_u8CellWindowNext;
+static bool sg_bSendCellWindow;
+#endif
+
+// String timing profile - per bit timing error of each cell's bytes (1/16us, + = slow
+// oscillator), by position in the string as it arrives. Smoothed over readings. The vUART
+// uses it to sample each cell's bits where they really are.
+static int8_t sg_s8CellTiming[MAX_CELLS];
+static int16_t sg_s16CellTimingTotal;			// This cell record's byte timings so far
+static uint8_t sg_u8CellTimingCount;
+
+// String statistics, accumulated one cell record at a time as it arrives so the
+// WRITE frame only has to finalize them. Voltages in mV, temperatures RAW.
+typedef struct
+{
+	uint32_t u32VoltageTotal;
+	int32_t s32TemperatureTotal;
+	uint16_t u16VoltageHighest;
+	uint16_t u16VoltageLowest;
+	int16_t s16TemperatureHighest;
+	int16_t s16TemperatureLowest;
+	uint8_t u8VoltageCount;
+	uint8_t u8TemperatureCount;
+	bool bDischargeOn;
+} SCellStringStats;
+
+static SCellStringStats sg_sStringStatsRX;	// Being accumulated by CellRecordsAssemble()
+static SCellStringStats sg_sStringStats;	// Completed string, latched by vUARTRXEnd()
+
+static void CellStringStatsAdd(SCellStringStats* psStats, uint16_t u16Voltage, int16_t s16Temperature);
+
+#ifdef STRING_PROCESS_PROFILING
+// Longest string statistics processing time (us) since the last CommStat1
+static uint16_t sg_u16StringProcessUsMax;
+#endif
+
+// String sample rate, reported in CommStat2. Timer 1 at the last string reading,
+// the interval (ms) from the one before it and # Of readings since the last report.
+static uint16_t sg_u16StringReadingTimer1;
+static bool sg_bStringReadingTimed;
+static uint16_t sg_u16StringIntervalMs;
+static uint16_t sg_u16StringReadings;
+volatile static bool __attribute__((section(".noinit"))) sg_bSendCellCommStat2;
+
+// String round trip - timer 1 when the string was asked for (vUARTRXStart()) and at its
+// last byte (vUARTRXData()), and the last complete string's request to last byte (ms)
+static uint16_t sg_u16StringRequestTimer1;
+static volatile uint16_t sg_u16StringLastByteTimer1;
+static uint16_t sg_u16StringRoundTripMs;
 
 
 
 
 
+
+#ifdef FRAME_DELTA_STRINGS
+// The latest string reading sits raw at the start of the cell buffer, with the older
+// ones packed after it (see stringdelta.h)
+static SStringDelta sg_sStringDelta;
+
+STATIC_ASSERT(offsetof(FrameMetadata, version) == STRINGDELTA_OFFSET_VERSION, stringdelta_version_offset);
+STATIC_ASSERT(offsetof(FrameMetadata, readingCount) == STRINGDELTA_OFFSET_READINGCOUNT, stringdelta_readingcount_offset);
+STATIC_ASSERT(FRAME_VERSION_DELTA == STRINGDELTA_FRAME_VERSION, stringdelta_frame_version);
+STATIC_ASSERT((INVALID_CELL_VOLTAGE == STRINGDELTA_INVALID_VOLTAGE) && (INVALID_CELL_TEMP == STRINGDELTA_INVALID_TEMP), stringdelta_invalid_markers);
+STATIC_ASSERT(sizeof(CellData) == STRINGDELTA_CELL_BYTES, stringdelta_cell_bytes);
+// A full string of escapes has to fit behind the latest reading
+STATIC_ASSERT(((FRAME_BUFFER_SIZE - sizeof(FrameMetadata) - (TOTAL_CELL_COUNT_MAX * sizeof(CellData))) * 8) >= (TOTAL_CELL_COUNT_MAX * STRINGDELTA_CELL_BITS_MAX), stringdelta_records_size);
+#else
+// The ring is full, and its frame is waiting for the last one's write to finish. The wrap
+// back to slot 0 is held until it's stored.
+static bool sg_bFrameStorePending;
+#endif
+
 // Sets the # of cells we expect for this configuration
 static void CellCountExpectedSet(uint8_t u8CellCountExpected)
 {
@@ -578,6 +847,15 @@ static void CellCountExpectedSet(uint8_t u8CellCountExpected)
 	// Total frame is 1024 bytes, cell buffer starts at cellBufferStart offset
 	uint16_t cellBufferSize = FRAME_BUFFER_SIZE - sg_sFrame.m.cellBufferStart;
 
+#ifdef FRAME_DELTA_STRINGS
+	// One raw slot - the latest reading. The rest of the buffer holds the packed ones.
+	sg_sFrame.m.nstrings = 1;
+	StringDelta_Init(&sg_sStringDelta,
+					 (uint8_t*)sg_sFrame.c,
+					 (uint8_t*)sg_sFrame.c + bytes_per_string,
+					 cellBufferSize - bytes_per_string,
+					 u8CellCountExpected);
+#else
 	if (bytes_per_string > 0) {
 		sg_sFrame.m.nstrings = cellBufferSize / bytes_per_string;
 
@@ -588,10 +866,14 @@ static void CellCountExpectedSet(uint8_t u8CellCountExpected)
 	} else {
 		sg_sFrame.m.nstrings = 1;
 	}
+#endif
 
 	// Initialize circular buffer indices
 	sg_sFrame.m.currentIndex = 0;
 	sg_sFrame.m.readingCount = 0;
+#ifndef FRAME_DELTA_STRINGS
+	sg_bFrameStorePending = false;
+#endif
 
 	// Clear entire buffer to invalid markers initially
 	CellData* buffer = (CellData*)sg_sFrame.c;
@@ -659,6 +941,179 @@ static void PauseCellString(void)
 	// after the state transition completes (INIT->OFF->ON->IGNORE->OPERATIONAL)
 }
 
+#ifdef VUART_RATE_NEGOTIATION
+#define VUART_RATE_SETTLE_READS		16		// Clean readings at a rate before trying a faster one
+#define VUART_RATE_VERIFY_READS		4		// Clean pattern readings to accept a new rate
+#define VUART_RATE_FALLBACK_ERRORS	3		// Bad readings in a row before giving a rate up
+
+typedef enum
+{
+	ERATE_SETTLE,				// Normal readings at the current rate
+	ERATE_COMMAND,				// Telling the cells to switch to sg_u8RateTarget
+	ERATE_VERIFY				// Reading the test pattern at sg_u8RateTarget
+} ERateState;
+
+static volatile ERateState sg_eRateState;			// PlatformGetSendData() works from it
+static uint8_t sg_u8RateTarget;
+static uint8_t sg_u8RateCeiling = VUART_RATE_COUNT;	// Slowest rate that's failed this session
+static uint8_t sg_u8RateFastest;					// Fastest rate that's worked this session
+static uint8_t sg_u8RateReads;						// Clean readings in the current state
+static uint8_t sg_u8RateErrors;						// Bad readings in a row at the current rate
+static bool sg_bRateFallback;						// Target is a step back down after a failure
+static volatile bool sg_bRateCommandSent;			// Set by PlatformGetSendData()
+static bool sg_bRXPattern;							// String being received is a test pattern
+static uint8_t sg_u8RXPatternErrors;				// ... and records in it that didn't match
+
+// Back to rate 0, which the cells power up at. Whatever's been learned about rates this
+// session is kept.
+static void VUARTRateReset(void)
+{
+	vUARTRateSet(0);
+	memset(sg_s8CellTiming, VUART_RX_TIMING_NONE, sizeof(sg_s8CellTiming));
+	sg_eRateState = ERATE_SETTLE;
+	sg_bRateCommandSent = false;
+	sg_u8RateReads = 0;
+	sg_u8RateErrors = 0;
+}
+
+// The cells have been told to switch - follow them. The timing profile is in 1/16us per
+// bit, so it doesn't carry over to another bit time.
+static void VUARTRateSwitch(uint8_t u8Rate)
+{
+	vUARTRateSet(u8Rate);
+	memset(sg_s8CellTiming, VUART_RX_TIMING_NONE, sizeof(sg_s8CellTiming));
+	sg_eRateState = ERATE_VERIFY;
+	sg_u8RateReads = 0;
+	sg_u8RateErrors = 0;
+}
+
+// u8Rate doesn't work - don't try it (or anything faster) again this session, and tell
+// the cells to drop back a rate
+static void VUARTRateFail(uint8_t u8Rate)
+{
+	if (u8Rate < sg_u8RateCeiling)
+	{
+		sg_u8RateCeiling = u8Rate;
+	}
+	if (sg_u8RateFastest >= u8Rate)
+	{
+		sg_u8RateFastest = u8Rate - 1;
+	}
+
+	sg_u8RateTarget = u8Rate - 1;
+	sg_bRateFallback = true;
+	sg_u8RateReads = 0;
+	sg_eRateState = ERATE_COMMAND;
+}
+
+// Called after every string reading is processed. Steps the rate up once the string has
+// been clean for a while, accepts or backs out of a new rate, and drops back a rate when
+// one that's been working starts giving framing errors.
+static void VUARTRateUpdate(void)
+{
+	bool bClean;
+
+	if (ESTRING_OPERATIONAL != sg_eStringPowerState)
+	{
+		return;
+	}
+
+	// The whole string, in whole records that check out, and a good pattern if it was one
+	bClean = (sg_sFrame.m.sg_u8CellCountExpected &&
+			  (sg_sFrame.m.sg_u8CellCPUCount == sg_sFrame.m.sg_u8CellCountExpected) &&
+			  (0 == CELL_RECORD_PARTIAL(sg_sFrame.m.sg_u16BytesReceived)) &&
+#ifdef CELL_RECORD_CRC
+			  (0 == sg_u8RXRecordErrors) &&
+#endif
+			  (0 == sg_u8RXPatternErrors));
+
+	switch (sg_eRateState)
+	{
+		case ERATE_SETTLE:
+		{
+			uint8_t u8Rate = vUARTRateGet();
+
+			if (false == bClean)
+			{
+				sg_u8RateReads = 0;
+				if (u8Rate && (++sg_u8RateErrors >= VUART_RATE_FALLBACK_ERRORS))
+				{
+					VUARTRateFail(u8Rate);
+				}
+				break;
+			}
+
+			sg_u8RateErrors = 0;
+			if (sg_u8RateReads < VUART_RATE_SETTLE_READS)
+			{
+				++sg_u8RateReads;
+				break;
+			}
+
+			// Straight back to the fastest rate that's worked, otherwise one faster
+			if (sg_u8RateFastest > u8Rate)
+			{
+				u8Rate = sg_u8RateFastest;
+			}
+			else
+			{
+				++u8Rate;
+			}
+
+			if (u8Rate < sg_u8RateCeiling)
+			{
+				sg_u8RateTarget = u8Rate;
+				sg_bRateFallback = false;
+				sg_eRateState = ERATE_COMMAND;
+			}
+			break;
+		}
+		case ERATE_COMMAND:
+		{
+			// The cells switch once they've passed the command on
+			if (sg_bRateCommandSent)
+			{
+				sg_bRateCommandSent = false;
+				VUARTRateSwitch(sg_u8RateTarget);
+			}
+			break;
+		}
+		case ERATE_VERIFY:
+		{
+			if (bClean)
+			{
+				if (++sg_u8RateReads >= VUART_RATE_VERIFY_READS)
+				{
+					if (sg_u8RateTarget > sg_u8RateFastest)
+					{
+						sg_u8RateFastest = sg_u8RateTarget;
+					}
+					sg_eRateState = ERATE_SETTLE;
+					sg_u8RateReads = 0;
+				}
+			}
+			else
+			if (sg_bRateFallback || (0 == sg_u8RateTarget))
+			{
+				// Can't get back to a rate that worked. Restart the string - the cells
+				// power up at rate 0.
+				sg_eStringPowerState = ESTRING_OFF;
+			}
+			else
+			{
+				VUARTRateFail(sg_u8RateTarget);
+			}
+			break;
+		}
+		default:
+		{
+			MBASSERT(0);
+			break;
+		}
+	}
+}
+#endif
+
 // This handles power state changes for the cell string
 static void CellStringPowerStateMachine(void)  // this is called at the start of each READ and WRITE frame
 {
@@ -676,6 +1131,9 @@ static void CellStringPowerStateMachine(void)  // this is called at the start of
 		{
 			CELL_POWER_DEASSERT();
 			FrameInit(false);  // clear out string data
+#ifdef VUART_RATE_NEGOTIATION
+			VUARTRateReset();  // cells come back up at rate 0
+#endif
 			sg_eStringPowerState = ESTRING_ON;
 			sg_u8CellStringPowerTimer = PERIODIC_INTERRUPT_MS_TO_TICKS(CELL_POWER_OFF_TO_ON_MS);
 			sg_sFrame.m.sg_u8CellCPUCountFewest = 0xff;  // reset min max cell counts
@@ -761,6 +1219,11 @@ void TimerInit( void )
 	
 	// Start the periodic timer
 	TIMER1_CHA_INT(PERIODIC_COMPARE_A_RELOAD);
+
+	// And the frame timer, at the slowest frame rate until the string has been timed
+	sg_u16FramePeriodTimer1 = FRAME_PERIOD_MS_TO_TIMER1(sg_u16FramePeriodMaxMs);
+	sg_u16FrameStartTimer1 = TCNT1;
+	TIMER1_CHB_INT(sg_u16FramePeriodTimer1);
 		
 	// Clear power reduction register to enable timer 1
 	PRR &= (uint8_t)~(1 << PRTIM1);
@@ -770,34 +1233,63 @@ void TimerInit( void )
 
 }
 
+// Profiling timestamps. Timer 1 gives the range, timer 0 (1us/tick) the resolution.
+typedef struct
+{
+	uint16_t u16Timer1;
+	uint8_t u8Timer0;
+} SProfileStamp;
+
+static void ProfileStamp(SProfileStamp* psStamp)
+{
+	uint8_t u8SREG = SREG;
+
+	// TCNT1 is read through the shared 16 bit TEMP register
+	cli();
+	psStamp->u8Timer0 = TCNT0;
+	psStamp->u16Timer1 = TCNT1;
+	SREG = u8SREG;
+}
+
+#ifdef STRING_PROCESS_PROFILING
+// Both timers free run off the same prescaler, so timer 1 ticks land on timer 0 tick
+// boundaries
+#define PROFILE_TIMER0_PER_TIMER1		(TIMER_PRESCALER1 / TIMER_PRESCALER0)
+STATIC_ASSERT(TIMER0_CLOCKS_PER_SECOND == 1000000, profile_timer0_not_1us);
+
+// Microseconds since psStart, saturating at 0xffff (65ms)
+static uint16_t ProfileElapsedUs(const SProfileStamp* psStart)
+{
+	SProfileStamp sNow;
+	uint16_t u16Timer1;
+	uint16_t u16Coarse;
+
+	ProfileStamp(&sNow);
+
+	u16Timer1 = sNow.u16Timer1 - psStart->u16Timer1;
+	if (u16Timer1 >= (0xffff / PROFILE_TIMER0_PER_TIMER1))
+	{
+		return(0xffff);
+	}
+
+	// Timer 1 is within a tick of the truth, timer 0 knows the exact time modulo 256us -
+	// correct the coarse time to the nearest value that agrees with timer 0
+	u16Coarse = u16Timer1 * PROFILE_TIMER0_PER_TIMER1;
+	return(u16Coarse + (int8_t) ((uint8_t) (sNow.u8Timer0 - psStart->u8Timer0) - (uint8_t) u16Coarse));
+}
+#endif
+
 // Timer 1 compare interrupt. This is called every (cpu speed / divisor) * reload clocks.
 // Currently 8Mhz, with a /256, it's once every 100ms due to PERIODIC_COMPARE_A_RELOAD
 ISR(TIMER1_COMPA_vect, ISR_NOBLOCK)
 {
-	//Reload the timer
+	//Reload the timer - interrupts off, since the vUART and frame timer interrupts use
+	// the 16 bit TEMP register too
+	cli();
 	TIMER1_CHA_INT(PERIODIC_COMPARE_A_RELOAD);
+	sei();
 	sg_bNewTick = true;  // set tru in periodic tick isr, cleared in main loop
 
-	// Handle the cell report timer, this always runs because string state machine is only
-	// called at the start of each READ and WRITE frame
-
-	++sg_u8CellFrameTimer;
-	if (sg_u8CellFrameTimer >= PERIODIC_CALLBACK_RATE_TICKS)  // frame ended, deal with it
-	{
-		sg_u8CellFrameTimer = 0;  //reset the frame timer
-		sg_bFrameStart = true;  // tell main loop it's first time through
-			
-		//toggle between read and write frames
-		if (EFRAMETYPE_WRITE == sg_eFrameStatus)
-		{
-			sg_eFrameStatus = EFRAMETYPE_READ;  // start the read frame
-		}
-		else  
-		{
-			sg_eFrameStatus = EFRAMETYPE_WRITE;  // start the write frame
-		}
-	}
-	
 	// And also handle the pack controller timer
 	if (sg_u8TicksSinceLastPackControllerMessage < 0xff)
 	{
@@ -816,6 +1308,30 @@ ISR(TIMER1_COMPA_vect, ISR_NOBLOCK)
 	}
 }
 
+// Timer 1 compare B interrupt - frame boundary. The next one is a frame period on from
+// this one, unless the string finishes early (FrameReadEndEarly()).
+ISR(TIMER1_COMPB_vect, ISR_BLOCK)
+{
+	sg_u16FrameStartTimer1 = OCR1B;
+	OCR1B = (uint16_t) (sg_u16FrameStartTimer1 + sg_u16FramePeriodTimer1);
+	sg_bFrameStart = true;  // tell main loop it's first time through
+
+#ifdef PIPELINED_FRAMES
+	// Every frame is a WRITE frame, which also kicks off the next read
+	sg_eFrameStatus = EFRAMETYPE_WRITE;
+#else
+	//toggle between read and write frames
+	if (EFRAMETYPE_WRITE == sg_eFrameStatus)
+	{
+		sg_eFrameStatus = EFRAMETYPE_READ;  // start the read frame
+	}
+	else  
+	{
+		sg_eFrameStatus = EFRAMETYPE_WRITE;  // start the write frame
+	}
+#endif
+}
+
 void WatchdogReset( void )
 {
 #ifdef WDT_ENABLE
@@ -977,7 +1493,7 @@ static void ModuleControllerStateHandle( void )
 				
 				if (sg_bSDCardReady)
 				{ 
-					sg_bSDCardReady = STORE_EndSession();
+					sg_bSDCardReady = STORE_EndSession(&sg_sFrame);
 				}
 				break;			
 			}
@@ -1017,10 +1533,16 @@ static void ModuleControllerStateHandle( void )
 				sg_bCellBalancedOnce = false;
 				sg_bStopDischarge = false;
 				
-//				start new logging session
+//				start new logging session - the session variables start again with it
+				if (EMODSTATE_OFF == sg_eModuleControllerStateCurrent)
+				{
+					sg_sFrame.m.sg_u8WDTCount = 0;
+					sg_sFrame.m.u16maxCurrent = 0x8000;
+					sg_sFrame.m.u16minCurrent = 0x8000;
+				}
 				if (sg_bSDCardReady)
 				{
-					sg_bSDCardReady = STORE_StartNewSession();
+					sg_bSDCardReady = STORE_StartNewSession(RTCGetTime());
 				}
 			
 				break;
@@ -1249,6 +1771,78 @@ ISR(PCINT2_vect, ISR_NOBLOCK)
 	Check5VLoss(u8NewState);
 }
 
+// Start sending a frame that's been loaded into the STORE frame buffer,
+// dropping any burst still running for a previous frame
+static void FrameTransferBegin(void)
+{
+	CANBurstAbort();
+	sg_pFrameToTransfer = (volatile FrameData*)STORE_GetFrameBuffer();
+	sg_eFrameTransferState = FRAME_TRANSFER_SENDING_START;
+	sg_u8FrameTransferSegment = 0;
+	sg_bFrameTransferResending = false;
+	sg_bFrameTransferCompressed = false;
+	sg_u8FrameTransferResendRounds = 0;
+	sg_bFrameRangePrefetched = false;
+	sg_u32FrameTransferCrc = 0;
+	sg_u16FrameTransferCrcByte = 0;
+	memset(sg_u8FrameTransferResend, 0, sizeof(sg_u8FrameTransferResend));
+}
+
+// A frame that didn't read back off the card, or a scrub that's finished (FRAME_CHECK).
+// Returns false if the TX queue is full.
+static bool FrameCheckSend(uint32_t u32Frame, uint8_t u8Result, uint8_t u8Source, uint16_t u16Count)
+{
+	uint8_t buffer[8];
+
+	*(uint32_t*)&buffer[0] = u32Frame;
+	buffer[4] = u8Result;
+	buffer[5] = u8Source;
+	*(uint16_t*)&buffer[6] = u16Count;
+
+	return(CANSendMessage(ECANMessageType_FrameCheck, buffer, sizeof(buffer)));
+}
+
+// Reads a frame off the card to transfer. It's checked against its CRC before any of it
+// goes (FRAME_TRANSFER_CHECKING). If it isn't there, or doesn't check out, FRAME_CHECK
+// says so instead of START. While a frame write has the buffer, it's tried again on a
+// later pass (FRAME_TRANSFER_READING).
+static void FrameTransferRead(uint32_t u32Frame)
+{
+	EFrameLogCheck eResult = STORE_ReadFrameByCounter(u32Frame);
+
+	sg_u32FrameTransferCheckFrame = u32Frame;
+	if (EFRAMELOG_CHECK_WAIT == eResult)
+	{
+		sg_eFrameTransferState = FRAME_TRANSFER_READING;
+	}
+	else
+	if (EFRAMELOG_CHECK_BUSY == eResult)
+	{
+		sg_eFrameTransferState = FRAME_TRANSFER_CHECKING;
+	}
+	else
+	{
+		sg_eFrameTransferCheck = eResult;
+		sg_eFrameTransferState = FRAME_TRANSFER_SENDING_CHECK;
+	}
+}
+
+// Carries the END CRC on over up to u16Bytes more of the frame being transferred
+static void FrameTransferCrcStep(uint16_t u16Bytes)
+{
+	uint16_t u16Left = sizeof(FrameData) - sg_u16FrameTransferCrcByte;
+
+	if (u16Bytes > u16Left)
+	{
+		u16Bytes = u16Left;
+	}
+
+	sg_u32FrameTransferCrc = CRC32_Update(sg_u32FrameTransferCrc,
+										  &((const uint8_t*)sg_pFrameToTransfer)[sg_u16FrameTransferCrcByte],
+										  u16Bytes);
+	sg_u16FrameTransferCrcByte += u16Bytes;
+}
+
 void CANReceiveCallback(ECANMessageType eType, uint8_t* pu8Data, uint8_t u8DataLen)
 {
 	
@@ -1308,89 +1902,243 @@ void CANReceiveCallback(ECANMessageType eType, uint8_t* pu8Data, uint8_t u8DataL
 		// Hardware MOB filtering ensures this is for us - no need to check module ID
 		// Extract requested frame counter (now in bytes 0-3, moduleId was redundant)
 		uint32_t requestedFrame = *(uint32_t*)&pu8Data[0];
+		uint16_t u16FrameCount = 1;
+		uint8_t u8FrameStep = 1;
+
+		// Range request - bytes 4-5 frame count, byte 6 decimation (0/1 = every frame)
+		if (u8DataLen >= 7)
+		{
+			u16FrameCount = *(uint16_t*)&pu8Data[4];
+			if (pu8Data[6] > 1)
+			{
+				u8FrameStep = pu8Data[6];
+			}
+		}
+
+		// Byte 7 - transfer options, applies to every frame of a range
+		sg_u8FrameTransferFlags = 0;
+		if (u8DataLen >= 8)
+		{
+			sg_u8FrameTransferFlags = pu8Data[7];
+		}
+
+		// Any range in progress is replaced by this request
+		sg_u16FrameRangeRemaining = 0;
 
 		// Transfer from STORE frameBuffer (which contains last written frame)
 		// This avoids race conditions with cell reading updating sg_sFrame
 		if (requestedFrame == 0xFFFFFFFF)
 		{
-			// Use frame buffer (contains most recent frame written to SD)
-			sg_pFrameToTransfer = (volatile FrameData*)STORE_GetFrameBuffer();
+			// Use frame buffer (contains most recent frame written to SD) - never a range
+			FrameTransferBegin();
 		}
 		else
 		{
-			// Read specific frame from SD card by frame counter
-			if (STORE_ReadFrameByCounter(requestedFrame))
-			{
-				sg_pFrameToTransfer = (volatile FrameData*)STORE_GetFrameBuffer();
-			}
-			else
+			if (u16FrameCount > 1)
 			{
-				// Failed to read frame - ignore request
-				return;
+				sg_u16FrameRangeRemaining = u16FrameCount - 1;
+				sg_u32FrameRangeNext = requestedFrame + u8FrameStep;
+				sg_u8FrameRangeStep = u8FrameStep;
 			}
-		}
 
-		// Initiate frame transfer
-		sg_eFrameTransferState = FRAME_TRANSFER_SENDING_START;
-		sg_u8FrameTransferSegment = 0;
+			// Read specific frame from SD card by frame counter - it starts once it's checked
+			CANBurstAbort();
+			FrameTransferRead(requestedFrame);
+		}
 
 		return;  // done here
 	}
 
-	// While transferring, ignore status/cell detail requests but process state changes
-	if (sg_eFrameTransferState != FRAME_TRANSFER_IDLE)
+	// SD session index - bytes 0-3 first session (0xFFFFFFFF = the latest ones), bytes 4-5
+	// # of sessions (0 = 1). The pack then asks for a session's frames by frame counter.
+	if( ECANMessageType_SessionRequest == eType )
 	{
-		if (eType == ECANMessageType_ModuleStatusRequest ||
-		    eType == ECANMessageType_ModuleCellDetailRequest)
+		uint32_t u32First;
+		uint32_t u32Sessions;
+		uint16_t u16Count = 1;
+
+		// Any listing in progress is replaced by this request
+		sg_u16SessionSendRemaining = 0;
+		sg_bSessionSendSummary = false;
+
+		if ((u8DataLen < sizeof(uint32_t)) ||
+			(false == sg_bSDCardReady) ||
+			(false == STORE_GetSessionCount(&u32Sessions)))
 		{
-			// Ignore these while transferring
 			return;
 		}
-		// State change requests (MaxState, AllIsolate) already processed above
-	}
 
-	if( ECANMessageType_ModuleAnnounceRequest == eType )
-	{
-		// Pack controller is requesting announcements from unregistered modules
-		if (!sg_bModuleRegistered && !sg_bAnnouncementPending)
+		u32First = *(uint32_t*)&pu8Data[0];
+		if ((u8DataLen >= 6) && (*(uint16_t*)&pu8Data[4] > 1))
 		{
-			// Use last byte of unique ID as delay in milliseconds (0-255ms)
-			// This saves computation and works well for sequential IDs
-			uint8_t u8RandomDelay = (uint8_t)(sg_sFrame.m.moduleUniqueId & 0xFF);
-			
-			DebugOut("RX Announce Request (UNREGISTERED) - scheduling response in %dms\r\n", u8RandomDelay);
-					
-			// Schedule announcement after delay (assuming 10ms ticks)
-			sg_u8AnnouncementDelayTicks = u8RandomDelay / 10;  // Convert to 10ms ticks
-			if (sg_u8AnnouncementDelayTicks == 0) sg_u8AnnouncementDelayTicks = 1;  // Minimum 1 tick delay
-			sg_bAnnouncementPending = true;
+			u16Count = *(uint16_t*)&pu8Data[4];
 		}
-		else if (sg_bModuleRegistered)
+
+		if (0xFFFFFFFF == u32First)
 		{
-			// We're registered, ignore announce requests
-			DebugOut("RX Announce Request (REGISTERED) - ignoring\r\n");
+			u32First = (u32Sessions > u16Count) ? (u32Sessions - u16Count) : 0;
 		}
-		else
+
+		if (u32First < u32Sessions)
 		{
-			// Announcement already pending, ignore duplicate request
-			DebugOut("RX Announce Request - already pending\r\n");
+			if (u16Count > (u32Sessions - u32First))
+			{
+				u16Count = (uint16_t) (u32Sessions - u32First);
+			}
+
+			sg_u32SessionSendNext = u32First;
+			sg_u16SessionSendRemaining = u16Count;
 		}
 		return;  // done here
 	}
 
-		
-	if( ECANMessageType_ModuleRegistration == eType )  // handle registration
+	// SD frame scrub - bytes 0-3 first frame (0xFFFFFFFF = the latest ones), bytes 4-7
+	// # of frames (0 = stop). Bad frames and the finish come back as FRAME_CHECK.
+	if( ECANMessageType_FrameScrubRequest == eType )
 	{
-		if( 8 == u8DataLen )
+		uint32_t u32First;
+		uint32_t u32Count = 0;
+
+		if (u8DataLen < sizeof(uint32_t))
 		{
-			// Registration message contains assigned module ID - this is NOT redundant
-			// Pack controller is telling us what ID we've been assigned
-			uint8_t u8RegID = pu8Data[0];  // Assigned module ID from pack controller
+			return;
+		}
 
-			// If the qualifiers match what was sent in the announcement, this is for us
-			if( (MANUFACTURE_ID == pu8Data[2]) &&
-				(PART_ID == pu8Data[3]) &&
-				(sg_sFrame.m.moduleUniqueId == *((uint32_t *) &pu8Data[4])) )
+		u32First = *(uint32_t*)&pu8Data[0];
+		if (u8DataLen >= 8)
+		{
+			u32Count = *(uint32_t*)&pu8Data[4];
+		}
+
+		if (0xFFFFFFFF == u32First)
+		{
+			u32First = (FrameCounter_Get() > u32Count) ? (FrameCounter_Get() - u32Count) : 0;
+		}
+
+		// Any scrub in progress is replaced by this request. It's always answered with a
+		// finish, even if there's nothing to check.
+		sg_u32FrameScrubChecked = 0;
+		sg_u16FrameScrubBad = 0;
+		sg_eFrameScrubBad = EFRAMELOG_CHECK_OK;
+		(void) STORE_ScrubStart(u32First, sg_bSDCardReady ? u32Count : 0);
+		sg_bFrameScrubActive = true;
+		return;  // done here
+	}
+
+	// Pack has the whole frame - release the frame buffer
+	if( ECANMessageType_FrameTransferAck == eType )
+	{
+		if ((FRAME_TRANSFER_WAIT_ACK == sg_eFrameTransferState) &&
+			(u8DataLen >= sizeof(uint32_t)) &&
+			(*(uint32_t*)&pu8Data[0] == sg_pFrameToTransfer->m.frameCounter))
+		{
+			// On to the next frame of a range, or idle
+			sg_eFrameTransferState = FRAME_TRANSFER_NEXT_FRAME;
+		}
+		return;  // done here
+	}
+
+	// Pack is missing segments - collect the bitmap and resend just those
+	if( ECANMessageType_FrameTransferNack == eType )
+	{
+		// Only between END and ACK, so the burst isn't reading the bitmap while we write it
+		if ((FRAME_TRANSFER_WAIT_ACK == sg_eFrameTransferState) &&
+			(8 == u8DataLen) &&
+			(sg_u8FrameTransferResendRounds < FRAME_TRANSFER_MAX_RESENDS))
+		{
+			uint8_t u8Base = pu8Data[0] & FRAME_TRANSFER_NACK_BASE_MASK;
+			uint8_t u8Bit;
+
+			for (u8Bit = 0; u8Bit < FRAME_TRANSFER_NACK_BITS; u8Bit++)
+			{
+				uint8_t u8Segment = u8Base + u8Bit;
+
+				if (u8Segment >= FRAME_TRANSFER_SEGMENTS)
+				{
+					break;
+				}
+
+				if (pu8Data[1 + (u8Bit >> 3)] & (1 << (u8Bit & 7)))
+				{
+					sg_u8FrameTransferResend[u8Segment >> 3] |= (uint8_t) (1 << (u8Segment & 7));
+				}
+			}
+
+			// Last NACK of the set - start resending
+			if (0 == (pu8Data[0] & FRAME_TRANSFER_NACK_MORE))
+			{
+				sg_u8FrameTransferResendRounds++;
+				sg_bFrameTransferResending = true;
+				sg_eFrameTransferState = FRAME_TRANSFER_SENDING_DATA;
+			}
+			else
+			{
+				// Hold off the timeout while the rest of the set arrives
+				sg_u8FrameTransferTimeoutTicks = FRAME_TRANSFER_ACK_TIMEOUT_TICKS;
+			}
+		}
+		return;  // done here
+	}
+
+	// While transferring, ignore status/cell detail requests but process state changes.
+	// Nothing is on the wire while a frame's being read or checked, or while waiting for
+	// the ACK, so those are answered as usual.
+	if ((sg_eFrameTransferState != FRAME_TRANSFER_IDLE) &&
+		(sg_eFrameTransferState != FRAME_TRANSFER_READING) &&
+		(sg_eFrameTransferState != FRAME_TRANSFER_CHECKING) &&
+		(sg_eFrameTransferState != FRAME_TRANSFER_WAIT_ACK))
+	{
+		if (eType == ECANMessageType_ModuleStatusRequest ||
+		    eType == ECANMessageType_ModuleCellDetailRequest)
+		{
+			// Ignore these while transferring
+			return;
+		}
+		// State change requests (MaxState, AllIsolate) already processed above
+	}
+
+	if( ECANMessageType_ModuleAnnounceRequest == eType )
+	{
+		// Pack controller is requesting announcements from unregistered modules
+		if (!sg_bModuleRegistered && !sg_bAnnouncementPending)
+		{
+			// Use last byte of unique ID as delay in milliseconds (0-255ms)
+			// This saves computation and works well for sequential IDs
+			uint8_t u8RandomDelay = (uint8_t)(sg_sFrame.m.moduleUniqueId & 0xFF);
+			
+			DebugOut("RX Announce Request (UNREGISTERED) - scheduling response in %dms\r\n", u8RandomDelay);
+					
+			// Schedule announcement after delay (assuming 10ms ticks)
+			sg_u8AnnouncementDelayTicks = u8RandomDelay / 10;  // Convert to 10ms ticks
+			if (sg_u8AnnouncementDelayTicks == 0) sg_u8AnnouncementDelayTicks = 1;  // Minimum 1 tick delay
+			sg_bAnnouncementPending = true;
+		}
+		else if (sg_bModuleRegistered)
+		{
+			// We're registered, ignore announce requests
+			DebugOut("RX Announce Request (REGISTERED) - ignoring\r\n");
+		}
+		else
+		{
+			// Announcement already pending, ignore duplicate request
+			DebugOut("RX Announce Request - already pending\r\n");
+		}
+		return;  // done here
+	}
+
+		
+	if( ECANMessageType_ModuleRegistration == eType )  // handle registration
+	{
+		if( 8 == u8DataLen )
+		{
+			// Registration message contains assigned module ID - this is NOT redundant
+			// Pack controller is telling us what ID we've been assigned
+			uint8_t u8RegID = pu8Data[0];  // Assigned module ID from pack controller
+
+			// If the qualifiers match what was sent in the announcement, this is for us
+			if( (MANUFACTURE_ID == pu8Data[2]) &&
+				(PART_ID == pu8Data[3]) &&
+				(sg_sFrame.m.moduleUniqueId == *((uint32_t *) &pu8Data[4])) )
 			{
 				sg_u8TicksSinceLastPackControllerMessage = 0;
 
@@ -1458,8 +2206,45 @@ void CANReceiveCallback(ECANMessageType eType, uint8_t* pu8Data, uint8_t u8DataL
 			{
 				if( 3 == u8DataLen )
 				{
+					bool bCellValid = (pu8Data[1] < sg_sFrame.m.sg_u8CellCountExpected) || (CELL_DETAIL_ALL == pu8Data[1]);
+
+					if( pu8Data[2] & CELL_DETAIL_REQUEST_BULK )
+					{
+						// Packed reply - from the requested cell (or cell 0 for ALL) to the last cell
+						if( (false == sg_bSendCellDetailBulk) && bCellValid )
+						{
+							sg_u8CellBulkNext = (CELL_DETAIL_ALL == pu8Data[1]) ? 0 : pu8Data[1];
+							sg_u8CellBulkTarget = sg_sFrame.m.sg_u8CellCountExpected;
+							sg_bSendCellDetailBulk = true;
+						}
+					}
+					else
+					if( pu8Data[2] & CELL_DETAIL_REQUEST_TIMING )
+					{
+						// Timing profile - same range as the packed reply
+						if( (false == sg_bSendCellTiming) && bCellValid )
+						{
+							sg_u8CellTimingNext = (CELL_DETAIL_ALL == pu8Data[1]) ? 0 : pu8Data[1];
+							sg_u8CellTimingTarget = sg_sFrame.m.sg_u8CellCountExpected;
+							sg_bSendCellTiming = true;
+						}
+					}
+					else
+#ifdef CELL_RECORD_CRC
+					if( pu8Data[2] & CELL_DETAIL_REQUEST_ERRORS )
+					{
+						// Record CRC error counts - same range as the packed reply
+						if( (false == sg_bSendCellErrors) && bCellValid )
+						{
+							sg_u8CellErrorsNext = (CELL_DETAIL_ALL == pu8Data[1]) ? 0 : pu8Data[1];
+							sg_u8CellErrorsTarget = sg_sFrame.m.sg_u8CellCountExpected;
+							sg_bSendCellErrors = true;
+						}
+					}
+					else
+#endif
 					// If not already replying and this is a valid cell number, schedule response
-					if( (false == sg_bSendCellStatus) && (pu8Data[1] < sg_sFrame.m.sg_u8CellCountExpected) )
+					if( (false == sg_bSendCellStatus) && bCellValid )
 					{
 						sg_u8CellStatus = pu8Data[1];
 						sg_u8CellStatusTarget = sg_u8CellStatus + 1;  // Send one cell (target is exclusive)
@@ -1493,6 +2278,64 @@ void CANReceiveCallback(ECANMessageType eType, uint8_t* pu8Data, uint8_t u8DataL
 				return;
 			}
 
+			// frame period bounds - bytes 0-1 minimum, 2-3 maximum (ms), 0 for the default
+			if( ECANMessageType_FrameRate == eType )
+			{
+				if( 4 == u8DataLen )
+				{
+					uint16_t u16MinMs = *((uint16_t *) &pu8Data[0]);
+					uint16_t u16MaxMs = *((uint16_t *) &pu8Data[2]);
+
+					if (0 == u16MinMs)
+					{
+						u16MinMs = FRAME_PERIOD_MIN_MS_DEFAULT;
+					}
+					if (0 == u16MaxMs)
+					{
+						u16MaxMs = FRAME_PERIOD_MAX_MS_DEFAULT;
+					}
+
+					if ((u16MinMs >= FRAME_PERIOD_FLOOR_MS) &&
+						(u16MaxMs <= FRAME_PERIOD_LIMIT_MS) &&
+						(u16MinMs <= u16MaxMs))
+					{
+						// Picked up at the next string - until then the frame timer stays as it is
+						sg_u16FramePeriodMinMs = u16MinMs;
+						sg_u16FramePeriodMaxMs = u16MaxMs;
+					}
+				}
+				return;
+			}
+
+#ifdef CELL_WINDOW_POLLING
+			// cell window - byte 0 first cell ID (0xff = hottest), 1 # of cells (0 = off),
+			// 2 full string every N readings (0 = default)
+			if( ECANMessageType_CellWindow == eType )
+			{
+				if( 3 == u8DataLen )
+				{
+					uint8_t u8FullEvery = pu8Data[2];
+
+					if (0 == u8FullEvery)
+					{
+						u8FullEvery = CELL_WINDOW_FULL_EVERY_DEFAULT;
+					}
+
+					// A full string every reading would be no window at all
+					if ((pu8Data[1] <= CELL_WINDOW_CELLS_MAX) &&
+						(u8FullEvery > 1) &&
+						((CELL_WINDOW_AUTO == pu8Data[0]) || (pu8Data[0] < MAX_CELLS)))
+					{
+						// Picked up at the next reading
+						sg_u8CellWindowFirst = pu8Data[0];
+						sg_u8CellWindowCount = pu8Data[1];
+						sg_u8CellWindowFullEvery = u8FullEvery;
+					}
+				}
+				return;
+			}
+#endif
+
 			// hardware detail request
 			if( ECANMessageType_ModuleHardwareDetail == eType )
 			{
@@ -1519,54 +2362,84 @@ void CANReceiveCallback(ECANMessageType eType, uint8_t* pu8Data, uint8_t u8DataL
 	}
 }
 
-// Called at the start of cell string data via MC RX
-void vUARTRXStart(void)
+static void CellStringStatsReset(SCellStringStats* psStats)
 {
-	sg_u8CellBufferRX = 0;
-	sg_u8CellIndex = 0;
-	sg_u16BytesReceived = 0;
-	sg_u8CellReports = 0;
+	psStats->u32VoltageTotal = 0;
+	psStats->s32TemperatureTotal = 0;
+	psStats->u16VoltageHighest = 0;
+	psStats->u16VoltageLowest = 0xffff;
+	psStats->s16TemperatureHighest = -32768;
+	psStats->s16TemperatureLowest = 32767;
+	psStats->u8VoltageCount = 0;
+	psStats->u8TemperatureCount = 0;
+	psStats->bDischargeOn = false;
 }
 
-// Called at start of WRITE frame to wrap up any receive housekeeping prior to frame processing
-void vUARTRXEnd(void)
+// Folds a cell record's byte timings into the string timing profile
+static void CellTimingUpdate(uint8_t u8Position)
 {
-#ifdef FAKE_CELL_DATA
-#else
-	// disable the edge interrupt
-//	VUART_RX_DISABLE();
-	// disable bit timer interrupt, should already be off but just in case
-//	TIMER_CHB_INT_DISABLE();
-	// update bytes and cells received
-	sg_sFrame.m.sg_u16BytesReceived = sg_u16BytesReceived;
-	sg_sFrame.m.sg_u8CellCPUCount = sg_u8CellReports;
-	sg_u16BytesReceived = 0;
-	sg_u8CellReports = 0;
+	int8_t s8Timing;
 
-#endif
+	if (0 == sg_u8CellTimingCount)
+	{
+		return;
+	}
+
+	s8Timing = (int8_t) (sg_s16CellTimingTotal / sg_u8CellTimingCount);
+	if (VUART_RX_TIMING_NONE == sg_s8CellTiming[u8Position])
+	{
+		sg_s8CellTiming[u8Position] = s8Timing;
+	}
+	else
+	{
+		// A quarter of the way to the new reading
+		sg_s8CellTiming[u8Position] += (int8_t) ((s8Timing - sg_s8CellTiming[u8Position]) / 4);
+	}
 }
 
-// This is called for every byte received from MC RX (from the cell chain)
-void vUARTRXData( uint8_t u8rxDataByte )
+#if (defined(REQUEST_DEBUG_CELL_RESPONSE) || defined(VUART_RATE_NEGOTIATION))
+// True if the cell record just put together is the cells' MSG_CELL_SEND_PATTERN reply
+static bool CellRecordIsPattern(void)
 {
-#ifdef FAKE_CELL_DATA
-#else
-	// Add the data
-	sg_u8CellBufferTemp[sg_u8CellBufferRX++] = u8rxDataByte;
-	sg_u16BytesReceived++;
-	
-	// If we have a full cell buffer then copy it into the cell data store
-	if (sg_u8CellBufferRX >= sizeof(sg_u8CellBufferTemp))
+	return((sg_u8CellBufferTemp[0] == ((uint8_t) PATTERN_VOLTAGE)) &&
+		   (sg_u8CellBufferTemp[1] == ((uint8_t) (PATTERN_VOLTAGE >> 8))) &&
+		   (sg_u8CellBufferTemp[2] == ((uint8_t) PATTERN_TEMPERATURE)) &&
+		   (sg_u8CellBufferTemp[3] == ((uint8_t) (PATTERN_TEMPERATURE >> 8))));
+}
+#endif
+
+// Puts cell records together from the bytes vUARTRXData() has queued up, and files
+// them in the string data. Runs in the main loop.
+static void CellRecordsAssemble(void)
+{
+	uint8_t u8Tail = sg_u8RXRingTail;
+
+	while (u8Tail != sg_u8RXRingHead)
 	{
+		int8_t s8Timing = sg_s8RXTimingRing[u8Tail];
+
+		sg_u8CellBufferTemp[sg_u8CellBufferRX++] = sg_u8RXRing[u8Tail];
+		u8Tail = (uint8_t) ((u8Tail + 1) & VUART_RX_RING_MASK);
+		sg_u8RXRingTail = u8Tail;
+
+		if (s8Timing != VUART_RX_TIMING_NONE)
+		{
+			sg_s16CellTimingTotal += s8Timing;
+			sg_u8CellTimingCount++;
+		}
+
+		// Wait for a full cell buffer
+		if (sg_u8CellBufferRX < sizeof(sg_u8CellBufferTemp))
+		{
+			continue;
+		}
+
 		sg_u8CellBufferRX = 0;
 		
 #ifdef REQUEST_DEBUG_CELL_RESPONSE
 		// We're looking for a specific pattern. If it doesn't match what
 		// we expect, halt
-		if ((sg_u8CellBufferTemp[0] != ((uint8_t) PATTERN_VOLTAGE)) ||
-			(sg_u8CellBufferTemp[1] != ((uint8_t) (PATTERN_VOLTAGE >> 8))) ||
-			(sg_u8CellBufferTemp[2] != ((uint8_t) PATTERN_TEMPERATURE)) ||
-			(sg_u8CellBufferTemp[3] != ((uint8_t) (PATTERN_TEMPERATURE >> 8))))
+		if (false == CellRecordIsPattern())
 		{
 			volatile uint8_t u8Foo = 0;  //change to 1 to enable halting here for debug
 			
@@ -1581,57 +2454,261 @@ void vUARTRXData( uint8_t u8rxDataByte )
 		// Each data store is 4 bytes so do 32-bit xfer:
 		if (sg_u8CellIndex < MAX_CELLS)
 		{
-			// 32bit copy for speed - inside the ISR - copied atomically
-			// ASSUMES 4-BYTE ALIGNMENT - CHECK!
-			volatile CellData* stringData = GetStringDataVolatile(&sg_sFrame);
-			*(uint32_t*)&(stringData[sg_u8CellIndex]) = *((uint32_t*)sg_u8CellBufferTemp);
+#ifdef CELL_RECORD_CRC
+			if (CRC8_Calculate(sg_u8CellBufferTemp, sizeof(CellData)) != sg_u8CellBufferTemp[sizeof(CellData)])
+			{
+				// Corrupted somewhere along the string. Its slot stays empty, as for a
+				// cell that didn't report, and the cells after it still line up.
+				if (sg_u8RXRecordErrors != 0xff)
+				{
+					sg_u8RXRecordErrors++;
+				}
+				if (sg_u8CellRecordErrors[sg_u8CellIndex] != 0xff)
+				{
+					sg_u8CellRecordErrors[sg_u8CellIndex]++;
+				}
+			}
+			else
+#endif
+#ifdef CELL_WINDOW_POLLING
+			if (sg_bRXWindow)
+			{
+				uint8_t u8Window = sg_u8CellIndex - sg_u8RXWindowPosition;
+
+				// Goes to the pack as it is, not into the frame
+				if (u8Window < CELL_WINDOW_CELLS_MAX)
+				{
+					*(uint32_t*)&sg_sCellWindow[u8Window] = *((uint32_t*)sg_u8CellBufferTemp);
+				}
+			}
+			else
+#endif
+#ifdef VUART_RATE_NEGOTIATION
+			if (sg_bRXPattern)
+			{
+				// Checking out a new rate - the pattern isn't cell data, so it doesn't
+				// get filed
+				if ((false == CellRecordIsPattern()) &&
+					(sg_u8RXPatternErrors != 0xff))
+				{
+					sg_u8RXPatternErrors++;
+				}
+			}
+			else
+#endif
+			{
+#ifdef FRAME_DELTA_STRINGS
+				// Packed against the latest reading as it comes in, making room if need be
+				sg_sFrame.m.readingCount -= StringDelta_Cell(&sg_sStringDelta, sg_u8CellIndex, sg_u8CellBufferTemp);
+#else
+				volatile CellData* stringData = GetStringDataVolatile(&sg_sFrame);
+				*(uint32_t*)&(stringData[sg_u8CellIndex]) = *((uint32_t*)sg_u8CellBufferTemp);
+#endif
+
+				// Fold this cell into the string statistics while it's at hand
+				CellStringStatsAdd(&sg_sStringStatsRX,
+								   *((uint16_t*)&sg_u8CellBufferTemp[0]),
+								   *((int16_t*)&sg_u8CellBufferTemp[2]));
+			}
 		
 			*((uint32_t*)sg_u8CellBufferTemp) = 0;  // zero out all 32 bits to avoid stale data (?)
 
+			CellTimingUpdate(sg_u8CellIndex);
+
 			// Next cell!
 			sg_u8CellIndex++;
 			sg_u8CellReports++;
 		}
+
+		sg_s16CellTimingTotal = 0;
+		sg_u8CellTimingCount = 0;
+	}
+}
+
+// Called at the start of cell string data via MC RX
+void vUARTRXStart(void)
+{
+	SProfileStamp sStamp;
+	uint8_t u8SREG;
+	uint8_t u8Position = 0;
+
+	ProfileStamp(&sStamp);
+	sg_u16StringRequestTimer1 = sStamp.u16Timer1;
+	sg_u8CellBufferRX = 0;
+#ifdef CELL_WINDOW_POLLING
+	// A window's records carry on from where they'd be in the whole string
+	u8Position = sg_bRXWindow ? sg_u8RXWindowPosition : 0;
+	if (sg_bRXWindow)
+	{
+		// Marked the same way as an empty frame slot, for cells that don't make it
+		for (uint8_t u8Window = 0; u8Window < CELL_WINDOW_CELLS_MAX; u8Window++)
+		{
+			sg_sCellWindow[u8Window].voltage = INVALID_CELL_VOLTAGE;
+			sg_sCellWindow[u8Window].temperature = INVALID_CELL_TEMP;
+		}
 	}
 #endif
+	sg_u8CellIndex = u8Position;
+	sg_u8CellReports = 0;
+	sg_s16CellTimingTotal = 0;
+	sg_u8CellTimingCount = 0;
+	CellStringStatsReset(&sg_sStringStatsRX);
+#ifdef VUART_RATE_NEGOTIATION
+	sg_bRXPattern = (ERATE_VERIFY == sg_eRateState);
+	sg_u8RXPatternErrors = 0;
+#endif
+#ifdef CELL_RECORD_CRC
+	sg_u8RXRecordErrors = 0;
+#endif
+
+	// Throw away anything left over from the last string
+	u8SREG = SREG;
+	cli();
+	sg_u8RXRingTail = sg_u8RXRingHead;
+	sg_bRXRingOverrun = false;
+	sg_u16BytesReceived = 0;
+	sg_u8RXRecordPosition = u8Position;
+	sg_u8RXRecordByte = 0;
+	sg_bStringComplete = false;
+	SREG = u8SREG;
 }
 
-// Converts 0-15 value scaled to 0-100
-static const uint8_t sg_u8FractionalLookup[] =
+// Called at start of WRITE frame to wrap up any receive housekeeping prior to frame processing
+void vUARTRXEnd(void)
 {
-	0,
-	6,
-	12,
-	18,
-	25,
-	31,
-	37,
-	43,
-	50,
-	56,
-	62,
-	68,
-	75,
-	81,
-	87,
-	93
-};
+#ifdef FAKE_CELL_DATA
+#else
+	uint8_t u8SREG;
 
-// Converts incoming cell data to the CAN bus-documented format
-// for consumption by the pack controller.
+	// disable the edge interrupt
+//	VUART_RX_DISABLE();
+	// disable bit timer interrupt, should already be off but just in case
+//	TIMER_CHB_INT_DISABLE();
 
-//reality checks for data validity
+	// Pick up whatever the main loop hasn't got to yet
+	CellRecordsAssemble();
 
-#define MAX_VALID_CELL_VOLTAGE 0x0400  //4.5V, max ADC range
-#define MIN_VALID_CELL_VOLTAGE 0x01f0  //2.2V, cell curcuit doesn't run below that
+#ifdef CELL_WINDOW_POLLING
+	if (sg_bRXWindow)
+	{
+		// Only a few cells - CellWindowReadingEnd() takes them from here, and the frame
+		// isn't touched
+		u8SREG = SREG;
+		cli();
+		sg_u16BytesReceived = 0;
+		SREG = u8SREG;
+		sg_u8CellWindowReceived = sg_u8CellReports;
+		sg_u8CellReports = 0;
+		CellStringStatsReset(&sg_sStringStatsRX);
+		return;
+	}
+#endif
 
-// just returns result of validity check if pointer is NULL
-// otherwise mofifies pointed location to read in mV corrected 
-static bool CellDataConvertVoltage( uint16_t u16CellData,   
-							 uint16_t* pu16Voltage 
-							)
+	// update bytes and cells received
+	u8SREG = SREG;
+	cli();
+	sg_sFrame.m.sg_u16BytesReceived = sg_u16BytesReceived;
+	sg_u16BytesReceived = 0;
+	SREG = u8SREG;
+	sg_sFrame.m.sg_u8CellCPUCount = sg_u8CellReports;
+	sg_u8CellReports = 0;
+
+#endif
+	// Hand the string statistics over to CellStringProcess()
+	sg_sStringStats = sg_sStringStatsRX;
+	CellStringStatsReset(&sg_sStringStatsRX);
+}
+
+// This is called for every byte received from MC RX (from the cell chain), from the
+// vUART RX interrupt. It only queues the byte and its timing - CellRecordsAssemble()
+// does the rest.
+void vUARTRXData( uint8_t u8rxDataByte, int8_t s8Timing )
 {
-	uint16_t u16Voltage = u16CellData;
+#ifdef FAKE_CELL_DATA
+#else
+	uint8_t u8SREG;
+	uint8_t u8Head = sg_u8RXRingHead;
+	uint8_t u8Next = (uint8_t) ((u8Head + 1) & VUART_RX_RING_MASK);
+
+	if (sg_bRXRingOverrun)
+	{
+		return;
+	}
+
+	if (u8Next == sg_u8RXRingTail)
+	{
+		// Main loop has fallen behind. A dropped byte would shift every record after it,
+		// so drop the rest of the string - it shows up as short.
+		sg_bRXRingOverrun = true;
+		return;
+	}
+
+	sg_u8RXRing[u8Head] = u8rxDataByte;
+	sg_s8RXTimingRing[u8Head] = s8Timing;
+	sg_u8RXRingHead = u8Next;
+	sg_u16BytesReceived++;
+
+	if (++sg_u8RXRecordByte >= CELL_RECORD_BYTES)
+	{
+		sg_u8RXRecordByte = 0;
+		if (sg_u8RXRecordPosition != 0xff)
+		{
+			sg_u8RXRecordPosition++;
+		}
+	}
+
+	// Last byte (so far) for the string round trip. TCNT1 is read through the shared
+	// TEMP register, and the edge capture receiver calls in here with interrupts on.
+	u8SREG = SREG;
+	cli();
+	sg_u16StringLastByteTimer1 = TCNT1;
+	SREG = u8SREG;
+#endif
+}
+
+// Called from the vUART RX ISR when the string is done - the last byte's stop bit said
+// nothing more is coming, or the line went quiet after a byte. A string that stops
+// part way through a cell record is left to the frame timer, as before.
+void vUARTRXComplete(void)
+{
+	if (sg_u16BytesReceived &&
+		(0 == sg_u8RXRecordByte) &&
+		(false == sg_bRXRingOverrun))
+	{
+		sg_bStringComplete = true;
+	}
+}
+
+// Called from the vUART RX ISR for the per bit timing error (1/16us) of the cell whose
+// byte comes next, from the string timing profile. 0 if it hasn't been measured.
+int8_t vUARTRXSkew(void)
+{
+	uint8_t u8Position = sg_u8RXRecordPosition;
+
+	if ((u8Position >= MAX_CELLS) ||
+		(VUART_RX_TIMING_NONE == sg_s8CellTiming[u8Position]))
+	{
+		return(0);
+	}
+
+	return(sg_s8CellTiming[u8Position]);
+}
+
+// Converts incoming cell data to the CAN bus-documented format
+// for consumption by the pack controller.
+
+//reality checks for data validity
+
+#define MAX_VALID_CELL_VOLTAGE 0x0400  //4.5V, max ADC range
+#define MIN_VALID_CELL_VOLTAGE 0x01f0  //2.2V, cell curcuit doesn't run below that
+
+// just returns result of validity check if pointer is NULL
+// otherwise mofifies pointed location to read in mV corrected 
+static bool CellDataConvertVoltage( uint16_t u16CellData,   
+							 uint16_t* pu16Voltage 
+							)
+{
+	uint16_t u16Voltage = u16CellData;
 	bool bCellDataValid = true;  //assume good to start
 					
 	// Scale voltage - Needs to be in millivolt increments - 0-65.535mv
@@ -1652,15 +2729,12 @@ static bool CellDataConvertVoltage( uint16_t u16CellData,
 	else
 	#endif
 	{
-		// Convert from # of scale of the ADC to the nondivided voltage range, in millivolts
-		uint32_t temp = (uint32_t)u16Voltage * VOLTAGE_CONVERSION_FACTOR;
-		u16Voltage = (uint16_t)((temp / ADC_MAX_VALUE + FIXED_POINT_SCALE/2) / FIXED_POINT_SCALE);
-		
-		// Still check for completely invalid values (0 or 0xFFFF)
-		if (u16Voltage == 0 || u16Voltage == 0xFFFF)
+		// Convert from # of scale of the ADC to the nondivided voltage range, in millivolts.
+		// Table is CellCalVoltage() for every reading - 0 for completely invalid values.
+		u16Voltage = pgm_read_word(&sg_u16CellVoltageTable[u16Voltage]);
+		if (0 == u16Voltage)
 		{
 			bCellDataValid = false;
-			u16Voltage = 0;
 		}
 	}
 	// Return the values if pointers nonzero
@@ -1719,14 +2793,21 @@ static bool CellDataConvertTemperature( int16_t s16CellData,
 		else
 		{
 			// Scale to 100ths of degrees C
-			s16Temperature = (s16Temperature * 100) + (int16_t) sg_u8FractionalLookup[u8Fractional];
-			s16Temperature += TEMPERATURE_BASE;
+			s16Temperature = CellCalTemperature(s16Temperature, u8Fractional);
 		}
 		*/
 		// TEMPORARY - Always do conversion regardless of range
-		// Scale to 100ths of degrees C
-		s16Temperature = (s16Temperature * 100) + (int16_t) sg_u8FractionalLookup[u8Fractional];
-		s16Temperature += TEMPERATURE_BASE;
+		// Scale to 100ths of degrees C - straight from the tables for anything bits 4-12
+		// can hold, arithmetic for the odd reading with MCP9843 alarm bits set
+		if ((uint16_t) (s16Temperature + (CELL_TEMP_TABLE_ENTRIES / 2)) < CELL_TEMP_TABLE_ENTRIES)
+		{
+			s16Temperature = (int16_t) pgm_read_word(&sg_s16CellTemperatureTable[s16Temperature & CELL_TEMP_TABLE_MASK]) +
+							 (int16_t) pgm_read_byte(&sg_u8CellTemperatureFractionTable[u8Fractional]);
+		}
+		else
+		{
+			s16Temperature = CellCalTemperature(s16Temperature, u8Fractional);
+		}
 	}
 	else
 	{
@@ -1742,6 +2823,100 @@ static bool CellDataConvertTemperature( int16_t s16CellData,
 }
 
 
+// Adds one received cell record to the running string statistics, as
+// CellRecordsAssemble() puts it together (FrameReadStart() with FAKE_CELL_DATA). The
+// averages are left to CellStringProcess().
+static void CellStringStatsAdd(SCellStringStats* psStats, uint16_t u16Voltage, int16_t s16Temperature)
+{
+	// if valid, count it
+	if (CellDataConvertTemperature(s16Temperature,NULL))  // only do validity check, don't convert since we're doing stats raw
+	{
+		if (s16Temperature & (1 << 12))
+		{
+			// Sign extend/2's complement
+			s16Temperature |= 0xf000;
+		}
+		else
+		{
+			s16Temperature &= ~MSG_CELL_TEMP_I2C_OK;  // clear the i2c bit
+		}
+
+		if (psStats->s16TemperatureHighest < s16Temperature)
+		{
+			psStats->s16TemperatureHighest = s16Temperature;
+		}
+		if (psStats->s16TemperatureLowest > s16Temperature)
+		{
+			psStats->s16TemperatureLowest = s16Temperature;
+		}
+		psStats->s32TemperatureTotal += s16Temperature;
+		psStats->u8TemperatureCount++;
+	}
+
+	// Is it discharging?
+	if (u16Voltage & MSG_CELL_DISCHARGE_ACTIVE)
+	{
+		psStats->bDischargeOn = true;
+	}
+
+	// if valid, count it
+	if (CellDataConvertVoltage(u16Voltage,&u16Voltage))  // this will check limits, scale to mV and clear unused bits
+	{
+		if (psStats->u16VoltageHighest < u16Voltage)
+		{
+			psStats->u16VoltageHighest = u16Voltage;
+		}
+		if (psStats->u16VoltageLowest > u16Voltage)
+		{
+			psStats->u16VoltageLowest = u16Voltage;
+		}
+		psStats->u32VoltageTotal += u16Voltage;
+		psStats->u8VoltageCount++;
+	}
+}
+
+// MODULE_DETAIL_BULK temperature - 0.5 degree C steps from -40C (-40C to +87C), saturating
+#define CELL_TEMP_BULK_OFFSET		40
+#define CELL_TEMP_BULK_MAX			0xfe
+#define CELL_TEMP_BULK_INVALID		0xff
+
+// Compress raw cell temperature (signed 8.4 fixed point, same input as
+// CellDataConvertTemperature()) into the 8 bit MODULE_DETAIL_BULK format
+static uint8_t CellDataCompressTemperature( int16_t s16CellData )
+{
+	int16_t s16Temperature = s16CellData;
+
+	if (TEMPERATURE_INVALID == (uint16_t) s16Temperature)
+	{
+		return(CELL_TEMP_BULK_INVALID);
+	}
+
+	if (s16Temperature & (1 << 12))
+	{
+		// Sign extend/2's complement
+		s16Temperature |= 0xf000;
+	}
+	else
+	{
+		s16Temperature &= ~MSG_CELL_TEMP_I2C_OK; // clear the i2c bit
+	}
+
+	// 16ths of a degree to half degrees, then offset so -40C is 0
+	s16Temperature >>= 3;
+	s16Temperature += (CELL_TEMP_BULK_OFFSET * 2);
+
+	if (s16Temperature < 0)
+	{
+		s16Temperature = 0;
+	}
+	else if (s16Temperature > CELL_TEMP_BULK_MAX)
+	{
+		s16Temperature = CELL_TEMP_BULK_MAX;
+	}
+
+	return((uint8_t) s16Temperature);
+}
+
 static void CellDataConvert( CellData* pCellData,
 							uint16_t* pu16Voltage,
 							int16_t* ps16Temperature
@@ -1774,6 +2949,18 @@ uint16_t PlatformGetSendData( bool bUpdateBalanceStatus )
 		}
 		u16SendValue = 0x3ff;
 	}
+#ifdef VUART_RATE_NEGOTIATION
+	else
+	if (ERATE_COMMAND == sg_eRateState)
+	{
+		// Rate change - leaves balancing stopped, like the above
+		u16SendValue = MSG_CELL_SET_BIT_RATE | ((uint16_t) sg_u8RateTarget << MSG_CELL_BIT_RATE_SHIFT) | 0x3ff;
+		if (bUpdateBalanceStatus)	// only once it's actually going out
+		{
+			sg_bRateCommandSent = true;
+		}
+	}
+#endif
 	else
 	{
 		// Always request reports
@@ -1802,10 +2989,26 @@ uint16_t PlatformGetSendData( bool bUpdateBalanceStatus )
 #endif
 		{
 			u16SendValue |= MSG_CELL_SEND_REPORT;
+#ifdef CELL_WINDOW_POLLING
+			// Only the window's cells - the cells after it aren't asked
+			if (sg_bRXWindow)
+			{
+				u16SendValue |= (uint16_t) (MSG_CELL_REPORT_WINDOW |
+											((uint16_t) sg_u8RXWindowFirst << MSG_CELL_WINDOW_FIRST_SHIFT) |
+											sg_u8RXWindowCount);
+			}
+#endif
 			
 			// Optionally request a specific response from the cells 
 #ifdef REQUEST_DEBUG_CELL_RESPONSE
 			u16SendValue |= MSG_CELL_SEND_PATTERN;
+#endif
+#ifdef VUART_RATE_NEGOTIATION
+			// Checking out a new rate
+			if (ERATE_VERIFY == sg_eRateState)
+			{
+				u16SendValue |= MSG_CELL_SEND_PATTERN;
+			}
 #endif
 		}
 	}
@@ -1916,8 +3119,9 @@ static void ControllerStatusMessagesSend(uint8_t *pu8Response)
 		}
 	}
 	
-	// If this is set, send a PKT_MODULE_STATUS1 through _STATUS3
-	if( sg_bSendModuleControllerStatus )
+	// If this is set, send a PKT_MODULE_STATUS1 through _STATUS3 - all in one pass
+	// unless the CAN TX queue fills up, in which case we carry on next time
+	while( sg_bSendModuleControllerStatus )
 	{
 		bool bStatusSendSuccessful = true;
 		bool bSent;
@@ -2100,9 +3304,14 @@ if(0)
 				// Leave the module controller status alone so we pick it up next time
 			}
 		}
+		else
+		{
+			break;
+		}
 	}
 			
-	if( sg_bSendCellStatus )
+	// Queue as many cell details as the CAN TX queue will take
+	while( sg_bSendCellStatus )
 	{
 		bool bSuccess;
 		uint16_t u16Voltage = 0;
@@ -2198,6 +3407,10 @@ if(0)
 				sg_bSendCellStatus = false;
 			}
 		}
+		else
+		{
+			break;
+		}
 	}
 		
 	// If we need to send the cell comm stats, do so
@@ -2229,8 +3442,14 @@ if(0)
 			pu8Response[5] = 0xff;
 		}
 		
+#ifdef STRING_PROCESS_PROFILING
+		// Longest string statistics processing time (us) since the last report
+		pu8Response[6] = (uint8_t) sg_u16StringProcessUsMax;
+		pu8Response[7] = (uint8_t) (sg_u16StringProcessUsMax >> 8);
+#else
 		pu8Response[6] = 0;
 		pu8Response[7] = 0;
+#endif
 			
 		bSuccess = CANSendMessage( ECANMessageType_ModuleCellCommStat1, pu8Response, CAN_STATUS_RESPONSE_SIZE );
 
@@ -2238,6 +3457,45 @@ if(0)
 		if (bSuccess)
 		{
 			sg_bSendCellCommStatus = false;
+#ifdef STRING_PROCESS_PROFILING
+			sg_u16StringProcessUsMax = 0;
+#endif
+			sg_bSendCellCommStat2 = true;
+		}
+	}
+
+	// Followed by the string sample rate
+	if (sg_bSendCellCommStat2)
+	{
+		// Interval between the last two string readings (ms)
+		pu8Response[0] = (uint8_t) sg_u16StringIntervalMs;
+		pu8Response[1] = (uint8_t) (sg_u16StringIntervalMs >> 8);
+
+		// # Of string readings since the last report
+		pu8Response[2] = (uint8_t) sg_u16StringReadings;
+		pu8Response[3] = (uint8_t) (sg_u16StringReadings >> 8);
+
+		// Frame mode and current frame period (10ms units)
+#ifdef PIPELINED_FRAMES
+		pu8Response[4] = CELL_COMM_STAT2_PIPELINED;
+#else
+		pu8Response[4] = 0;
+#endif
+#ifdef VUART_RATE_NEGOTIATION
+		pu8Response[4] |= (uint8_t) (CELL_COMM_STAT2_RATE_NEGOTIATION |
+									 (vUARTRateGet() << CELL_COMM_STAT2_RATE_SHIFT) |
+									 (sg_u8RateFastest << CELL_COMM_STAT2_RATE_FASTEST_SHIFT));
+#endif
+		pu8Response[5] = (uint8_t) (FRAME_PERIOD_TIMER1_TO_MS(sg_u16FramePeriodTimer1) / 10);
+
+		// Last full string's round trip (ms) - what the frame period follows
+		pu8Response[6] = (uint8_t) sg_u16StringRoundTripMs;
+		pu8Response[7] = (uint8_t) (sg_u16StringRoundTripMs >> 8);
+
+		if (CANSendMessage( ECANMessageType_ModuleCellCommStat2, pu8Response, CAN_STATUS_RESPONSE_SIZE ))
+		{
+			sg_bSendCellCommStat2 = false;
+			sg_u16StringReadings = 0;
 		}
 	}
 
@@ -2284,168 +3542,665 @@ if(0)
 
 
 
-static void CellStringProcess(uint8_t *pu8Response)  // no longer does float calcs on every cell, doesn't do anything with pu8Response
+// Write the low u8Bits of u16Value into pu8Dest starting at bit u8BitPos (LSB first)
+static void CellDetailBulkPack( uint8_t* pu8Dest,
+								uint8_t u8BitPos,
+								uint16_t u16Value,
+								uint8_t u8Bits )
 {
-	// Process even if no bytes received - need to handle timeout case
-	// When sg_u16BytesReceived == 0, sg_u8CellCPUCount will also be 0
-	// This will trigger the mismatch counter if we're expecting cells
-
-	// Only process cell data if we actually received some
-	if (sg_sFrame.m.sg_u16BytesReceived)
+	while( u8Bits-- )
 	{
-		// Assume there are no I2C errors...
-		sg_sFrame.m.sg_u8CellFirstI2CError = 0xff;
-
-		// Update comm stats
-		if (sg_sFrame.m.sg_u8CellCPUCountFewest > sg_sFrame.m.sg_u8CellCPUCount)
+		if( u16Value & 1 )
 		{
-			sg_sFrame.m.sg_u8CellCPUCountFewest = sg_sFrame.m.sg_u8CellCPUCount;
-			sg_bSendCellCommStatus = true;
+			pu8Dest[u8BitPos >> 3] |= (uint8_t) (1 << (u8BitPos & 7));
 		}
-		if (sg_sFrame.m.sg_u8CellCPUCountMost < sg_sFrame.m.sg_u8CellCPUCount)
+
+		u16Value >>= 1;
+		u8BitPos++;
+	}
+}
+
+// Packs one cell's voltage and temperature into a MODULE_DETAIL_BULK bitstream at
+// u8BitPos, or "not reporting" if psCell is NULL. Returns the bit position after it.
+static uint8_t CellDetailBulkPackCell( uint8_t* pu8Dest,
+									   uint8_t u8BitPos,
+									   volatile CellData* psCell )
+{
+	uint16_t u16Voltage = 0;
+	uint8_t u8Temperature = CELL_TEMP_BULK_INVALID;
+
+	if (psCell)
+	{
+		u16Voltage = psCell->voltage & ((1 << CELL_VOLTAGE_BITS) - 1);
+		u8Temperature = CellDataCompressTemperature(psCell->temperature);
+	}
+
+	CellDetailBulkPack(pu8Dest, u8BitPos, u16Voltage, CELL_VOLTAGE_BITS);
+	u8BitPos += CELL_VOLTAGE_BITS;
+	CellDetailBulkPack(pu8Dest, u8BitPos, u8Temperature, 8);
+	u8BitPos += 8;
+
+	return(u8BitPos);
+}
+
+// Stream MODULE_DETAIL_BULK messages - called every main loop pass so the whole
+// module goes out back-to-back, limited only by the CAN TX queue.
+//
+// Byte 0    - First cell ID in this message (0-based, same numbering as MODULE_DETAIL)
+// Bytes 1-7 - LSB first bitstream:
+//		bits 0-1	- Cell count in this message (1-3)
+//		per cell	- 10 bit raw cell voltage (0 = not reporting), then 8 bit
+//					  temperature (CellDataCompressTemperature(), 0xff = not valid)
+static void CellDetailBulkSend(void)
+{
+	while( sg_bSendCellDetailBulk )
+	{
+		uint8_t u8Response[CAN_STATUS_RESPONSE_SIZE];
+		uint8_t cellsReceived = sg_sFrame.m.sg_u8LastCompleteCellCount;
+		volatile CellData* stringData = GetLatestCompleteString(&sg_sFrame);
+		uint8_t u8Count = sg_u8CellBulkTarget - sg_u8CellBulkNext;
+		uint8_t u8BitPos = 2;
+		uint8_t u8Index;
+
+		if (u8Count > CELL_DETAIL_BULK_CELLS)
 		{
-			sg_sFrame.m.sg_u8CellCPUCountMost = sg_sFrame.m.sg_u8CellCPUCount;
-			sg_bSendCellCommStatus = true;
+			u8Count = CELL_DETAIL_BULK_CELLS;
 		}
 
-		// Auto-discover cell count if expected count is 0 or unprogrammed
-		// Update expected count if we receive more cells than expected
-		// This works even if unique ID is programmed but cell count is not
-		if (sg_sFrame.m.sg_u8CellCountExpected == 0)
+		memset((void *) u8Response, 0, sizeof(u8Response));
+		u8Response[0] = sg_u8CellBulkNext;
+		CellDetailBulkPack(&u8Response[1], 0, u8Count, 2);
+
+		for (u8Index = 0; u8Index < u8Count; u8Index++)
 		{
-			if (sg_sFrame.m.sg_u8CellCPUCount > 0)
+			uint8_t requestedCellId = sg_u8CellBulkNext + u8Index;
+			volatile CellData* psCell = NULL;
+
+			// Same reverse mapping as MODULE_DETAIL - cells report last to first
+			if (requestedCellId < cellsReceived)
 			{
-				CellCountExpectedSet(sg_sFrame.m.sg_u8CellCPUCount);
+				uint8_t actualIndex = (cellsReceived - 1) - requestedCellId;
+
+				if (actualIndex < MAX_CELLS)
+				{
+					psCell = &stringData[actualIndex];
+				}
 			}
+
+			u8BitPos = CellDetailBulkPackCell(&u8Response[1], u8BitPos, psCell);
 		}
-		else if (!sg_bEEPROMValid)
+
+		if (false == CANSendMessage( ECANMessageType_ModuleCellDetailBulk, u8Response, CAN_STATUS_RESPONSE_SIZE ))
 		{
-			// EEPROM fully unprogrammed - allow cell count to grow
-			if (sg_sFrame.m.sg_u8CellCPUCount > sg_sFrame.m.sg_u8CellCountExpected)
-			{
-				CellCountExpectedSet(sg_sFrame.m.sg_u8CellCPUCount);
-			}
+			// Queue full - carry on next pass
+			break;
 		}
 
-		// OK, we have at least one. Let's see if the cell count is
-		// reasonable. If it isn't, flag it as a framing error
-		if (sg_sFrame.m.sg_u16BytesReceived & (((1 << BYTES_PER_CELL_SHIFT) - 1))) // number of bytes not evenly divisible by bytes per cell
+		sg_u8CellBulkNext += u8Count;
+		if (sg_u8CellBulkNext >= sg_u8CellBulkTarget)
 		{
-			if (sg_sFrame.m.sg_u8MCRXFramingErrors != 0xff)
-			{
-				sg_sFrame.m.sg_u8MCRXFramingErrors++;
-				sg_bSendCellCommStatus = true;
-			}
+			sg_bSendCellDetailBulk = false;
 		}
+	}
+}
 
-		// Find the highest and lowest temperatures and voltages for this batch of cell data
-		sg_sFrame.m.sg_u16HighestCellVoltage = 0;
-		sg_sFrame.m.sg_u16LowestCellVoltage  = 0xffff;
-		sg_sFrame.m.sg_u16AverageCellVoltage = 0;
-		sg_sFrame.m.sg_s16HighestCellTemp = -32768;
-		sg_sFrame.m.sg_s16LowestCellTemp = 32767;
-		sg_sFrame.m.sg_s16AverageCellTemp = 0;
-		int16_t s16HighestCellTempRAW = -32768;  // keep stats in RAW
-		int16_t s16LowestCellTempRAW = 32767;
-		int32_t s32TempTotal = 0;
-		uint32_t u32CellVoltageTotalmV = 0;		// All cell CPU voltages added up, RAW
-		uint8_t u8CellVoltageCount = 0;
-		uint8_t u8CellTemperatureCount = 0;
+// Stream MODULE_VUART_TIMING messages, the string timing profile - called every main
+// loop pass, like CellDetailBulkSend().
+//
+// Byte 0    - First cell ID in this message (0-based, same numbering as MODULE_DETAIL)
+// Bytes 1-7 - Per bit timing error of each cell's bytes, signed, 1/16us units (+ = the
+//			   cell's bits run long). 0x80 = not measured, or past the last cell.
+static void CellTimingSend(void)
+{
+	while( sg_bSendCellTiming )
+	{
+		uint8_t u8Response[CAN_STATUS_RESPONSE_SIZE];
+		uint8_t u8CellCount = sg_sFrame.m.sg_u8CellCountExpected;
+		uint8_t u8Index;
 
-		for (uint8_t u8CellIndex = 0; u8CellIndex < sg_sFrame.m.sg_u8CellCPUCount; u8CellIndex++)  // process however many cells we received
+		u8Response[0] = sg_u8CellTimingNext;
+		for (u8Index = 0; u8Index < CELL_TIMING_CELLS; u8Index++)
 		{
-			volatile CellData* stringData = GetStringDataVolatile(&sg_sFrame);
-			uint16_t u16Voltage = stringData[u8CellIndex].voltage;
-			int16_t s16Temperature = stringData[u8CellIndex].temperature;
-		
-			// Bits 0-3  - 16ths of a degree C
-			// Bits 4-11 - Whole degrees C
-			// Bit 12    - Temperature sign bit - 0=Positive, 1=Negative
-
+			uint8_t u8CellId = sg_u8CellTimingNext + u8Index;
 
+			u8Response[1 + u8Index] = (uint8_t) VUART_RX_TIMING_NONE;
 
-			// if valid, count it
-			if (CellDataConvertTemperature(s16Temperature,NULL))  // only do validity check, don't convert since we're doing stats raw
+			// Same reverse mapping as MODULE_DETAIL - cells report last to first
+			if ((u8CellId < sg_u8CellTimingTarget) && (u8CellId < u8CellCount))
 			{
-				if (s16Temperature & (1 << 12))
-				{
-					// Sign extend/2's complement
-					s16Temperature |= 0xf000;
-				}
-				else
-				{
-					s16Temperature &= ~MSG_CELL_TEMP_I2C_OK;  // clear the i2c bit
-				}
+				uint8_t u8Position = (u8CellCount - 1) - u8CellId;
 
-				if (s16HighestCellTempRAW < s16Temperature)
-				{
-					s16HighestCellTempRAW = s16Temperature;
-				}
-				if (s16LowestCellTempRAW > s16Temperature)
+				if (u8Position < MAX_CELLS)
 				{
-					s16LowestCellTempRAW = s16Temperature;
+					u8Response[1 + u8Index] = (uint8_t) sg_s8CellTiming[u8Position];
 				}
-				s32TempTotal += s16Temperature;
-				u8CellTemperatureCount++;
 			}
+		}
 
-			// Is it discharging?
-			if (stringData[u8CellIndex].voltage & MSG_CELL_DISCHARGE_ACTIVE)
-			{
-				// update the flag
-				sg_sFrame.m.bDischargeOn = true;
-			}	
-		
-			// if valid, count it		
-			if (CellDataConvertVoltage(u16Voltage,&u16Voltage))  // this will check limits, scale to mV and clear unused bits
+		if (false == CANSendMessage( ECANMessageType_ModuleVUARTTiming, u8Response, CAN_STATUS_RESPONSE_SIZE ))
+		{
+			// Queue full - carry on next pass
+			break;
+		}
+
+		sg_u8CellTimingNext += CELL_TIMING_CELLS;
+		if (sg_u8CellTimingNext >= sg_u8CellTimingTarget)
+		{
+			sg_bSendCellTiming = false;
+		}
+	}
+}
+
+#ifdef CELL_RECORD_CRC
+// Stream MODULE_CELL_ERRORS messages, the cell record CRC error counts - called every main
+// loop pass, like CellTimingSend().
+//
+// Byte 0    - First cell ID in this message (0-based, same numbering as MODULE_DETAIL)
+// Bytes 1-7 - Records from each cell that failed their CRC this session (0xff = 255 or
+//			   more). 0 past the last cell.
+static void CellErrorsSend(void)
+{
+	while( sg_bSendCellErrors )
+	{
+		uint8_t u8Response[CAN_STATUS_RESPONSE_SIZE];
+		uint8_t u8CellCount = sg_sFrame.m.sg_u8CellCountExpected;
+		uint8_t u8Index;
+
+		u8Response[0] = sg_u8CellErrorsNext;
+		for (u8Index = 0; u8Index < CELL_ERRORS_CELLS; u8Index++)
+		{
+			uint8_t u8CellId = sg_u8CellErrorsNext + u8Index;
+
+			u8Response[1 + u8Index] = 0;
+
+			// Same reverse mapping as MODULE_DETAIL - cells report last to first
+			if ((u8CellId < sg_u8CellErrorsTarget) && (u8CellId < u8CellCount))
 			{
-				if (sg_sFrame.m.sg_u16HighestCellVoltage < u16Voltage)
-				{
-					sg_sFrame.m.sg_u16HighestCellVoltage = u16Voltage;
-				}
-				if (sg_sFrame.m.sg_u16LowestCellVoltage > u16Voltage)
+				uint8_t u8Position = (u8CellCount - 1) - u8CellId;
+
+				if (u8Position < MAX_CELLS)
 				{
-					sg_sFrame.m.sg_u16LowestCellVoltage = u16Voltage;
+					u8Response[1 + u8Index] = sg_u8CellRecordErrors[u8Position];
 				}
-				u32CellVoltageTotalmV += u16Voltage;
-				u8CellVoltageCount++;
 			}
 		}
 
-		if (u8CellVoltageCount)  // got at least some
+		if (false == CANSendMessage( ECANMessageType_ModuleCellErrors, u8Response, CAN_STATUS_RESPONSE_SIZE ))
 		{
-			sg_sFrame.m.sg_u32CellVoltageTotal = u32CellVoltageTotalmV;
-			sg_sFrame.m.sg_u16AverageCellVoltage = (uint16_t)(sg_sFrame.m.sg_u32CellVoltageTotal / u8CellVoltageCount);
-
-			if ((EMODSTATE_ON != sg_eModuleControllerStateCurrent) &&
-			(false == sg_bCellBalancedOnce) &&
-			(sg_sFrame.m.sg_u16HighestCellVoltage >= sg_sFrame.m.sg_u16LowestCellVoltage) &&
-			((sg_sFrame.m.sg_u16HighestCellVoltage - sg_sFrame.m.sg_u16LowestCellVoltage) >= BALANCE_VOLTAGE_THRESHOLD))
-			{
-				sg_bCellBalanceReady = true;
-			}
+			// Queue full - carry on next pass
+			break;
 		}
 
-		if (u8CellTemperatureCount)  // got at least some
+		sg_u8CellErrorsNext += CELL_ERRORS_CELLS;
+		if (sg_u8CellErrorsNext >= sg_u8CellErrorsTarget)
 		{
-			int16_t s16AverageTempRAW = (int16_t)(s32TempTotal / u8CellTemperatureCount);
-			CellDataConvertTemperature(s16AverageTempRAW,&sg_sFrame.m.sg_s16AverageCellTemp);
-			CellDataConvertTemperature(s16HighestCellTempRAW,&sg_sFrame.m.sg_s16HighestCellTemp);
-			CellDataConvertTemperature(s16LowestCellTempRAW,&sg_sFrame.m.sg_s16LowestCellTemp);
+			sg_bSendCellErrors = false;
 		}
+	}
+}
+#endif
 
-	}  // end if (sg_sFrame.m.sg_u16BytesReceived)
-	else
+// Stream the sessions the pack asked for from the SD session index - called every main
+// loop pass, like CellTimingSend(). Each session is a pair of messages, both with the
+// session's low 10 bits as the extended ID sequence number. A session that isn't in RAM
+// costs one SD sector read.
+//
+// MODULE_SESSION			Bytes 0-3 - Frame counter of its first frame, 0xFFFFFFFF if the
+//									index has gone round and written over it
+//							Bytes 4-7 - One past its last frame (so far, if it's still open)
+// MODULE_SESSION_SUMMARY	Bytes 0-3 - time_t it started (low 32 bits)
+//							Bytes 4-5 - Session number (low 16 bits)
+//							Byte 6    - Watchdog resets during the session
+//							Byte 7    - SESSIONLOG_FLAG_* (open, cut short)
+static void SessionSend(void)
+{
+	while( sg_u16SessionSendRemaining )
+	{
+		SSessionRecord sRecord;
+		uint8_t u8Response[CAN_STATUS_RESPONSE_SIZE];
+		uint16_t u16Seq = (uint16_t) (sg_u32SessionSendNext & 0x3ff);
+		EFrameLogCheck eResult = STORE_GetSessionInfo(sg_u32SessionSendNext, &sRecord);
+
+		if (EFRAMELOG_CHECK_WAIT == eResult)
+		{
+			// A frame write has the card - carry on next pass
+			break;
+		}
+		if (EFRAMELOG_CHECK_OK != eResult)
+		{
+			memset((void *) &sRecord, 0, sizeof(sRecord));
+			sRecord.u32StartFrame = 0xFFFFFFFF;
+			sRecord.u32EndFrame = 0xFFFFFFFF;
+		}
+
+		if (false == sg_bSessionSendSummary)
+		{
+			*(uint32_t*)&u8Response[0] = sRecord.u32StartFrame;
+			*(uint32_t*)&u8Response[4] = sRecord.u32EndFrame;
+			if (false == CANSendMessageWithSeq( ECANMessageType_ModuleSession, u8Response, CAN_STATUS_RESPONSE_SIZE, u16Seq ))
+			{
+				// Queue full - carry on next pass
+				break;
+			}
+			sg_bSessionSendSummary = true;
+		}
+
+		*(uint32_t*)&u8Response[0] = (uint32_t) sRecord.u64StartTime;
+		*(uint16_t*)&u8Response[4] = (uint16_t) sg_u32SessionSendNext;
+		u8Response[6] = sRecord.u8WDTCount;
+		u8Response[7] = sRecord.u8Flags;
+		if (false == CANSendMessageWithSeq( ECANMessageType_ModuleSessionSummary, u8Response, CAN_STATUS_RESPONSE_SIZE, u16Seq ))
+		{
+			break;
+		}
+
+		sg_bSessionSendSummary = false;
+		sg_u32SessionSendNext++;
+		sg_u16SessionSendRemaining--;
+	}
+}
+
+// Moves the SD frame scrub along a step a main loop pass - a sector read or a slice of a
+// frame's CRC. Each frame that doesn't check out is reported as FRAME_CHECK:
+//
+// Bytes 0-3 - Frame counter
+// Byte 4    - EFrameLogCheck (not on the card, corrupt, card didn't read)
+// Byte 5    - FRAME_CHECK_SOURCE_SCRUB
+// Bytes 6-7 - Bad frames so far
+//
+// When it's done, a last FRAME_CHECK has the frames checked in bytes 0-3, and
+// FRAME_CHECK_SCRUB_FINISHED in byte 4. A frame transfer has the card first.
+static void FrameScrubService(void)
+{
+	uint32_t u32Frame;
+	EFrameLogCheck eResult;
+
+	if (false == sg_bFrameScrubActive)
+	{
+		return;
+	}
+
+	// A bad frame still to report holds the scrub up
+	if (EFRAMELOG_CHECK_OK != sg_eFrameScrubBad)
+	{
+		if (false == FrameCheckSend(sg_u32FrameScrubBadFrame, (uint8_t) sg_eFrameScrubBad,
+									FRAME_CHECK_SOURCE_SCRUB, sg_u16FrameScrubBad))
+		{
+			return;
+		}
+		sg_eFrameScrubBad = EFRAMELOG_CHECK_OK;
+	}
+
+	if (0 == STORE_ScrubRemaining())
+	{
+		if (FrameCheckSend(sg_u32FrameScrubChecked, FRAME_CHECK_SCRUB_FINISHED,
+						   FRAME_CHECK_SOURCE_SCRUB, sg_u16FrameScrubBad))
+		{
+			sg_bFrameScrubActive = false;
+		}
+		return;
+	}
+
+	if (FRAME_TRANSFER_IDLE != sg_eFrameTransferState)
+	{
+		return;
+	}
+
+	eResult = STORE_ScrubStep(&u32Frame);
+	if (EFRAMELOG_CHECK_BUSY == eResult)
+	{
+		return;
+	}
+
+	sg_u32FrameScrubChecked++;
+	if (EFRAMELOG_CHECK_OK != eResult)
+	{
+		if (sg_u16FrameScrubBad < 0xffff)
+		{
+			sg_u16FrameScrubBad++;
+		}
+		sg_u32FrameScrubBadFrame = u32Frame;
+		sg_eFrameScrubBad = eResult;
+
+		// The rest won't read either
+		if (EFRAMELOG_CHECK_READ_FAILED == eResult)
+		{
+			(void) STORE_ScrubStart(0, 0);
+		}
+	}
+}
+
+#ifdef CELL_WINDOW_POLLING
+// Stream the last window reading to the pack as MODULE_DETAIL_BULK messages, unasked -
+// called every main loop pass, like CellDetailBulkSend()
+static void CellWindowSend(void)
+{
+	while( sg_bSendCellWindow )
+	{
+		uint8_t u8Response[CAN_STATUS_RESPONSE_SIZE];
+		uint8_t u8Last = sg_u8CellWindowSentFirst + sg_u8CellWindowSentCount - 1;
+		uint8_t u8Count = (u8Last + 1) - sg_u8CellWindowNext;
+		uint8_t u8BitPos = 2;
+		uint8_t u8Index;
+
+		if (u8Count > CELL_DETAIL_BULK_CELLS)
+		{
+			u8Count = CELL_DETAIL_BULK_CELLS;
+		}
+
+		memset((void *) u8Response, 0, sizeof(u8Response));
+		u8Response[0] = sg_u8CellWindowNext;
+		CellDetailBulkPack(&u8Response[1], 0, u8Count, 2);
+
+		for (u8Index = 0; u8Index < u8Count; u8Index++)
+		{
+			// The window came in last cell first, like the whole string
+			uint8_t u8Window = u8Last - (sg_u8CellWindowNext + u8Index);
+
+			u8BitPos = CellDetailBulkPackCell(&u8Response[1], u8BitPos,
+											  (u8Window < sg_u8CellWindowReceived) ? &sg_sCellWindow[u8Window] : NULL);
+		}
+
+		if (false == CANSendMessage( ECANMessageType_ModuleCellDetailBulk, u8Response, CAN_STATUS_RESPONSE_SIZE ))
+		{
+			// Queue full - carry on next pass
+			break;
+		}
+
+		sg_u8CellWindowNext += u8Count;
+		if (sg_u8CellWindowNext > u8Last)
+		{
+			sg_bSendCellWindow = false;
+		}
+	}
+}
+
+// After a full string reading - centres the automatic window on the hottest cell
+static void CellWindowAutoUpdate(void)
+{
+	volatile CellData* stringData = GetLatestCompleteString(&sg_sFrame);
+	uint8_t u8CellCount = sg_sFrame.m.sg_u8LastCompleteCellCount;
+	uint8_t u8Hottest = 0xff;
+	int16_t s16Hottest = 0;
+	uint8_t u8Position;
+
+	if (u8CellCount > MAX_CELLS)
+	{
+		u8CellCount = MAX_CELLS;
+	}
+
+	for (u8Position = 0; u8Position < u8CellCount; u8Position++)
+	{
+		int16_t s16Temperature;
+
+		if (CellDataConvertTemperature(stringData[u8Position].temperature, &s16Temperature) &&
+			((0xff == u8Hottest) || (s16Temperature > s16Hottest)))
+		{
+			u8Hottest = u8Position;
+			s16Hottest = s16Temperature;
+		}
+	}
+
+	if ((0xff == u8Hottest) || (sg_u8CellWindowCount > u8CellCount))
+	{
+		// Nothing to go by - keep the last one
+		return;
+	}
+
+	// Position to cell ID, then back off half the window, keeping it on the string
+	u8Hottest = (u8CellCount - 1) - u8Hottest;
+	sg_u8CellWindowAutoFirst = (u8Hottest > (sg_u8CellWindowCount >> 1)) ? (u8Hottest - (sg_u8CellWindowCount >> 1)) : 0;
+	if ((sg_u8CellWindowAutoFirst + sg_u8CellWindowCount) > u8CellCount)
+	{
+		sg_u8CellWindowAutoFirst = u8CellCount - sg_u8CellWindowCount;
+	}
+}
+
+// Start of a reading - decides whether it's the whole string or just the window. A full
+// string comes every sg_u8CellWindowFullEvery readings, and whenever the window doesn't fit.
+static void CellWindowReadingStart(void)
+{
+	uint8_t u8CellCount = sg_sFrame.m.sg_u8CellCountExpected;
+	uint8_t u8First = (CELL_WINDOW_AUTO == sg_u8CellWindowFirst) ? sg_u8CellWindowAutoFirst : sg_u8CellWindowFirst;
+
+	sg_bRXWindow = false;
+
+	if ((0 == sg_u8CellWindowCount) ||
+		(0 == sg_sFrame.m.sg_u8LastCompleteCellCount) ||
+		((u8First + sg_u8CellWindowCount) > u8CellCount) ||
+#ifdef VUART_RATE_NEGOTIATION
+		(ERATE_SETTLE != sg_eRateState) ||		// rate changes need the whole string
+#endif
+		((sg_u8CellWindowReadings + 1) >= sg_u8CellWindowFullEvery))
+	{
+		sg_u8CellWindowReadings = 0;
+		return;
+	}
+
+	// The window buffer is about to be refilled - anything not sent yet is stale anyway
+	sg_bSendCellWindow = false;
+
+	sg_u8CellWindowReadings++;
+	sg_bRXWindow = true;
+	sg_u8RXWindowFirst = u8First;
+	sg_u8RXWindowCount = sg_u8CellWindowCount;
+	sg_u8RXWindowPosition = u8CellCount - (u8First + sg_u8CellWindowCount);
+}
+
+// End of a reading. Returns false if it was the whole string. A window goes to the pack
+// and nowhere else - it isn't a string reading.
+static bool CellWindowReadingEnd(void)
+{
+	if (false == sg_bRXWindow)
+	{
+		return(false);
+	}
+
+	sg_bRXWindow = false;
+
+	if (sg_u8CellWindowReceived)
+	{
+		sg_u8CellWindowSentFirst = sg_u8RXWindowFirst;
+		sg_u8CellWindowSentCount = sg_u8RXWindowCount;
+		sg_u8CellWindowNext = sg_u8RXWindowFirst;
+		sg_bSendCellWindow = true;
+	}
+
+	return(true);
+}
+#endif
+
+// A frame write started by FrameStore() has finished (called from STORE)
+void FrameWriteCallback(bool bWritten)
+{
+	// Only increment frame counter if we successfully wrote to SD
+	// Frame counter tracks frames on SD card, not frames in buffer
+	if (bWritten)
+	{
+		FrameCounter_Increment();
+		sg_sFrame.m.frameCounter = FrameCounter_Get();
+	}
+	else
+	{
+		sg_bSDCardReady = false;
+	}
+}
+
+// Frame is full - copy it to frameBuffer and start the next one. Returns false, and
+// leaves the frame as it is, while the last one is still on its way to the card.
+static bool FrameStore(void)
+{
+	bool bWriteSuccess;
+
+	if (STORE_WriteBusy())
+	{
+		return(false);
+	}
+
+	// STORE_WriteFrame always copies to frameBuffer, optionally starts writing it to SD.
+	// The main loop runs the write and FrameWriteCallback() gets the outcome.
+	bWriteSuccess = STORE_WriteFrame(&sg_sFrame, sg_bSDCardReady, sg_bSDWriteEnabled);
+
+	sg_bSDCardReady = bWriteSuccess;
+
+	// Reset per-frame statistics for new frame
+	// Min/max cell count tracks range within this frame's string readings
+	sg_sFrame.m.sg_u8CellCPUCountFewest = 0xff;
+	sg_sFrame.m.sg_u8CellCPUCountMost = 0;
+
+	return(true);
+}
+
+#ifdef FRAME_DELTA_STRINGS
+static void StringDeltaReadingEnd(void)
+{
+	// The first reading of a frame has nothing before it to keep - that went out with
+	// the last frame. Older readings dropped to make room come off the count.
+	bool bKeep = (sg_sFrame.m.readingCount > 0);
+
+	sg_sFrame.m.readingCount -= StringDelta_End(&sg_sStringDelta, bKeep);
+	sg_sFrame.m.readingCount++;
+
+	// Write the frame out once another reading might not fit. While a frame transfer,
+	// or the last frame's write, holds it up, the oldest readings make way for new ones.
+	if (StringDelta_Full(&sg_sStringDelta) &&
+		(sg_eFrameTransferState == FRAME_TRANSFER_IDLE) &&
+		FrameStore())
+	{
+		// The latest stays, so CAN detail requests still have it
+		sg_sFrame.m.readingCount = 0;
+		StringDelta_Clear(&sg_sStringDelta);
+	}
+}
+#endif
+
+static void CellStringProcess(uint8_t *pu8Response)  // no longer does float calcs on every cell, doesn't do anything with pu8Response
+{
+#ifdef STRING_PROCESS_PROFILING
+	SProfileStamp sStart;
+	uint16_t u16ElapsedUs;
+
+	ProfileStamp(&sStart);
+#endif
+
+	// Process even if no bytes received - need to handle timeout case
+	// When sg_u16BytesReceived == 0, sg_u8CellCPUCount will also be 0
+	// This will trigger the mismatch counter if we're expecting cells
+
+	// Only process cell data if we actually received some
+	if (sg_sFrame.m.sg_u16BytesReceived)
+	{
+		// Assume there are no I2C errors...
+		sg_sFrame.m.sg_u8CellFirstI2CError = 0xff;
+
+		// Update comm stats
+		if (sg_sFrame.m.sg_u8CellCPUCountFewest > sg_sFrame.m.sg_u8CellCPUCount)
+		{
+			sg_sFrame.m.sg_u8CellCPUCountFewest = sg_sFrame.m.sg_u8CellCPUCount;
+			sg_bSendCellCommStatus = true;
+		}
+		if (sg_sFrame.m.sg_u8CellCPUCountMost < sg_sFrame.m.sg_u8CellCPUCount)
+		{
+			sg_sFrame.m.sg_u8CellCPUCountMost = sg_sFrame.m.sg_u8CellCPUCount;
+			sg_bSendCellCommStatus = true;
+		}
+
+		// Auto-discover cell count if expected count is 0 or unprogrammed
+		// Update expected count if we receive more cells than expected
+		// This works even if unique ID is programmed but cell count is not
+		if (sg_sFrame.m.sg_u8CellCountExpected == 0)
+		{
+			if (sg_sFrame.m.sg_u8CellCPUCount > 0)
+			{
+				CellCountExpectedSet(sg_sFrame.m.sg_u8CellCPUCount);
+			}
+		}
+		else if (!sg_bEEPROMValid)
+		{
+			// EEPROM fully unprogrammed - allow cell count to grow
+			if (sg_sFrame.m.sg_u8CellCPUCount > sg_sFrame.m.sg_u8CellCountExpected)
+			{
+				CellCountExpectedSet(sg_sFrame.m.sg_u8CellCPUCount);
+			}
+		}
+
+		// OK, we have at least one. Let's see if the cell count is
+		// reasonable. If it isn't, flag it as a framing error
+		if (CELL_RECORD_PARTIAL(sg_sFrame.m.sg_u16BytesReceived)  // number of bytes not evenly divisible by bytes per cell
+#ifdef CELL_RECORD_CRC
+			|| sg_u8RXRecordErrors		// or records that didn't check out
+#endif
+			)
+		{
+			if (sg_sFrame.m.sg_u8MCRXFramingErrors != 0xff)
+			{
+				sg_sFrame.m.sg_u8MCRXFramingErrors++;
+				sg_bSendCellCommStatus = true;
+			}
+		}
+
+		// Finalize the string statistics accumulated by CellRecordsAssemble() as the cells arrived
+		sg_sFrame.m.sg_u16HighestCellVoltage = sg_sStringStats.u16VoltageHighest;
+		sg_sFrame.m.sg_u16LowestCellVoltage  = sg_sStringStats.u16VoltageLowest;
+		sg_sFrame.m.sg_u16AverageCellVoltage = 0;
+		sg_sFrame.m.sg_s16HighestCellTemp = -32768;
+		sg_sFrame.m.sg_s16LowestCellTemp = 32767;
+		sg_sFrame.m.sg_s16AverageCellTemp = 0;
+
+		if (sg_sStringStats.bDischargeOn)
+		{
+			// update the flag
+			sg_sFrame.m.bDischargeOn = true;
+		}
+
+		if (sg_sStringStats.u8VoltageCount)  // got at least some
+		{
+			sg_sFrame.m.sg_u32CellVoltageTotal = sg_sStringStats.u32VoltageTotal;
+			sg_sFrame.m.sg_u16AverageCellVoltage = (uint16_t)(sg_sFrame.m.sg_u32CellVoltageTotal / sg_sStringStats.u8VoltageCount);
+
+			if ((EMODSTATE_ON != sg_eModuleControllerStateCurrent) &&
+			(false == sg_bCellBalancedOnce) &&
+			(sg_sFrame.m.sg_u16HighestCellVoltage >= sg_sFrame.m.sg_u16LowestCellVoltage) &&
+			((sg_sFrame.m.sg_u16HighestCellVoltage - sg_sFrame.m.sg_u16LowestCellVoltage) >= BALANCE_VOLTAGE_THRESHOLD))
+			{
+				sg_bCellBalanceReady = true;
+			}
+		}
+
+		if (sg_sStringStats.u8TemperatureCount)  // got at least some
+		{
+			int16_t s16AverageTempRAW = (int16_t)(sg_sStringStats.s32TemperatureTotal / sg_sStringStats.u8TemperatureCount);
+			CellDataConvertTemperature(s16AverageTempRAW,&sg_sFrame.m.sg_s16AverageCellTemp);
+			CellDataConvertTemperature(sg_sStringStats.s16TemperatureHighest,&sg_sFrame.m.sg_s16HighestCellTemp);
+			CellDataConvertTemperature(sg_sStringStats.s16TemperatureLowest,&sg_sFrame.m.sg_s16LowestCellTemp);
+		}
+
+	}  // end if (sg_sFrame.m.sg_u16BytesReceived)
+	else
 	{
 		// No bytes received - complete VUART failure
 		// sg_u8CellCPUCount will remain 0 from vUARTRXEnd()
 	}
 
+#ifdef STRING_PROCESS_PROFILING
+	// Statistics are done - reported in CommStat1 (frame storage below is not included)
+	u16ElapsedUs = ProfileElapsedUs(&sStart);
+	if (u16ElapsedUs > sg_u16StringProcessUsMax)
+	{
+		sg_u16StringProcessUsMax = u16ElapsedUs;
+	}
+#endif
+
 	// Always update the last complete cell count - even if 0
 	// This tells pack controller how many cells we actually received
 	// Pack controller will mark data as stale if this doesn't match expected
 	sg_sFrame.m.sg_u8LastCompleteCellCount = sg_sFrame.m.sg_u8CellCPUCount;
 
+#ifdef FRAME_DELTA_STRINGS
+	// The reading that just came in becomes the latest, the one before it is packed
+	// behind it. Missing cells are INVALID.
+	StringDeltaReadingEnd();
+#else
 	// Advance circular buffer to next slot after WRITE frame
 	// This happens regardless of how many cells reported (could be partial or zero)
 	// Missing cells retain their INVALID markers
@@ -2453,191 +4208,698 @@ static void CellStringProcess(uint8_t *pu8Response)  // no longer does float cal
 	{
 		if (sg_sFrame.m.readingCount < sg_sFrame.m.nstrings)
 		{
-			sg_sFrame.m.readingCount++;
+			sg_sFrame.m.readingCount++;
+		}
+
+		// Check if we're about to wrap around (buffer will be full after this write)
+		// If so, write the complete frame to frameBuffer before wrapping. If the last
+		// frame is still being written, the wrap waits for it - FrameReadStart() tries
+		// again before the next reading, and if the card's still busy that reading goes
+		// in the last slot again and it's tried after it. During a transfer it wraps.
+		if ((sg_sFrame.m.currentIndex == sg_sFrame.m.nstrings - 1) &&
+		    (sg_sFrame.m.readingCount >= sg_sFrame.m.nstrings) &&
+		    (sg_eFrameTransferState == FRAME_TRANSFER_IDLE) &&
+		    (false == FrameStore()))
+		{
+			sg_bFrameStorePending = true;
+		}
+		else
+		{
+			// Now advance to next slot (may wrap to 0)
+			sg_bFrameStorePending = false;
+			sg_sFrame.m.currentIndex = (sg_sFrame.m.currentIndex + 1) % sg_sFrame.m.nstrings;
+		}
+	}
+#endif
+
+	// Don't send unsolicited status - Pack Controller will request when needed
+
+
+}
+
+void FrameInit(bool  bFullInit)  // receives true if full init is needed, false if only cell reading data is to be reset
+{
+		// initialize frame structure
+		if (bFullInit || (FRAME_VALID_SIG != sg_sFrame.m.validSig)) // full init or invalid frame
+		{
+			memset(&sg_sFrame,0,sizeof(sg_sFrame)); // set all to 0
+			sg_sFrame.m.frameBytes = sizeof(sg_sFrame);
+			sg_sFrame.m.validSig = FRAME_VALID_SIG;
+#ifdef FRAME_DELTA_STRINGS
+			sg_sFrame.m.version = FRAME_VERSION_DELTA;
+#else
+			sg_sFrame.m.version = FRAME_VERSION;
+#endif
+
+			// Calculate cell buffer start offset (4-byte aligned)
+			// This is the offset from the start of the frame to where cell data begins
+			uint16_t metadataSize = sizeof(FrameMetadata);
+			// Round up to next 4-byte boundary
+			sg_sFrame.m.cellBufferStart = (uint8_t)((metadataSize + 3) & ~3);
+
+			sg_sFrame.m.moduleUniqueId = ModuleControllerGetUniqueID();
+			sg_sFrame.m.sg_u8CellFirstI2CError = 0xff;
+			sg_sFrame.m.sg_u8CellCPUCountFewest = 0xff;
+			sg_sFrame.m.sg_u8CellCPUCountMost = 0;  // Explicitly init to 0 (should already be 0 from memset, but being explicit)
+
+			// Initialize current fields to 0A (0x8000 = 32768)
+			// Current formula: Amps = -655.36 + raw * 0.02, so 0A = 32768
+			sg_sFrame.m.u16maxCurrent = 0x8000;
+			sg_sFrame.m.u16minCurrent = 0x8000;
+			sg_sFrame.m.u16avgCurrent = 0x8000;
+
+			// Load cell count expected from EEPROM, or use default for unprogrammed values
+			uint8_t u8CellCountEEPROM = EEPROMRead(EEPROM_EXPECTED_CELL_COUNT);
+			if ((u8CellCountEEPROM == 0xFF) || (u8CellCountEEPROM == 0x00))
+			{
+				// Cell count unprogrammed - start with 0 cells expected
+				// This will auto-increment as cells are discovered
+				CellCountExpectedSet(0);
+			}
+			else
+			{
+				// Use programmed cell count
+				CellCountExpectedSet(u8CellCountEEPROM);
+			}
+
+			// Initialize frame counter from EEPROM
+			FrameCounter_Init();
+			sg_sFrame.m.frameCounter = FrameCounter_Get();
+		}
+		else  // do only if partial init, in full init the memset takes care of all this
+		{
+#ifdef FRAME_DELTA_STRINGS
+			// Start packing a new reading - any cells that don't report are packed as
+			// invalid. The latest reading stays as it is until this one ends.
+			StringDelta_Start(&sg_sStringDelta);
+#else
+			// Initialize current buffer slot with invalid markers at READ frame start
+			// Any cells that don't report will retain these markers
+			volatile CellData* stringData = GetStringDataVolatile(&sg_sFrame);
+			uint8_t i;
+			for (i = 0; i < sg_sFrame.m.sg_u8CellCountExpected; i++) {
+				stringData[i].voltage = INVALID_CELL_VOLTAGE;
+				stringData[i].temperature = INVALID_CELL_TEMP;
+			}
+#endif
+
+			sg_sFrame.m.bDischargeOn = false;
+			sg_sFrame.m.sg_u16CellCPUI2CErrors = 0;
+			sg_sFrame.m.sg_u8CellFirstI2CError = 0;
+			sg_sFrame.m.sg_u8CellCPUCount = 0;     // for the frame
+			sg_sFrame.m.sg_u8MCRXFramingErrors = 0;
+			
+			// Only reset voltage/temp stats if we have no valid data
+			// This prevents the alternating zero issue when status is polled
+			if (sg_sFrame.m.sg_u32CellVoltageTotal == 0)
+			{
+				sg_sFrame.m.sg_u32CellVoltageTotal = 0;		// All cell CPU voltages added up (in millivolts)
+				sg_sFrame.m.sg_u16HighestCellVoltage = 0;
+				sg_sFrame.m.sg_u16LowestCellVoltage = 0;
+				sg_sFrame.m.sg_u16AverageCellVoltage = 0;
+				sg_sFrame.m.sg_s16HighestCellTemp = TEMPERATURE_BASE;	// 0C default, in case we get no readings
+				sg_sFrame.m.sg_s16LowestCellTemp = TEMPERATURE_BASE;		// 0C default, in case we get no readings
+				sg_sFrame.m.sg_s16AverageCellTemp = TEMPERATURE_BASE;	// 0C default, in case we get no readings
+			}
+		}
+		
+		// initialize other housekeeping
+		sg_u8CurrentBufferIndex=0xff;  // this indicates the buffer is empty, to be filled with first reading
+
+}
+
+// Compressed variant of FrameTransferSegmentFill() - encodes the next segment on the fly.
+// The NACK bitmap covers 8 byte blocks of the decoded frame, so a resend round
+// restarts the encoder at each missing block.
+static bool FrameTransferSegmentFillCompressed(uint16_t* pu16SeqNum, uint8_t* pu8Data, uint8_t* pu8DataLen)
+{
+	uint16_t u16Quad = sg_u16FrameTransferQuad;
+
+	if (sg_bFrameTransferResending)
+	{
+		while ((u16Quad < FRAMECODEC_QUADS) &&
+			   (0 == (sg_u8FrameTransferResend[u16Quad >> 4] & (1 << ((u16Quad >> 1) & 7)))))
+		{
+			u16Quad++;
+		}
+	}
+
+	*pu8DataLen = FrameCodec_EncodeSegment(&sg_sFrameCodec, (const uint8_t*)sg_pFrameToTransfer, &u16Quad, pu8Data);
+	sg_u16FrameTransferQuad = u16Quad;
+
+	if (0 == *pu8DataLen)
+	{
+		return(false);
+	}
+
+	*pu16SeqNum = sg_u8FrameTransferSegment;
+	sg_u8FrameTransferSegment++;
+
+	return(true);
+}
+
+// Supplies frame segments to the CAN burst engine - called from CAN ISR.
+// On a resend round only the segments set in sg_u8FrameTransferResend are supplied.
+static bool FrameTransferSegmentFill(uint16_t* pu16SeqNum, uint8_t* pu8Data, uint8_t* pu8DataLen)
+{
+	uint8_t u8Segment = sg_u8FrameTransferSegment;
+
+	if (sg_bFrameTransferCompressed)
+	{
+		return(FrameTransferSegmentFillCompressed(pu16SeqNum, pu8Data, pu8DataLen));
+	}
+
+	if (sg_bFrameTransferResending)
+	{
+		while ((u8Segment < FRAME_TRANSFER_SEGMENTS) &&
+			   (0 == (sg_u8FrameTransferResend[u8Segment >> 3] & (1 << (u8Segment & 7)))))
+		{
+			u8Segment++;
+		}
+	}
+
+	if (u8Segment >= FRAME_TRANSFER_SEGMENTS)
+	{
+		sg_u8FrameTransferSegment = u8Segment;
+		return(false);
+	}
+
+	memcpy(pu8Data, &((uint8_t*)sg_pFrameToTransfer)[u8Segment << 3], 8);
+
+	// Sequence number goes in extended ID bits 8-17
+	*pu16SeqNum = u8Segment;
+	sg_u8FrameTransferSegment = u8Segment + 1;
+
+	return(true);
+}
+
+// Process frame transfer state machine - called every main loop pass so the
+// START/burst/END hand-offs don't each wait for a 100ms tick
+void ProcessFrameTransfer(void)
+{
+	uint8_t buffer[8];
+
+	switch (sg_eFrameTransferState)
+	{
+		case FRAME_TRANSFER_IDLE:
+			// Nothing to do
+			break;
+
+		case FRAME_TRANSFER_READING:
+			// Waiting for a frame write to give frameBuffer up
+			FrameTransferRead(sg_u32FrameTransferCheckFrame);
+			break;
+
+		case FRAME_TRANSFER_CHECKING:
+		{
+			// A slice of the frame's CRC a pass - it only goes out if it checks out
+			EFrameLogCheck eResult = STORE_CheckFrameStep();
+
+			if (EFRAMELOG_CHECK_OK == eResult)
+			{
+				FrameTransferBegin();
+			}
+			else
+			if (EFRAMELOG_CHECK_BUSY != eResult)
+			{
+				sg_eFrameTransferCheck = eResult;
+				sg_eFrameTransferState = FRAME_TRANSFER_SENDING_CHECK;
+			}
+			break;
+		}
+
+		case FRAME_TRANSFER_SENDING_CHECK:
+			// A range goes on past a corrupt frame, but stops at the first one that isn't
+			// on the card, or if the card doesn't read
+			if (EFRAMELOG_CHECK_CORRUPT != sg_eFrameTransferCheck)
+			{
+				sg_u16FrameRangeRemaining = 0;
+			}
+
+			if (FrameCheckSend(sg_u32FrameTransferCheckFrame, (uint8_t) sg_eFrameTransferCheck,
+							   FRAME_CHECK_SOURCE_TRANSFER, sg_u16FrameRangeRemaining))
+			{
+				sg_eFrameTransferState = FRAME_TRANSFER_NEXT_FRAME;
+			}
+			break;
+
+		case FRAME_TRANSFER_SENDING_START:
+		{
+			uint16_t u16Segments = FRAME_TRANSFER_SEGMENTS;
+
+			// Compressed if the pack asked for it and it actually saves segments.
+			// A dry run of the encoder gives the exact segment count for START.
+			sg_bFrameTransferCompressed = false;
+			if (sg_u8FrameTransferFlags & FRAME_TRANSFER_FLAG_COMPRESSED)
+			{
+				uint16_t u16Quad = 0;
+				uint16_t u16Compressed = 0;
+
+				FrameCodec_Init(&sg_sFrameCodec, (const uint8_t*)sg_pFrameToTransfer);
+				while (FrameCodec_EncodeSegment(&sg_sFrameCodec, (const uint8_t*)sg_pFrameToTransfer, &u16Quad, buffer))
+				{
+					u16Compressed++;
+				}
+
+				if (u16Compressed < FRAME_TRANSFER_SEGMENTS)
+				{
+					sg_bFrameTransferCompressed = true;
+					u16Segments = u16Compressed;
+				}
+			}
+
+			// Send start message with frame counter
+			*(uint32_t*)&buffer[0] = sg_pFrameToTransfer->m.frameCounter;
+			*(uint16_t*)&buffer[4] = u16Segments + 1;  // Total messages (1 start + data segments + 1 end)
+			*(uint16_t*)&buffer[6] = sg_u16FrameRangeRemaining;     // Frames still to come in a range request
+
+			// Data segment encoding goes in the START sequence number
+			if (CANSendMessageWithSeq(ECANMessageType_FrameTransferStart, buffer, 8,
+									  sg_bFrameTransferCompressed ? FRAME_TRANSFER_ENCODING_COMPRESSED : FRAME_TRANSFER_ENCODING_RAW))
+			{
+				sg_eFrameTransferState = FRAME_TRANSFER_SENDING_DATA;
+				sg_u8FrameTransferSegment = 0;
+			}
+			break;
+		}
+
+		case FRAME_TRANSFER_SENDING_DATA:
+			// Hand the data segments to the CAN burst engine - it refills the spare
+			// MOBs from the TX complete interrupt until FrameTransferSegmentFill() runs dry
+			sg_u8FrameTransferSegment = 0;
+			sg_u16FrameTransferQuad = 0;
+			if (CANBurstStart(ECANMessageType_FrameTransferData, FrameTransferSegmentFill))
+			{
+				sg_u8FrameTransferBurstSegment = sg_u8FrameTransferSegment;
+				sg_u8FrameTransferTimeoutTicks = FRAME_TRANSFER_BURST_TIMEOUT_TICKS;
+				sg_eFrameTransferState = FRAME_TRANSFER_BURSTING;
+			}
+			break;
+
+		case FRAME_TRANSFER_BURSTING:
+			// The burst has to keep moving. CANCheckTxStatus() fails it if a MOB never
+			// completes, but if it stalls any other way, don't hold the frame for good.
+			if (CANBurstActive() && (sg_u8FrameTransferSegment != sg_u8FrameTransferBurstSegment))
+			{
+				sg_u8FrameTransferBurstSegment = sg_u8FrameTransferSegment;
+				sg_u8FrameTransferTimeoutTicks = FRAME_TRANSFER_BURST_TIMEOUT_TICKS;
+			}
+			else
+			if (CANBurstActive() && (0 == sg_u8FrameTransferTimeoutTicks))
+			{
+				CANBurstAbort();
+			}
+
+			if (CANBurstActive())
+			{
+				// Work the END CRC out a slice at a time while the segments go
+				FrameTransferCrcStep(FRAME_TRANSFER_CRC_STEP_BYTES);
+
+				// The bus is busy with this frame - read ahead into the next one.
+				// frameBuffer is still on the wire, so only the STORE sector buffer is free.
+				if (sg_u16FrameRangeRemaining && (false == sg_bFrameRangePrefetched))
+				{
+					sg_bFrameRangePrefetched = true;
+					(void) STORE_PrefetchFrame(sg_u32FrameRangeNext);
+				}
+			}
+			else
+			{
+				if (CANBurstFailed() || (0 == sg_u8FrameTransferTimeoutTicks))
+				{
+					// Bus trouble or a stalled burst - give up on the frame and any range, the pack will re-request
+					sg_eFrameTransferState = FRAME_TRANSFER_IDLE;
+					sg_pFrameToTransfer = NULL;
+					sg_u16FrameRangeRemaining = 0;
+				}
+				else
+				{
+					// All data sent, move to end.  The next NACK starts a fresh bitmap.
+					sg_bFrameTransferResending = false;
+					memset(sg_u8FrameTransferResend, 0, sizeof(sg_u8FrameTransferResend));
+					sg_eFrameTransferState = FRAME_TRANSFER_SENDING_END;
+				}
+			}
+			break;
+
+		case FRAME_TRANSFER_SENDING_END:
+		{
+			// CRC32 of entire frame - whatever the burst didn't get to. Resend rounds
+			// and retries for a full TX queue have it already.
+			FrameTransferCrcStep(sizeof(FrameData));
+
+			*(uint32_t*)&buffer[0] = sg_u32FrameTransferCrc;
+			buffer[4] = sg_u8FrameTransferResendRounds;	// 0 = first pass, >0 = after resends
+			buffer[5] = 0;
+			buffer[6] = 0;
+			buffer[7] = 0;
+
+			if (CANSendMessage(ECANMessageType_FrameTransferEnd, buffer, 8))
+			{
+				// Hold the frame buffer until the pack ACKs or NACKs it
+				sg_u8FrameTransferTimeoutTicks = FRAME_TRANSFER_ACK_TIMEOUT_TICKS;
+				sg_eFrameTransferState = FRAME_TRANSFER_WAIT_ACK;
+			}
+			break;
+		}
+
+		case FRAME_TRANSFER_WAIT_ACK:
+			if (0 == sg_u8FrameTransferTimeoutTicks)
+			{
+				// No answer (or a pack that doesn't ACK) - done either way
+				sg_eFrameTransferState = FRAME_TRANSFER_NEXT_FRAME;
+			}
+			break;
+
+		case FRAME_TRANSFER_NEXT_FRAME:
+			sg_eFrameTransferState = FRAME_TRANSFER_IDLE;
+			sg_pFrameToTransfer = NULL;  // Clear pointer
+
+			if (sg_u16FrameRangeRemaining)
+			{
+				uint32_t u32Frame = sg_u32FrameRangeNext;
+
+				sg_u16FrameRangeRemaining--;
+				sg_u32FrameRangeNext += sg_u8FrameRangeStep;
+
+				FrameTransferRead(u32Frame);
+			}
+			break;
+	}
+}
+
+static void FrameReadStart(void);
+
+// Time string readings as they're processed. Only back to back readings are timed -
+// timer 1 wraps every 2.1 seconds, which is far longer than a frame.
+static void StringReadingTime(void)
+{
+	SProfileStamp sNow;
+
+	if (0 == sg_sFrame.m.sg_u16BytesReceived)
+	{
+		sg_bStringReadingTimed = false;
+		return;
+	}
+
+	ProfileStamp(&sNow);
+
+	if (sg_bStringReadingTimed)
+	{
+		sg_u16StringIntervalMs = (uint16_t) (((uint32_t) (uint16_t) (sNow.u16Timer1 - sg_u16StringReadingTimer1) * 1000) / TIMER1_CLOCKS_PER_SECOND);
+	}
+
+	sg_u16StringReadingTimer1 = sNow.u16Timer1;
+	sg_bStringReadingTimed = true;
+
+	if (sg_u16StringReadings != 0xffff)
+	{
+		sg_u16StringReadings++;
+	}
+}
+
+// Follow the string - the frame period becomes the last full string's round trip plus
+// the guard, within the bounds. Anything short of a full string goes back to the maximum,
+// so a string cut off by a short frame can't keep the frames short.
+static void FramePeriodUpdate(void)
+{
+	uint16_t u16PeriodMs = sg_u16FramePeriodMaxMs;
+	uint16_t u16PeriodTimer1;
+	uint8_t u8SREG;
+
+#ifndef FAKE_CELL_DATA
+	if (sg_sFrame.m.sg_u8CellCountExpected &&
+		(sg_sFrame.m.sg_u8CellCPUCount == sg_sFrame.m.sg_u8CellCountExpected))
+	{
+		uint16_t u16LastByte;
+
+		u8SREG = SREG;
+		cli();
+		u16LastByte = sg_u16StringLastByteTimer1;
+		SREG = u8SREG;
+
+		sg_u16StringRoundTripMs = FRAME_PERIOD_TIMER1_TO_MS((uint16_t) (u16LastByte - sg_u16StringRequestTimer1));
+		u16PeriodMs = sg_u16StringRoundTripMs + FRAME_PERIOD_GUARD_MS;
+
+		if (u16PeriodMs < sg_u16FramePeriodMinMs)
+		{
+			u16PeriodMs = sg_u16FramePeriodMinMs;
+		}
+		if (u16PeriodMs > sg_u16FramePeriodMaxMs)
+		{
+			u16PeriodMs = sg_u16FramePeriodMaxMs;
+		}
+	}
+#endif
+
+	u16PeriodTimer1 = FRAME_PERIOD_MS_TO_TIMER1(u16PeriodMs);
+
+	// Takes effect from the next frame boundary
+	u8SREG = SREG;
+	cli();
+	sg_u16FramePeriodTimer1 = u16PeriodTimer1;
+	SREG = u8SREG;
+}
+
+// A string reading is in - process it, then the timing and the cell count checks
+static void StringReadingEnd(uint8_t *pu8Reply)
+{
+	CellStringProcess(pu8Reply);  // get it processed
+
+	StringReadingTime();
+	FramePeriodUpdate();
+#ifdef VUART_RATE_NEGOTIATION
+	VUARTRateUpdate();
+#endif
+#ifdef CELL_WINDOW_POLLING
+	CellWindowAutoUpdate();
+#endif
+
+	if (ESTRING_OPERATIONAL == sg_eStringPowerState)
+	{
+		// We're operational. If we didn't get the number of cells we expect
+		// increment sg_u8SequentailCellCountMismatches. If this exceeds
+		// SEQUENTIAL_COUNT_MISMATCH_THRESHOLD, reset the chain. Setting to 0 will
+		// disable the cell string reset.
+		if ((sg_sFrame.m.sg_u8CellCPUCount != sg_sFrame.m.sg_u8CellCountExpected) &&
+		(sg_sFrame.m.sg_u8CellCountExpected))
+		{
+			#if (SEQUENTIAL_COUNT_MISMATCH_THRESHOLD > 0)  // Feature enabled at compile time
+			{
+				++sg_u8SequentailCellCountMismatches;
+				if ((sg_u8SequentailCellCountMismatches >= SEQUENTIAL_COUNT_MISMATCH_THRESHOLD))
+				{
+					sg_eStringPowerState = ESTRING_OFF;  // this will turn string off on the start of read frame
+					sg_u8SequentailCellCountMismatches = 0; // reset the timer
+				}
+			}
+			#endif
+		}
+		else
+		{
+			// All good
+			// Clear running count since we got a good read
+			sg_u8SequentailCellCountMismatches = 0;
 		}
+	}
+}
 
-		// Check if we're about to wrap around (buffer will be full after this write)
-		// If so, write the complete frame to frameBuffer before wrapping
-		if ((sg_sFrame.m.currentIndex == sg_sFrame.m.nstrings - 1) &&
-		    (sg_sFrame.m.readingCount >= sg_sFrame.m.nstrings) &&
-		    (sg_eFrameTransferState == FRAME_TRANSFER_IDLE))
-		{
-			// STORE_WriteFrame always copies to frameBuffer, optionally writes to SD
-			bool bWriteSuccess = STORE_WriteFrame(&sg_sFrame, sg_bSDCardReady, sg_bSDWriteEnabled);
+// Start of WRITE frame - wrap up the string reading that just came in, process,
+// store and report it
+static void FrameWriteStart(uint8_t *pu8Reply)
+{
+	CellStringPowerStateMachine(); // if we just turned off the string it will clear out frame
 
-			// Only increment frame counter if we successfully wrote to SD
-			// Frame counter tracks frames on SD card, not frames in buffer
-			if (bWriteSuccess && sg_bSDCardReady && sg_bSDWriteEnabled)
-			{
-				FrameCounter_Increment();
-				sg_sFrame.m.frameCounter = FrameCounter_Get();
-			}
+	vUARTRXEnd();  // wrap up previous read
+#ifdef CELL_WINDOW_POLLING
+	if (CellWindowReadingEnd())
+	{
+		// Only a window - already on its way to the pack
+	}
+	else
+#endif
+	{
+		StringReadingEnd(pu8Reply);
+	}
+	
+	if( sg_bSendAnnouncement )  //we should announce ourselves
+	{
+		bool bSent;
 
-			sg_bSDCardReady = bWriteSuccess;
+		// Reply with general status
+		pu8Reply[0] = (uint8_t) FW_BUILD_NUMBER;
+		pu8Reply[1] = (uint8_t) (FW_BUILD_NUMBER >> 8);
+		pu8Reply[2] = MANUFACTURE_ID;
+		pu8Reply[3] = PART_ID;
+		*((uint32_t*)&pu8Reply[4]) = sg_sFrame.m.moduleUniqueId;
 
-			// Reset per-frame statistics for new frame
-			// Min/max cell count tracks range within this frame's string readings
-			sg_sFrame.m.sg_u8CellCPUCountFewest = 0xff;
-			sg_sFrame.m.sg_u8CellCPUCountMost = 0;
+		bSent = CANSendMessage( ECANMessageType_ModuleAnnouncement, pu8Reply, CAN_STATUS_RESPONSE_SIZE );
+
+		if( bSent )
+		{
+			sg_bSendAnnouncement = false;
 		}
+	// Send a module announcement if unregistered
 
-		// Now advance to next slot (may wrap to 0)
-		sg_sFrame.m.currentIndex = (sg_sFrame.m.currentIndex + 1) % sg_sFrame.m.nstrings;
 	}
+	// Only send the announcement if the module isn't registered
+	// disable can interrupts as they seem to result in misreading of status
 
-	// Don't send unsolicited status - Pack Controller will request when needed
-
+#ifdef PIPELINED_FRAMES
+	// Request the next string straight away - it lands in the next ring slot
+	// while this one is reported and stored
+	FrameReadStart();
+#endif
 
-}
+	// This code will cycle through all of the states once every
+	// STATE_CYCLE_INTERVAL frames
+#ifdef STATE_CYCLE
+	sg_u8StateCounter++;
+	if (sg_u8StateCounter >= STATE_CYCLE_INTERVAL)
+	{
+		sg_u8StateCounter = 0;
 
-void FrameInit(bool  bFullInit)  // receives true if full init is needed, false if only cell reading data is to be reset
-{
-		// initialize frame structure
-		if (bFullInit || (FRAME_VALID_SIG != sg_sFrame.m.validSig)) // full init or invalid frame
+		if (sg_eStateCycle >= EMODSTATE_ON)
 		{
-			memset(&sg_sFrame,0,sizeof(sg_sFrame)); // set all to 0
-			sg_sFrame.m.frameBytes = sizeof(sg_sFrame);
-			sg_sFrame.m.validSig = FRAME_VALID_SIG;
-			sg_sFrame.m.version = FRAME_VERSION;
-
-			// Calculate cell buffer start offset (4-byte aligned)
-			// This is the offset from the start of the frame to where cell data begins
-			uint16_t metadataSize = sizeof(FrameMetadata);
-			// Round up to next 4-byte boundary
-			sg_sFrame.m.cellBufferStart = (uint8_t)((metadataSize + 3) & ~3);
+			sg_eStateCycle = EMODSTATE_OFF;  //turn off sequence and delays handled by state handler
+		}
+		else
+		{
+			sg_eStateCycle++;
+		} 
 
-			sg_sFrame.m.moduleUniqueId = ModuleControllerGetUniqueID();
-			sg_sFrame.m.sg_u8CellFirstI2CError = 0xff;
-			sg_sFrame.m.sg_u8CellCPUCountFewest = 0xff;
-			sg_sFrame.m.sg_u8CellCPUCountMost = 0;  // Explicitly init to 0 (should already be 0 from memset, but being explicit)
+		// Now set the new state
+		ModuleControllerStateSet(sg_eStateCycle);
+	}
+#endif
+}
 
-			// Initialize current fields to 0A (0x8000 = 32768)
-			// Current formula: Amps = -655.36 + raw * 0.02, so 0A = 32768
-			sg_sFrame.m.u16maxCurrent = 0x8000;
-			sg_sFrame.m.u16minCurrent = 0x8000;
-			sg_sFrame.m.u16avgCurrent = 0x8000;
+// The string came in before the frame timer ran out. Pulls the end of the READ frame in
+// to now. When pipelined every frame is reading, and the next frame is the next string
+// request, so it's never sooner than the minimum frame period after the frame started.
+static void FrameReadEndEarly(void)
+{
+	uint8_t u8SREG = SREG;
 
-			// Load cell count expected from EEPROM, or use default for unprogrammed values
-			uint8_t u8CellCountEEPROM = EEPROMRead(EEPROM_EXPECTED_CELL_COUNT);
-			if ((u8CellCountEEPROM == 0xFF) || (u8CellCountEEPROM == 0x00))
-			{
-				// Cell count unprogrammed - start with 0 cells expected
-				// This will auto-increment as cells are discovered
-				CellCountExpectedSet(0);
-			}
-			else
-			{
-				// Use programmed cell count
-				CellCountExpectedSet(u8CellCountEEPROM);
-			}
+	cli();  // timer 1 registers go through TEMP, and the frame timer mustn't fire part way
+#ifdef PIPELINED_FRAMES
+	if (false == sg_bFrameStart)
+#else
+	if ((EFRAMETYPE_READ == sg_eFrameStatus) && (false == sg_bFrameStart))
+#endif
+	{
+		uint16_t u16Now = TCNT1;
+#ifdef PIPELINED_FRAMES
+		uint16_t u16End = (uint16_t) (sg_u16FrameStartTimer1 + FRAME_PERIOD_MS_TO_TIMER1(sg_u16FramePeriodMinMs));
+#else
+		uint16_t u16End = u16Now;  // the WRITE frame that follows holds the rate down
+#endif
 
-			// Initialize frame counter from EEPROM
-			FrameCounter_Init();
-			sg_sFrame.m.frameCounter = FrameCounter_Get();
-		}
-		else  // do only if partial init, in full init the memset takes care of all this
+		if ((int16_t) (u16End - u16Now) < FRAME_TIMER1_SOONEST)
 		{
-			// Initialize current buffer slot with invalid markers at READ frame start
-			// Any cells that don't report will retain these markers
-			volatile CellData* stringData = GetStringDataVolatile(&sg_sFrame);
-			uint8_t i;
-			for (i = 0; i < sg_sFrame.m.sg_u8CellCountExpected; i++) {
-				stringData[i].voltage = INVALID_CELL_VOLTAGE;
-				stringData[i].temperature = INVALID_CELL_TEMP;
-			}
-
-			sg_sFrame.m.bDischargeOn = false;
-			sg_sFrame.m.sg_u16CellCPUI2CErrors = 0;
-			sg_sFrame.m.sg_u8CellFirstI2CError = 0;
-			sg_sFrame.m.sg_u8CellCPUCount = 0;     // for the frame
-			sg_sFrame.m.sg_u8MCRXFramingErrors = 0;
-			
-			// Only reset voltage/temp stats if we have no valid data
-			// This prevents the alternating zero issue when status is polled
-			if (sg_sFrame.m.sg_u32CellVoltageTotal == 0)
-			{
-				sg_sFrame.m.sg_u32CellVoltageTotal = 0;		// All cell CPU voltages added up (in millivolts)
-				sg_sFrame.m.sg_u16HighestCellVoltage = 0;
-				sg_sFrame.m.sg_u16LowestCellVoltage = 0;
-				sg_sFrame.m.sg_u16AverageCellVoltage = 0;
-				sg_sFrame.m.sg_s16HighestCellTemp = TEMPERATURE_BASE;	// 0C default, in case we get no readings
-				sg_sFrame.m.sg_s16LowestCellTemp = TEMPERATURE_BASE;		// 0C default, in case we get no readings
-				sg_sFrame.m.sg_s16AverageCellTemp = TEMPERATURE_BASE;	// 0C default, in case we get no readings
-			}
+			u16End = (uint16_t) (u16Now + FRAME_TIMER1_SOONEST);
 		}
-		
-		// initialize other housekeeping
-		sg_u8CurrentBufferIndex=0xff;  // this indicates the buffer is empty, to be filled with first reading
 
+		// Only ever earlier
+		if ((int16_t) (OCR1B - u16End) > 0)
+		{
+			OCR1B = u16End;
+		}
+	}
+	SREG = u8SREG;
 }
 
-// Process frame transfer state machine
-void ProcessFrameTransfer(void)
+// Start of READ frame - clear the ring slot for the next string reading and request it
+static void FrameReadStart(void)
 {
-	uint8_t buffer[8];
-
-	switch (sg_eFrameTransferState)
+#ifndef FRAME_DELTA_STRINGS
+	// A full frame waiting on the last one's write is stored before the ring wraps onto it
+	if (sg_bFrameStorePending &&
+		(sg_eFrameTransferState == FRAME_TRANSFER_IDLE) &&
+		FrameStore())
 	{
-		case FRAME_TRANSFER_IDLE:
-			// Nothing to do
-			break;
+		sg_bFrameStorePending = false;
+		sg_sFrame.m.currentIndex = 0;
+	}
+#endif
 
-		case FRAME_TRANSFER_SENDING_START:
-			// Send start message with frame counter
-			*(uint32_t*)&buffer[0] = sg_pFrameToTransfer->m.frameCounter;
-			*(uint16_t*)&buffer[4] = 129;  // Total messages (1 start + 128 data + 1 end)
-			buffer[6] = 0;
-			buffer[7] = 0;
+	FrameInit(false);  // init frame data
+	
+	if (ESTRING_OPERATIONAL == sg_eStringPowerState)  //only do this if we are up and running
+	{
+		
+#ifdef FAKE_CELL_DATA   // fake it
+#ifdef FRAME_DELTA_STRINGS
+		// Packed a cell at a time, as if they'd come in over the vUART
+		const uint8_t *pu8Src = (const uint8_t *) sg_u16FakeCellData;
+		CellData sCell;
+
+		CellStringStatsReset(&sg_sStringStatsRX);
+		for (uint8_t u8Cell = 0; u8Cell < sg_sFrame.m.sg_u8CellCountExpected; u8Cell++)
+		{
+			uint8_t *pu8Dest = (uint8_t*)&sCell;
+			uint8_t u8Count = sizeof(sCell);
 
-			if (CANSendMessage(ECANMessageType_FrameTransferStart, buffer, 8))
+			// Don't run off the end of the fake data
+			if ((uint16_t)((u8Cell + 1) * sizeof(sCell)) > sizeof(sg_u16FakeCellData))
 			{
-				sg_eFrameTransferState = FRAME_TRANSFER_SENDING_DATA;
-				sg_u8FrameTransferSegment = 0;
+				break;
 			}
-			break;
 
-		case FRAME_TRANSFER_SENDING_DATA:
-			if (sg_u8FrameTransferSegment < 128)
+			// This is done explicitly because it's copying from code space into data space
+			// and memcpy() doesn't deal with the difference.
+			while (u8Count--)
 			{
-				// Calculate offset into frame
-				uint16_t offset = sg_u8FrameTransferSegment * 8;
+				*pu8Dest = *pu8Src;
+				++pu8Dest;
+				++pu8Src;
+			}
 
-				// Copy 8 bytes from frame
-				uint8_t *frameBytes = (uint8_t*)sg_pFrameToTransfer;
-				memcpy(buffer, &frameBytes[offset], 8);
+			sg_sFrame.m.readingCount -= StringDelta_Cell(&sg_sStringDelta, u8Cell, (const uint8_t*)&sCell);
+			CellStringStatsAdd(&sg_sStringStatsRX, sCell.voltage, sCell.temperature);
+		}
 
-				// Send with sequence number in extended ID bits 8-17
-				if (CANSendMessageWithSeq(ECANMessageType_FrameTransferData, buffer, 8, sg_u8FrameTransferSegment))
-				{
-					sg_u8FrameTransferSegment++;
-				}
-			}
-			else
-			{
-				// All data sent, move to end
-				sg_eFrameTransferState = FRAME_TRANSFER_SENDING_END;
-			}
-			break;
+		sg_sFrame.m.sg_u16BytesReceived = sg_sFrame.m.sg_u8CellCountExpected * CELL_RECORD_BYTES;
+		sg_sFrame.m.sg_u8CellCPUCount = sg_sFrame.m.sg_u8CellCountExpected;
+#else
+		uint8_t *pu8Dest = (uint8_t*)GetStringDataVolatile(&sg_sFrame);
+		const uint8_t *pu8Src = (const uint8_t *) sg_u16FakeCellData;;
+		uint16_t u16Count = sizeof(sg_u16FakeCellData);
 
-		case FRAME_TRANSFER_SENDING_END:
+		// This is done explicitly because it's copying from code space into data space
+		// and memcpy() doesn't deal with the difference.
+		while (u16Count--)
 		{
-			// Calculate CRC32 of entire frame
-			uint32_t crc = CRC32_Calculate((uint8_t*)sg_pFrameToTransfer,
-			                                sizeof(FrameData));
+			*pu8Dest = *pu8Src;
+			++pu8Dest;
+			++pu8Src;
+		}
 
-			*(uint32_t*)&buffer[0] = crc;
-			buffer[4] = 0;
-			buffer[5] = 0;
-			buffer[6] = 0;
-			buffer[7] = 0;
+//				sg_sFrame.m.sg_u16BytesReceived = sizeof(sg_u16FakeCellData);
+		sg_sFrame.m.sg_u16BytesReceived = sg_sFrame.m.sg_u8CellCountExpected * CELL_RECORD_BYTES;
+//				sg_sFrame.m.sg_u8CellCPUCount = sizeof(sg_u16FakeCellData) >> 2;	// Each cell report is 4 bytes
+		sg_sFrame.m.sg_u8CellCPUCount = sg_sFrame.m.sg_u8CellCountExpected;
 
-			if (CANSendMessage(ECANMessageType_FrameTransferEnd, buffer, 8))
-			{
-				sg_eFrameTransferState = FRAME_TRANSFER_IDLE;
-				sg_pFrameToTransfer = NULL;  // Clear pointer
-			}
-			break;
+		// No vUART traffic to accumulate statistics from, so do it here
+		CellStringStatsReset(&sg_sStringStatsRX);
+		for (uint8_t u8Cell = 0; u8Cell < sg_sFrame.m.sg_u8CellCPUCount; u8Cell++)
+		{
+			volatile CellData* stringData = GetStringDataVolatile(&sg_sFrame);
+			CellStringStatsAdd(&sg_sStringStatsRX, stringData[u8Cell].voltage, stringData[u8Cell].temperature);
 		}
+#endif
+#else  // make it
+		// Initialize receive capability
+		vUARTInitReceive();
+#ifdef CELL_WINDOW_POLLING
+		// Whole string or just the window
+		CellWindowReadingStart();
+#endif
+		// Clear receive state machine - using reset instead of start clears the state to ESTATE_IDLE
+		vUARTRXReset();
+		// Start a request for data to the cell CPUs.
+		vUARTStarttx();  //requesting cell data
+#endif
 	}
 }
 
@@ -2693,6 +4955,21 @@ int main(void)
 		sg_sFrame.m.sg_u8WDTCount++;
 		WDTSetLeash(WDT_LEASH_LONG, EWDT_NORMAL);  // set on long leash
 		ModuleControllerStateHandle();  // finish what we were doing
+
+		// The reset stopped the clock setup and timers, and SDInit() times its power up
+		// off timer 0 - without them it waits forever and the watchdog goes round again
+		SetSysclock();
+		TimerInit();
+
+		// The SD card and frame counter lost their state with the reset - pick the
+		// frame log up from its head so the frames before the reset aren't written over.
+		// A session that was open carries on, unless we were on the way to off.
+#ifndef STATE_CYCLE
+		sg_bSDCardReady = STORE_Init(EMODSTATE_OFF != sg_eModuleControllerStateCurrent);
+#else
+		FrameCounter_Init();
+#endif
+		sg_sFrame.m.frameCounter = FrameCounter_Get();
 	}
 	else
 	{
@@ -2717,7 +4994,7 @@ int main(void)
 		ADCInit();
 
 #ifndef STATE_CYCLE		// don't attempt SD when cycling
-		sg_bSDCardReady = STORE_Init();
+		sg_bSDCardReady = STORE_Init(false);  // A session left open was cut short
 		sg_bSDWriteEnabled = false;  // Start with SD writes disabled (module starts in OFF state)
 		sg_bSDBusy = false;  // Initialize SD busy flag (can be set if WDT reset during SD operation)
 #else
@@ -2792,8 +5069,12 @@ int main(void)
 		sg_bPackControllerTimeout = false;
 		sg_bSendModuleControllerStatus = false;
 		sg_bSendCellStatus = false;
+		sg_bSendCellDetailBulk = false;
+		sg_bSendCellTiming = false;
+		sg_bSendCellErrors = false;
 		sg_bSendHardwareDetail = false;
 		sg_bSendCellCommStatus = false;
+		sg_bSendCellCommStat2 = false;
 		sg_bCellBalanceReady = false;
 		sg_bCellBalancedOnce = false;
 		sg_bStopDischarge = false;
@@ -2820,6 +5101,9 @@ int main(void)
 		sg_eFrameStatus = EFRAMETYPE_WRITE; // start on a write so that housekeeping gets done
 	}
 	
+
+	// Nothing measured yet
+	memset((void *) sg_s8CellTiming, (uint8_t) VUART_RX_TIMING_NONE, sizeof(sg_s8CellTiming));
 		
 	// Enable all interrupts!
 	sei();
@@ -2832,26 +5116,80 @@ int main(void)
 		// Call frequently to ensure timely message processing
 		CANProcessQueue();
 
+		// Frame transfer runs outside the tick - data segments stream from the CAN ISR
+		// and the burst flow control reopens its window as soon as control traffic is clear
+		ProcessFrameTransfer();
+		CANBurstService();
+
+		// Packed cell detail also streams as fast as the TX queue drains
+		CellDetailBulkSend();
+		CellTimingSend();
+#ifdef CELL_RECORD_CRC
+		CellErrorsSend();
+#endif
+#ifdef CELL_WINDOW_POLLING
+		CellWindowSend();
+#endif
+		SessionSend();
+		FrameScrubService();
+
+		// Cell records are put together here rather than in the vUART RX interrupt
+		CellRecordsAssemble();
+
+		// A frame going to the SD card is written a slice at a time, so a slow card
+		// doesn't hold up CAN or state changes
+		STORE_Process();
+
+		// Don't wait for the frame timer once the whole string is in
+		if (sg_bStringComplete)
+		{
+			sg_bStringComplete = false;
+			FrameReadEndEarly();
+		}
+
+		// Frame boundaries come from the frame timer, not the tick
+		if (sg_bFrameStart)
+		{
+			uint8_t u8Reply[CAN_STATUS_RESPONSE_SIZE];
+			uint8_t savedTIMSK1 = TIMSK1;  // disable timer int to preserve state
+			EFrameType eCurrentFrame;
+
+			TIMSK1 &= ~(1 << OCIE1B);
+			eCurrentFrame = sg_eFrameStatus;
+			sg_bFrameStart = false;
+			TIMSK1 = savedTIMSK1;
+
+			if (EFRAMETYPE_WRITE == eCurrentFrame)
+			{
+				FrameWriteStart(u8Reply);
+			}
+			else
+			{
+				CellStringPowerStateMachine(); // if we just turned off the string in write frame, it will take effect here
+				FrameReadStart();
+			}
+		}
+
 		if (sg_bNewTick)
 		{
 			sg_bNewTick = false;  // set tru in periodic tick isr, cleared in main loop
 			uint8_t u8Reply[CAN_STATUS_RESPONSE_SIZE];
 
-			// Check CAN TX status every tick (100ms) for recovery from stuck transmissions
+			// Check CAN TX queue MOBs every tick (100ms) for recovery from stuck transmissions
 			CANCheckTxStatus();
 
+			// Frame transfer ACK/NACK timeout
+			if (sg_u8FrameTransferTimeoutTicks)
+			{
+				sg_u8FrameTransferTimeoutTicks--;
+			}
+
 			// Check overall CAN health and recover from error states
 			CANCheckHealth();
 
-			// Process TX retries if pending (deferred from ISR)
-			CANCheckRetry();
-
 			// Reconfigure MOBs if needed (deferred from ISR)
 			CANCheckMOBs();
 
-			// Process frame transfer if active
-			ProcessFrameTransfer();
-
 			// Clear separation of registered vs unregistered behavior
 			if (!sg_bModuleRegistered)
 			{
@@ -2910,76 +5248,12 @@ int main(void)
 	//------------------------- section specific to WRITE frame --------------------------------
 
 			uint8_t savedTIMSK1 = TIMSK1;  // disable timer int to preserve state
-			TIMSK1 &= ~(1 << OCIE1A);
+			TIMSK1 &= ~(1 << OCIE1B);
 			EFrameType eCurrentFrame = sg_eFrameStatus;
-			bool bFrameStart = sg_bFrameStart;	
 			TIMSK1 = savedTIMSK1;
 		
 			if (EFRAMETYPE_WRITE == eCurrentFrame)  // only do these ops if vUART is idle!
 			{
-				if(bFrameStart) // start of WRITE frame, reference local variable saved earlier
-				{
-					sg_bFrameStart = false;
-					CellStringPowerStateMachine(); // if we just turned off the string it will clear out frame
-
-					vUARTRXEnd();  // wrap up previous read
-					CellStringProcess(u8Reply);  // get it processed
-
-
-					if (ESTRING_OPERATIONAL == sg_eStringPowerState)
-					{
-						// We're operational. If we didn't get the number of cells we expect
-						// increment sg_u8SequentailCellCountMismatches. If this exceeds
-						// SEQUENTIAL_COUNT_MISMATCH_THRESHOLD, reset the chain. Setting to 0 will
-						// disable the cell string reset.
-						if ((sg_sFrame.m.sg_u8CellCPUCount != sg_sFrame.m.sg_u8CellCountExpected) &&
-						(sg_sFrame.m.sg_u8CellCountExpected))
-						{
-							#if (SEQUENTIAL_COUNT_MISMATCH_THRESHOLD > 0)  // Feature enabled at compile time
-							{
-								++sg_u8SequentailCellCountMismatches;
-								if ((sg_u8SequentailCellCountMismatches >= SEQUENTIAL_COUNT_MISMATCH_THRESHOLD))
-								{
-									sg_eStringPowerState = ESTRING_OFF;  // this will turn string off on the start of read frame
-									sg_u8SequentailCellCountMismatches = 0; // reset the timer
-								}
-							}
-							#endif
-						}
-						else
-						{
-							// All good
-							// Clear running count since we got a good read
-							sg_u8SequentailCellCountMismatches = 0;
-						}
-					}
-					
-					if( sg_bSendAnnouncement )  //we should announce ourselves
-					{
-						bool bSent;
-
-						// Reply with general status
-						u8Reply[0] = (uint8_t) FW_BUILD_NUMBER;
-						u8Reply[1] = (uint8_t) (FW_BUILD_NUMBER >> 8);
-						u8Reply[2] = MANUFACTURE_ID;
-						u8Reply[3] = PART_ID;
-						*((uint32_t*)&u8Reply[4]) = sg_sFrame.m.moduleUniqueId;
-			
-						bSent = CANSendMessage( ECANMessageType_ModuleAnnouncement, u8Reply, CAN_STATUS_RESPONSE_SIZE );
-
-						if( bSent )
-						{
-							sg_bSendAnnouncement = false;
-						}
-					// Send a module announcement if unregistered
-		
-					}
-					// Only send the announcement if the module isn't registered
-					// disable can interrupts as they seem to result in misreading of status
-					
-	
-				}  //end of write frame start code
-			
 				// the following is done continuously while in WRITE frame
 
 				// Check for a state transition and handle it
@@ -2990,77 +5264,7 @@ int main(void)
 				if (sg_bOvercurrentSignal)
 				{
 					sg_bOvercurrentSignal = false;
-				}
-
-
-				// This code will cycle through all of the states once every
-				// STATE_CYCLE_INTERVAL frames
-	#ifdef STATE_CYCLE
-				if(bFrameStart) // Only increment once per frame, not continuously
-				{
-					sg_u8StateCounter++;
-					if (sg_u8StateCounter >= STATE_CYCLE_INTERVAL)
-					{
-						sg_u8StateCounter = 0;
-
-						if (sg_eStateCycle >= EMODSTATE_ON)
-						{
-							sg_eStateCycle = EMODSTATE_OFF;  //turn off sequence and delays handled by state handler
-						}
-						else
-						{
-							sg_eStateCycle++;
-						} 
-
-						// Now set the new state
-						ModuleControllerStateSet(sg_eStateCycle);
-					}
-				}
-	#endif
-		
-			}
-	//------------------------- section specific to READ frame --------------------------------
-			else  // we are in READ frame
-			{
-				if(bFrameStart) // start of READ frame, reference local variable saved earlier
-				{
-					sg_bFrameStart = false;
-					CellStringPowerStateMachine(); // if we just turned off the string in write frame, it will take effect here
-					
-					FrameInit(false);  // init frame data
-					
-					if (ESTRING_OPERATIONAL == sg_eStringPowerState)  //only do this if we are up and running
-					{
-						
-		#ifdef FAKE_CELL_DATA   // fake it
-						uint8_t *pu8Dest = (uint8_t*)GetStringDataVolatile(&sg_sFrame);
-						const uint8_t *pu8Src = (const uint8_t *) sg_u16FakeCellData;;
-						uint16_t u16Count = sizeof(sg_u16FakeCellData);
-
-						// This is done explicitly because it's copying from code space into data space
-						// and memcpy() doesn't deal with the difference.
-						while (u16Count--)
-						{
-							*pu8Dest = *pu8Src;
-							++pu8Dest;
-							++pu8Src;
-						}
-
-		//				sg_sFrame.m.sg_u16BytesReceived = sizeof(sg_u16FakeCellData);
-						sg_sFrame.m.sg_u16BytesReceived = sg_sFrame.m.sg_u8CellCountExpected << 2;
-		//				sg_sFrame.m.sg_u8CellCPUCount = sizeof(sg_u16FakeCellData) >> 2;	// Each cell report is 4 bytes
-						sg_sFrame.m.sg_u8CellCPUCount = sg_sFrame.m.sg_u8CellCountExpected;
-		#else  // make it
-						// Initialize receive capability
-						vUARTInitReceive();
-						// Clear receive state machine - using reset instead of start clears the state to ESTATE_IDLE
-						vUARTRXReset();
-						// Start a request for data to the cell CPUs.
-						vUARTStarttx();  //requesting cell data
-		#endif
-					}
-
-				}
+				}		
 			}  // end of frame-specific section
 	//------------------------- end of frame specific section --------------------------------
 
@@ -3174,14 +5378,6 @@ ISR(TIMER1_CAPT_vect, ISR_BLOCK)
 // }
 
 
-ISR(TIMER1_COMPB_vect, ISR_BLOCK)
-{
-	sg_u8UnhandledInterruptVector = (uint8_t) TIMER1_COMPB_vect;
-	sg_u8PCMSK0 = PCMSK0; sg_u8PCMSK1 = PCMSK1;
-	while (1);
-}
-
-
 ISR(TIMER1_OVF_vect, ISR_BLOCK)
 {
 	sg_u8UnhandledInterruptVector = (uint8_t) TIMER1_OVF_vect;
@@ -29,6 +29,17 @@
 
 // Callback frames alternate between active read (where we get string data) and write (where we report and store it).
 
+// Frame period (ms). Frame boundaries come from timer 1 compare B, which runs at the
+// measured string round trip plus FRAME_PERIOD_GUARD_MS, held between a minimum and
+// maximum the pack controller can set (ID_MODULE_FRAME_RATE). Starts out at the maximum.
+#define FRAME_PERIOD_MIN_MS_DEFAULT		100
+#define FRAME_PERIOD_MAX_MS_DEFAULT		PERIODIC_CALLBACK_RATE_MS
+#define FRAME_PERIOD_GUARD_MS			20
+#define FRAME_PERIOD_FLOOR_MS			10		// Lowest minimum the pack controller can set
+#define FRAME_PERIOD_LIMIT_MS			2000	// Timer 1 compare reach is 65535 * 32us
+#define FRAME_PERIOD_MS_TO_TIMER1(x)	((uint16_t) (((uint32_t) (x) * TIMER1_CLOCKS_PER_SECOND) / 1000))
+#define FRAME_PERIOD_TIMER1_TO_MS(x)	((uint16_t) (((uint32_t) (x) * 1000) / TIMER1_CLOCKS_PER_SECOND))
+
 typedef enum
 {
 	EFRAMETYPE_READ,
@@ -91,10 +102,37 @@ extern void DebugGPIOToggle( void );
 extern uint16_t PlatformGetSendData( bool bUpdateBalanceStatus );
 extern void WatchdogReset( void );
 extern void SetSDBusy( bool bBusy );
+extern void FrameWriteCallback( bool bWritten );
 
 extern void vUARTRXStart(void);
 extern void vUARTRXEnd(void);
-extern void vUARTRXData( uint8_t u8rxDataByte );
+extern void vUARTRXData( uint8_t u8rxDataByte, int8_t s8Timing );
+extern void vUARTRXComplete(void);
+extern int8_t vUARTRXSkew(void);
+
+// Cell command bits added here until they move to Shared.h with the other MSG_CELL_
+// bits. Bit 15 (MSG_CELL_SEND_REPORT) tells these two apart, so they can share bit 13 -
+// check both sides before adding another.
+//
+// Report request for a window of cells (see CELL_WINDOW_POLLING.md) - with
+// MSG_CELL_SEND_REPORT, bits 6-12 are the first cell ID and bits 0-5 the # of cells.
+// Unlike a whole string request it goes out in full.
+#ifndef MSG_CELL_REPORT_WINDOW
+#define MSG_CELL_REPORT_WINDOW				0x2000
+#define MSG_CELL_WINDOW_FIRST_SHIFT			6
+#endif
+
+// Command, without MSG_CELL_SEND_REPORT (see VUART_RATE_NEGOTIATION.md) - pass this on,
+// then switch the vUART to the rate in bits 10-11. The low 10 bits are the "stop
+// discharging" balance value, so cell firmware that doesn't know it just stops balancing.
+#ifndef MSG_CELL_SET_BIT_RATE
+#define MSG_CELL_SET_BIT_RATE				0x2000
+#define MSG_CELL_BIT_RATE_SHIFT				10
+#endif
+
+// vUARTRXData() timing - the byte's per bit timing error in 1/16us (+ = the sender's bits
+// run long), or this if the byte had no edge to measure it by
+#define VUART_RX_TIMING_NONE				((int8_t) -128)
 extern volatile bool g_bServiceNeeded;
 
 extern void FrameInit(bool  bFullInit);  // call with true for full init (session), false for partial (frame)
@@ -261,6 +261,11 @@
 #define ID_MODULE_CELL_COMM_STATUS1 0x507
 #define ID_MODULE_CELL_COMM_STATUS2 0x508
 #define ID_MODULE_STATUS_4          0x509
+#define ID_MODULE_DETAIL_BULK       0x50A  // Packed raw detail for up to 3 cells per message
+#define ID_MODULE_VUART_TIMING      0x50B  // String vUART timing profile, 7 cells per message
+#define ID_MODULE_CELL_ERRORS       0x50C  // Cell record CRC error counts, 7 cells per message
+#define ID_MODULE_SESSION           0x50D  // SD session index - a session's frames
+#define ID_MODULE_SESSION_SUMMARY   0x50E  // SD session index - a session's start time and faults
 
 // Pack Controller to Module Controller
 // Extended Frame: (Base ID << 18) | Module ID
@@ -275,6 +280,9 @@
 #define ID_MODULE_SET_TIME          0x516  // Module ID = 0x01-0x1F (specific module)
 #define ID_MODULE_MAX_STATE         0x517  // Module ID = 0x00 (broadcast - all registered modules)
 #define ID_MODULE_DEREGISTER        0x518  // Module ID = 0x01-0x1F (specific module)
+#define ID_MODULE_FRAME_RATE        0x519  // Module ID = 0x01-0x1F (specific module)
+#define ID_MODULE_CELL_WINDOW       0x51A  // Module ID = 0x01-0x1F (specific module)
+#define ID_MODULE_SESSION_REQUEST   0x51B  // Module ID = 0x01-0x1F (specific module)
 #define ID_MODULE_ANNOUNCE_REQUEST  0x51D  // Module ID = 0xFF (unregistered modules only)
 #define ID_MODULE_ALL_DEREGISTER    0x51E  // Module ID = 0x00 (broadcast - all registered modules)
 #define ID_MODULE_ALL_ISOLATE       0x51F  // Module ID = 0x00 (broadcast - all registered modules)
@@ -286,5 +294,9 @@
 #define ID_FRAME_TRANSFER_START     0x521  // Module -> Pack: Start frame transfer
 #define ID_FRAME_TRANSFER_DATA      0x522  // Module -> Pack: Frame data segment
 #define ID_FRAME_TRANSFER_END       0x523  // Module -> Pack: End frame transfer
+#define ID_FRAME_TRANSFER_ACK       0x524  // Pack -> Module: Frame received intact
+#define ID_FRAME_TRANSFER_NACK      0x525  // Pack -> Module: Missing segment bitmap
+#define ID_FRAME_CHECK              0x526  // Module -> Pack: A frame on the SD card that didn't read back, or a scrub finished
+#define ID_FRAME_SCRUB_REQUEST      0x527  // Pack -> Module: Check a range of frames on the SD card
 
 #endif /* INC_CAN_ID_ALL_H_ */
@@ -115,10 +115,38 @@ typedef struct {                  // 0x507 MODULE CELL COMMUNICATION STATUS #1 -
   uint32_t i2cErrors          : 16;   // # Of I2C faults - # Of times a cell has stated an I2C error
   uint32_t framingErrors      : 8;    // # Of cell serial framing errors - # Of times the Module Controller has detected a framing error in the data stream
   uint32_t cellI2cFaultFirst  : 8;    // First cell that's reporting an I2C fault (0xff == none are)
+#ifdef STRING_PROCESS_PROFILING
+  uint32_t stringProcessUs    : 16;   // Longest string statistics processing time (us) since the last report
+#else
   uint32_t UNUSED_49_63       : 16;
+#endif
 }CANFRM_MODULE_CELL_COMM_STATUS_1;
 
 
+typedef struct {                  // 0x508 MODULE CELL COMMUNICATION STATUS #2 - 8 bytes
+  uint32_t stringIntervalMs   : 16;   // Interval between the last two string readings (ms), 0 = not yet timed
+  uint32_t stringReadings     : 16;   // # Of string readings since the last report
+  uint32_t pipelined          : 1 ;   // 1 = Pipelined frames, 0 = alternating READ/WRITE frames
+  uint32_t UNUSED_33_39       : 7 ;
+  uint32_t framePeriod        : 8 ;   // Current frame period in 10ms units
+  uint32_t stringRoundTripMs  : 16;   // Last full string's request to last byte (ms)
+}CANFRM_MODULE_CELL_COMM_STATUS_2;
+
+
+typedef struct {                  // 0x50D MODULE SESSION - 8 bytes, extended ID sequence = session & 0x3FF
+  uint32_t startFrame;            // Frame counter of the session's first frame, 0xFFFFFFFF = not on the card
+  uint32_t endFrame;              // One past its last frame (so far, if it's still open)
+}CANFRM_MODULE_SESSION;
+
+
+typedef struct {                  // 0x50E MODULE SESSION SUMMARY - 8 bytes, extended ID sequence = session & 0x3FF
+  uint32_t startTime;             // time_t it opened (low 32 bits)
+  uint32_t session      : 16;     // Session number (low 16 bits)
+  uint32_t wdtCount     : 8;      // Watchdog resets during the session
+  uint32_t flags        : 8;      // Bit 0 = still open, bit 1 = cut short (never closed)
+}CANFRM_MODULE_SESSION_SUMMARY;
+
+
 typedef struct {                    // 0x517 MODULE MAXIMUM ALLOWED STATE - 1 bytes
   uint8_t maximumState       : 4 ; // Maximum allowed state
   uint8_t UNUSED_4_7         : 4 ;
@@ -131,6 +159,25 @@ typedef struct {                  // 0x518 MODULE DEREGISTER - 2 bytes
 }CANFRM_MODULE_DEREGISTER;
 
 
+typedef struct {                  // 0x519 MODULE FRAME RATE - 4 bytes
+  uint16_t framePeriodMinMs;      // Shortest frame period (ms), 0 = default (100ms)
+  uint16_t framePeriodMaxMs;      // Longest frame period (ms), 0 = default (300ms)
+}CANFRM_MODULE_FRAME_RATE;
+
+
+typedef struct {                  // 0x51A MODULE CELL WINDOW - 3 bytes
+  uint8_t firstCellId;            // First cell in the window, 0xFF = centred on the hottest cell
+  uint8_t cellCount;              // # Of cells in the window (max 16), 0 = off
+  uint8_t fullEvery;              // Full string every N readings, 0 = default (4)
+}CANFRM_MODULE_CELL_WINDOW;
+
+
+typedef struct {                  // 0x51B MODULE SESSION REQUEST - 6 bytes
+  uint32_t firstSession;          // First session to send, 0xFFFFFFFF = the latest ones
+  uint16_t sessionCount;          // # Of sessions to send, 0 = 1
+}CANFRM_MODULE_SESSION_REQUEST;
+
+
 typedef struct {                  // 0x51E ALL MODULES DEREGISTER - 1 bytes
   uint8_t controllerId  : 8;      // module ID
 }CANFRM_MODULE_ALL_DEREGISTER;
@@ -146,4 +193,18 @@ typedef struct {                  // 0x51D MODULE ANNOUNCE REQUEST - 1 bytes
 }CANFRM_MODULE_ANNOUNCE_REQUEST;
 
 
+typedef struct {                  // 0x526 FRAME CHECK - 8 bytes
+  uint32_t frameCounter;          // The frame, or for a scrub that's finished the # of frames it checked
+  uint8_t result;                 // 1 = not on the card, 2 = CRC doesn't match, 3 = card didn't read, 0 = scrub finished
+  uint8_t source;                 // 0 = frame transfer, 1 = scrub
+  uint16_t count;                 // Transfer: frames still to come in the range. Scrub: bad frames so far
+}CANFRM_FRAME_CHECK;
+
+
+typedef struct {                  // 0x527 FRAME SCRUB REQUEST - 8 bytes
+  uint32_t firstFrame;            // First frame counter to check, 0xFFFFFFFF = the latest ones
+  uint32_t frameCount;            // # Of frames to check, 0 = stop the scrub in progress
+}CANFRM_FRAME_SCRUB_REQUEST;
+
+
 #endif /* INC_CAN_FRM_MOD_H_ */
@@ -372,6 +372,18 @@ bool RTCRead( struct tm * psTime )
 	return(true);
 }
 
+// The current time as a 64 bit time_t
+uint64_t RTCGetTime( void )
+{
+	uint64_t u64Time;
+
+	cli();
+	u64Time = sg_u64Time;
+	sei();
+
+	return(u64Time);
+}
+
 // This sets the RTC to the specific time passed in. True is returned
 // if it's 
 bool RTCSetTime(uint64_t u64Timet)
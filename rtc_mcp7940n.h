@@ -7,5 +7,6 @@
 extern bool RTCInit( void );
 extern bool RTCRead( struct tm * psTime );
 extern bool RTCSetTime( uint64_t u64Timet );
+extern uint64_t RTCGetTime( void );
 
 #endif // _RTC_MCP7940N_H_
\ No newline at end of file
@@ -0,0 +1,13 @@
+#ifndef _SDSIM_AVR_IO_H_
+#define _SDSIM_AVR_IO_H_
+
+#include <stdint.h>
+
+// Host stand-in for the AVR registers SD.c touches. The card model in sdsim.c watches
+// PORTC for the SD chip select.
+extern volatile uint8_t PORTC;
+extern volatile uint8_t DDRC;
+
+#define PINC6		6
+
+#endif
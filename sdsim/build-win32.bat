@@ -0,0 +1 @@
+cl /I. sdsim.c ..\SD.c ..\geneeprom\cmdline.c shell32.lib
\ No newline at end of file
@@ -0,0 +1,884 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#include <avr/io.h>
+
+#include "../geneeprom/CmdLine.h"
+#include "../SD.h"
+#include "../SPI.h"
+
+// SD card model for the firmware's own SD.c (see SD_FRAME_WRITES.md). SPITransaction()
+// feeds every byte through a model of a card in SPI mode: commands, data tokens, data
+// responses and busy. Frames are committed the way STORE_WriteFrame() does it, and the
+// model counts the time spent clocking a busy card, and what every commit took.
+// The stepped modes start each write with SDWriteAsync() and give it one SDWriteStep()
+// per main loop pass, the way STORE_Process() does, timing the longest call.
+//
+// The busy model is deliberately simple - a card's real timing depends on the card:
+//	- every write transaction (CMD24, or CMD25 up to its stop token) costs an erase
+//	- every block costs a program time
+//	- the end of a transaction (single block done, or stop token) costs a commit
+// Pre-erase (ACMD23) isn't credited with anything beyond that.
+
+#define SECTOR_BYTES				512
+#define FRAME_SECTORS				2		// SECTORS_PER_FRAME in STORE.h
+#define FRAME_BYTES					(SECTOR_BYTES * FRAME_SECTORS)
+
+#define FRAMES_DEFAULT				200
+#define FRAME_PERIOD_US_DEFAULT		300000	// Time between frame commits
+#define ERASE_US_DEFAULT			1000
+#define PROGRAM_US_DEFAULT			200
+#define COMMIT_US_DEFAULT			300
+#define BURST_FRAMES_DEFAULT		8
+#define LOOP_US_DEFAULT				200		// Main loop pass between SDWriteStep()s
+#define STEPPED_READ_STEPS			3		// Steps before a read back breaks into a stepped write
+
+// SPI.c - FCLKIO / 2 is the fastest, halving from there
+#define SPI_FCLKIO					4000000
+#define SPI_DIVISORS				7
+#define SPI_BYTE_OVERHEAD_US		1.0		// SPITransaction() loop, per byte
+
+#define CARD_SECTORS				8192
+#define CARD_OUT_BYTES				(SECTOR_BYTES + 8)
+
+// Data response - accepted
+#define CARD_DATA_ACCEPTED			0xe5
+
+static SCmdLineOption sg_sCmdLineOptions[] =
+{
+	{"-frames",			"# Of frames to commit (200)",							false,	true},
+	{"-start",			"Frame counter of the first frame (0)",					false,	true},
+	{"-period",			"Time between frame commits in us (300000)",			false,	true},
+	{"-erase",			"Card erase time per write transaction in us (1000)",	false,	true},
+	{"-program",		"Card program time per block in us (200)",				false,	true},
+	{"-commit",			"Card time to end a write transaction in us (300)",		false,	true},
+	{"-burst",			"Frames per burst for the burst modes (8)",				false,	true},
+	{"-loop",			"Main loop time between write steps in us (200)",		false,	true},
+	{"-verify",			"Every mode, several bursts and starts, read back, fail on any error",	false,	false},
+
+	{NULL}
+};
+
+typedef enum
+{
+	ECOMMIT_SINGLE,				// Two CMD24s - how STORE_WriteFrame() used to do it
+	ECOMMIT_MULTI,				// SDWrite() of the frame - one pre-erased CMD25
+	ECOMMIT_BURST,				// SDWriteAsync() in bursts, waited for - CMD25 kept open across frames
+	ECOMMIT_STEPPED,			// SDWriteAsync() of the frame, a step per main loop pass
+	ECOMMIT_STEPPED_BURST,		// The same, in bursts
+
+	ECOMMIT_COUNT
+} ECommitMode;
+
+static const char *sg_peCommitModes[ECOMMIT_COUNT] =
+{
+	"single",
+	"multi",
+	"burst",
+	"step",
+	"stepb"
+};
+
+typedef struct
+{
+	uint32_t u32Frames;
+	uint32_t u32Start;
+	uint32_t u32PeriodUs;
+	uint32_t u32EraseUs;
+	uint32_t u32ProgramUs;
+	uint32_t u32CommitUs;
+	uint32_t u32BurstFrames;
+	uint32_t u32LoopUs;
+	uint32_t u32ReadEvery;		// Read a frame back every this many commits, 0 = never
+} SSimParams;
+
+typedef enum
+{
+	ECARD_IDLE,
+	ECARD_WRITE_WAIT,			// Write command taken, waiting for a data token
+	ECARD_WRITE_DATA,			// Taking a block
+	ECARD_BUSY,					// Programming - MISO held low
+	ECARD_READ_MULTI			// CMD18 - blocks until CMD12
+} ECardState;
+
+typedef struct
+{
+	ECardState eState;
+	ECardState eAfterBusy;
+	bool bMultiWrite;
+	bool bAppCommand;
+	bool bErased;				// This write transaction's erase has been charged
+	uint8_t u8Command[6];
+	uint8_t u8CommandBytes;
+	uint8_t u8Out[CARD_OUT_BYTES];
+	uint16_t u16OutNext;
+	uint16_t u16OutCount;
+	uint8_t u8Block[SECTOR_BYTES + 2];
+	uint16_t u16BlockBytes;
+	uint32_t u32Sector;
+	uint32_t u32PreErase;
+	double dBusyUntilUs;
+
+	// Counts
+	uint32_t u32Transactions;
+	uint32_t u32Blocks;
+	uint32_t u32Errors;
+	double dBusyWaitUs;			// Time the host spent clocking a busy card
+} SCard;
+
+// Chip select and the clock
+volatile uint8_t PORTC = (1 << PINC6);
+volatile uint8_t DDRC;
+static double sg_dNowUs;
+static double sg_dByteUs;
+
+static SCard sg_sCard;
+static uint8_t sg_u8CardData[CARD_SECTORS][SECTOR_BYTES];
+static const SSimParams *sg_psParams;
+
+// Longest SD call of the last Run()
+static double sg_dLongestCallUs;
+
+// SDWriteAsync() completion
+static bool sg_bFrameDone;
+static bool sg_bFrameWritten;
+
+// Card specific data - CSD version 2, 512 byte blocks, C_SIZE 7 (CARD_SECTORS)
+static const uint8_t sg_u8CSD[16] =
+{
+	0x40, 0x0e, 0x00, 0x32, 0x5b, 0x59, 0x00, 0x00, 0x00, 0x07, 0x7f, 0x80, 0x0a, 0x40, 0x00, 0x01
+};
+
+static void CardError(const char *peError)
+{
+	if (0 == sg_sCard.u32Errors)
+	{
+		printf("  Card: %s\n", peError);
+	}
+	sg_sCard.u32Errors++;
+}
+
+static void CardOut(uint8_t u8Byte)
+{
+	if ((sg_sCard.u16OutNext + sg_sCard.u16OutCount) < CARD_OUT_BYTES)
+	{
+		sg_sCard.u8Out[sg_sCard.u16OutNext + sg_sCard.u16OutCount] = u8Byte;
+		sg_sCard.u16OutCount++;
+	}
+}
+
+// Queues a data block for a read - a byte's gap, the start token, the data and a CRC
+static void CardOutBlock(uint32_t u32Sector)
+{
+	uint16_t u16Byte;
+
+	if (u32Sector >= CARD_SECTORS)
+	{
+		CardError("read past the end of the card");
+		u32Sector = 0;
+	}
+
+	CardOut(0xff);
+	CardOut(0xfe);
+	for (u16Byte = 0; u16Byte < SECTOR_BYTES; u16Byte++)
+	{
+		CardOut(sg_u8CardData[u32Sector][u16Byte]);
+	}
+	CardOut(0);
+	CardOut(0);
+}
+
+static void CardBusy(double dUs, ECardState eAfter)
+{
+	sg_sCard.eState = ECARD_BUSY;
+	sg_sCard.eAfterBusy = eAfter;
+	sg_sCard.dBusyUntilUs = sg_dNowUs + dUs;
+}
+
+static void CardCommand(void)
+{
+	uint8_t u8Command = sg_sCard.u8Command[0] & 0x3f;
+	uint32_t u32Arg = ((uint32_t) sg_sCard.u8Command[1] << 24) |
+					  ((uint32_t) sg_sCard.u8Command[2] << 16) |
+					  ((uint32_t) sg_sCard.u8Command[3] << 8) |
+					  sg_sCard.u8Command[4];
+	bool bAppCommand = sg_sCard.bAppCommand;
+	uint8_t u8Byte;
+
+	sg_sCard.bAppCommand = false;
+	sg_sCard.u16OutNext = 0;
+	sg_sCard.u16OutCount = 0;
+
+	if ((ECARD_WRITE_WAIT == sg_sCard.eState) && sg_sCard.bMultiWrite)
+	{
+		// A multisector write only ends with the stop token
+		CardError("command in the middle of a multisector write");
+		sg_sCard.eState = ECARD_IDLE;
+	}
+
+	// Command response time
+	CardOut(0xff);
+
+	switch (u8Command)
+	{
+		case 0:
+			CardOut(0x01);
+			break;
+		case 8:
+			CardOut(0x01);
+			CardOut(0x00);
+			CardOut(0x00);
+			CardOut((uint8_t) (u32Arg >> 8));
+			CardOut((uint8_t) u32Arg);
+			break;
+		case 9:
+			CardOut(0x00);
+			CardOut(0xff);
+			CardOut(0xfe);
+			for (u8Byte = 0; u8Byte < sizeof(sg_u8CSD); u8Byte++)
+			{
+				CardOut(sg_u8CSD[u8Byte]);
+			}
+			CardOut(0);
+			CardOut(0);
+			break;
+		case 12:
+			if (sg_sCard.eState != ECARD_READ_MULTI)
+			{
+				CardError("CMD12 without a multisector read");
+			}
+			sg_sCard.eState = ECARD_IDLE;
+
+			// Stuff byte, then the response
+			CardOut(0xff);
+			CardOut(0x00);
+			break;
+		case 17:
+			CardOut(0x00);
+			CardOutBlock(u32Arg);
+			break;
+		case 18:
+			CardOut(0x00);
+			sg_sCard.u32Sector = u32Arg;
+			sg_sCard.eState = ECARD_READ_MULTI;
+			break;
+		case 23:
+			CardOut(0x00);
+			if (false == bAppCommand)
+			{
+				CardError("CMD23 without CMD55");
+			}
+			sg_sCard.u32PreErase = u32Arg & 0x7fffff;
+			break;
+		case 24:
+		case 25:
+			CardOut(0x00);
+			sg_sCard.u32Sector = u32Arg;
+			sg_sCard.bMultiWrite = (25 == u8Command);
+			sg_sCard.bErased = false;
+			sg_sCard.eState = ECARD_WRITE_WAIT;
+			sg_sCard.u32Transactions++;
+			if (false == sg_sCard.bMultiWrite)
+			{
+				sg_sCard.u32PreErase = 0;
+			}
+			break;
+		case 41:
+			CardOut(0x00);
+			if (false == bAppCommand)
+			{
+				CardError("CMD41 without CMD55");
+			}
+			break;
+		case 55:
+			CardOut(0x00);
+			sg_sCard.bAppCommand = true;
+			break;
+		case 58:
+			CardOut(0x00);
+			CardOut(0xc0);
+			CardOut(0xff);
+			CardOut(0x80);
+			CardOut(0x00);
+			break;
+		default:
+			CardError("unexpected command");
+			CardOut(0x04);
+			break;
+	}
+}
+
+// A block has come in - store it and go busy programming it
+static void CardBlock(void)
+{
+	double dBusyUs = sg_psParams->u32ProgramUs;
+
+	if (sg_sCard.u32Sector >= CARD_SECTORS)
+	{
+		CardError("write past the end of the card");
+	}
+	else
+	{
+		memcpy(sg_u8CardData[sg_sCard.u32Sector], sg_sCard.u8Block, SECTOR_BYTES);
+	}
+
+	sg_sCard.u32Sector++;
+	sg_sCard.u32Blocks++;
+	if (sg_sCard.u32PreErase)
+	{
+		sg_sCard.u32PreErase--;
+	}
+
+	if (false == sg_sCard.bErased)
+	{
+		sg_sCard.bErased = true;
+		dBusyUs += sg_psParams->u32EraseUs;
+	}
+
+	CardOut(CARD_DATA_ACCEPTED);
+	if (sg_sCard.bMultiWrite)
+	{
+		CardBusy(dBusyUs, ECARD_WRITE_WAIT);
+	}
+	else
+	{
+		CardBusy(dBusyUs + sg_psParams->u32CommitUs, ECARD_IDLE);
+	}
+}
+
+// One byte each way. Returns what the card puts on MISO.
+static uint8_t CardByte(uint8_t u8In)
+{
+	if (PORTC & (1 << PINC6))
+	{
+		// Not selected - MISO floats high
+		return(0xff);
+	}
+
+	if (ECARD_WRITE_DATA == sg_sCard.eState)
+	{
+		sg_sCard.u8Block[sg_sCard.u16BlockBytes++] = u8In;
+		if (sizeof(sg_sCard.u8Block) == sg_sCard.u16BlockBytes)
+		{
+			CardBlock();
+		}
+		return(0xff);
+	}
+
+	if (sg_sCard.u8CommandBytes)
+	{
+		sg_sCard.u8Command[sg_sCard.u8CommandBytes++] = u8In;
+		if (sizeof(sg_sCard.u8Command) == sg_sCard.u8CommandBytes)
+		{
+			sg_sCard.u8CommandBytes = 0;
+			CardCommand();
+		}
+		return(0xff);
+	}
+
+	// Start of a command?
+	if ((0x40 == (u8In & 0xc0)) &&
+		(sg_sCard.eState != ECARD_BUSY))
+	{
+		sg_sCard.u8Command[0] = u8In;
+		sg_sCard.u8CommandBytes = 1;
+		return(0xff);
+	}
+
+	if (sg_sCard.u16OutCount)
+	{
+		sg_sCard.u16OutCount--;
+		return(sg_sCard.u8Out[sg_sCard.u16OutNext++]);
+	}
+	sg_sCard.u16OutNext = 0;
+
+	switch (sg_sCard.eState)
+	{
+		case ECARD_BUSY:
+			if (sg_dNowUs < sg_sCard.dBusyUntilUs)
+			{
+				sg_sCard.dBusyWaitUs += sg_dByteUs;
+				return(0x00);
+			}
+			sg_sCard.eState = sg_sCard.eAfterBusy;
+			break;
+
+		case ECARD_WRITE_WAIT:
+			if ((0xfe == u8In) || (0xfc == u8In))
+			{
+				if ((0xfc == u8In) != sg_sCard.bMultiWrite)
+				{
+					CardError("wrong start token for the write");
+				}
+				sg_sCard.u16BlockBytes = 0;
+				sg_sCard.eState = ECARD_WRITE_DATA;
+			}
+			else
+			if (0xfd == u8In)
+			{
+				if (false == sg_sCard.bMultiWrite)
+				{
+					CardError("stop token in a single sector write");
+				}
+				if (sg_sCard.u32PreErase)
+				{
+					// Fewer blocks than pre-erased is allowed - the rest are just erased
+					sg_sCard.u32PreErase = 0;
+				}
+
+				// A byte, then busy
+				CardOut(0xff);
+				CardBusy(sg_psParams->u32CommitUs, ECARD_IDLE);
+			}
+			else
+			if (u8In != 0xff)
+			{
+				CardError("junk waiting for a data token");
+			}
+			break;
+
+		case ECARD_READ_MULTI:
+			CardOutBlock(sg_sCard.u32Sector++);
+			break;
+
+		default:
+			break;
+	}
+
+	return(0xff);
+}
+
+void SPIInit(void)
+{
+}
+
+uint32_t SPISetBaudRate(uint32_t u32BaudRate)
+{
+	uint32_t u32Rate = SPI_FCLKIO >> 1;
+	uint8_t u8Divisor = 1;
+
+	// Same choice as SPI.c - the fastest that isn't above the request
+	while ((u32BaudRate < u32Rate) && (u8Divisor < SPI_DIVISORS))
+	{
+		u32Rate >>= 1;
+		u8Divisor++;
+	}
+
+	sg_dByteUs = (8000000.0 / u32Rate) + SPI_BYTE_OVERHEAD_US;
+	return(u32Rate);
+}
+
+void SPITransaction(ESPIBusState eSPIBusState,
+					uint8_t *pu8Buffer,
+					uint16_t u16ByteCount)
+{
+	while (u16ByteCount--)
+	{
+		uint8_t u8In = 0xff;
+		uint8_t u8Out;
+
+		if (ESTATE_TX_DATA == eSPIBusState)
+		{
+			u8In = *pu8Buffer;
+		}
+		else
+		if (ESTATE_TX_PATTERN == eSPIBusState)
+		{
+			u8In = (uint8_t) (uintptr_t) pu8Buffer;
+		}
+
+		u8Out = CardByte(u8In);
+		sg_dNowUs += sg_dByteUs;
+
+		if (ESTATE_RX_DATA == eSPIBusState)
+		{
+			*pu8Buffer = u8Out;
+		}
+		if (eSPIBusState != ESTATE_TX_PATTERN)
+		{
+			++pu8Buffer;
+		}
+	}
+}
+
+void Delay(uint32_t u32Microseconds)
+{
+	sg_dNowUs += u32Microseconds;
+}
+
+void WatchdogReset(void)
+{
+}
+
+static void FrameFill(uint8_t *pu8Frame, uint32_t u32Frame)
+{
+	uint16_t u16Byte;
+
+	for (u16Byte = 0; u16Byte < FRAME_BYTES; u16Byte++)
+	{
+		pu8Frame[u16Byte] = (uint8_t) ((u32Frame * 7) + (u16Byte * 13) + (u16Byte >> 8));
+	}
+	pu8Frame[0] = (uint8_t) u32Frame;
+	pu8Frame[1] = (uint8_t) (u32Frame >> 8);
+}
+
+static bool FrameCheck(uint32_t u32Frame)
+{
+	uint8_t u8Expected[FRAME_BYTES];
+	uint8_t u8Read[FRAME_BYTES];
+
+	FrameFill(u8Expected, u32Frame);
+	memset((void *) u8Read, 0, sizeof(u8Read));
+	if (false == SDRead(u32Frame * FRAME_SECTORS, u8Read, FRAME_SECTORS))
+	{
+		printf("  Frame %u: read failed\n", u32Frame);
+		return(false);
+	}
+	if (memcmp((void *) u8Read, (void *) u8Expected, sizeof(u8Read)))
+	{
+		printf("  Frame %u: doesn't read back\n", u32Frame);
+		return(false);
+	}
+
+	return(true);
+}
+
+static void FrameWritten(bool bResult)
+{
+	sg_bFrameDone = true;
+	sg_bFrameWritten = bResult;
+}
+
+// Starts the frame's write, then steps it once per main loop pass until it's done. With
+// u32Steps set, it stops stepping after that many and leaves the rest to whatever's next.
+// Returns the longest call.
+static double FrameStepped(uint32_t u32Sector,
+						   uint8_t *pu8Frame,
+						   uint32_t u32GroupSectors,
+						   uint32_t u32Steps)
+{
+	double dCallUs = sg_dNowUs;
+	double dLongestUs;
+
+	sg_bFrameDone = false;
+	SDWriteAsync(u32Sector, pu8Frame, FRAME_SECTORS, u32GroupSectors, FrameWritten);
+	dLongestUs = sg_dNowUs - dCallUs;
+
+	while (false == sg_bFrameDone)
+	{
+		bool bMore;
+
+		if (u32Steps && (0 == u32Steps--))
+		{
+			break;
+		}
+
+		sg_dNowUs += sg_psParams->u32LoopUs;
+		dCallUs = sg_dNowUs;
+		bMore = SDWriteStep();
+		if ((sg_dNowUs - dCallUs) > dLongestUs)
+		{
+			dLongestUs = sg_dNowUs - dCallUs;
+		}
+
+		if (false == bMore)
+		{
+			break;
+		}
+	}
+
+	return(dLongestUs);
+}
+
+// Commits the frames one after another, the frame period apart. Returns false on any
+// write, read back or protocol error.
+static bool Run(const SSimParams *psParams, ECommitMode eMode, bool bQuiet)
+{
+	uint8_t u8Frame[FRAME_BYTES];
+	uint32_t u32Frame;
+	double dCommitTotalUs = 0.0;
+	double dCommitWorstUs = 0.0;
+	double dLongestCallUs = 0.0;
+	bool bResult = true;
+
+	sg_psParams = psParams;
+	memset((void *) &sg_sCard, 0, sizeof(sg_sCard));
+	memset((void *) sg_u8CardData, 0, sizeof(sg_u8CardData));
+	sg_dNowUs = 0.0;
+
+	if ((psParams->u32Start + psParams->u32Frames) * FRAME_SECTORS > CARD_SECTORS)
+	{
+		printf("Frames run past the end of the %u sector card\n", CARD_SECTORS);
+		return(false);
+	}
+
+	if (false == SDInit())
+	{
+		printf("  SDInit() failed\n");
+		return(false);
+	}
+	sg_sCard.u32Transactions = 0;
+	sg_sCard.dBusyWaitUs = 0.0;
+
+	for (u32Frame = psParams->u32Start; u32Frame < (psParams->u32Start + psParams->u32Frames); u32Frame++)
+	{
+		uint32_t u32Sector = u32Frame * FRAME_SECTORS;
+		double dStartUs;
+		double dCommitUs;
+		double dCallUs;
+		bool bReadBack = (psParams->u32ReadEvery && (0 == (u32Frame % psParams->u32ReadEvery)));
+		bool bWritten;
+
+		FrameFill(u8Frame, u32Frame);
+		dStartUs = sg_dNowUs;
+
+		switch (eMode)
+		{
+			case ECOMMIT_SINGLE:
+				bWritten = SDWrite(u32Sector, u8Frame, 1) &&
+						   SDWrite(u32Sector + 1, u8Frame + SECTOR_BYTES, 1);
+				break;
+			case ECOMMIT_MULTI:
+				bWritten = SDWrite(u32Sector, u8Frame, FRAME_SECTORS);
+				break;
+			case ECOMMIT_BURST:
+				SDWriteAsync(u32Sector, u8Frame, FRAME_SECTORS, psParams->u32BurstFrames * FRAME_SECTORS, NULL);
+				bWritten = SDWriteWait();
+				break;
+			default:
+				// A read back comes in part way through the write, and has to finish it
+				dCallUs = FrameStepped(u32Sector,
+									   u8Frame,
+									   (ECOMMIT_STEPPED_BURST == eMode) ? (psParams->u32BurstFrames * FRAME_SECTORS) : 0,
+									   bReadBack ? STEPPED_READ_STEPS : 0);
+				if (dCallUs > dLongestCallUs)
+				{
+					dLongestCallUs = dCallUs;
+				}
+				if (bReadBack &&
+					(false == sg_bFrameDone) &&
+					(false == FrameCheck(u32Frame)))
+				{
+					bResult = false;
+				}
+				bWritten = sg_bFrameDone && sg_bFrameWritten;
+				break;
+		}
+
+		dCommitUs = sg_dNowUs - dStartUs;
+		if ((eMode < ECOMMIT_STEPPED) &&
+			(dCommitUs > dLongestCallUs))
+		{
+			dLongestCallUs = dCommitUs;
+		}
+		dCommitTotalUs += dCommitUs;
+		if (dCommitUs > dCommitWorstUs)
+		{
+			dCommitWorstUs = dCommitUs;
+		}
+
+		if (false == bWritten)
+		{
+			printf("  Frame %u: write failed\n", u32Frame);
+			bResult = false;
+			break;
+		}
+
+		// Read one back now and then - that has to end a burst in progress
+		if (bReadBack &&
+			(eMode < ECOMMIT_STEPPED) &&
+			(false == FrameCheck(u32Frame)))
+		{
+			bResult = false;
+		}
+
+		sg_dNowUs += psParams->u32PeriodUs;
+	}
+
+	if (false == SDWriteFlush())
+	{
+		printf("  Flush failed\n");
+		bResult = false;
+	}
+
+	if (false == bQuiet)
+	{
+		printf("%-6s  %4u transactions  busy wait %7.1fus/frame  commit %7.1fus/frame, worst %7.1fus  longest call %7.1fus\n",
+			   sg_peCommitModes[eMode],
+			   sg_sCard.u32Transactions,
+			   sg_sCard.dBusyWaitUs / psParams->u32Frames,
+			   dCommitTotalUs / psParams->u32Frames,
+			   dCommitWorstUs,
+			   dLongestCallUs);
+	}
+
+	for (u32Frame = psParams->u32Start; bResult && (u32Frame < (psParams->u32Start + psParams->u32Frames)); u32Frame++)
+	{
+		if (false == FrameCheck(u32Frame))
+		{
+			bResult = false;
+		}
+	}
+
+	if (sg_sCard.u32Errors)
+	{
+		printf("  %u card protocol errors\n", sg_sCard.u32Errors);
+		bResult = false;
+	}
+
+	sg_dLongestCallUs = dLongestCallUs;
+	return(bResult);
+}
+
+// Every mode over a few burst sizes and starting frames, with read backs in the middle
+// of bursts. Each has to read back clean, and each of the waited for modes has to wait
+// less than the last. No step of the stepped modes can take as long as clocking a sector.
+static bool Verify(const SSimParams *psParams)
+{
+	static const uint32_t u32Bursts[] = {1, 2, 4, 8, 16};
+	static const uint32_t u32Starts[] = {0, 3, 13};
+	SSimParams sParams = *psParams;
+	bool bResult = true;
+	uint8_t u8Start;
+	uint8_t u8Burst;
+
+	for (u8Start = 0; u8Start < (sizeof(u32Starts) / sizeof(u32Starts[0])); u8Start++)
+	{
+		for (u8Burst = 0; u8Burst < (sizeof(u32Bursts) / sizeof(u32Bursts[0])); u8Burst++)
+		{
+			double dBusyWaitUs[ECOMMIT_COUNT];
+			uint8_t u8Mode;
+
+			sParams.u32Start = u32Starts[u8Start];
+			sParams.u32BurstFrames = u32Bursts[u8Burst];
+
+			for (u8Mode = 0; u8Mode < ECOMMIT_COUNT; u8Mode++)
+			{
+				// Straight through, then with read backs breaking into bursts
+				sParams.u32ReadEvery = 0;
+				if (false == Run(&sParams, (ECommitMode) u8Mode, true))
+				{
+					bResult = false;
+				}
+				dBusyWaitUs[u8Mode] = sg_sCard.dBusyWaitUs;
+
+				if ((u8Mode >= ECOMMIT_STEPPED) &&
+					(sg_dLongestCallUs >= (SECTOR_BYTES * sg_dByteUs)))
+				{
+					printf("  Start %u, burst %u, %s: a step took %.0fus\n",
+						   sParams.u32Start,
+						   sParams.u32BurstFrames,
+						   sg_peCommitModes[u8Mode],
+						   sg_dLongestCallUs);
+					bResult = false;
+				}
+
+				sParams.u32ReadEvery = 5;
+				if (false == Run(&sParams, (ECommitMode) u8Mode, true))
+				{
+					bResult = false;
+				}
+			}
+
+			if ((dBusyWaitUs[ECOMMIT_MULTI] >= dBusyWaitUs[ECOMMIT_SINGLE]) ||
+				((sParams.u32BurstFrames > 1) && (dBusyWaitUs[ECOMMIT_BURST] >= dBusyWaitUs[ECOMMIT_MULTI])))
+			{
+				printf("  Start %u, burst %u: busy wait didn't come down (%.0f/%.0f/%.0fus)\n",
+					   sParams.u32Start,
+					   sParams.u32BurstFrames,
+					   dBusyWaitUs[ECOMMIT_SINGLE],
+					   dBusyWaitUs[ECOMMIT_MULTI],
+					   dBusyWaitUs[ECOMMIT_BURST]);
+				bResult = false;
+			}
+		}
+	}
+
+	printf("%s\n", bResult ? "All modes read back clean" : "FAILED");
+	return(bResult);
+}
+
+int main(int argc, char **argv)
+{
+	SSimParams sParams;
+	bool bResult = true;
+	uint8_t u8Mode;
+
+	if (false == CmdLineInitArgcArgv(argc,
+									 argv,
+									 sg_sCmdLineOptions,
+									 argv[0]))
+	{
+		printf("Failed\n");
+		CmdLineDumpOptions(sg_sCmdLineOptions);
+		return(1);
+	}
+
+	memset((void *) &sParams, 0, sizeof(sParams));
+	sParams.u32Frames = FRAMES_DEFAULT;
+	sParams.u32PeriodUs = FRAME_PERIOD_US_DEFAULT;
+	sParams.u32EraseUs = ERASE_US_DEFAULT;
+	sParams.u32ProgramUs = PROGRAM_US_DEFAULT;
+	sParams.u32CommitUs = COMMIT_US_DEFAULT;
+	sParams.u32BurstFrames = BURST_FRAMES_DEFAULT;
+	sParams.u32LoopUs = LOOP_US_DEFAULT;
+
+	if (CmdLineOptionValue("-frames"))
+	{
+		sParams.u32Frames = (uint32_t) strtoul(CmdLineOptionValue("-frames"), NULL, 0);
+	}
+	if (CmdLineOptionValue("-start"))
+	{
+		sParams.u32Start = (uint32_t) strtoul(CmdLineOptionValue("-start"), NULL, 0);
+	}
+	if (CmdLineOptionValue("-period"))
+	{
+		sParams.u32PeriodUs = (uint32_t) strtoul(CmdLineOptionValue("-period"), NULL, 0);
+	}
+	if (CmdLineOptionValue("-erase"))
+	{
+		sParams.u32EraseUs = (uint32_t) strtoul(CmdLineOptionValue("-erase"), NULL, 0);
+	}
+	if (CmdLineOptionValue("-program"))
+	{
+		sParams.u32ProgramUs = (uint32_t) strtoul(CmdLineOptionValue("-program"), NULL, 0);
+	}
+	if (CmdLineOptionValue("-commit"))
+	{
+		sParams.u32CommitUs = (uint32_t) strtoul(CmdLineOptionValue("-commit"), NULL, 0);
+	}
+	if (CmdLineOptionValue("-burst"))
+	{
+		sParams.u32BurstFrames = (uint32_t) strtoul(CmdLineOptionValue("-burst"), NULL, 0);
+	}
+
+	if (CmdLineOptionValue("-loop"))
+	{
+		sParams.u32LoopUs = (uint32_t) strtoul(CmdLineOptionValue("-loop"), NULL, 0);
+	}
+
+	if ((0 == sParams.u32Frames) || (0 == sParams.u32BurstFrames))
+	{
+		printf("-frames and -burst must be at least 1\n");
+		return(1);
+	}
+
+	if (CmdLineOption("-verify"))
+	{
+		bResult = Verify(&sParams);
+	}
+	else
+	{
+		for (u8Mode = 0; u8Mode < ECOMMIT_COUNT; u8Mode++)
+		{
+			if (false == Run(&sParams, (ECommitMode) u8Mode, false))
+			{
+				bResult = false;
+			}
+		}
+	}
+
+	return(bResult ? 0 : 1);
+}
@@ -0,0 +1,6 @@
+#ifndef _SDSIM_XC_H_
+#define _SDSIM_XC_H_
+
+// Host stand-in so the firmware's SD.c builds into sdsim - nothing needed from here
+
+#endif
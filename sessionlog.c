@@ -0,0 +1,63 @@
+#include <string.h>
+#include "sessionlog.h"
+#include "crc32.h"
+
+// The index only goes on a card with room for this many times as many frame sectors
+#define SESSIONLOG_CARD_MIN_SLOTS	4
+
+void SessionLog_Layout(uint32_t u32Sectors,
+					   uint32_t* pu32FrameSlots,
+					   uint32_t* pu32IndexSector,
+					   uint32_t* pu32SessionSlots)
+{
+	*pu32SessionSlots = 0;
+	if (u32Sectors >= ((uint32_t) SESSIONLOG_SLOTS * SESSIONLOG_CARD_MIN_SLOTS))
+	{
+		*pu32SessionSlots = SESSIONLOG_SLOTS;
+	}
+
+	// The index goes at the end, so frame N stays in the same place on any card
+	*pu32IndexSector = u32Sectors - *pu32SessionSlots;
+	*pu32FrameSlots = *pu32IndexSector / (FRAMELOG_FRAME_BYTES / FRAMELOG_HEADER_BYTES);
+}
+
+void SessionLog_Seal(SSessionRecord* psRecord)
+{
+	psRecord->u16Sig = SESSIONLOG_SIG;
+	psRecord->u8Version = SESSIONLOG_VERSION;
+	psRecord->u16Reserved = 0;
+	psRecord->u32Crc = CRC32_Update(0, (const uint8_t*) psRecord, SESSIONLOG_RECORD_CRC_BYTES);
+}
+
+bool SessionLog_Header(const uint8_t* pu8Sector, uint32_t* pu32Session)
+{
+	SSessionRecord sRecord;
+
+	memcpy((void*) &sRecord, (const void*) pu8Sector, sizeof(sRecord));
+	if ((SESSIONLOG_SIG != sRecord.u16Sig) ||
+		(SESSIONLOG_VERSION != sRecord.u8Version) ||
+		(CRC32_Update(0, pu8Sector, SESSIONLOG_RECORD_CRC_BYTES) != sRecord.u32Crc))
+	{
+		return(false);
+	}
+
+	*pu32Session = sRecord.u32Session;
+	return(true);
+}
+
+bool SessionLog_FindHead(uint32_t u32Slots,
+						 PFFrameLogRead pfRead,
+						 uint8_t* pu8Sector,
+						 uint32_t* pu32Head)
+{
+	// Start from the last slot. Once the index has been round, that's always part of the
+	// latest run, even if the write to slot 0 was the one cut short. Until then it's
+	// empty, and the search starts from slot 0.
+	if (false == FrameLog_FindRun(u32Slots, u32Slots - 1, pfRead, SessionLog_Header, pu8Sector, pu32Head))
+	{
+		return(false);
+	}
+
+	// The search may have finished on a slot past the head
+	return(pfRead(*pu32Head % u32Slots, pu8Sector, false));
+}
@@ -0,0 +1,75 @@
+#ifndef _SESSIONLOG_H_
+#define _SESSIONLOG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "framelog.h"
+
+// The SD session index - shared by the firmware and host tools, so no AVR dependencies
+// in here.
+//
+// The last SESSIONLOG_SLOTS sectors of the card hold one record per session, a sector
+// each, and the frame log (framelog.h) has the rest. Session N goes in index slot
+// N % SESSIONLOG_SLOTS, so session N is always one sector read away. Sessions are
+// numbered in order, so the index is laid out just like the frame log, and its head is
+// found at boot the same way (FrameLog_FindRun()).
+//
+// A record is written when its session opens, and again when it closes - each time
+// a single sector write, with no read first. If the module resets part way through a
+// session, the head record is still marked open. A watchdog reset carries the session
+// on. Anything else closes it at boot, cut short, ending at the head of the frame log.
+
+#define SESSIONLOG_SECTOR_BYTES		512
+#define SESSIONLOG_SLOTS			1024	// Sessions the card holds - one sector each
+#define SESSIONLOG_SIG				0x5e55
+#define SESSIONLOG_VERSION			1
+
+// u8Flags
+#define SESSIONLOG_FLAG_OPEN		0x01	// Still going - u32EndFrame is where it got to
+#define SESSIONLOG_FLAG_CUT_SHORT	0x02	// Never closed - the module lost power or was reset
+
+// Laid out the same on the AVR and the host - nothing needs padding
+typedef struct
+{
+	uint16_t u16Sig;				// SESSIONLOG_SIG
+	uint8_t u8Version;				// SESSIONLOG_VERSION
+	uint8_t u8Flags;				// SESSIONLOG_FLAG_*
+	uint32_t u32Session;			// Session number, from 0
+	uint32_t u32StartFrame;			// Frame counter of its first frame
+	uint32_t u32EndFrame;			// One past its last frame
+	uint64_t u64StartTime;			// time_t it opened, from the RTC
+	uint16_t u16MaxCurrent;			// Session current extremes, as FrameMetadata has them
+	uint16_t u16MinCurrent;
+	uint8_t u8WDTCount;				// Watchdog resets during the session
+	uint8_t u8CellCount;			// Cells the string was expected to have
+	uint16_t u16Reserved;			// 0
+	uint32_t u32Crc;				// CRC32 of the record up to here
+} SSessionRecord;
+
+#define SESSIONLOG_RECORD_CRC_BYTES	32		// offsetof(SSessionRecord, u32Crc)
+
+// Splits a card of u32Sectors sectors between the frame log and the session index.
+// *pu32FrameSlots is 0 if the card's too small for either, *pu32SessionSlots if it's
+// too small for an index - frames go on the whole card then.
+extern void SessionLog_Layout(uint32_t u32Sectors,
+							  uint32_t* pu32FrameSlots,
+							  uint32_t* pu32IndexSector,
+							  uint32_t* pu32SessionSlots);
+
+// Works out the record's CRC and puts it in
+extern void SessionLog_Seal(SSessionRecord* psRecord);
+
+// True if pu8Sector holds a record that checks out. *pu32Session gets its number.
+// Fits PFFrameLogHeader.
+extern bool SessionLog_Header(const uint8_t* pu8Sector, uint32_t* pu32Session);
+
+// Finds the head of an index u32Slots slots long. pu8Sector is a sector of scratch for
+// pfRead, which only ever needs to read a sector. Returns false if there's no index
+// yet. Otherwise *pu32Head is the last session's number, and its record is left in
+// pu8Sector.
+extern bool SessionLog_FindHead(uint32_t u32Slots,
+								PFFrameLogRead pfRead,
+								uint8_t* pu8Sector,
+								uint32_t* pu32Head);
+
+#endif // _SESSIONLOG_H_
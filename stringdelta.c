@@ -0,0 +1,475 @@
+#include <string.h>
+#ifndef __AVR__
+#include <stdlib.h>
+#endif
+#include "stringdelta.h"
+
+// Cell codes (see stringdelta.h)
+#define STRINGDELTA_SAME				0
+#define STRINGDELTA_VOLTAGE				1
+#define STRINGDELTA_SMALL				2
+#define STRINGDELTA_WIDE				3
+
+#define STRINGDELTA_SMALL_BITS			4
+#define STRINGDELTA_SMALL_MAX			7		// Not 8 - the code has to turn round
+#define STRINGDELTA_MEDIUM_BITS			8
+#define STRINGDELTA_MEDIUM_MAX			127
+
+static const uint8_t sg_u8InvalidCell[STRINGDELTA_CELL_BYTES] =
+{
+	(uint8_t) STRINGDELTA_INVALID_VOLTAGE, (uint8_t) (STRINGDELTA_INVALID_VOLTAGE >> 8),
+	(uint8_t) STRINGDELTA_INVALID_TEMP, (uint8_t) (STRINGDELTA_INVALID_TEMP >> 8)
+};
+
+static void StringDeltaPut(uint8_t* pu8Bits, uint16_t u16Bit, uint16_t u16Value, uint8_t u8Bits)
+{
+	while (u8Bits--)
+	{
+		uint8_t u8Mask = (uint8_t) (1 << (u16Bit & 7));
+
+		if (u16Value & 1)
+		{
+			pu8Bits[u16Bit >> 3] |= u8Mask;
+		}
+		else
+		{
+			pu8Bits[u16Bit >> 3] &= (uint8_t) ~u8Mask;
+		}
+
+		u16Value >>= 1;
+		u16Bit++;
+	}
+}
+
+static uint16_t StringDeltaGet(const uint8_t* pu8Bits, uint16_t u16Bit, uint8_t u8Bits)
+{
+	uint16_t u16Value = 0;
+	uint8_t u8Index;
+
+	for (u8Index = 0; u8Index < u8Bits; u8Index++)
+	{
+		if (pu8Bits[(u16Bit + u8Index) >> 3] & (1 << ((u16Bit + u8Index) & 7)))
+		{
+			u16Value |= (uint16_t) (1 << u8Index);
+		}
+	}
+
+	return(u16Value);
+}
+
+// Sign extends an u8Bits wide difference
+static int16_t StringDeltaSigned(uint16_t u16Value, uint8_t u8Bits)
+{
+	if (u16Value & (1 << (u8Bits - 1)))
+	{
+		return((int16_t) (u16Value - (1 << u8Bits)));
+	}
+
+	return((int16_t) u16Value);
+}
+
+static uint16_t StringDeltaValue(const uint8_t* pu8Cell, uint8_t u8Field)
+{
+	return((uint16_t) (pu8Cell[u8Field] | (pu8Cell[u8Field + 1] << 8)));
+}
+
+static void StringDeltaValueSet(uint8_t* pu8Cell, uint8_t u8Field, uint16_t u16Value)
+{
+	pu8Cell[u8Field] = (uint8_t) u16Value;
+	pu8Cell[u8Field + 1] = (uint8_t) (u16Value >> 8);
+}
+
+// Code for a pair of differences, and its size in bits
+static uint8_t StringDeltaCode(int16_t s16Voltage, int16_t s16Temperature, uint8_t* pu8Bits)
+{
+	if ((0 == s16Voltage) && (0 == s16Temperature))
+	{
+		*pu8Bits = 2;
+		return(STRINGDELTA_SAME);
+	}
+
+	if ((s16Voltage >= -STRINGDELTA_SMALL_MAX) && (s16Voltage <= STRINGDELTA_SMALL_MAX))
+	{
+		if (0 == s16Temperature)
+		{
+			*pu8Bits = 2 + STRINGDELTA_SMALL_BITS;
+			return(STRINGDELTA_VOLTAGE);
+		}
+
+		if ((s16Temperature >= -STRINGDELTA_SMALL_MAX) && (s16Temperature <= STRINGDELTA_SMALL_MAX))
+		{
+			*pu8Bits = 2 + (STRINGDELTA_SMALL_BITS << 1);
+			return(STRINGDELTA_SMALL);
+		}
+	}
+
+	if ((s16Voltage >= -STRINGDELTA_MEDIUM_MAX) && (s16Voltage <= STRINGDELTA_MEDIUM_MAX) &&
+		(s16Temperature >= -STRINGDELTA_MEDIUM_MAX) && (s16Temperature <= STRINGDELTA_MEDIUM_MAX))
+	{
+		*pu8Bits = 3 + (STRINGDELTA_MEDIUM_BITS << 1);
+	}
+	else
+	{
+		*pu8Bits = STRINGDELTA_CELL_BITS_MAX;
+	}
+
+	return(STRINGDELTA_WIDE);
+}
+
+// Size in bits of the cell code at u16Bit
+static uint8_t StringDeltaCodeBits(const uint8_t* pu8Bits, uint16_t u16Bit)
+{
+	switch (StringDeltaGet(pu8Bits, u16Bit, 2))
+	{
+		case STRINGDELTA_SAME:
+			return(2);
+		case STRINGDELTA_VOLTAGE:
+			return(2 + STRINGDELTA_SMALL_BITS);
+		case STRINGDELTA_SMALL:
+			return(2 + (STRINGDELTA_SMALL_BITS << 1));
+		default:
+			break;
+	}
+
+	if (StringDeltaGet(pu8Bits, u16Bit + 2, 1))
+	{
+		return(STRINGDELTA_CELL_BITS_MAX);
+	}
+
+	return(3 + (STRINGDELTA_MEDIUM_BITS << 1));
+}
+
+// Applies the cell code at u16Bit to pu8From, giving pu8To. With bTurn, the code is
+// rewritten to go from pu8To back to pu8From. pu8From and pu8To can be the same.
+static uint8_t StringDeltaApply(uint8_t* pu8Bits, uint16_t u16Bit, const uint8_t* pu8From, uint8_t* pu8To, bool bTurn)
+{
+	uint16_t u16Voltage = StringDeltaValue(pu8From, 0);
+	uint16_t u16Temperature = StringDeltaValue(pu8From, 2);
+	uint8_t u8Code = (uint8_t) StringDeltaGet(pu8Bits, u16Bit, 2);
+	uint8_t u8Width = STRINGDELTA_SMALL_BITS;
+	uint16_t u16Field = u16Bit + 2;
+	int16_t s16Voltage = 0;
+	int16_t s16Temperature = 0;
+
+	if (STRINGDELTA_SAME == u8Code)
+	{
+		StringDeltaValueSet(pu8To, 0, u16Voltage);
+		StringDeltaValueSet(pu8To, 2, u16Temperature);
+		return(2);
+	}
+
+	if (STRINGDELTA_WIDE == u8Code)
+	{
+		u16Field++;
+		if (StringDeltaGet(pu8Bits, u16Bit + 2, 1))
+		{
+			// Escape - swap the values over
+			StringDeltaValueSet(pu8To, 0, StringDeltaGet(pu8Bits, u16Field, 16));
+			StringDeltaValueSet(pu8To, 2, StringDeltaGet(pu8Bits, u16Field + 16, 16));
+			if (bTurn)
+			{
+				StringDeltaPut(pu8Bits, u16Field, u16Voltage, 16);
+				StringDeltaPut(pu8Bits, u16Field + 16, u16Temperature, 16);
+			}
+			return(STRINGDELTA_CELL_BITS_MAX);
+		}
+
+		u8Width = STRINGDELTA_MEDIUM_BITS;
+	}
+
+	s16Voltage = StringDeltaSigned(StringDeltaGet(pu8Bits, u16Field, u8Width), u8Width);
+	if (u8Code != STRINGDELTA_VOLTAGE)
+	{
+		s16Temperature = StringDeltaSigned(StringDeltaGet(pu8Bits, u16Field + u8Width, u8Width), u8Width);
+	}
+
+	StringDeltaValueSet(pu8To, 0, (uint16_t) (u16Voltage + s16Voltage));
+	StringDeltaValueSet(pu8To, 2, (uint16_t) (u16Temperature + s16Temperature));
+
+	if (bTurn)
+	{
+		StringDeltaPut(pu8Bits, u16Field, (uint16_t) -s16Voltage, u8Width);
+		if (u8Code != STRINGDELTA_VOLTAGE)
+		{
+			StringDeltaPut(pu8Bits, u16Field + u8Width, (uint16_t) -s16Temperature, u8Width);
+		}
+	}
+
+	return((uint8_t) (u16Field + (u8Width << ((u8Code != STRINGDELTA_VOLTAGE) ? 1 : 0)) - u16Bit));
+}
+
+// Packed size in bytes of the reading at pu8Bits
+static uint16_t StringDeltaReadingBytes(const uint8_t* pu8Bits, uint8_t u8Cells)
+{
+	uint16_t u16Bit = 0;
+
+	while (u8Cells--)
+	{
+		u16Bit += StringDeltaCodeBits(pu8Bits, u16Bit);
+	}
+
+	return((u16Bit + 7) >> 3);
+}
+
+// Makes room by dropping the oldest reading. Returns false if there are none.
+static bool StringDeltaDropOldest(SStringDelta* psDelta)
+{
+	uint16_t u16Bytes;
+
+	if (0 == psDelta->u16End)
+	{
+		return(false);
+	}
+
+	u16Bytes = StringDeltaReadingBytes(psDelta->pu8Records, psDelta->u8Cells);
+	memmove(psDelta->pu8Records,
+			psDelta->pu8Records + u16Bytes,
+			(psDelta->u16End - u16Bytes) + ((psDelta->u16Bits + 7) >> 3));
+	psDelta->u16End -= u16Bytes;
+
+	return(true);
+}
+
+// Packs the next cell against the latest reading. Returns the number of older readings
+// dropped to make room.
+static uint8_t StringDeltaAdd(SStringDelta* psDelta, const uint8_t* pu8Cell)
+{
+	const uint8_t* pu8Latest = psDelta->pu8Latest + (psDelta->u8Cell * STRINGDELTA_CELL_BYTES);
+	uint16_t u16Voltage = StringDeltaValue(pu8Cell, 0);
+	uint16_t u16Temperature = StringDeltaValue(pu8Cell, 2);
+	int16_t s16Voltage = (int16_t) (u16Voltage - StringDeltaValue(pu8Latest, 0));
+	int16_t s16Temperature = (int16_t) (u16Temperature - StringDeltaValue(pu8Latest, 2));
+	uint8_t u8Bits;
+	uint8_t u8Code = StringDeltaCode(s16Voltage, s16Temperature, &u8Bits);
+	uint8_t u8Dropped = 0;
+	uint8_t* pu8Bits;
+	uint16_t u16Bit;
+
+	while ((((uint32_t) (psDelta->u16RecordBytes - psDelta->u16End) << 3) - psDelta->u16Bits) < u8Bits)
+	{
+		if (false == StringDeltaDropOldest(psDelta))
+		{
+			// Only if the records can't hold one reading of escapes - see StringDelta_Init()
+			psDelta->u8Cell++;
+			return(u8Dropped);
+		}
+		u8Dropped++;
+	}
+
+	pu8Bits = psDelta->pu8Records + psDelta->u16End;
+	u16Bit = psDelta->u16Bits;
+
+	StringDeltaPut(pu8Bits, u16Bit, u8Code, 2);
+	u16Bit += 2;
+	if (STRINGDELTA_WIDE == u8Code)
+	{
+		if (STRINGDELTA_CELL_BITS_MAX == u8Bits)
+		{
+			StringDeltaPut(pu8Bits, u16Bit, 1, 1);
+			StringDeltaPut(pu8Bits, u16Bit + 1, u16Voltage, 16);
+			StringDeltaPut(pu8Bits, u16Bit + 17, u16Temperature, 16);
+		}
+		else
+		{
+			StringDeltaPut(pu8Bits, u16Bit, 0, 1);
+			StringDeltaPut(pu8Bits, u16Bit + 1, (uint16_t) s16Voltage, STRINGDELTA_MEDIUM_BITS);
+			StringDeltaPut(pu8Bits, u16Bit + 1 + STRINGDELTA_MEDIUM_BITS, (uint16_t) s16Temperature, STRINGDELTA_MEDIUM_BITS);
+		}
+	}
+	else
+	if (u8Code != STRINGDELTA_SAME)
+	{
+		StringDeltaPut(pu8Bits, u16Bit, (uint16_t) s16Voltage, STRINGDELTA_SMALL_BITS);
+		if (STRINGDELTA_SMALL == u8Code)
+		{
+			StringDeltaPut(pu8Bits, u16Bit + STRINGDELTA_SMALL_BITS, (uint16_t) s16Temperature, STRINGDELTA_SMALL_BITS);
+		}
+	}
+
+	psDelta->u16Bits += u8Bits;
+	psDelta->u8Cell++;
+
+	return(u8Dropped);
+}
+
+void StringDelta_Init(SStringDelta* psDelta,
+					  uint8_t* pu8Latest,
+					  uint8_t* pu8Records,
+					  uint16_t u16RecordBytes,
+					  uint8_t u8Cells)
+{
+	psDelta->pu8Latest = pu8Latest;
+	psDelta->pu8Records = pu8Records;
+	psDelta->u16RecordBytes = u16RecordBytes;
+	psDelta->u8Cells = u8Cells;
+	StringDelta_Clear(psDelta);
+}
+
+void StringDelta_Clear(SStringDelta* psDelta)
+{
+	psDelta->u16End = 0;
+	psDelta->u16LastBytes = 0;
+	StringDelta_Start(psDelta);
+}
+
+void StringDelta_Start(SStringDelta* psDelta)
+{
+	psDelta->u16Bits = 0;
+	psDelta->u8Cell = 0;
+}
+
+uint8_t StringDelta_Cell(SStringDelta* psDelta, uint8_t u8Position, const uint8_t* pu8Cell)
+{
+	uint8_t u8Dropped = 0;
+
+	if ((u8Position < psDelta->u8Cell) || (u8Position >= psDelta->u8Cells))
+	{
+		// Already had it, or more cells than expected
+		return(0);
+	}
+
+	while (psDelta->u8Cell < u8Position)
+	{
+		u8Dropped += StringDeltaAdd(psDelta, sg_u8InvalidCell);
+	}
+
+	return(u8Dropped + StringDeltaAdd(psDelta, pu8Cell ? pu8Cell : sg_u8InvalidCell));
+}
+
+uint8_t StringDelta_End(SStringDelta* psDelta, bool bKeep)
+{
+	uint8_t u8Dropped = 0;
+	uint8_t* pu8Bits;
+	uint16_t u16Bit = 0;
+	uint8_t u8Cell;
+
+	while (psDelta->u8Cell < psDelta->u8Cells)
+	{
+		u8Dropped += StringDeltaAdd(psDelta, sg_u8InvalidCell);
+	}
+
+	// Bring the latest up to date, turning each code round to point back at the old value
+	pu8Bits = psDelta->pu8Records + psDelta->u16End;
+	for (u8Cell = 0; u8Cell < psDelta->u8Cells; u8Cell++)
+	{
+		uint8_t* pu8Latest = psDelta->pu8Latest + (u8Cell * STRINGDELTA_CELL_BYTES);
+
+		u16Bit += StringDeltaApply(pu8Bits, u16Bit, pu8Latest, pu8Latest, true);
+	}
+
+	psDelta->u16LastBytes = (psDelta->u16Bits + 7) >> 3;
+	if (bKeep)
+	{
+		psDelta->u16End += psDelta->u16LastBytes;
+	}
+
+	StringDelta_Start(psDelta);
+
+	return(u8Dropped);
+}
+
+bool StringDelta_Full(const SStringDelta* psDelta)
+{
+	// Room for another reading like the last, and half a byte a cell to spare
+	return((psDelta->u16RecordBytes - psDelta->u16End) < (psDelta->u16LastBytes + (psDelta->u8Cells >> 1)));
+}
+
+#ifndef __AVR__
+// Size in bits of the cell code at u16Bit, or 0 if it runs past u16Bytes
+static uint8_t StringDeltaCodeBitsChecked(const uint8_t* pu8Bits, uint16_t u16Bytes, uint16_t u16Bit)
+{
+	uint8_t u8Bits;
+
+	// The tag, then the escape bit, then the rest - each has to be there before it's read
+	if (((u16Bit + 2 + 7) >> 3) > u16Bytes)
+	{
+		return(0);
+	}
+	if ((STRINGDELTA_WIDE == StringDeltaGet(pu8Bits, u16Bit, 2)) &&
+		(((u16Bit + 3 + 7) >> 3) > u16Bytes))
+	{
+		return(0);
+	}
+
+	u8Bits = StringDeltaCodeBits(pu8Bits, u16Bit);
+	if (((u16Bit + u8Bits + 7) >> 3) > u16Bytes)
+	{
+		return(0);
+	}
+
+	return(u8Bits);
+}
+
+bool StringDelta_Decode(const uint8_t* pu8Latest,
+						const uint8_t* pu8Records,
+						uint16_t u16RecordBytes,
+						uint8_t u8Cells,
+						uint16_t u16Readings,
+						uint8_t* pu8Out)
+{
+	uint16_t u16ReadingBytes = (uint16_t) u8Cells * STRINGDELTA_CELL_BYTES;
+	uint16_t u16Offset = 0;
+	uint16_t u16Reading;
+	uint16_t* pu16Offsets;
+
+	if (0 == u16Readings)
+	{
+		return(true);
+	}
+
+	// Every older reading takes at least a byte
+	if ((u16Readings - 1) > u16RecordBytes)
+	{
+		return(false);
+	}
+
+	pu16Offsets = malloc(u16Readings * sizeof(*pu16Offsets));
+	if (NULL == pu16Offsets)
+	{
+		return(false);
+	}
+
+	// Each older reading's size depends on its codes, so find them all first
+	for (u16Reading = 0; u16Reading < (uint16_t) (u16Readings - 1); u16Reading++)
+	{
+		uint16_t u16Bit = 0;
+		uint8_t u8Cell;
+
+		pu16Offsets[u16Reading] = u16Offset;
+		for (u8Cell = 0; u8Cell < u8Cells; u8Cell++)
+		{
+			uint8_t u8Bits = StringDeltaCodeBitsChecked(pu8Records + u16Offset, u16RecordBytes - u16Offset, u16Bit);
+
+			if (0 == u8Bits)
+			{
+				free(pu16Offsets);
+				return(false);
+			}
+			u16Bit += u8Bits;
+		}
+		u16Offset += (u16Bit + 7) >> 3;
+	}
+
+	// Newest first, each from the one after it
+	memcpy(pu8Out + ((u16Readings - 1) * (uint32_t) u16ReadingBytes), pu8Latest, u16ReadingBytes);
+	u16Reading = u16Readings - 1;
+	while (u16Reading--)
+	{
+		const uint8_t* pu8Next = pu8Out + ((u16Reading + 1) * (uint32_t) u16ReadingBytes);
+		uint8_t* pu8This = pu8Out + (u16Reading * (uint32_t) u16ReadingBytes);
+		uint16_t u16Bit = 0;
+		uint8_t u8Cell;
+
+		for (u8Cell = 0; u8Cell < u8Cells; u8Cell++)
+		{
+			u16Bit += StringDeltaApply((uint8_t*) (pu8Records + pu16Offsets[u16Reading]), u16Bit,
+									   pu8Next + (u8Cell * STRINGDELTA_CELL_BYTES),
+									   pu8This + (u8Cell * STRINGDELTA_CELL_BYTES),
+									   false);
+		}
+	}
+
+	free(pu16Offsets);
+	return(true);
+}
+#endif
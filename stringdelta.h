@@ -0,0 +1,91 @@
+#ifndef _STRINGDELTA_H_
+#define _STRINGDELTA_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Delta packed string readings for FRAME_VERSION_DELTA frames - shared by the firmware
+// (encoder) and host tools (decoder), so no AVR dependencies in here.
+//
+// The frame's cell buffer starts with the latest string reading, raw, so it can be
+// read like any other reading. The older readings follow it, oldest first, each one
+// packed as its difference from the reading after it. Every cell is a bit packed code,
+// least significant bit first:
+//
+//	00							- Same as the next reading
+//	01 vvvv						- Voltage differs by -7..7, temperature the same
+//	10 vvvv tttt				- Voltage and temperature differ by -7..7
+//	11 0 vvvvvvvv tttttttt		- Voltage and temperature differ by -127..127
+//	11 1 <voltage> <temperature> - Escape - both as they are, 16 bits each. Large jumps,
+//								  and cells going to or from the invalid markers.
+//
+// Differences are of the raw 16 bit values, mod 65536. A cell that stays invalid is
+// "same". Each reading is padded to a whole byte.
+//
+// A reading coming in is packed against the latest reading as it arrives, then turned
+// round to point the other way once it's complete. Each code is the same size both
+// ways, so that's done in place.
+
+#define STRINGDELTA_CELL_BYTES			4		// Voltage, then temperature, little endian
+#define STRINGDELTA_CELL_BITS_MAX		35		// Escape
+
+// Cells that didn't report - the same as INVALID_CELL_VOLTAGE/INVALID_CELL_TEMP in STORE.h
+#define STRINGDELTA_INVALID_VOLTAGE		0xffff
+#define STRINGDELTA_INVALID_TEMP		0x7fff
+
+// Frame metadata the host decoder needs. These are the AVR offsets of FrameMetadata.version
+// and .readingCount - cellBufferStart and the cell count are in framecodec.h.
+#define STRINGDELTA_FRAME_VERSION		2
+#define STRINGDELTA_OFFSET_VERSION		2
+#define STRINGDELTA_OFFSET_READINGCOUNT	93
+
+typedef struct
+{
+	uint8_t* pu8Latest;			// Latest reading, raw
+	uint8_t* pu8Records;		// Older readings, packed
+	uint16_t u16RecordBytes;	// Room for them
+	uint16_t u16End;			// Bytes of older readings kept
+	uint16_t u16Bits;			// Bits so far of the reading coming in, after u16End
+	uint16_t u16LastBytes;		// Packed size of the last reading
+	uint8_t u8Cells;			// Cells per reading
+	uint8_t u8Cell;				// Next cell of the reading coming in
+} SStringDelta;
+
+// Set up for readings of u8Cells cells, with no older readings. u16RecordBytes has to
+// hold at least one reading of escapes (STRINGDELTA_CELL_BITS_MAX a cell).
+extern void StringDelta_Init(SStringDelta* psDelta,
+							 uint8_t* pu8Latest,
+							 uint8_t* pu8Records,
+							 uint16_t u16RecordBytes,
+							 uint8_t u8Cells);
+
+// Forget the older readings - the latest stays
+extern void StringDelta_Clear(SStringDelta* psDelta);
+
+// Start a new reading, dropping any of the last one that hasn't been ended
+extern void StringDelta_Start(SStringDelta* psDelta);
+
+// The cell at string position u8Position has come in (NULL = invalid). Positions that
+// were skipped are invalid. Returns the number of older readings dropped to make room.
+extern uint8_t StringDelta_Cell(SStringDelta* psDelta, uint8_t u8Position, const uint8_t* pu8Cell);
+
+// End of the reading. Cells that didn't come in are invalid. It becomes the latest, and
+// if bKeep the one before it is kept as an older reading. Returns the number of older
+// readings dropped to make room.
+extern uint8_t StringDelta_End(SStringDelta* psDelta, bool bKeep);
+
+// True if another reading might not fit - time to write the frame out
+extern bool StringDelta_Full(const SStringDelta* psDelta);
+
+#ifndef __AVR__
+// Unpacks a frame's u16Readings readings (the latest and u16Readings - 1 older ones) into
+// pu8Out, oldest first. Returns false if the packed readings run past u16RecordBytes.
+extern bool StringDelta_Decode(const uint8_t* pu8Latest,
+							   const uint8_t* pu8Records,
+							   uint16_t u16RecordBytes,
+							   uint8_t u8Cells,
+							   uint16_t u16Readings,
+							   uint8_t* pu8Out);
+#endif
+
+#endif // _STRINGDELTA_H_
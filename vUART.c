@@ -33,6 +33,21 @@
  * 6) On the 9th bit, sample the RX pin. If it's 1, more data is coming, go back to step
  *    1. If it's 0, continue on to step 7.
  * 7) Unmask RX Pin to wait for next byte start
+ *
+ * The string is over when a byte's stop bit says nothing more is coming, or when no
+ * start bit shows up for VUART_IDLE_TIMEOUT_US after a byte. Either way vUARTRXComplete()
+ * is called so the main loop can end the READ frame without waiting out its timer.
+ *
+ * Bit times above are for rate 0, VUART_BIT_TICKS, which is what the cells power up at.
+ * vUARTRateSet() moves both directions to a shorter bit time once the cells have been
+ * told to (see VUART_RATE_NEGOTIATION.md).
+ *
+ * With VUART_EDGE_CAPTURE defined, reception works differently (see VUART_EDGE_CAPTURE.md):
+ *
+ * 1) Every RX line edge interrupts. The interrupt only snapshots timer 0 and timer 1 into
+ *    a small ring, along with the line level
+ * 2) A decode tick on compare B, every VUART_IDLE_TICKS while edges are coming in, turns
+ *    the time between edges into bits (vuartdecode.c) and hands over whole bytes
  */
 
 #include <stdint.h>
@@ -43,13 +58,19 @@
 #include "main.h"
 #include "vUART.h"
 #include "debugSerial.h"
+#include "vuartdecode.h"
 #include "../Shared/Shared.h"
 
 //#define PauseCAN 1  // comment out if not using
 
+// Uncomment to receive by timestamping edges instead of sampling every bit
+//#define VUART_EDGE_CAPTURE
+
 // Enable edge-triggered timing correction during VUART reception
 // ModuleCPU is receiver-only, so edge sync is appropriate here
+#ifndef VUART_EDGE_CAPTURE
 #define ENABLE_EDGE_SYNC   //TODO this needs fine-tuning, currently pushes next sample to 35us instead of 25, with VUART_SAMPLE_OFFSET 3 and VUART_ISR_OVERHEAD 0
+#endif
 
 //The subtracted value for next bit time is empirically
 // measured to ensure the per-bit time matches VUART_BIT_TICKS
@@ -69,6 +90,32 @@
 //#define PROF_1_ASSERT()
 //#define PROF_1_DEASSERT()
 
+// Inter-byte idle timeout. After each byte compare B keeps running in VUART_IDLE_TICKS
+// steps (timer 0 is 1us/tick) until the next start bit - this many quiet steps in a row
+// ends the string.
+#define VUART_IDLE_TICKS			250
+#define VUART_IDLE_TIMEOUT_US		5000
+#define VUART_IDLE_TIMEOUT_COUNT	(VUART_IDLE_TIMEOUT_US / VUART_IDLE_TICKS)
+
+#ifdef VUART_EDGE_CAPTURE
+// Edges waiting for the decode tick. At most 10 edges per byte and a tick every 5 bit
+// times, so 16 leaves plenty of room for a late tick. Power of 2.
+#define VUART_EDGE_RING_SIZE		16
+#define VUART_EDGE_RING_MASK		(VUART_EDGE_RING_SIZE - 1)
+
+typedef struct
+{
+	uint8_t u8Timer0;
+	uint8_t u8Timer1;			// Low byte of timer 1
+	bool bLevel;				// Line level after the edge
+} SVUARTEdge;
+#endif
+
+// Bit time of each vUART rate (see vUARTRateSet()). Rate 0 is the rate the cells power
+// up at. The sample offset scales with the bit time, so it stays the same fraction of a bit.
+#define VUART_RATE_BIT_TICKS(n, d)	((uint8_t) ((VUART_BIT_TICKS * (n)) / (d)))
+#define VUART_RATE_SAMPLE_OFFSET(n, d)	((uint8_t) ((VUART_SAMPLE_OFFSET * (n)) / (d)))
+
 // If defined, will send a repeating pattern sequence to the cell CPUs
 //#define CELL_CPU_PATTERN		1
 
@@ -86,6 +133,39 @@ static uint8_t sg_u8rxDataByte;
 static EChannelState sg_eCell_mc_rxState = ESTATE_IDLE;
 static volatile bool sg_bCell_mc_rxPriorState;
 static volatile bool sg_bCell_mc_rxMoreData;
+static uint8_t sg_u8Cell_mc_rxIdleCount;
+
+#ifdef VUART_EDGE_CAPTURE
+static volatile SVUARTEdge sg_sEdgeRing[VUART_EDGE_RING_SIZE];
+static volatile uint8_t sg_u8EdgeHead;				// Written by the edge interrupt
+static volatile uint8_t sg_u8EdgeTail;				// Written by the decode tick
+static volatile bool sg_bEdgeOverrun;
+static volatile bool sg_bEdgeTickRunning;
+static volatile bool sg_bEdgeClockStart;			// Oldest edge in the ring starts the clock
+static SVUARTDecodeClock sg_sEdgeClock;
+static SVUARTDecode sg_sEdgeDecode;
+#endif
+
+// Current rate - bit time and sample offset in timer 0 ticks
+static uint8_t sg_u8Rate;
+static uint8_t sg_u8BitTicks = VUART_BIT_TICKS;
+static uint8_t sg_u8SampleOffset = VUART_SAMPLE_OFFSET;
+
+static const uint8_t sg_u8RateBitTicks[VUART_RATE_COUNT] =
+{
+	VUART_RATE_BIT_TICKS(1, 1),		// 50us, 20kbps
+	VUART_RATE_BIT_TICKS(4, 5),		// 40us, 25kbps
+	VUART_RATE_BIT_TICKS(2, 3),		// 33us, 30kbps
+	VUART_RATE_BIT_TICKS(1, 2),		// 25us, 40kbps
+};
+
+static const uint8_t sg_u8RateSampleOffset[VUART_RATE_COUNT] =
+{
+	VUART_RATE_SAMPLE_OFFSET(1, 1),
+	VUART_RATE_SAMPLE_OFFSET(4, 5),
+	VUART_RATE_SAMPLE_OFFSET(2, 3),
+	VUART_RATE_SAMPLE_OFFSET(1, 2),
+};
 
 // cell_dn_tx related
 static volatile uint8_t sg_u8txBitCount;
@@ -104,10 +184,20 @@ static volatile bool sg_bMCTxNextBit;
 
 #ifdef ENABLE_EDGE_SYNC
 // Edge-triggered timing correction variables
-static volatile int8_t sg_minTimingError;      // Minimum timing error seen (in timer ticks)
-static volatile int8_t sg_maxTimingError;      // Maximum timing error seen (in timer ticks)
 static volatile uint16_t sg_edgeCorrections;   // Count of corrections applied
 static volatile uint8_t sg_lastEdgeTimer;      // Timer value at last edge
+static volatile uint8_t sg_startEdgeTimer;     // Timer value at this byte's start edge
+static volatile uint8_t sg_lastEdgeBits;       // Bit times from the start edge to the last edge, 0 = none yet
+
+// Per bit timing error of the cell sending this byte (1/16us, + = slow), from the string
+// timing profile, split into whole and 16ths of a tick for the bit clock
+static int8_t sg_s8SkewStart;                  // Added to the first sample - 1.5 bits' worth
+static int8_t sg_s8SkewBit;                    // Whole ticks added to every bit
+static uint8_t sg_u8SkewFraction;              // 16ths of a tick added to every bit
+static uint8_t sg_u8SkewAccumulator;
+
+// 256 / bit count, for turning an error over n bits into an error per bit
+static const uint16_t sg_u16BitReciprocal[] = {0, 256, 128, 85, 64, 51, 43, 37, 32, 28};
 
 // Timing correction configuration
 #define TIMING_TOLERANCE 3      // Only correct if error > 3 timer ticks
@@ -154,13 +244,14 @@ static uint8_t vUARTtxDataGet( void )
 		sg_u8SendData[1] = (uint8_t) u16Data;
 #endif	
 	
-		if (sg_u8SendData[0] & 0x80)  //requesting cell reports
+		if ((sg_u8SendData[0] & 0x80) &&  //requesting cell reports
+			(0 == (sg_u8SendData[0] & (uint8_t) (MSG_CELL_REPORT_WINDOW >> 8))))  // ... from the whole string
 		{
 			sg_bCellReportsReuested = true;
 		}
 		else
 		{
-			sg_bCellReportsReuested = false;  //sending a command
+			sg_bCellReportsReuested = false;  //sending a command, or asking a window of cells
 		}
 	}
 
@@ -200,18 +291,118 @@ static bool vUARTtxDataAvailable( void )
 	return(false);
 }
 
+#ifdef ENABLE_EDGE_SYNC
+// Sets the bit clock up for the next byte's sender
+static void vUARTRXSkewLoad(void)
+{
+	int8_t s8Skew = vUARTRXSkew();
+
+	sg_s8SkewStart = (int8_t) (((int16_t) s8Skew * 3) >> 5);
+	sg_s8SkewBit = (int8_t) (s8Skew >> 4);
+	sg_u8SkewFraction = (uint8_t) (s8Skew & 0x0f);
+}
+
+// Per bit timing error of the byte just received, in 1/16us - the time from the start
+// edge to the last edge in the byte against where the nominal bit time puts that edge
+static int8_t vUARTRXTiming(void)
+{
+	uint8_t u8Bits = sg_lastEdgeBits;
+	int8_t s8Error;
+	int8_t s8Limit;
+
+	if ((0 == u8Bits) || (u8Bits >= (sizeof(sg_u16BitReciprocal) / sizeof(sg_u16BitReciprocal[0]))))
+	{
+		return(VUART_RX_TIMING_NONE);
+	}
+
+	s8Error = (int8_t) ((uint8_t) (sg_lastEdgeTimer - sg_startEdgeTimer) - (uint8_t) (u8Bits * sg_u8BitTicks));
+
+	// Keep the result within +/-8us per bit
+	s8Limit = (int8_t) ((u8Bits << 3) - 1);
+	if (s8Error > s8Limit)
+	{
+		s8Error = s8Limit;
+	}
+	else
+	if (s8Error < -s8Limit)
+	{
+		s8Error = -s8Limit;
+	}
+
+	return((int8_t) (((int16_t) s8Error * (int16_t) sg_u16BitReciprocal[u8Bits]) >> 4));
+}
+#endif
+
 // Called when we have a string timeout or need to reset the state machine
 // for the MC RX side of things
 void vUARTRXReset(void)
 {
+#ifdef VUART_EDGE_CAPTURE
+	uint8_t u8SREG = SREG;
+
+	// The edge interrupt stays live
+	cli();
+	TIMER_CHB_INT_DISABLE();
+	sg_bEdgeTickRunning = false;
+	sg_bEdgeOverrun = false;
+	sg_u8EdgeTail = sg_u8EdgeHead;
+	sg_eCell_mc_rxState = ESTATE_IDLE;
+	SREG = u8SREG;
+
+	vUARTDecode_Init(&sg_sEdgeDecode, sg_u8BitTicks);
+#else
 	sg_eCell_mc_rxState = ESTATE_IDLE;
+	TIMER_CHB_INT_DISABLE();  // stop the idle timeout, if it's running
+#endif
 	vUARTRXStart();
+#ifdef ENABLE_EDGE_SYNC
+	vUARTRXSkewLoad();
+#endif
 
 #ifdef PauseCAN
 	CANGIE = sg_u8SavedCANState;  // re-enable CAN
 #endif
 }
 
+// Switches the vUART to another rate (0 - VUART_RATE_COUNT-1), both directions. Only
+// between strings - nothing may be going on in either direction.
+void vUARTRateSet(uint8_t u8Rate)
+{
+	uint8_t u8SREG;
+
+	if (u8Rate >= VUART_RATE_COUNT)
+	{
+		u8Rate = VUART_RATE_COUNT - 1;
+	}
+
+	u8SREG = SREG;
+	cli();
+	sg_u8Rate = u8Rate;
+	sg_u8BitTicks = sg_u8RateBitTicks[u8Rate];
+	sg_u8SampleOffset = sg_u8RateSampleOffset[u8Rate];
+	SREG = u8SREG;
+
+#ifdef VUART_EDGE_CAPTURE
+	vUARTDecode_Init(&sg_sEdgeDecode, sg_u8BitTicks);
+#endif
+}
+
+uint8_t vUARTRateGet(void)
+{
+	return(sg_u8Rate);
+}
+
+// Bit time of a rate, in us
+uint8_t vUARTRateBitUs(uint8_t u8Rate)
+{
+	if (u8Rate >= VUART_RATE_COUNT)
+	{
+		return(0);
+	}
+
+	return(sg_u8RateBitTicks[u8Rate]);
+}
+
 // This starts an unsolicited transmission on tx. true Is returned if it was successfully
 // started, but false if the tx vUART is active.
 
@@ -237,7 +428,7 @@ bool vUARTStarttx(void)
 		sg_bMCTxNextBit = true;
 		
 		// We can start! Start at one bit's-worth of time later
-		TIMER_CHA_INT(VUART_BIT_TICKS);
+		TIMER_CHA_INT(sg_u8BitTicks);
 		bReturnCode = true;
 
 		// Seed the data stream	
@@ -250,6 +441,147 @@ bool vUARTStarttx(void)
 
 static bool sg_bState;
 
+#ifdef VUART_EDGE_CAPTURE
+
+// Pin change interrupt - every edge. Kept to a timestamp so it never holds anything else
+// off for long, and makes no calls so it doesn't have to save the call clobbered registers.
+ISR(INT1_vect, ISR_BLOCK)
+{
+	uint8_t u8Timer0 = TCNT0;  // capture timers asap
+	uint8_t u8Timer1 = TCNT1L;
+	uint8_t u8Head = sg_u8EdgeHead;
+	uint8_t u8Next = (uint8_t) ((u8Head + 1) & VUART_EDGE_RING_MASK);
+
+	if (u8Next == sg_u8EdgeTail)
+	{
+		// Decode tick has fallen behind - it'll throw away what's in the ring
+		sg_bEdgeOverrun = true;
+	}
+	else
+	{
+		sg_sEdgeRing[u8Head].u8Timer0 = u8Timer0;
+		sg_sEdgeRing[u8Head].u8Timer1 = u8Timer1;
+		sg_sEdgeRing[u8Head].bLevel = IS_PIN_RX_ASSERTED();
+		sg_u8EdgeHead = u8Next;
+	}
+
+	if (ESTATE_IDLE == sg_eCell_mc_rxState)
+	{
+		sg_eCell_mc_rxState = ESTATE_RX_DATA;
+	}
+
+	if (false == sg_bEdgeTickRunning)
+	{
+		sg_bEdgeTickRunning = true;
+		sg_bEdgeClockStart = true;
+		sg_u8Cell_mc_rxIdleCount = 0;
+		TIMER_CHB_INT(VUART_IDLE_TICKS);
+	}
+}
+
+// Hands a decoded byte over. Returns true if it was the end of the string.
+static bool vUARTEdgeResult(uint8_t u8Result, uint8_t u8Byte)
+{
+	if (u8Result & VUARTDECODE_BYTE)
+	{
+		vUARTRXData(u8Byte, VUART_RX_TIMING_NONE);
+		sg_eCell_mc_rxState = ESTATE_NEXT_BYTE;
+
+		if (u8Result & VUARTDECODE_LAST)
+		{
+			vUARTRXComplete();
+			return(true);
+		}
+	}
+
+	return(false);
+}
+
+// Timer 0 compare B interrupt - decode tick for mc rx from the cell CPUs. Interrupts are
+// on in here so edges keep getting timestamped while it decodes.
+ISR(TIMER0_COMPB_vect, ISR_NOBLOCK)
+{
+	uint8_t u8Timer0;
+	uint8_t u8Timer1;
+	uint8_t u8Head;
+	uint8_t u8Byte = 0;
+	bool bEnd = false;
+
+	// Snapshot "now" and the ring together, so everything in the ring is older than now.
+	// The tick stays off until it's done, so it can't run into itself.
+	cli();
+	TIMER_CHB_INT_DISABLE();
+	u8Timer0 = TCNT0;
+	u8Timer1 = TCNT1L;
+	u8Head = sg_u8EdgeHead;
+	sei();
+
+	if (sg_bEdgeClockStart)
+	{
+		sg_bEdgeClockStart = false;
+		vUARTDecode_ClockSet(&sg_sEdgeClock, sg_sEdgeRing[sg_u8EdgeTail].u8Timer0, sg_sEdgeRing[sg_u8EdgeTail].u8Timer1);
+	}
+
+	if (sg_bEdgeOverrun)
+	{
+		// Lost edges - drop the byte in progress and wait for the next start bit
+		sg_bEdgeOverrun = false;
+		sg_u8EdgeTail = u8Head;
+		vUARTDecode_Init(&sg_sEdgeDecode, sg_u8BitTicks);
+	}
+
+	if (sg_u8EdgeTail == u8Head)
+	{
+		++sg_u8Cell_mc_rxIdleCount;
+	}
+	else
+	{
+		sg_u8Cell_mc_rxIdleCount = 0;
+	}
+
+	while ((sg_u8EdgeTail != u8Head) && (false == bEnd))
+	{
+		uint8_t u8Tail = sg_u8EdgeTail;
+		uint16_t u16Time = vUARTDecode_ClockUs(&sg_sEdgeClock, sg_sEdgeRing[u8Tail].u8Timer0, sg_sEdgeRing[u8Tail].u8Timer1);
+
+		bEnd = vUARTEdgeResult(vUARTDecode_Edge(&sg_sEdgeDecode, u16Time, sg_sEdgeRing[u8Tail].bLevel, &u8Byte), u8Byte);
+		sg_u8EdgeTail = (uint8_t) ((u8Tail + 1) & VUART_EDGE_RING_MASK);
+	}
+
+	// The last byte of the string has no edge after its stop bit
+	if (false == bEnd)
+	{
+		bEnd = vUARTEdgeResult(vUARTDecode_Flush(&sg_sEdgeDecode, vUARTDecode_ClockUs(&sg_sEdgeClock, u8Timer0, u8Timer1), &u8Byte), u8Byte);
+	}
+
+	if ((false == bEnd) &&
+		(sg_u8Cell_mc_rxIdleCount >= VUART_IDLE_TIMEOUT_COUNT))
+	{
+		// Anything part way through a byte isn't coming back
+		vUARTDecode_Init(&sg_sEdgeDecode, sg_u8BitTicks);
+		bEnd = true;
+		if (ESTATE_NEXT_BYTE == sg_eCell_mc_rxState)
+		{
+			// Gone quiet - the end of string marker never showed up
+			vUARTRXComplete();
+		}
+	}
+
+	cli();
+	if (bEnd && (sg_u8EdgeTail == sg_u8EdgeHead))
+	{
+		// Next edge starts the tick again
+		sg_bEdgeTickRunning = false;
+	}
+	else
+	{
+		TIMER_CHB_INT(VUART_IDLE_TICKS);
+	}
+	sei();
+}
+
+#else // #ifdef VUART_EDGE_CAPTURE
+
 // Pin change interrupt - detecting start bit OR timing correction edges
 ISR(INT1_vect, ISR_BLOCK)
 {
@@ -261,8 +593,15 @@ ISR(INT1_vect, ISR_BLOCK)
 		// Program up the timer to interrupt about 1.5 bit's worth, which
 		// puts it almost in the center of the next bit. The added value 
 
-		TIMER_CHB_INT( VUART_BIT_TICKS + VUART_SAMPLE_OFFSET - VUART_BIT_TICK_OFFSET);  // start bit + sample offset to middle of first data bit
+#ifdef ENABLE_EDGE_SYNC
+		TIMER_CHB_INT( sg_u8BitTicks + sg_u8SampleOffset - VUART_BIT_TICK_OFFSET + sg_s8SkewStart);  // ... and where this sender's bits really are
+		sg_u8SkewAccumulator = 0;
+		sg_startEdgeTimer = currentTimer;
+		sg_lastEdgeBits = 0;
+#else
+		TIMER_CHB_INT( sg_u8BitTicks + sg_u8SampleOffset - VUART_BIT_TICK_OFFSET);  // start bit + sample offset to middle of first data bit
 																						// VUART_BIT_TICK_OFFSET needed for differences in ISR response
+#endif
 
 #ifdef ENABLE_EDGE_SYNC
 		// Switch to any-edge detection for timing correction
@@ -301,18 +640,14 @@ ISR(INT1_vect, ISR_BLOCK)
 		// This is an edge during data reception - always resync to it
 		// (we skip bit 0 since we just set up timing)
 
-/*		// Calculate timing error for statistics only
-		
-		uint8_t expectedTimer = (uint8_t)(OCR0B - (VUART_BIT_TICKS/2));
-		int8_t timingError = (int8_t)(currentTimer - expectedTimer);
-
-		// Update statistics
-		if (timingError < sg_minTimingError) sg_minTimingError = timingError;
-		if (timingError > sg_maxTimingError) sg_maxTimingError = timingError;
-*/
 		// ALWAYS resync: edge just occurred, so set timer to fire at mid-bit
 		// Use VUART_SAMPLE_OFFSET for consistency with start bit detection
-		OCR0B = (uint8_t)(currentTimer + VUART_SAMPLE_OFFSET - 10);  //use captured timer value, correction accounts for timer capture and rewrite
+		OCR0B = (uint8_t)(currentTimer + sg_u8SampleOffset - 10);  //use captured timer value, correction accounts for timer capture and rewrite
+		sg_u8SkewAccumulator = 0;
+
+		// For the byte's timing - this edge is the boundary ahead of the bit about to be sampled
+		sg_lastEdgeTimer = currentTimer;
+		sg_lastEdgeBits = sg_u8Cell_mc_rxBitCount;
 
 		// Increment correction counter
 		sg_edgeCorrections++;
@@ -328,11 +663,38 @@ ISR(INT1_vect, ISR_BLOCK)
 ISR(TIMER0_COMPB_vect, ISR_BLOCK)
 {
 	bool bData;
+
+	if (sg_eCell_mc_rxState != ESTATE_RX_DATA)
+	{
+		// Between bytes - no start bit yet
+		if ((ESTATE_NEXT_BYTE == sg_eCell_mc_rxState) &&
+			(++sg_u8Cell_mc_rxIdleCount < VUART_IDLE_TIMEOUT_COUNT))
+		{
+			TIMER_CHB_INT(VUART_IDLE_TICKS);
+		}
+		else
+		{
+			TIMER_CHB_INT_DISABLE();
+			if (ESTATE_NEXT_BYTE == sg_eCell_mc_rxState)
+			{
+				// Gone quiet - the end of string marker never showed up
+				vUARTRXComplete();
+			}
+		}
+		return;
+	}
 	
 	// Set the timer to the next bit. The subtracted value is empirically
 	// measured to ensure the per-bit time matches VUART_BIT_TICKS
 	// microseconds and accounts for CPU/interrupt/preamble overhead.
-	TIMER_CHB_INT(VUART_BIT_TICKS-VUART_BIT_TICK_OFFSET);  //different from bit start offset
+#ifdef ENABLE_EDGE_SYNC
+	// Stretched or shrunk to this sender's bit time, carrying the 16ths along
+	sg_u8SkewAccumulator += sg_u8SkewFraction;
+	TIMER_CHB_INT(sg_u8BitTicks-VUART_BIT_TICK_OFFSET+sg_s8SkewBit+(sg_u8SkewAccumulator >> 4));
+	sg_u8SkewAccumulator &= 0x0f;
+#else
+	TIMER_CHB_INT(sg_u8BitTicks-VUART_BIT_TICK_OFFSET);  //different from bit start offset
+#endif
 	
 	bData = sg_bCell_mc_rxPriorState;
 	sg_bCell_mc_rxPriorState = IS_PIN_RX_ASSERTED();
@@ -378,17 +740,34 @@ ISR(TIMER0_COMPB_vect, ISR_BLOCK)
 		VUART_RX_ENABLE();
 #endif
 		
-		// stop the timed bit interrupts
-		TIMER_CHB_INT_DISABLE();
-		
 		// record the received byte
-		vUARTRXData(sg_u8rxDataByte);
+#ifdef ENABLE_EDGE_SYNC
+		vUARTRXData(sg_u8rxDataByte, vUARTRXTiming());
+		vUARTRXSkewLoad();
+#else
+		vUARTRXData(sg_u8rxDataByte, VUART_RX_TIMING_NONE);
+#endif
 
 		// Flag that more data is coming, even if we don't get another one
 		sg_eCell_mc_rxState = ESTATE_NEXT_BYTE;
+
+		if (sg_bCell_mc_rxMoreData)
+		{
+			// Bit interrupts become the idle timeout until the next start bit
+			sg_u8Cell_mc_rxIdleCount = 0;
+			TIMER_CHB_INT(VUART_IDLE_TICKS);
+		}
+		else
+		{
+			// stop the timed bit interrupts - that was the end of the string
+			TIMER_CHB_INT_DISABLE();
+			vUARTRXComplete();
+		}
 	}
 }
 
+#endif // #ifdef VUART_EDGE_CAPTURE
+
 
 
 
@@ -396,7 +775,7 @@ ISR(TIMER0_COMPB_vect, ISR_BLOCK)
 ISR(TIMER0_COMPA_vect, ISR_BLOCK)
 {
 	// Set the timer to the next bit
-	TIMER_CHA_INT(VUART_BIT_TICKS-5);
+	TIMER_CHA_INT(sg_u8BitTicks-5);
 	
 	// Set the state of the output pin
 	if (sg_bMCTxNextBit)
@@ -472,7 +851,7 @@ ISR(TIMER0_COMPA_vect, ISR_BLOCK)
 			sg_u8txDataByte = vUARTtxDataGet();
 			
 			// Set the timer 2 bits later
-			TIMER_CHA_INT(VUART_BIT_TICKS*4);
+			TIMER_CHA_INT(sg_u8BitTicks*4);
 		}
 	}
 
@@ -509,11 +888,12 @@ void vUARTInitReceive(void)
 {
 	// Reset timing correction statistics
 #ifdef ENABLE_EDGE_SYNC
-	sg_minTimingError = 127;     // Max positive value for int8_t
-	sg_maxTimingError = -128;    // Max negative value for int8_t
 	sg_edgeCorrections = 0;
 #endif
 	
 	// Enable receives
 	VUART_RX_ENABLE();
+#ifdef VUART_EDGE_CAPTURE
+	VUART_RX_ANY_EDGE();
+#endif
 }
\ No newline at end of file
@@ -6,6 +6,12 @@ extern bool vUARTStarttx(void);
 extern void vUARTRXReset(void);
 extern void vUARTInitReceive(void);
 extern bool vUARTIsBusy(void);  // Returns true if UART is actively receiving
+extern void vUARTRateSet(uint8_t u8Rate);
+extern uint8_t vUARTRateGet(void);
+extern uint8_t vUARTRateBitUs(uint8_t u8Rate);
+
+// # Of vUART rates. Rate 0 is VUART_BIT_TICKS, what the cells start at.
+#define VUART_RATE_COUNT					4
 
 // # Of bytes per cell for cell data IN 1 << FORM (so (1 << 2) =4, (1 << 3) = 8, etc...
 #define BYTES_PER_CELL_SHIFT 2
@@ -0,0 +1,145 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include "vuartdecode.h"
+
+// Longest run that can mean anything - start bit through the guard bit
+#define VUARTDECODE_RUN_MAX		(VUARTDECODE_BIT_GUARD + 1)
+
+void vUARTDecode_ClockSet(SVUARTDecodeClock* psClock, uint8_t u8Timer0, uint8_t u8Timer1)
+{
+	psClock->u8Timer0 = u8Timer0;
+	psClock->u8Timer1 = u8Timer1;
+}
+
+uint16_t vUARTDecode_ClockUs(SVUARTDecodeClock* psClock, uint8_t u8Timer0, uint8_t u8Timer1)
+{
+	uint16_t u16Coarse;
+
+	// Timer 1 is within a tick of the truth, timer 0 knows the exact time modulo 256us -
+	// correct the coarse time to the nearest value that agrees with timer 0
+	u16Coarse = (uint16_t) ((uint8_t) (u8Timer1 - psClock->u8Timer1) * VUARTDECODE_TIMER0_PER_TIMER1);
+	psClock->u16Us += (uint16_t) (u16Coarse + (int8_t) ((uint8_t) (u8Timer0 - psClock->u8Timer0) - (uint8_t) u16Coarse));
+	psClock->u8Timer0 = u8Timer0;
+	psClock->u8Timer1 = u8Timer1;
+
+	return(psClock->u16Us);
+}
+
+void vUARTDecode_Init(SVUARTDecode* psDecode, uint8_t u8BitUs)
+{
+	psDecode->u16LastEdge = 0;
+	psDecode->u16HalfBit = u8BitUs >> 1;
+	psDecode->u16Reciprocal = (uint16_t) ((0x10000 + (u8BitUs >> 1)) / u8BitUs);
+	psDecode->u8Bit = VUARTDECODE_BIT_GUARD;
+	psDecode->u8Data = 0;
+	psDecode->bLevel = false;
+}
+
+// Run length in whole bit times, rounded to the nearest
+static uint8_t vUARTDecode_RunBits(SVUARTDecode* psDecode, uint16_t u16RunUs)
+{
+	uint32_t u32Bits;
+
+	if (u16RunUs > (0xffff - psDecode->u16HalfBit))
+	{
+		return(VUARTDECODE_RUN_MAX);
+	}
+
+	u32Bits = ((uint32_t) (u16RunUs + psDecode->u16HalfBit) * psDecode->u16Reciprocal) >> 16;
+	if (u32Bits > VUARTDECODE_RUN_MAX)
+	{
+		u32Bits = VUARTDECODE_RUN_MAX;
+	}
+
+	return((uint8_t) u32Bits);
+}
+
+// Hands u8Bits bit times of the current level to the byte in progress
+static uint8_t vUARTDecode_Bits(SVUARTDecode* psDecode, uint8_t u8Bits, uint8_t* pu8Byte)
+{
+	while (u8Bits--)
+	{
+		if (VUARTDECODE_BIT_START == psDecode->u8Bit)
+		{
+			if (false == psDecode->bLevel)
+			{
+				// Start bit didn't last - a glitch, wait for the next one
+				psDecode->u8Bit = VUARTDECODE_BIT_GUARD;
+				return(0);
+			}
+		}
+		else
+		if (psDecode->u8Bit < VUARTDECODE_BIT_STOP)
+		{
+			psDecode->u8Data = (uint8_t) ((psDecode->u8Data << 1) | psDecode->bLevel);
+		}
+		else
+		{
+			// Stop bit. Whatever's left of the run is guard bit and idle line.
+			*pu8Byte = psDecode->u8Data;
+			psDecode->u8Bit = VUARTDECODE_BIT_GUARD;
+			if (psDecode->bLevel)
+			{
+				return(VUARTDECODE_BYTE);
+			}
+
+			return(VUARTDECODE_BYTE | VUARTDECODE_LAST);
+		}
+
+		psDecode->u8Bit++;
+	}
+
+	return(0);
+}
+
+uint8_t vUARTDecode_Edge(SVUARTDecode* psDecode, uint16_t u16Time, bool bLevel, uint8_t* pu8Byte)
+{
+	uint8_t u8Result = 0;
+	uint8_t u8Bits;
+
+	u8Bits = vUARTDecode_RunBits(psDecode, (uint16_t) (u16Time - psDecode->u16LastEdge));
+	if ((0 == u8Bits) && (psDecode->u8Bit < VUARTDECODE_BIT_GUARD))
+	{
+		// Less than half a bit since the last edge. Keep timing the run from that edge
+		// so the glitch gets folded into its neighbours.
+		psDecode->bLevel = bLevel;
+		return(0);
+	}
+
+	if (psDecode->u8Bit < VUARTDECODE_BIT_GUARD)
+	{
+		u8Result = vUARTDecode_Bits(psDecode, u8Bits, pu8Byte);
+	}
+
+	psDecode->u16LastEdge = u16Time;
+	psDecode->bLevel = bLevel;
+
+	// Rising edge on an idle line is a start bit
+	if ((psDecode->u8Bit >= VUARTDECODE_BIT_GUARD) && bLevel)
+	{
+		psDecode->u8Bit = VUARTDECODE_BIT_START;
+		psDecode->u8Data = 0;
+	}
+
+	return(u8Result);
+}
+
+uint8_t vUARTDecode_Flush(SVUARTDecode* psDecode, uint16_t u16Now, uint8_t* pu8Byte)
+{
+	uint8_t u8Bits;
+
+	if (psDecode->u8Bit >= VUARTDECODE_BIT_GUARD)
+	{
+		return(0);
+	}
+
+	// Wait until the run reaches into the guard bit, so a stop bit that's about to
+	// change doesn't get read early
+	u8Bits = vUARTDecode_RunBits(psDecode, (uint16_t) (u16Now - psDecode->u16LastEdge));
+	if ((psDecode->u8Bit + u8Bits) <= VUARTDECODE_BIT_GUARD)
+	{
+		return(0);
+	}
+
+	return(vUARTDecode_Bits(psDecode, u8Bits, pu8Byte));
+}
@@ -0,0 +1,65 @@
+#ifndef _VUARTDECODE_H_
+#define _VUARTDECODE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Edge run length decoder for the vUART receive stream - shared by the firmware
+// (VUART_EDGE_CAPTURE receiver in vUART.c) and the host waveform simulator
+// (vuartsim/), so no AVR dependencies in here.
+//
+// The decoder is fed the time of every line edge and the level after it. The time
+// since the previous edge, in rounded bit times, says how many bits the previous
+// level lasted. Line levels are as the receiver sees them: idle low, start bit high,
+// then 8 data bits MSB first, the stop bit (high = more data coming) and the guard
+// bit (low).
+
+#define VUARTDECODE_BIT_START		0
+#define VUARTDECODE_BIT_STOP		9
+#define VUARTDECODE_BIT_GUARD		10		// Also "waiting for a start bit"
+
+// Timer 0 ticks (1us) per timer 1 tick (32us) - both run off the same prescaler
+#define VUARTDECODE_TIMER0_PER_TIMER1	32
+
+// vUARTDecode_Edge()/vUARTDecode_Flush() results
+#define VUARTDECODE_BYTE			0x01	// A byte was completed, in *pu8Byte
+#define VUARTDECODE_LAST			0x02	// ... and its stop bit says nothing more is coming
+
+typedef struct
+{
+	uint16_t u16LastEdge;		// Time (us) the current run started
+	uint16_t u16HalfBit;		// Half a bit time (us)
+	uint16_t u16Reciprocal;		// 65536 / bit time, so runs divide with a multiply
+	uint8_t u8Bit;				// Bit position the current run started at
+	uint8_t u8Data;				// Data bits so far
+	bool bLevel;				// Line level of the current run
+} SVUARTDecode;
+
+// Edges are stamped with raw timer 0 and timer 1 low byte snapshots - cheap to take
+// in the edge interrupt. This turns them into a running 16 bit microsecond clock.
+typedef struct
+{
+	uint16_t u16Us;				// Microseconds at the last snapshot
+	uint8_t u8Timer0;			// Last snapshot
+	uint8_t u8Timer1;
+} SVUARTDecodeClock;
+
+// Start the clock from a snapshot
+extern void vUARTDecode_ClockSet(SVUARTDecodeClock* psClock, uint8_t u8Timer0, uint8_t u8Timer1);
+
+// Microseconds at a later snapshot. Snapshots have to be fed in order, less than 8ms
+// (timer 1 low byte's reach) apart.
+extern uint16_t vUARTDecode_ClockUs(SVUARTDecodeClock* psClock, uint8_t u8Timer0, uint8_t u8Timer1);
+
+// Set up for a bit time of u8BitUs microseconds, waiting for a start bit
+extern void vUARTDecode_Init(SVUARTDecode* psDecode, uint8_t u8BitUs);
+
+// An edge at u16Time (us, free running and wrapping) leaving the line at bLevel
+extern uint8_t vUARTDecode_Edge(SVUARTDecode* psDecode, uint16_t u16Time, bool bLevel, uint8_t* pu8Byte);
+
+// No edge since the last one, and it's now u16Now. Completes the byte in progress if
+// the current run has already covered its stop bit - the last byte of a string has no
+// edge after it.
+extern uint8_t vUARTDecode_Flush(SVUARTDecode* psDecode, uint16_t u16Now, uint8_t* pu8Byte);
+
+#endif // _VUARTDECODE_H_
@@ -0,0 +1,545 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+#include <ctype.h>
+#include <string.h>
+#include <stdbool.h>
+
+#include "../geneeprom/CmdLine.h"
+#include "../vuartdecode.h"
+
+// Waveform simulator for the VUART_EDGE_CAPTURE receiver (see VUART_EDGE_CAPTURE.md).
+// Builds the RX line waveform for a string of bytes - with sender clock skew, edge
+// jitter and inter byte gaps - then plays it through a model of the receiver: the edge
+// interrupt's timer snapshots (timer 0 1us, timer 1 32us, both truncated like the
+// hardware), the 16 entry ring and the decode tick. The decoder and clock are the
+// firmware's own vuartdecode.c. The tick logic mirrors TIMER0_COMPB_vect in vUART.c.
+
+#define BIT_US_DEFAULT				50		// VUART_BIT_TICKS
+#define BYTES_DEFAULT				376		// 94 cells, 4 bytes each
+
+// Receiver model - keep in step with vUART.c
+#define IDLE_TICKS					250
+#define IDLE_TIMEOUT_COUNT			(5000 / IDLE_TICKS)
+#define EDGE_RING_SIZE				16
+#define EDGE_RING_MASK				(EDGE_RING_SIZE - 1)
+
+#define MAX_BYTES					1024
+#define MAX_EDGES					(MAX_BYTES * 12)
+
+static SCmdLineOption sg_sCmdLineOptions[] =
+{
+	{"-bytes",			"# Of bytes in the string (376)",						false,	true},
+	{"-bit",			"Bit time in us (50)",									false,	true},
+	{"-skew",			"Sender clock error in percent (0)",					false,	true},
+	{"-jitter",			"Random edge jitter in us, +/- (0)",					false,	true},
+	{"-latency",		"Worst case interrupt latency in us (0)",				false,	true},
+	{"-gap",			"Most idle bits between bytes (0)",						false,	true},
+	{"-seed",			"Random seed (1)",										false,	true},
+	{"-verify",			"Sweep skew/jitter/latency/gaps, fail on any error",	false,	false},
+
+	{NULL}
+};
+
+typedef struct
+{
+	uint16_t u16Bytes;
+	uint8_t u8BitUs;
+	double dSkew;
+	double dJitterUs;
+	double dLatencyUs;
+	uint8_t u8GapBits;
+	uint32_t u32Seed;
+} SSimParams;
+
+typedef struct
+{
+	double dTime;				// When the line changed (us)
+	bool bLevel;				// Level after the change
+} SLineEdge;
+
+typedef struct
+{
+	uint16_t u16Decoded;
+	uint16_t u16Errors;
+	uint32_t u32EdgeInts;
+	uint32_t u32TickInts;
+	uint16_t u16Overruns;
+	bool bComplete;
+	double dCompleteUs;			// String end to vUARTRXComplete()
+} SSimResult;
+
+static uint32_t sg_u32Random;
+
+// xorshift - the same sequence on every host
+static uint32_t Random(void)
+{
+	sg_u32Random ^= sg_u32Random << 13;
+	sg_u32Random ^= sg_u32Random >> 17;
+	sg_u32Random ^= sg_u32Random << 5;
+	return(sg_u32Random);
+}
+
+// Uniform in 0-1
+static double RandomUnit(void)
+{
+	return((double) (Random() & 0xffffff) / (double) 0x1000000);
+}
+
+static uint32_t BuildWaveform(const SSimParams *psParams,
+							  const uint8_t *pu8Bytes,
+							  SLineEdge *psEdges,
+							  double *pdEndUs)
+{
+	double dBitUs = psParams->u8BitUs * (1.0 + (psParams->dSkew / 100.0));
+	double dTime;
+	uint32_t u32Edges = 0;
+	uint32_t u32Bit = 0;
+	bool bLevel = false;
+	uint16_t u16Byte;
+
+	// Somewhere random against the receiver's timers
+	dTime = 1000.0 + (RandomUnit() * 8192.0);
+
+	for (u16Byte = 0; u16Byte < psParams->u16Bytes; u16Byte++)
+	{
+		bool bBits[11];
+		uint8_t u8Bit;
+
+		bBits[0] = true;
+		for (u8Bit = 0; u8Bit < 8; u8Bit++)
+		{
+			bBits[1 + u8Bit] = (pu8Bytes[u16Byte] & (0x80 >> u8Bit)) ? true : false;
+		}
+		bBits[9] = (u16Byte + 1) < psParams->u16Bytes;
+		bBits[10] = false;
+
+		for (u8Bit = 0; u8Bit < 11; u8Bit++)
+		{
+			if (bBits[u8Bit] != bLevel)
+			{
+				bLevel = bBits[u8Bit];
+				psEdges[u32Edges].dTime = dTime + (u32Bit * dBitUs) + (((RandomUnit() * 2.0) - 1.0) * psParams->dJitterUs);
+				psEdges[u32Edges].bLevel = bLevel;
+				++u32Edges;
+			}
+			++u32Bit;
+		}
+
+		// End of the stop bit - the last one's is the end of the string
+		*pdEndUs = dTime + ((u32Bit - 1) * dBitUs);
+
+		if (psParams->u8GapBits)
+		{
+			u32Bit += Random() % (psParams->u8GapBits + 1);
+		}
+	}
+
+	return(u32Edges);
+}
+
+// Receiver's view of the timers at a point in time
+static void Snapshot(double dTime,
+					 uint8_t *pu8Timer0,
+					 uint8_t *pu8Timer1)
+{
+	uint32_t u32Ticks = (uint32_t) dTime;
+
+	*pu8Timer0 = (uint8_t) u32Ticks;
+	*pu8Timer1 = (uint8_t) (u32Ticks >> 5);
+}
+
+static void Simulate(const SSimParams *psParams,
+					 SSimResult *psResult)
+{
+	static SLineEdge sEdges[MAX_EDGES];
+	static uint8_t u8Sent[MAX_BYTES];
+	static uint8_t u8Received[MAX_BYTES];
+	uint8_t u8RingTimer0[EDGE_RING_SIZE];
+	uint8_t u8RingTimer1[EDGE_RING_SIZE];
+	bool bRingLevel[EDGE_RING_SIZE];
+	uint8_t u8Head = 0;
+	uint8_t u8Tail = 0;
+	bool bOverrun = false;
+	bool bTickRunning = false;
+	bool bClockStart = false;
+	bool bByteSeen = false;
+	uint8_t u8IdleCount = 0;
+	double dTick = 0.0;
+	double dEdgeInt = 0.0;
+	double dLastInt = 0.0;
+	double dEndUs;
+	uint32_t u32Edges;
+	uint32_t u32Edge = 0;
+	SVUARTDecode sDecode;
+	SVUARTDecodeClock sClock;
+	uint16_t u16Byte;
+
+	memset((void *) psResult, 0, sizeof(*psResult));
+	memset((void *) &sClock, 0, sizeof(sClock));
+	sg_u32Random = psParams->u32Seed ? psParams->u32Seed : 1;
+
+	for (u16Byte = 0; u16Byte < psParams->u16Bytes; u16Byte++)
+	{
+		u8Sent[u16Byte] = (uint8_t) Random();
+	}
+
+	// Worst case patterns up front - longest runs and most edges
+	if (psParams->u16Bytes >= 4)
+	{
+		u8Sent[0] = 0xff;
+		u8Sent[1] = 0x00;
+		u8Sent[2] = 0x55;
+		u8Sent[3] = 0xaa;
+	}
+
+	u32Edges = BuildWaveform(psParams, u8Sent, sEdges, &dEndUs);
+	vUARTDecode_Init(&sDecode, psParams->u8BitUs);
+
+	if (u32Edges)
+	{
+		dEdgeInt = sEdges[0].dTime + (RandomUnit() * psParams->dLatencyUs);
+	}
+
+	while ((u32Edge < u32Edges) || bTickRunning)
+	{
+		uint8_t u8Timer0;
+		uint8_t u8Timer1;
+
+		if ((u32Edge < u32Edges) &&
+			((false == bTickRunning) || (dEdgeInt < dTick)))
+		{
+			// Edge interrupt. Another edge interrupt or the decode tick's snapshot holds it
+			// off, the rest of the decode tick doesn't.
+			double dNow = dEdgeInt;
+			bool bLevel;
+			uint8_t u8Next = (uint8_t) ((u8Head + 1) & EDGE_RING_MASK);
+
+			if (dNow < dLastInt)
+			{
+				dNow = dLastInt;
+			}
+			dLastInt = dNow + 2.0;
+
+			// The pin is read a little after the edge - a later edge may have landed by then
+			bLevel = sEdges[u32Edge].bLevel;
+			++u32Edge;
+			while ((u32Edge < u32Edges) && (sEdges[u32Edge].dTime <= dNow))
+			{
+				bLevel = sEdges[u32Edge].bLevel;
+				++u32Edge;
+			}
+
+			if (u32Edge < u32Edges)
+			{
+				dEdgeInt = sEdges[u32Edge].dTime + (RandomUnit() * psParams->dLatencyUs);
+			}
+
+			++psResult->u32EdgeInts;
+			Snapshot(dNow, &u8Timer0, &u8Timer1);
+
+			if (u8Next == u8Tail)
+			{
+				bOverrun = true;
+			}
+			else
+			{
+				u8RingTimer0[u8Head] = u8Timer0;
+				u8RingTimer1[u8Head] = u8Timer1;
+				bRingLevel[u8Head] = bLevel;
+				u8Head = u8Next;
+			}
+
+			if (false == bTickRunning)
+			{
+				bTickRunning = true;
+				bClockStart = true;
+				u8IdleCount = 0;
+				dTick = (double) (uint32_t) dNow + IDLE_TICKS + (RandomUnit() * psParams->dLatencyUs);
+			}
+		}
+		else
+		{
+			// Decode tick
+			double dNow = dTick;
+			uint8_t u8Byte = 0;
+			uint8_t u8Result;
+			uint8_t u8TickHead = u8Head;
+			bool bEnd = false;
+
+			if (dNow < dLastInt)
+			{
+				dNow = dLastInt;
+			}
+			dLastInt = dNow + 2.0;
+
+			++psResult->u32TickInts;
+			Snapshot(dNow, &u8Timer0, &u8Timer1);
+
+			if (bClockStart)
+			{
+				bClockStart = false;
+				vUARTDecode_ClockSet(&sClock, u8RingTimer0[u8Tail], u8RingTimer1[u8Tail]);
+			}
+
+			if (bOverrun)
+			{
+				bOverrun = false;
+				++psResult->u16Overruns;
+				u8Tail = u8TickHead;
+				vUARTDecode_Init(&sDecode, psParams->u8BitUs);
+			}
+
+			if (u8Tail == u8TickHead)
+			{
+				++u8IdleCount;
+			}
+			else
+			{
+				u8IdleCount = 0;
+			}
+
+			while (u8Tail != u8TickHead)
+			{
+				uint16_t u16Time = vUARTDecode_ClockUs(&sClock, u8RingTimer0[u8Tail], u8RingTimer1[u8Tail]);
+
+				u8Result = vUARTDecode_Edge(&sDecode, u16Time, bRingLevel[u8Tail], &u8Byte);
+				u8Tail = (uint8_t) ((u8Tail + 1) & EDGE_RING_MASK);
+
+				if (u8Result & VUARTDECODE_BYTE)
+				{
+					if (psResult->u16Decoded < MAX_BYTES)
+					{
+						u8Received[psResult->u16Decoded] = u8Byte;
+					}
+					++psResult->u16Decoded;
+					bByteSeen = true;
+				}
+
+				if (u8Result & VUARTDECODE_LAST)
+				{
+					bEnd = true;
+					break;
+				}
+			}
+
+			if (false == bEnd)
+			{
+				u8Result = vUARTDecode_Flush(&sDecode, vUARTDecode_ClockUs(&sClock, u8Timer0, u8Timer1), &u8Byte);
+				if (u8Result & VUARTDECODE_BYTE)
+				{
+					if (psResult->u16Decoded < MAX_BYTES)
+					{
+						u8Received[psResult->u16Decoded] = u8Byte;
+					}
+					++psResult->u16Decoded;
+					bByteSeen = true;
+				}
+
+				bEnd = (u8Result & VUARTDECODE_LAST) ? true : false;
+			}
+
+			if (bEnd)
+			{
+				psResult->bComplete = true;
+				psResult->dCompleteUs = dNow - dEndUs;
+			}
+			else
+			if (u8IdleCount >= IDLE_TIMEOUT_COUNT)
+			{
+				vUARTDecode_Init(&sDecode, psParams->u8BitUs);
+				bEnd = true;
+				if (bByteSeen && (false == psResult->bComplete))
+				{
+					// Timeout stands in for a lost end of string marker
+					psResult->bComplete = true;
+					psResult->dCompleteUs = dNow - dEndUs;
+				}
+			}
+
+			if (bEnd && (u8Tail == u8Head))
+			{
+				bTickRunning = false;
+			}
+			else
+			{
+				dTick = (double) (uint32_t) dNow + IDLE_TICKS + (RandomUnit() * psParams->dLatencyUs);
+			}
+		}
+	}
+
+	for (u16Byte = 0; u16Byte < psParams->u16Bytes; u16Byte++)
+	{
+		if ((u16Byte >= psResult->u16Decoded) || (u8Received[u16Byte] != u8Sent[u16Byte]))
+		{
+			++psResult->u16Errors;
+		}
+	}
+
+	if (psResult->u16Decoded > psParams->u16Bytes)
+	{
+		psResult->u16Errors += (uint16_t) (psResult->u16Decoded - psParams->u16Bytes);
+	}
+}
+
+static bool Report(const SSimParams *psParams,
+				   const SSimResult *psResult)
+{
+	bool bPass = (0 == psResult->u16Errors) && (0 == psResult->u16Overruns) && psResult->bComplete;
+
+	printf("skew %+.1f%% jitter %.0fus latency %.0fus gap %u seed %u: %u/%u bytes, %u errors, %u overruns, ",
+		   psParams->dSkew,
+		   psParams->dJitterUs,
+		   psParams->dLatencyUs,
+		   psParams->u8GapBits,
+		   psParams->u32Seed,
+		   psResult->u16Decoded,
+		   psParams->u16Bytes,
+		   psResult->u16Errors,
+		   psResult->u16Overruns);
+
+	if (psResult->bComplete)
+	{
+		printf("complete %.0fus after the last stop bit - %s\n", psResult->dCompleteUs, bPass ? "OK" : "FAIL");
+	}
+	else
+	{
+		printf("never completed - FAIL\n");
+	}
+
+	return(bPass);
+}
+
+static void ReportLoad(const SSimParams *psParams,
+					   const SSimResult *psResult)
+{
+	// The bit sampling receiver takes a compare B interrupt per bit and, with edge sync,
+	// an INT1 interrupt per edge
+	printf("Interrupts per byte: %.2f edge + %.2f tick = %.2f (bit sampling: %.2f)\n",
+		   (double) psResult->u32EdgeInts / psParams->u16Bytes,
+		   (double) psResult->u32TickInts / psParams->u16Bytes,
+		   (double) (psResult->u32EdgeInts + psResult->u32TickInts) / psParams->u16Bytes,
+		   10.0 + ((double) psResult->u32EdgeInts / psParams->u16Bytes));
+}
+
+static bool Verify(const SSimParams *psBase)
+{
+	static const double dSkews[] = {-3.0, -2.0, -1.0, 0.0, 1.0, 2.0, 3.0};
+	static const double dJitters[] = {0.0, 2.0};
+	static const double dLatencies[] = {0.0, 8.0};
+	static const uint8_t u8Gaps[] = {0, 4};
+	SSimParams sParams = *psBase;
+	SSimResult sResult;
+	uint32_t u32Runs = 0;
+	uint32_t u32Failures = 0;
+	uint8_t u8Skew;
+	uint8_t u8Jitter;
+	uint8_t u8Latency;
+	uint8_t u8Gap;
+	uint32_t u32Seed;
+
+	for (u8Skew = 0; u8Skew < (sizeof(dSkews) / sizeof(dSkews[0])); u8Skew++)
+	{
+		for (u8Jitter = 0; u8Jitter < (sizeof(dJitters) / sizeof(dJitters[0])); u8Jitter++)
+		{
+			for (u8Latency = 0; u8Latency < (sizeof(dLatencies) / sizeof(dLatencies[0])); u8Latency++)
+			{
+				for (u8Gap = 0; u8Gap < sizeof(u8Gaps); u8Gap++)
+				{
+					for (u32Seed = 1; u32Seed <= 8; u32Seed++)
+					{
+						sParams.dSkew = dSkews[u8Skew];
+						sParams.dJitterUs = dJitters[u8Jitter];
+						sParams.dLatencyUs = dLatencies[u8Latency];
+						sParams.u8GapBits = u8Gaps[u8Gap];
+						sParams.u32Seed = u32Seed;
+
+						Simulate(&sParams, &sResult);
+						++u32Runs;
+
+						// Only the failures are interesting
+						if ((sResult.u16Errors) || (sResult.u16Overruns) || (false == sResult.bComplete))
+						{
+							Report(&sParams, &sResult);
+							++u32Failures;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	printf("%u runs, %u failures\n", u32Runs, u32Failures);
+	return(0 == u32Failures);
+}
+
+int main(int argc, char **argv)
+{
+	SSimParams sParams;
+	SSimResult sResult;
+	bool bResult;
+
+	if (false == CmdLineInitArgcArgv(argc,
+									 argv,
+									 sg_sCmdLineOptions,
+									 argv[0]))
+	{
+		printf("Failed\n");
+		CmdLineDumpOptions(sg_sCmdLineOptions);
+		return(1);
+	}
+
+	memset((void *) &sParams, 0, sizeof(sParams));
+	sParams.u16Bytes = BYTES_DEFAULT;
+	sParams.u8BitUs = BIT_US_DEFAULT;
+	sParams.u32Seed = 1;
+
+	if (CmdLineOptionValue("-bytes"))
+	{
+		sParams.u16Bytes = (uint16_t) atoi(CmdLineOptionValue("-bytes"));
+	}
+	if (CmdLineOptionValue("-bit"))
+	{
+		sParams.u8BitUs = (uint8_t) atoi(CmdLineOptionValue("-bit"));
+	}
+	if (CmdLineOptionValue("-skew"))
+	{
+		sParams.dSkew = atof(CmdLineOptionValue("-skew"));
+	}
+	if (CmdLineOptionValue("-jitter"))
+	{
+		sParams.dJitterUs = atof(CmdLineOptionValue("-jitter"));
+	}
+	if (CmdLineOptionValue("-latency"))
+	{
+		sParams.dLatencyUs = atof(CmdLineOptionValue("-latency"));
+	}
+	if (CmdLineOptionValue("-gap"))
+	{
+		sParams.u8GapBits = (uint8_t) atoi(CmdLineOptionValue("-gap"));
+	}
+	if (CmdLineOptionValue("-seed"))
+	{
+		sParams.u32Seed = (uint32_t) strtoul(CmdLineOptionValue("-seed"), NULL, 0);
+	}
+
+	if ((0 == sParams.u16Bytes) || (sParams.u16Bytes > MAX_BYTES) || (sParams.u8BitUs < 8))
+	{
+		printf("-bytes must be 1-%u and -bit at least 8\n", MAX_BYTES);
+		return(1);
+	}
+
+	if (CmdLineOption("-verify"))
+	{
+		bResult = Verify(&sParams);
+	}
+	else
+	{
+		Simulate(&sParams, &sResult);
+		bResult = Report(&sParams, &sResult);
+		ReportLoad(&sParams, &sResult);
+	}
+
+	return(bResult ? 0 : 1);
+}